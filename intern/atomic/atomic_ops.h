@@ -98,6 +98,8 @@ ATOMIC_INLINE int16_t atomic_fetch_and_and_int16(int16_t *p, int16_t b);
 
 ATOMIC_INLINE uint8_t atomic_fetch_and_or_uint8(uint8_t *p, uint8_t b);
 ATOMIC_INLINE uint8_t atomic_fetch_and_and_uint8(uint8_t *p, uint8_t b);
+ATOMIC_INLINE uint8_t atomic_load_uint8(const uint8_t *v);
+ATOMIC_INLINE void atomic_store_uint8(uint8_t *p, uint8_t v);
 
 ATOMIC_INLINE int8_t atomic_fetch_and_or_int8(int8_t *p, int8_t b);
 ATOMIC_INLINE int8_t atomic_fetch_and_and_int8(int8_t *p, int8_t b);
@@ -126,6 +128,8 @@ ATOMIC_INLINE void *atomic_load_ptr(void *const *v);
 ATOMIC_INLINE void atomic_store_ptr(void **p, void *v);
 
 ATOMIC_INLINE float atomic_cas_float(float *v, float old, float _new);
+ATOMIC_INLINE float atomic_load_fl(const float *v);
+ATOMIC_INLINE void atomic_store_fl(float *p, float v);
 
 /* WARNING! Float 'atomics' are really faked ones, those are actually closer to some kind of
  * spinlock-sync'ed operation, which means they are only efficient if collisions are highly
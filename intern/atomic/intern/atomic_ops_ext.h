@@ -231,6 +231,17 @@ ATOMIC_INLINE float atomic_cas_float(float *v, float old, float _new)
   return *(float *)&ret;
 }
 
+ATOMIC_INLINE float atomic_load_fl(const float *v)
+{
+  uint32_t ret = atomic_load_uint32((const uint32_t *)v);
+  return *(float *)&ret;
+}
+
+ATOMIC_INLINE void atomic_store_fl(float *p, float v)
+{
+  atomic_store_uint32((uint32_t *)p, *(uint32_t *)&v);
+}
+
 ATOMIC_INLINE float atomic_add_and_fetch_fl(float *p, const float x)
 {
   float oldval, newval;
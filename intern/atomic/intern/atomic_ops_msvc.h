@@ -254,6 +254,16 @@ ATOMIC_INLINE uint8_t atomic_fetch_and_or_uint8(uint8_t *p, uint8_t b)
 #endif
 }
 
+ATOMIC_INLINE uint8_t atomic_load_uint8(const uint8_t *v)
+{
+  return __atomic_impl_load_generic(v);
+}
+
+ATOMIC_INLINE void atomic_store_uint8(uint8_t *p, uint8_t v)
+{
+  __atomic_impl_store_generic(p, v);
+}
+
 /* Signed */
 #pragma intrinsic(_InterlockedAnd8)
 ATOMIC_INLINE int8_t atomic_fetch_and_and_int8(int8_t *p, int8_t b)
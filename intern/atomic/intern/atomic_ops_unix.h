@@ -647,6 +647,14 @@ ATOMIC_INLINE uint8_t atomic_fetch_and_or_uint8(uint8_t *p, uint8_t b)
 {
   return __sync_fetch_and_or(p, b);
 }
+ATOMIC_INLINE uint8_t atomic_load_uint8(const uint8_t *v)
+{
+  return __atomic_load_n(v, __ATOMIC_SEQ_CST);
+}
+ATOMIC_INLINE void atomic_store_uint8(uint8_t *p, uint8_t v)
+{
+  __atomic_store(p, &v, __ATOMIC_SEQ_CST);
+}
 
 /* Signed */
 ATOMIC_INLINE int8_t atomic_fetch_and_and_int8(int8_t *p, int8_t b)
@@ -663,6 +671,8 @@ ATOMIC_INLINE int8_t atomic_fetch_and_or_int8(int8_t *p, int8_t b)
 /* Unsigned */
 ATOMIC_LOCKING_FETCH_AND_AND_DEFINE(uint8)
 ATOMIC_LOCKING_FETCH_AND_OR_DEFINE(uint8)
+ATOMIC_LOCKING_LOAD_DEFINE(uint8)
+ATOMIC_LOCKING_STORE_DEFINE(uint8)
 
 /* Signed */
 ATOMIC_LOCKING_FETCH_AND_AND_DEFINE(int8)
@@ -750,6 +750,40 @@ TEST(atomic, atomic_fetch_and_and_uint8)
   }
 }
 
+TEST(atomic, atomic_load_uint8)
+{
+  /* Make sure alias is implemented. */
+  {
+    uint8_t value = 2;
+    EXPECT_EQ(atomic_load_uint8(&value), 2);
+  }
+
+  /* Make sure alias is using proper bitness. */
+  {
+    const uint8_t uint8_t_max = std::numeric_limits<uint8_t>::max();
+    uint8_t value = uint8_t_max;
+    EXPECT_EQ(atomic_load_uint8(&value), uint8_t_max);
+  }
+}
+
+TEST(atomic, atomic_store_uint8)
+{
+  /* Make sure alias is implemented. */
+  {
+    uint8_t value = 0;
+    atomic_store_uint8(&value, 2);
+    EXPECT_EQ(value, 2);
+  }
+
+  /* Make sure alias is using proper bitness. */
+  {
+    const uint8_t uint8_t_max = std::numeric_limits<uint8_t>::max();
+    uint8_t value = 0;
+    atomic_store_uint8(&value, uint8_t_max);
+    EXPECT_EQ(value, uint8_t_max);
+  }
+}
+
 /** \} */
 
 /** \name 8 bit signed int atomics
@@ -1092,6 +1126,23 @@ TEST(atomic, atomic_cas_float)
   }
 }
 
+TEST(atomic, atomic_load_fl)
+{
+  {
+    float value = 1.234f;
+    EXPECT_EQ(atomic_load_fl(&value), 1.234f);
+  }
+}
+
+TEST(atomic, atomic_store_fl)
+{
+  {
+    float value = 0.0f;
+    atomic_store_fl(&value, 2.71f);
+    EXPECT_EQ(value, 2.71f);
+  }
+}
+
 TEST(atomic, atomic_add_and_fetch_fl)
 {
   {
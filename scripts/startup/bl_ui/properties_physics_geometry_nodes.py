@@ -51,6 +51,9 @@ class PHYSICS_PT_geometry_nodes(Panel):
         layout.use_property_decorate = False
         ob = context.object
         layout.prop(ob, "use_simulation_cache", text="Cache", text_ctxt=i18n_contexts.id_simulation)
+        row = layout.row()
+        row.active = ob.use_simulation_cache
+        row.prop(ob, "use_simulation_cache_compression", text="Compress")
 
 
 classes = (
@@ -132,6 +132,25 @@ class EvaluationResult {
   }
 };
 
+/**
+ * Evaluate all F-Curves of the channelbag at the given time, in the order of
+ * `channelbag.fcurves()`. Gives the same values as #evaluate_fcurve.
+ *
+ * This only works on evaluated copies of the Action. Their slots cache the
+ * values of recent times that were evaluated more than once, so strips that are
+ * held, or that are evaluated at an unchanged time, do not evaluate their
+ * F-Curves again. The cache is discarded together with the evaluated copy
+ * whenever the original Action is edited.
+ *
+ * \return false when the Action is not an evaluated copy, in which case
+ * `r_values` is not written.
+ */
+bool evaluate_channelbag_fcurves(const Action &owning_action,
+                                 slot_handle_t slot_handle,
+                                 const Channelbag &channelbag,
+                                 float eval_time,
+                                 MutableSpan<float> r_values);
+
 /**
  * Evaluate the given action for the given slot and animated ID.
  *
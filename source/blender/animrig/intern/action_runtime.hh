@@ -10,10 +10,18 @@
 
 #pragma once
 
+#include <memory>
+
+#include "BLI_array.hh"
+#include "BLI_map.hh"
+#include "BLI_mutex.hh"
 #include "BLI_vector.hh"
 
+#include "BKE_fcurve.hh"
+
 struct ID;
 struct Main;
+struct ActionChannelbag;
 
 namespace blender::animrig {
 
@@ -33,6 +41,42 @@ class SlotRuntime {
    * \note This is NOT thread-safe.
    */
   Vector<ID *> users;
+
+  /**
+   * F-Curves of the slot's channelbags, compiled for batched evaluation of keyframe strips.
+   *
+   * Only used on evaluated copies of the Action. Those are copied again whenever the original
+   * Action changes, which gives them new slot runtime data as well.
+   */
+  Map<const ActionChannelbag *, std::unique_ptr<bke::CompiledFCurves>> compiled_fcurves;
+  Mutex compiled_fcurves_mutex;
+
+  /** F-Curve values of a channelbag, evaluated at one point in time. */
+  struct CachedFCurveValues {
+    const ActionChannelbag *channelbag;
+    float eval_time;
+    Array<float> values;
+  };
+
+  /**
+   * F-Curve values of the slot's channelbags at times that were evaluated more than once, so that
+   * strips that are held, or channelbags evaluated by several users at the same time, don't
+   * evaluate their F-Curves again.
+   *
+   * Only used on evaluated copies of the Action, like #compiled_fcurves. Entries are replaced in
+   * round-robin order once #cached_fcurve_values_max is reached, reusing their value storage.
+   */
+  Vector<CachedFCurveValues> cached_fcurve_values;
+  int cached_fcurve_values_next = 0;
+  /**
+   * Time each channelbag was last evaluated at without being cached. Values are only cached once
+   * the same time is requested again, so regular playback, where every time is evaluated once,
+   * doesn't copy values into the cache.
+   */
+  Map<const ActionChannelbag *, float> uncached_fcurve_eval_times;
+  Mutex cached_fcurve_values_mutex;
+
+  static constexpr int cached_fcurve_values_max = 8;
 };
 
 namespace internal {
@@ -7,10 +7,15 @@
 #include "BKE_animsys.h"
 #include "BKE_fcurve.hh"
 
+#include "BLI_array.hh"
 #include "BLI_map.hh"
+#include "BLI_task.hh"
+
+#include "DNA_ID.h"
 
 #include "CLG_log.h"
 
+#include "action_runtime.hh"
 #include "evaluation_internal.hh"
 
 static CLG_LogRef LOG = {"anim.evaluation"};
@@ -140,7 +145,110 @@ static void animsys_write_orig_anim_rna(PointerRNA *ptr,
   }
 }
 
+/**
+ * Get the compiled F-Curves of the channelbag, building them on first use. Only evaluated copies
+ * of an Action are compiled, as their F-Curves don't change until they are copied again.
+ */
+static const bke::CompiledFCurves *compiled_fcurves_for_channelbag(const Action &owning_action,
+                                                                   const slot_handle_t slot_handle,
+                                                                   const Channelbag &channelbag)
+{
+  if ((owning_action.id.tag & ID_TAG_COPIED_ON_EVAL) == 0) {
+    return nullptr;
+  }
+  const Slot *slot = owning_action.slot_for_handle(slot_handle);
+  if (!slot || !slot->runtime) {
+    return nullptr;
+  }
+  SlotRuntime &runtime = *slot->runtime;
+  std::scoped_lock lock(runtime.compiled_fcurves_mutex);
+  return runtime.compiled_fcurves
+      .lookup_or_add_cb(&channelbag,
+                        [&]() {
+                          /* Compiling runs a parallel loop while the mutex is locked. Isolate it,
+                           * so that this thread does not run another evaluation of the same slot
+                           * while waiting, which would try to lock the mutex again. */
+                          std::unique_ptr<bke::CompiledFCurves> compiled;
+                          threading::isolate_task([&]() {
+                            compiled = std::make_unique<bke::CompiledFCurves>(
+                                channelbag.fcurves());
+                          });
+                          return compiled;
+                        })
+      .get();
+}
+
+bool evaluate_channelbag_fcurves(const Action &owning_action,
+                                 const slot_handle_t slot_handle,
+                                 const Channelbag &channelbag,
+                                 const float eval_time,
+                                 MutableSpan<float> r_values)
+{
+  BLI_assert(r_values.size() == channelbag.fcurves().size());
+
+  const bke::CompiledFCurves *compiled_fcurves = compiled_fcurves_for_channelbag(
+      owning_action, slot_handle, channelbag);
+  if (!compiled_fcurves) {
+    return false;
+  }
+  BLI_assert(compiled_fcurves->size() == r_values.size());
+
+  /* The slot runtime exists, otherwise the F-Curves could not have been compiled. */
+  SlotRuntime &runtime = *owning_action.slot_for_handle(slot_handle)->runtime;
+  const auto find_cached = [&]() -> const SlotRuntime::CachedFCurveValues * {
+    for (const SlotRuntime::CachedFCurveValues &cached : runtime.cached_fcurve_values) {
+      if (cached.channelbag == &channelbag && cached.eval_time == eval_time) {
+        return &cached;
+      }
+    }
+    return nullptr;
+  };
+
+  bool store_values;
+  {
+    std::scoped_lock lock(runtime.cached_fcurve_values_mutex);
+    if (const SlotRuntime::CachedFCurveValues *cached = find_cached()) {
+      r_values.copy_from(cached->values);
+      return true;
+    }
+    /* Only cache times which are evaluated again. During playback every time is usually only
+     * evaluated once, so caching those values would only add copies. */
+    const float *prev_eval_time = runtime.uncached_fcurve_eval_times.lookup_ptr(&channelbag);
+    store_values = prev_eval_time != nullptr && *prev_eval_time == eval_time;
+    if (!store_values) {
+      runtime.uncached_fcurve_eval_times.add_overwrite(&channelbag, eval_time);
+    }
+  }
+
+  compiled_fcurves->evaluate(eval_time, r_values);
+  if (!store_values) {
+    return true;
+  }
+
+  std::scoped_lock lock(runtime.cached_fcurve_values_mutex);
+  if (find_cached()) {
+    /* Cached by another thread in the meantime. */
+    return true;
+  }
+  if (runtime.cached_fcurve_values.size() < SlotRuntime::cached_fcurve_values_max) {
+    runtime.cached_fcurve_values.append({&channelbag, eval_time, r_values.as_span()});
+    return true;
+  }
+  SlotRuntime::CachedFCurveValues &cached =
+      runtime.cached_fcurve_values[runtime.cached_fcurve_values_next];
+  runtime.cached_fcurve_values_next = (runtime.cached_fcurve_values_next + 1) %
+                                      SlotRuntime::cached_fcurve_values_max;
+  cached.channelbag = &channelbag;
+  cached.eval_time = eval_time;
+  if (cached.values.size() != r_values.size()) {
+    cached.values.reinitialize(r_values.size());
+  }
+  cached.values.as_mutable_span().copy_from(r_values);
+  return true;
+}
+
 static EvaluationResult evaluate_keyframe_data(PointerRNA &animated_id_ptr,
+                                               const Action &owning_action,
                                                StripKeyframeData &strip_data,
                                                const slot_handle_t slot_handle,
                                                const AnimationEvalContext &offset_eval_context)
@@ -150,8 +258,18 @@ static EvaluationResult evaluate_keyframe_data(PointerRNA &animated_id_ptr,
     return {};
   }
 
+  /* Evaluate all curves of the channelbag at once when possible. */
+  const Span<FCurve *> fcurves = channelbag_for_slot->fcurves();
+  Array<float> compiled_values(fcurves.size());
+  const bool use_compiled_values = evaluate_channelbag_fcurves(owning_action,
+                                                               slot_handle,
+                                                               *channelbag_for_slot,
+                                                               offset_eval_context.eval_time,
+                                                               compiled_values);
+
   EvaluationResult evaluation_result;
-  for (FCurve *fcu : channelbag_for_slot->fcurves()) {
+  for (const int fcurve_index : fcurves.index_range()) {
+    FCurve *fcu = fcurves[fcurve_index];
     /* Blatant copy of animsys_evaluate_fcurves(). */
 
     if (!is_fcurve_evaluatable(fcu)) {
@@ -172,7 +290,14 @@ static EvaluationResult evaluate_keyframe_data(PointerRNA &animated_id_ptr,
       continue;
     }
 
-    const float curval = calculate_fcurve(&anim_rna, fcu, &offset_eval_context);
+    float curval;
+    if (use_compiled_values) {
+      curval = compiled_values[fcurve_index];
+      fcu->curval = curval; /* Debug display only, see #calculate_fcurve. */
+    }
+    else {
+      curval = calculate_fcurve(&anim_rna, fcu, &offset_eval_context);
+    }
     evaluation_result.store(fcu->rna_path, fcu->array_index, curval, anim_rna);
   }
 
@@ -216,7 +341,8 @@ static EvaluationResult evaluate_strip(PointerRNA &animated_id_ptr,
   switch (strip.type()) {
     case Strip::Type::Keyframe: {
       StripKeyframeData &strip_data = strip.data<StripKeyframeData>(owning_action);
-      return evaluate_keyframe_data(animated_id_ptr, strip_data, slot_handle, offset_eval_context);
+      return evaluate_keyframe_data(
+          animated_id_ptr, owning_action, strip_data, slot_handle, offset_eval_context);
     }
   }
 
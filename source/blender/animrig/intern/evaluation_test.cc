@@ -4,6 +4,7 @@
 
 #include "ANIM_action.hh"
 #include "ANIM_evaluation.hh"
+#include "action_runtime.hh"
 #include "evaluation_internal.hh"
 
 #include "BKE_action.hh"
@@ -282,6 +283,55 @@ TEST_F(AnimationEvaluationTest, strip_boundaries__overlapping_edge)
   EXPECT_TRUE(test_evaluate_layer_no_result("location", 0, 19.001f));
 }
 
+TEST_F(AnimationEvaluationTest, evaluate_channelbag_fcurves__cached)
+{
+  Strip &strip = layer->strip_add(*action, Strip::Type::Keyframe);
+  StripKeyframeData &strip_data = strip.data<StripKeyframeData>(*action);
+  strip_data.keyframe_insert(bmain, *slot, {"location", 0}, {1.0f, 47.0f}, settings);
+  strip_data.keyframe_insert(bmain, *slot, {"location", 0}, {5.0f, 327.0f}, settings);
+  const Channelbag &channelbag = *strip_data.channelbag_for_slot(*slot);
+  const Vector<SlotRuntime::CachedFCurveValues> &cache = slot->runtime->cached_fcurve_values;
+
+  /* Only evaluated copies of the Action are cached. */
+  float value = 0.0f;
+  EXPECT_FALSE(
+      evaluate_channelbag_fcurves(*action, slot->handle, channelbag, 3.0f, {&value, 1}));
+  EXPECT_EQ(0, cache.size());
+
+  action->id.tag |= ID_TAG_COPIED_ON_EVAL;
+
+  /* Times which are evaluated once, like during playback, are not cached. */
+  for (const float frame : {2.0f, 4.0f, 3.0f}) {
+    EXPECT_TRUE(
+        evaluate_channelbag_fcurves(*action, slot->handle, channelbag, frame, {&value, 1}));
+  }
+  EXPECT_FLOAT_EQ(187.0f, value);
+  EXPECT_EQ(0, cache.size());
+
+  /* A time which is evaluated again is cached. */
+  EXPECT_TRUE(evaluate_channelbag_fcurves(*action, slot->handle, channelbag, 3.0f, {&value, 1}));
+  EXPECT_FLOAT_EQ(187.0f, value);
+  EXPECT_EQ(1, cache.size());
+
+  /* Evaluating at the same time again reuses the cached values. */
+  value = 0.0f;
+  EXPECT_TRUE(evaluate_channelbag_fcurves(*action, slot->handle, channelbag, 3.0f, {&value, 1}));
+  EXPECT_FLOAT_EQ(187.0f, value);
+  EXPECT_EQ(1, cache.size());
+
+  /* The number of cached times is limited. */
+  for (int frame = 0; frame < 2 * SlotRuntime::cached_fcurve_values_max; frame++) {
+    for (int repeat = 0; repeat < 2; repeat++) {
+      EXPECT_TRUE(
+          evaluate_channelbag_fcurves(*action, slot->handle, channelbag, frame, {&value, 1}));
+    }
+  }
+  EXPECT_EQ(SlotRuntime::cached_fcurve_values_max, cache.size());
+  EXPECT_FLOAT_EQ(327.0f, value);
+
+  action->id.tag &= ~ID_TAG_COPIED_ON_EVAL;
+}
+
 class AccessibleEvaluationResult : public EvaluationResult {
  public:
   EvaluationMap &get_map()
@@ -8,12 +8,16 @@
  * \ingroup bke
  */
 
+#include <memory>
 #include <optional>
 
+#include "BLI_array.hh"
 #include "BLI_bounds_types.hh"
 #include "BLI_function_ref.hh"
+#include "BLI_implicit_sharing.hh"
 #include "BLI_math_matrix_types.hh"
 #include "BLI_math_vector_types.hh"
+#include "BLI_offset_indices.hh"
 #include "BLI_set.hh"
 
 #include "DNA_armature_types.h"
@@ -641,10 +645,115 @@ void BKE_pose_eval_done(Depsgraph *depsgraph, Object *object);
 
 void BKE_pose_eval_cleanup(Depsgraph *depsgraph, Scene *scene, Object *object);
 
+namespace blender::bke {
+
+/**
+ * Order in which the bones of a pose are evaluated when the whole pose is evaluated by a single
+ * depsgraph operation instead of a few operations per bone, see #BKE_pose_eval_bones_batched.
+ *
+ * Bones are grouped into chains: runs of bones in which every bone only depends on the bone
+ * before it. Chains are grouped into stages: a chain only depends on chains of earlier stages,
+ * so all chains of a stage can be evaluated in parallel.
+ */
+class PoseEvalSchedule : NonCopyable, NonMovable {
+  /* Pose channel indices, ordered by stage and then by chain. */
+  Array<int> bone_indices_;
+  /* Bones of every chain, as ranges of #bone_indices_. */
+  Array<int> chain_offsets_;
+  /* Chains of every stage. */
+  Array<int> stage_offsets_;
+
+ public:
+  /**
+   * Build the schedule for the pose of the given armature object.
+   *
+   * \return Null when the pose is to be evaluated with separate operations per bone. That is the
+   * case for small rigs and whenever bones need to be interleaved with evaluation outside of the
+   * pose: IK solvers, drivers on pose bones and constraints targeting other objects.
+   */
+  static std::unique_ptr<PoseEvalSchedule> create(Object &object);
+
+  Span<int> bone_indices() const
+  {
+    return bone_indices_;
+  }
+  OffsetIndices<int> chains() const
+  {
+    return chain_offsets_.as_span();
+  }
+  OffsetIndices<int> stages() const
+  {
+    return stage_offsets_.as_span();
+  }
+};
+
+}  // namespace blender::bke
+
+/**
+ * Evaluate all bones of the pose following the schedule, replacing the per-bone operations of
+ * #BKE_pose_eval_bone, #BKE_pose_constraints_evaluate, #BKE_pose_bone_done and
+ * #BKE_pose_eval_bbone_segments.
+ */
+void BKE_pose_eval_bones_batched(Depsgraph *depsgraph,
+                                 Scene *scene,
+                                 Object *object,
+                                 const blender::bke::PoseEvalSchedule &schedule);
+
 /* -------------------------------------------------------------------- */
 /** \name Deform 3D Coordinates by Armature (`armature_deform.cc`)
  * \{ */
 
+namespace blender::bke {
+
+/**
+ * Vertex group weights of a mesh in a compact layout for armature deformation. The group index
+ * and weight of every #MDeformWeight are stored in contiguous arrays, the assignments of vertex
+ * `i` being at `offsets[i]` to `offsets[i + 1]`. This avoids following the separately allocated
+ * weight arrays of every vertex and allows blending the bone matrices with SIMD.
+ *
+ * Owned by the armature modifier runtime data and only rebuilt when the vertex group data of the
+ * deformed mesh has changed since the previous evaluation.
+ */
+class ArmatureDeformWeightsCache : NonCopyable, NonMovable {
+  /* Weak user of the vertex group layer data the compact weights were built from. The version of
+   * the sharing info changes whenever that data is modified in place. */
+  const ImplicitSharingInfo *sharing_info_ = nullptr;
+  int64_t sharing_info_version_ = 0;
+  const MDeformVert *dverts_data_ = nullptr;
+
+  Array<int> offsets_;
+  Array<int> def_nrs_;
+  Array<float> weights_;
+
+ public:
+  ArmatureDeformWeightsCache() = default;
+  ~ArmatureDeformWeightsCache();
+
+  /**
+   * Make sure the compact weights match the vertex groups of the mesh.
+   * \return False if the mesh has no vertex groups or they can't be cached.
+   */
+  bool ensure(const Mesh &mesh);
+
+  OffsetIndices<int> offsets() const
+  {
+    return OffsetIndices<int>(offsets_, offset_indices::NoSortCheck());
+  }
+  Span<int> def_nrs() const
+  {
+    return def_nrs_;
+  }
+  Span<float> weights() const
+  {
+    return weights_;
+  }
+
+ private:
+  void clear();
+};
+
+}  // namespace blender::bke
+
 /* Note that we could have a #BKE_armature_deform_coords that doesn't take object data
  * currently there are no callers for this though. */
 
@@ -667,7 +776,8 @@ void BKE_armature_deform_coords_with_mesh(
     std::optional<blender::MutableSpan<blender::float3x3>> vert_deform_mats,
     int deformflag,
     blender::StringRefNull defgrp_name,
-    const Mesh *me_target);
+    const Mesh *me_target,
+    blender::bke::ArmatureDeformWeightsCache *weights_cache = nullptr);
 
 void BKE_armature_deform_coords_with_editmesh(
     const Object &ob_arm,
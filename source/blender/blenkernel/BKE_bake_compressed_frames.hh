@@ -0,0 +1,106 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ *
+ * Compact in-memory storage for the frames of a simulation cache.
+ *
+ * Frames are serialized with the same format that is used for bakes, but the binary data is kept
+ * in memory and compressed. Arrays that did not change since they were stored for an earlier frame
+ * are only stored once. Arrays that did change are stored as the difference to the corresponding
+ * array of the previous frame, which is usually small and compresses well for simulations that
+ * move a persistent set of elements. Every few frames a keyframe is stored without differences,
+ * to limit the number of frames that have to be decoded to restore a single frame.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "BLI_array.hh"
+#include "BLI_map.hh"
+#include "BLI_mutex.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_bake_items.hh"
+#include "BKE_bake_items_serialize.hh"
+
+struct TaskPool;
+
+namespace blender::bke::bake {
+
+class CompressedFrameStore : NonCopyable, NonMovable {
+ private:
+  /** Data passed to a single #BlobWriter::write call. */
+  struct Blob {
+    /** Compressed data, the difference to #base_blob if that is set. */
+    Array<std::byte> compressed;
+    int64_t size = 0;
+    /** Blob of the previous frame that this blob is stored relative to. */
+    std::optional<int> base_blob;
+  };
+
+  struct Frame {
+    /** Compressed serialized meta data of the #BakeState. */
+    Array<std::byte> meta_compressed;
+    int64_t meta_size = 0;
+    /** Blobs that were written for this frame. The frame may also reference older blobs. */
+    IndexRange blobs;
+  };
+
+  class Writer;
+  class Reader;
+
+  mutable Mutex mutex_;
+  Vector<Blob> blobs_;
+  Vector<Frame> frames_;
+  BlobWriteSharing write_sharing_;
+  /** Uncompressed blobs of the last stored frame, the base for differences of the next frame. */
+  Vector<Array<std::byte>> last_frame_blobs_;
+  /** Decoded blobs that were used by the last loaded frame, by blob index. */
+  Map<int, Array<std::byte>> decoded_blobs_;
+  /** Frame that was decoded ahead of time by #prefetch. */
+  std::optional<std::pair<int, BakeState>> prefetched_;
+  TaskPool *prefetch_pool_ = nullptr;
+  int64_t compressed_size_ = 0;
+  int64_t uncompressed_size_ = 0;
+
+ public:
+  /** Number of frames between frames that are stored without differences to the previous one. */
+  static constexpr int keyframe_interval = 16;
+
+  CompressedFrameStore() = default;
+  ~CompressedFrameStore();
+
+  /**
+   * Compress the state and add it as the next frame.
+   * \return Index of the new frame.
+   */
+  int add(const BakeState &state);
+
+  /** Decompress the frame at the given index. */
+  std::optional<BakeState> load(int frame_index);
+
+  /**
+   * Start decompressing the frame in the background, so that a later call to #load for the same
+   * frame can return it right away. Does nothing if the frame is decompressed already.
+   */
+  void prefetch(int frame_index);
+
+  int frames_num() const;
+
+  /** Memory used by the compressed data in bytes. */
+  int64_t compressed_size() const;
+  /** Size of all stored data before compression in bytes. */
+  int64_t uncompressed_size() const;
+
+ private:
+  std::optional<BakeState> load_locked(int frame_index);
+  const Array<std::byte> &decode_blob(int blob_index, Map<int, Array<std::byte>> &decoded);
+  void wait_for_prefetch();
+};
+
+}  // namespace blender::bke::bake
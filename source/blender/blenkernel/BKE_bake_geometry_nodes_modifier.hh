@@ -11,6 +11,7 @@
 #include "BLI_mutex.hh"
 #include "BLI_sub_frame.hh"
 
+#include "BKE_bake_compressed_frames.hh"
 #include "BKE_bake_items.hh"
 #include "BKE_bake_items_paths.hh"
 #include "BKE_bake_items_serialize.hh"
@@ -47,6 +48,19 @@ struct FrameCache {
    * or from an in-memory buffer.
    */
   std::optional<std::variant<std::string, Span<std::byte>>> meta_data_source;
+  /**
+   * Index in #NodeBakeCache::compressed_frames when the state is stored compressed. The #state is
+   * empty then.
+   */
+  std::optional<int> compressed_index;
+  /**
+   * State of a compressed frame while it is decompressed. It is shared with the evaluations that
+   * read it, so that it stays alive when the cache frees it in the mean time.
+   */
+  std::shared_ptr<const BakeState> decompressed_state;
+
+  /** The state of the frame, see #NodeBakeCache::ensure_frame_decompressed. */
+  BakeStateRef state_ref() const;
 };
 
 /**
@@ -75,9 +89,30 @@ struct NodeBakeCache {
   /** Used to avoid checking if a bake exists many times. */
   bool failed_finding_bake = false;
 
+  /** Compressed states of frames in #frames, when the frame cache is compressed. */
+  std::unique_ptr<CompressedFrameStore> compressed_frames;
+  /** Indices of compressed frames that are decompressed currently, least recently used first. */
+  Vector<int> decompressed_frames;
+
   /** Range spanning from the first to the last baked frame. */
   IndexRange frame_range() const;
 
+  /**
+   * Move the state of the frame into #compressed_frames. Used for frames that are not needed for
+   * the next simulation step anymore.
+   */
+  void compress_frame(int frame_index);
+
+  /**
+   * Make sure that the state of a compressed frame is available in
+   * #FrameCache::decompressed_state. Only a few frames are kept decompressed at the same time, the
+   * cache releases the state of the frame that was not used for the longest time when necessary.
+   */
+  void ensure_frame_decompressed(int frame_index);
+
+  /** Start decompressing the frame in the background when it is compressed. */
+  void prefetch_frame(int frame_index);
+
   void reset();
 };
 
@@ -50,9 +50,15 @@ struct BakeState {
 /** Same as #BakeState, but does not own the bake items. */
 struct BakeStateRef {
   Map<int, const BakeItem *> items_by_id;
+  /**
+   * Keeps the items alive when the referenced state may be freed by its cache while it is still
+   * read, e.g. a decompressed frame that is evicted by another evaluation.
+   */
+  std::shared_ptr<const BakeState> owner;
 
   BakeStateRef() = default;
   BakeStateRef(const BakeState &bake_state);
+  BakeStateRef(std::shared_ptr<const BakeState> bake_state);
 };
 
 class GeometryBakeItem : public BakeItem {
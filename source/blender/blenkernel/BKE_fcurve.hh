@@ -8,9 +8,14 @@
  * \ingroup bke
  */
 
+#include <atomic>
+#include <memory>
+
+#include "BLI_array.hh"
 #include "BLI_math_vector_types.hh"
 #include "BLI_span.hh"
 #include "BLI_string_ref.hh"
+#include "BLI_utility_mixins.hh"
 
 #include "DNA_curve_types.h"
 
@@ -618,6 +623,73 @@ float calculate_fcurve(PathResolvedRNA *anim_rna,
                        FCurve *fcu,
                        const AnimationEvalContext *anim_eval_context);
 
+namespace blender::bke {
+
+/**
+ * Key-framed F-Curves compiled into contiguous tables of keyframe segments, to evaluate many
+ * curves at once. Gives the same values as #evaluate_fcurve.
+ *
+ * The shape of every segment is precomputed: linear interpolation factors, corrected Bezier
+ * handles as polynomial coefficients and the slopes of the extrapolation. The key used by the
+ * last evaluation of each curve is remembered, so sequential playback rarely has to search for
+ * it. Curves which can't be compiled (with modifiers, sampled points, easing interpolation or
+ * unsorted keys) fall back to #evaluate_fcurve.
+ *
+ * The compiled data references the F-Curves and has to be rebuilt when they change.
+ */
+class CompiledFCurves : NonCopyable, NonMovable {
+ public:
+  enum class SegmentType : int8_t {
+    /** Value of the key at the start of the segment. */
+    Constant,
+    /** Coefficients are `(begin, change, duration, -)`, like #BLI_easing_linear_ease. */
+    Linear,
+    /** Coefficients of the value polynomial, the X polynomial is solved for the parameter. */
+    Bezier,
+  };
+
+ private:
+  Array<const FCurve *> fcurves_;
+  /** Curves which are evaluated with #evaluate_fcurve. */
+  Array<bool> use_generic_;
+  /** Round the value to integers, for #FCURVE_INT_VALUES. */
+  Array<bool> use_int_values_;
+
+  /** Range of the keys of every curve in the arrays below. */
+  Array<int> key_offsets_;
+  Array<float> key_times_;
+  Array<float> key_values_;
+  /** Segment starting at every key. The entry of the last key of a curve is unused. */
+  Array<SegmentType> segment_types_;
+  Array<float4> segment_coefficients_;
+  /** Start, and X polynomial coefficients of Bezier segments, see `findzero`. */
+  Array<float4> segment_bezier_x_;
+  /** Slope of the extrapolation before the first and after the last key of every curve. */
+  Array<float2> extrapolation_slopes_;
+
+  /** Index of the key starting the segment that was last evaluated, for every curve. */
+  std::unique_ptr<std::atomic<int>[]> last_segment_;
+
+ public:
+  explicit CompiledFCurves(Span<const FCurve *> fcurves);
+
+  int size() const
+  {
+    return fcurves_.size();
+  }
+
+  /**
+   * Evaluate all curves at the given time. Safe to call from multiple threads at the same time.
+   */
+  void evaluate(float evaltime, MutableSpan<float> r_values) const;
+
+ private:
+  bool compile_curve(int curve_index);
+  int find_segment(int curve_index, float evaltime) const;
+};
+
+}  // namespace blender::bke
+
 /* ************* F-Curve Samples API ******************** */
 
 /* -------- Defines -------- */
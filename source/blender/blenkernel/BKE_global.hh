@@ -272,6 +272,14 @@ enum {
 
   G_DEBUG_GHOST = (1 << 24),  /* Debug GHOST module. */
   G_DEBUG_WINTAB = (1 << 25), /* Debug Wintab. */
+
+  /* Record the timeline of depsgraph evaluations, written to the file given on the command line
+   * or with `Depsgraph.debug_eval_trace()`. Not part of #G_DEBUG_DEPSGRAPH, as it keeps the
+   * recorded events in memory until they are written. */
+  G_DEBUG_DEPSGRAPH_TRACE = (1 << 26),
+  /* Always rebuild depsgraph relations from scratch, instead of only rebuilding the relations of
+   * the edited objects. */
+  G_DEBUG_DEPSGRAPH_NO_INCREMENTAL = (1 << 27),
 };
 
 #define G_DEBUG_ALL \
@@ -0,0 +1,97 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bke
+ *
+ * Sharing of evaluated meshes between dependency graphs.
+ *
+ * Active viewport dependency graphs offer the meshes they evaluate, and render dependency graphs
+ * reuse them instead of evaluating the modifier stack again, when the evaluation gives the same
+ * result in both modes. The shared meshes are shallow copies, so the attribute arrays are shared
+ * between the dependency graphs with implicit sharing instead of being duplicated.
+ *
+ * A shared mesh is only reused while its source dependency graph is fully evaluated at the same
+ * frame: any update tagged in the source makes all its meshes unavailable until it is evaluated
+ * again, and meshes of objects tagged for update are removed when the tags are flushed.
+ *
+ * The viewport doesn't copy anything while it is evaluated. The meshes are collected from it on
+ * demand, right before a render dependency graph which reuses them is evaluated.
+ */
+
+#include <cstdint>
+
+#include "BLI_span.hh"
+
+struct CustomData_MeshMasks;
+struct Depsgraph;
+struct Mesh;
+struct Object;
+struct Scene;
+
+namespace blender::bke {
+
+/**
+ * Register a render dependency graph which looks up shared meshes. The stored meshes are removed
+ * when the last one is unregistered.
+ */
+void mesh_eval_share_consumer_add();
+/** A dependency graph registered with #mesh_eval_share_consumer_add is freed. */
+void mesh_eval_share_consumer_remove();
+
+/**
+ * Store the meshes of all source dependency graphs which are fully evaluated at the current frame
+ * of the scene. Called by a consumer right before it is evaluated.
+ */
+void mesh_eval_share_collect(const Scene &scene);
+
+/**
+ * Offer the mesh evaluated for the object to other dependency graphs. Does nothing when the
+ * dependency graph or the object can not be used as source.
+ */
+void mesh_eval_share_store(const Depsgraph &depsgraph,
+                           const Object &object,
+                           const Mesh &mesh_final,
+                           const Mesh *mesh_deform,
+                           const CustomData_MeshMasks &data_mask,
+                           bool need_mapping);
+
+/**
+ * Get a copy of the mesh evaluated for the object by another dependency graph, if it is the same
+ * as the result of evaluating the object in this dependency graph.
+ *
+ * \param r_data_mask: Is set to the data mask the shared mesh was evaluated with, which contains
+ * at least the requested one.
+ * \return False when there is no compatible mesh, the output arguments are unchanged then.
+ */
+bool mesh_eval_share_lookup(const Depsgraph &depsgraph,
+                            Object &object,
+                            const CustomData_MeshMasks &data_mask,
+                            Mesh **r_mesh_final,
+                            Mesh **r_mesh_deform,
+                            CustomData_MeshMasks *r_data_mask,
+                            bool *r_need_mapping);
+
+/**
+ * The dependency graph was tagged for an update, its meshes are outdated until evaluated. Only
+ * needs to be called for the first tag after an evaluation.
+ */
+void mesh_eval_share_source_tag_update(const Depsgraph *depsgraph);
+
+/**
+ * The dependency graph finished evaluating all its tagged updates at the given time. Active
+ * viewport dependency graphs become sources for #mesh_eval_share_collect.
+ */
+void mesh_eval_share_source_evaluated(const Depsgraph *depsgraph, float ctime);
+
+/** Remove the meshes shared for objects which are tagged for update. */
+void mesh_eval_share_source_invalidate(const Depsgraph *depsgraph,
+                                       Span<uint32_t> object_session_uids);
+
+/** Remove all meshes shared by the dependency graph, which is about to be freed. */
+void mesh_eval_share_source_remove(const Depsgraph *depsgraph);
+
+}  // namespace blender::bke
@@ -0,0 +1,63 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ *
+ * Evaluation of several frames of a scene at the same time, for exporters and other tools that
+ * step through every frame of an animation.
+ */
+
+#pragma once
+
+#include "BLI_function_ref.hh"
+#include "BLI_span.hh"
+#include "BLI_utility_mixins.hh"
+#include "BLI_vector.hh"
+
+struct Depsgraph;
+
+namespace blender::bke {
+
+/**
+ * Evaluates the frames of an animation in batches, on the given depsgraph and on lightweight
+ * copies of it which use the same #Main, scene and view layer. Every depsgraph of a batch is
+ * evaluated concurrently, after which the frames are handed out one after another in order.
+ *
+ * Frames are evaluated one after another on the depsgraph itself, exactly like
+ * #BKE_scene_graph_update_for_newframe does, when that is not safe or not worth it: with few
+ * threads, when scripts registered frame change handlers, or when the scene contains point caches.
+ * Concurrently evaluated frames do not change the current frame of the scene and do not run the
+ * frame change handlers.
+ */
+class SceneFrameBatchEvaluator : NonCopyable, NonMovable {
+  Depsgraph *depsgraph_;
+  Vector<Depsgraph *> copies_;
+
+ public:
+  /**
+   * \param frames_num: Number of frames that are going to be evaluated, used to avoid creating
+   * copies that would not be used.
+   * \param build_fn: Builds the relations of a copy in the same way as those of `depsgraph`.
+   *
+   * Like building the depsgraph itself, this has to be called from the main thread.
+   */
+  SceneFrameBatchEvaluator(Depsgraph *depsgraph,
+                           int frames_num,
+                           FunctionRef<void(Depsgraph *depsgraph)> build_fn);
+  ~SceneFrameBatchEvaluator();
+
+  /** Number of frames that are evaluated at the same time. */
+  int batch_size() const;
+
+  /**
+   * Evaluate all frames and call `frame_fn` in order with the depsgraph that was evaluated for
+   * each of them. Evaluation stops when `frame_fn` returns false. The depsgraph itself is always
+   * evaluated for the last frame that was handed out.
+   */
+  void evaluate(Span<double> frames,
+                FunctionRef<bool(Depsgraph *depsgraph, double frame)> frame_fn);
+};
+
+}  // namespace blender::bke
@@ -14,6 +14,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_bit_vector.hh"
 #include "BLI_listbase.h"
 #include "BLI_listbase_wrapper.hh"
@@ -2660,7 +2661,25 @@ static void nlasnapshot_from_action(PointerRNA *ptr,
   const float modified_evaltime = evaluate_time_fmodifiers(
       &storage, modifiers, nullptr, 0.0f, evaltime);
 
-  for (const FCurve *fcu : animrig::legacy::fcurves_for_action_slot(action, slot_handle)) {
+  const Vector<FCurve *> fcurves = animrig::legacy::fcurves_for_action_slot(action, slot_handle);
+
+  /* Layered Actions get the F-Curve values from the cache of the evaluated Action, so strips that
+   * are held or evaluated at an unchanged time don't evaluate their F-Curves again. The value
+   * modifiers of the strips are applied afterwards, as they are not part of the cache. */
+  Array<float> cached_values;
+  bool use_cached_values = false;
+  if (action->wrap().is_action_layered()) {
+    const animrig::Channelbag *channelbag = animrig::channelbag_for_action_slot(action->wrap(),
+                                                                               slot_handle);
+    if (channelbag && channelbag->fcurves().size() == fcurves.size()) {
+      cached_values.reinitialize(fcurves.size());
+      use_cached_values = animrig::evaluate_channelbag_fcurves(
+          action->wrap(), slot_handle, *channelbag, modified_evaltime, cached_values);
+    }
+  }
+
+  for (const int fcurve_index : fcurves.index_range()) {
+    const FCurve *fcu = fcurves[fcurve_index];
     if (!is_fcurve_evaluatable(fcu)) {
       continue;
     }
@@ -2678,7 +2697,8 @@ static void nlasnapshot_from_action(PointerRNA *ptr,
 
     NlaEvalChannelSnapshot *necs = nlaeval_snapshot_ensure_channel(r_snapshot, nec);
 
-    float value = evaluate_fcurve(fcu, modified_evaltime);
+    float value = use_cached_values ? cached_values[fcurve_index] :
+                                      evaluate_fcurve(fcu, modified_evaltime);
     evaluate_value_fmodifiers(&storage, modifiers, fcu, &value, evaltime);
     necs->values[fcu->array_index] = value;
 
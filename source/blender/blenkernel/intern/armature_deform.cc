@@ -22,6 +22,7 @@
 #include "BLI_math_quaternion.hh"
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
+#include "BLI_simd.hh"
 #include "BLI_task.h"
 #include "BLI_task.hh"
 
@@ -196,6 +197,114 @@ template<bool full_deform> struct BoneDeformDualQuaternionMixer {
   }
 };
 
+#if BLI_HAVE_SSE2
+
+/**
+ * Same as #BoneDeformLinearMixer, with the columns of the bone matrices blended in SIMD
+ * registers. B-Bone segments are not supported.
+ */
+template<bool full_deform> struct BoneDeformLinearMixerSIMD {
+  __m128 position_delta = _mm_setzero_ps();
+  __m128 deform[3] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+
+  void accumulate(const bPoseChannel &pchan, const float3 &co, const float weight)
+  {
+    const __m128 col0 = _mm_loadu_ps(pchan.chan_mat[0]);
+    const __m128 col1 = _mm_loadu_ps(pchan.chan_mat[1]);
+    const __m128 col2 = _mm_loadu_ps(pchan.chan_mat[2]);
+    const __m128 col3 = _mm_loadu_ps(pchan.chan_mat[3]);
+    const __m128 position = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(col0, _mm_set1_ps(co.x)), _mm_mul_ps(col1, _mm_set1_ps(co.y))),
+        _mm_add_ps(_mm_mul_ps(col2, _mm_set1_ps(co.z)), col3));
+    const __m128 co_v = _mm_setr_ps(co.x, co.y, co.z, 0.0f);
+    const __m128 weight_v = _mm_set1_ps(weight);
+
+    position_delta = _mm_add_ps(position_delta, _mm_mul_ps(weight_v, _mm_sub_ps(position, co_v)));
+    if constexpr (full_deform) {
+      deform[0] = _mm_add_ps(deform[0], _mm_mul_ps(weight_v, col0));
+      deform[1] = _mm_add_ps(deform[1], _mm_mul_ps(weight_v, col1));
+      deform[2] = _mm_add_ps(deform[2], _mm_mul_ps(weight_v, col2));
+    }
+  }
+
+  void finalize(const float3 & /*co*/,
+                float total,
+                float armature_weight,
+                float3 &r_delta_co,
+                float3x3 &r_deform_mat)
+  {
+    const __m128 scale_factor = _mm_set1_ps(armature_weight / total);
+    float4 result;
+    _mm_storeu_ps(result, _mm_mul_ps(position_delta, scale_factor));
+    r_delta_co = result.xyz();
+    if constexpr (full_deform) {
+      for (const int col : IndexRange(3)) {
+        _mm_storeu_ps(result, _mm_mul_ps(deform[col], scale_factor));
+        r_deform_mat[col] = result.xyz();
+      }
+    }
+  };
+};
+
+/**
+ * Same as #BoneDeformDualQuaternionMixer, with the rotation and translation parts blended in SIMD
+ * registers. Only bones without scale are supported, for which the pivot has no effect.
+ */
+template<bool full_deform> struct BoneDeformDualQuaternionMixerSIMD {
+  __m128 quat = _mm_setzero_ps();
+  __m128 trans = _mm_setzero_ps();
+
+  static float dot_v4(const __m128 a, const __m128 b)
+  {
+    const __m128 mul = _mm_mul_ps(a, b);
+    const __m128 sum = _mm_add_ps(mul, _mm_shuffle_ps(mul, mul, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(_mm_add_ss(sum, _mm_movehl_ps(sum, sum)));
+  }
+
+  void accumulate(const bPoseChannel &pchan, const float3 & /*co*/, const float weight)
+  {
+    const DualQuat &deform_quat = pchan.runtime.deform_dual_quat;
+    BLI_assert(deform_quat.scale_weight == 0.0f);
+
+    const __m128 bone_quat = _mm_loadu_ps(deform_quat.quat);
+    /* Make sure we interpolate quaternions in the right direction, see #add_weighted_dq_dq. */
+    const __m128 weight_v = _mm_set1_ps(dot_v4(bone_quat, quat) < 0.0f ? -weight : weight);
+    quat = _mm_add_ps(quat, _mm_mul_ps(weight_v, bone_quat));
+    trans = _mm_add_ps(trans, _mm_mul_ps(weight_v, _mm_loadu_ps(deform_quat.trans)));
+  }
+
+  void finalize(const float3 &co,
+                float total,
+                float armature_weight,
+                float3 &r_delta_co,
+                float3x3 &r_deform_mat)
+  {
+    DualQuat dq = {};
+    _mm_storeu_ps(dq.quat, quat);
+    _mm_storeu_ps(dq.trans, trans);
+    normalize_dq(&dq, total);
+    float3 dco = co;
+    float3x3 dmat;
+    mul_v3m3_dq(dco, full_deform ? dmat.ptr() : nullptr, &dq);
+    r_delta_co = (dco - co) * armature_weight;
+    if constexpr (full_deform) {
+      r_deform_mat = dmat;
+    }
+  }
+};
+
+template<bool full_deform> using CompactLinearMixer = BoneDeformLinearMixerSIMD<full_deform>;
+template<bool full_deform>
+using CompactDualQuaternionMixer = BoneDeformDualQuaternionMixerSIMD<full_deform>;
+
+#else
+
+template<bool full_deform> using CompactLinearMixer = BoneDeformLinearMixer<full_deform>;
+template<bool full_deform>
+using CompactDualQuaternionMixer = BoneDeformDualQuaternionMixer<full_deform>;
+
+#endif
+
 /* Add interpolated deformation along a b-bone segment of the pose channel. */
 template<typename MixerT>
 static void b_bone_deform(const bPoseChannel &pchan,
@@ -269,6 +378,84 @@ static float pchan_bone_deform(const bPoseChannel &pchan,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Compact Vertex Group Weights
+ * \{ */
+
+namespace blender::bke {
+
+ArmatureDeformWeightsCache::~ArmatureDeformWeightsCache()
+{
+  this->clear();
+}
+
+void ArmatureDeformWeightsCache::clear()
+{
+  if (sharing_info_) {
+    sharing_info_->remove_weak_user_and_delete_if_last();
+    sharing_info_ = nullptr;
+  }
+  dverts_data_ = nullptr;
+  offsets_.reinitialize(0);
+  def_nrs_.reinitialize(0);
+  weights_.reinitialize(0);
+}
+
+bool ArmatureDeformWeightsCache::ensure(const Mesh &mesh)
+{
+  const int layer_index = CustomData_get_layer_index(&mesh.vert_data, CD_MDEFORMVERT);
+  if (layer_index == -1) {
+    this->clear();
+    return false;
+  }
+  const CustomDataLayer &layer = mesh.vert_data.layers[layer_index];
+  if (layer.sharing_info == nullptr) {
+    /* Changes of the data can't be detected. */
+    this->clear();
+    return false;
+  }
+  const MDeformVert *dverts_data = static_cast<const MDeformVert *>(layer.data);
+  if (layer.sharing_info == sharing_info_ && dverts_data == dverts_data_ &&
+      layer.sharing_info->version() == sharing_info_version_ &&
+      offsets_.size() == mesh.verts_num + 1)
+  {
+    return true;
+  }
+
+  this->clear();
+  sharing_info_ = layer.sharing_info;
+  sharing_info_->add_weak_user();
+  sharing_info_version_ = sharing_info_->version();
+  dverts_data_ = dverts_data;
+
+  const Span<MDeformVert> dverts(dverts_data, mesh.verts_num);
+  offsets_.reinitialize(dverts.size() + 1);
+  threading::parallel_for(dverts.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      offsets_[i] = dverts[i].totweight;
+    }
+  });
+  const OffsetIndices<int> offsets = offset_indices::accumulate_counts_to_offsets(offsets_);
+
+  def_nrs_.reinitialize(offsets.total_size());
+  weights_.reinitialize(offsets.total_size());
+  threading::parallel_for(dverts.index_range(), 1024, [&](const IndexRange range) {
+    for (const int i : range) {
+      const IndexRange vert_weights = offsets[i];
+      const Span<MDeformWeight> dweights(dverts[i].dw, dverts[i].totweight);
+      for (const int j : dweights.index_range()) {
+        def_nrs_[vert_weights[j]] = dweights[j].def_nr;
+        weights_[vert_weights[j]] = dweights[j].weight;
+      }
+    }
+  });
+  return true;
+}
+
+}  // namespace blender::bke
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Armature Deform #BKE_armature_deform_coords API
  *
@@ -277,6 +464,16 @@ static float pchan_bone_deform(const bPoseChannel &pchan,
 
 namespace blender::bke {
 
+/* How the bone of a vertex group is applied when using compact vertex group weights. */
+enum class CompactBoneDeform : int8_t {
+  /* The vertex group has no deforming bone. */
+  None,
+  /* Only the bone matrix or dual quaternion is needed, which is done with the SIMD mixers. */
+  Simple,
+  /* B-Bone segments, envelope distance or scale need the generic code path. */
+  Generic,
+};
+
 struct ArmatureDeformParams {
   MutableSpan<float3> vert_coords;
   std::optional<MutableSpan<float3x3>> vert_deform_mats;
@@ -294,6 +491,9 @@ struct ArmatureDeformParams {
    * Vertex groups used for deform can be different from the target object vertex groups list,
    * the def_nr needs to be mapped to the correct pose channel first. */
   Array<bPoseChannel *> pose_channel_by_vertex_group;
+  /* Deform method for each bone of #pose_channel_by_vertex_group, only initialized when compact
+   * vertex group weights are used. */
+  Array<CompactBoneDeform> compact_deform_by_vertex_group;
 
   float4x4 target_to_armature;
   float4x4 armature_to_target;
@@ -358,6 +558,89 @@ static ArmatureDeformParams get_armature_deform_params(
   return deform_params;
 }
 
+static void init_compact_bone_deform(ArmatureDeformParams &params, const bool use_quaternion)
+{
+  const Span<bPoseChannel *> pose_channels = params.pose_channel_by_vertex_group;
+  params.compact_deform_by_vertex_group.reinitialize(pose_channels.size());
+  for (const int def_nr : pose_channels.index_range()) {
+    const bPoseChannel *pchan = pose_channels[def_nr];
+    CompactBoneDeform &deform = params.compact_deform_by_vertex_group[def_nr];
+    if (pchan == nullptr) {
+      deform = CompactBoneDeform::None;
+      continue;
+    }
+    const Bone *bone = pchan->bone;
+    const bool use_bbone = bone->segments > 1 && pchan->runtime.bbone_segments == bone->segments;
+    const bool use_scale = use_quaternion && pchan->runtime.deform_dual_quat.scale_weight != 0.0f;
+    deform = (use_bbone || use_scale || (bone->flag & BONE_MULT_VG_ENV)) ?
+                 CompactBoneDeform::Generic :
+                 CompactBoneDeform::Simple;
+  }
+}
+
+/**
+ * Compute the overall influence of the armature on a vertex, which can change by masking with a
+ * vertex group. Returns false when the vertex is not to be changed at all.
+ */
+static bool get_vert_armature_weight(const ArmatureDeformParams &params,
+                                     const std::optional<float> mask_weight,
+                                     float &r_armature_weight,
+                                     float &r_prevco_weight)
+{
+  r_armature_weight = 1.0f;
+  r_prevco_weight = 0.0f; /* weight for optional cached vertexcos */
+  if (!mask_weight) {
+    return true;
+  }
+  /* On multi-modifier the mask is used to blend with previous coordinates. */
+  if (params.vert_coords_prev) {
+    r_prevco_weight = params.invert_vgroup ? *mask_weight : 1.0f - *mask_weight;
+    return r_prevco_weight != 1.0f;
+  }
+  r_armature_weight = params.invert_vgroup ? 1.0f - *mask_weight : *mask_weight;
+  return r_armature_weight != 0.0f;
+}
+
+/* Apply the accumulated bone deformations to the vertex, `co` being in armature space. */
+template<typename MixerT>
+static void armature_vert_finalize(const ArmatureDeformParams &params,
+                                   const int i,
+                                   float3 co,
+                                   const float contrib,
+                                   const float armature_weight,
+                                   const float prevco_weight,
+                                   MixerT &mixer)
+{
+  const bool full_deform = params.vert_deform_mats.has_value();
+
+  /* TODO Actually should be EPSILON? Weight values and contrib can be like 10e-39 small. */
+  constexpr float contrib_threshold = 0.0001f;
+  if (contrib > contrib_threshold) {
+    float3 delta_co;
+    float3x3 local_deform_mat;
+    mixer.finalize(co, contrib, armature_weight, delta_co, local_deform_mat);
+
+    co += delta_co;
+    if (full_deform) {
+      float3x3 &deform_mat = (*params.vert_deform_mats)[i];
+      const float3x3 armature_to_target = params.armature_to_target.view<3, 3>();
+      const float3x3 target_to_armature = params.target_to_armature.view<3, 3>();
+      deform_mat = armature_to_target * local_deform_mat * target_to_armature * deform_mat;
+    }
+  }
+
+  /* Transform back to target object space. */
+  co = math::transform_point(params.armature_to_target, co);
+
+  /* Multi-modifier: Interpolate with previous modifier position using the vertex group mask. */
+  if (params.vert_coords_prev) {
+    copy_v3_v3(params.vert_coords[i], math::interpolate(co, params.vert_coords[i], prevco_weight));
+  }
+  else {
+    copy_v3_v3(params.vert_coords[i], co);
+  }
+}
+
 /* Accumulate bone deformations using the mixer implementation. */
 template<typename MixerT>
 static void armature_vert_task_with_mixer(const ArmatureDeformParams &params,
@@ -365,26 +648,14 @@ static void armature_vert_task_with_mixer(const ArmatureDeformParams &params,
                                           const MDeformVert *dvert,
                                           MixerT &mixer)
 {
-  const bool full_deform = params.vert_deform_mats.has_value();
-
-  /* Overall influence, can change by masking with a vertex group. */
-  float armature_weight = 1.0f;
-  float prevco_weight = 0.0f; /* weight for optional cached vertexcos */
+  std::optional<float> mask_weight;
   if (params.armature_def_nr != -1 && dvert) {
-    const float mask_weight = BKE_defvert_find_weight(dvert, params.armature_def_nr);
-    /* On multi-modifier the mask is used to blend with previous coordinates. */
-    if (params.vert_coords_prev) {
-      prevco_weight = params.invert_vgroup ? mask_weight : 1.0f - mask_weight;
-      if (prevco_weight == 1.0f) {
-        return;
-      }
-    }
-    else {
-      armature_weight = params.invert_vgroup ? 1.0f - mask_weight : mask_weight;
-      if (armature_weight == 0.0f) {
-        return;
-      }
-    }
+    mask_weight = BKE_defvert_find_weight(dvert, params.armature_def_nr);
+  }
+  float armature_weight;
+  float prevco_weight;
+  if (!get_vert_armature_weight(params, mask_weight, armature_weight, prevco_weight)) {
+    return;
   }
 
   /* Input coordinates to start from. */
@@ -433,32 +704,76 @@ static void armature_vert_task_with_mixer(const ArmatureDeformParams &params,
     }
   }
 
-  /* TODO Actually should be EPSILON? Weight values and contrib can be like 10e-39 small. */
-  constexpr float contrib_threshold = 0.0001f;
-  if (contrib > contrib_threshold) {
-    float3 delta_co;
-    float3x3 local_deform_mat;
-    mixer.finalize(co, contrib, armature_weight, delta_co, local_deform_mat);
+  armature_vert_finalize(params, i, co, contrib, armature_weight, prevco_weight, mixer);
+}
 
-    co += delta_co;
-    if (full_deform) {
-      float3x3 &deform_mat = (*params.vert_deform_mats)[i];
-      const float3x3 armature_to_target = params.armature_to_target.view<3, 3>();
-      const float3x3 target_to_armature = params.target_to_armature.view<3, 3>();
-      deform_mat = armature_to_target * local_deform_mat * target_to_armature * deform_mat;
+/**
+ * Same as #armature_vert_task_with_mixer, using the compact vertex group weights of the vertex.
+ * Returns false without changing the vertex when a bone needs the generic code path.
+ */
+template<typename MixerT>
+static bool armature_vert_task_compact_with_mixer(const ArmatureDeformParams &params,
+                                                  const int i,
+                                                  const Span<int> def_nrs,
+                                                  const Span<float> weights,
+                                                  MixerT &mixer)
+{
+  const Span<CompactBoneDeform> bone_deforms = params.compact_deform_by_vertex_group;
+
+  std::optional<float> mask_weight;
+  if (params.armature_def_nr != -1) {
+    mask_weight = 0.0f;
+  }
+  bool mask_weight_found = false;
+  bool deformed = false;
+  for (const int j : def_nrs.index_range()) {
+    const int def_nr = def_nrs[j];
+    if (def_nr == params.armature_def_nr && !mask_weight_found) {
+      mask_weight = weights[j];
+      mask_weight_found = true;
+    }
+    if (!bone_deforms.index_range().contains(def_nr)) {
+      continue;
+    }
+    switch (bone_deforms[def_nr]) {
+      case CompactBoneDeform::None:
+        break;
+      case CompactBoneDeform::Simple:
+        deformed = true;
+        break;
+      case CompactBoneDeform::Generic:
+        return false;
     }
   }
+  /* Envelopes are only used when no bone deformed the vertex. */
+  if (!deformed && params.use_envelope) {
+    return false;
+  }
 
-  /* Transform back to target object space. */
-  co = math::transform_point(params.armature_to_target, co);
-
-  /* Multi-modifier: Interpolate with previous modifier position using the vertex group mask. */
-  if (params.vert_coords_prev) {
-    copy_v3_v3(params.vert_coords[i], math::interpolate(co, params.vert_coords[i], prevco_weight));
+  float armature_weight;
+  float prevco_weight;
+  if (!get_vert_armature_weight(params, mask_weight, armature_weight, prevco_weight)) {
+    return true;
   }
-  else {
-    copy_v3_v3(params.vert_coords[i], co);
+
+  float3 co = params.vert_coords_prev ? (*params.vert_coords_prev)[i] : params.vert_coords[i];
+  co = math::transform_point(params.target_to_armature, co);
+
+  float contrib = 0.0f;
+  for (const int j : def_nrs.index_range()) {
+    const int def_nr = def_nrs[j];
+    const float weight = weights[j];
+    if (weight == 0.0f || !bone_deforms.index_range().contains(def_nr) ||
+        bone_deforms[def_nr] != CompactBoneDeform::Simple)
+    {
+      continue;
+    }
+    mixer.accumulate(*params.pose_channel_by_vertex_group[def_nr], co, weight);
+    contrib += weight;
   }
+
+  armature_vert_finalize(params, i, co, contrib, armature_weight, prevco_weight, mixer);
+  return true;
 }
 
 /* Accumulate bone deformations for a vertex. */
@@ -490,6 +805,30 @@ static void armature_vert_task_with_dvert(const ArmatureDeformParams &deform_par
   }
 }
 
+/* Accumulate bone deformations for a vertex with compact vertex group weights. */
+static bool armature_vert_task_compact(const ArmatureDeformParams &deform_params,
+                                       const int i,
+                                       const Span<int> def_nrs,
+                                       const Span<float> weights,
+                                       const bool use_quaternion)
+{
+  const bool full_deform = deform_params.vert_deform_mats.has_value();
+  if (use_quaternion) {
+    if (full_deform) {
+      bke::CompactDualQuaternionMixer<true> mixer;
+      return armature_vert_task_compact_with_mixer(deform_params, i, def_nrs, weights, mixer);
+    }
+    bke::CompactDualQuaternionMixer<false> mixer;
+    return armature_vert_task_compact_with_mixer(deform_params, i, def_nrs, weights, mixer);
+  }
+  if (full_deform) {
+    bke::CompactLinearMixer<true> mixer;
+    return armature_vert_task_compact_with_mixer(deform_params, i, def_nrs, weights, mixer);
+  }
+  bke::CompactLinearMixer<false> mixer;
+  return armature_vert_task_compact_with_mixer(deform_params, i, def_nrs, weights, mixer);
+}
+
 static void armature_deform_coords(const Object &ob_arm,
                                    const Object &ob_target,
                                    const ListBase *defbase,
@@ -499,7 +838,8 @@ static void armature_deform_coords(const Object &ob_arm,
                                    const std::optional<Span<float3>> vert_coords_prev,
                                    blender::StringRefNull defgrp_name,
                                    const std::optional<Span<MDeformVert>> dverts,
-                                   const Mesh *me_target)
+                                   const Mesh *me_target,
+                                   ArmatureDeformWeightsCache *weights_cache)
 {
   ArmatureDeformParams deform_params = get_armature_deform_params(ob_arm,
                                                                   ob_target,
@@ -513,6 +853,30 @@ static void armature_deform_coords(const Object &ob_arm,
 
   const bool use_quaternion = bool(deformflag & ARM_DEF_QUATERNION);
   constexpr int grain_size = 32;
+
+  if (weights_cache && deform_params.use_dverts && me_target && dverts &&
+      weights_cache->ensure(*me_target))
+  {
+    init_compact_bone_deform(deform_params, use_quaternion);
+    const OffsetIndices<int> offsets = weights_cache->offsets();
+    const Span<int> def_nrs = weights_cache->def_nrs();
+    const Span<float> weights = weights_cache->weights();
+    threading::parallel_for(vert_coords.index_range(), grain_size, [&](const IndexRange range) {
+      for (const int i : range) {
+        const IndexRange vert_weights = offsets[i];
+        if (!armature_vert_task_compact(deform_params,
+                                        i,
+                                        def_nrs.slice(vert_weights),
+                                        weights.slice(vert_weights),
+                                        use_quaternion))
+        {
+          armature_vert_task_with_dvert(deform_params, i, &(*dverts)[i], use_quaternion);
+        }
+      }
+    });
+    return;
+  }
+
   threading::parallel_for(vert_coords.index_range(), grain_size, [&](const IndexRange range) {
     for (const int i : range) {
       const MDeformVert *dvert = nullptr;
@@ -645,6 +1009,7 @@ void BKE_armature_deform_coords_with_curves(
                               vert_coords_prev,
                               defgrp_name,
                               dverts,
+                              nullptr,
                               nullptr);
 }
 
@@ -656,7 +1021,8 @@ void BKE_armature_deform_coords_with_mesh(
     std::optional<blender::MutableSpan<blender::float3x3>> vert_deform_mats,
     int deformflag,
     blender::StringRefNull defgrp_name,
-    const Mesh *me_target)
+    const Mesh *me_target,
+    blender::bke::ArmatureDeformWeightsCache *weights_cache)
 {
   using namespace blender;
 
@@ -706,7 +1072,8 @@ void BKE_armature_deform_coords_with_mesh(
                               vert_coords_prev,
                               defgrp_name,
                               dverts_opt,
-                              me_target);
+                              me_target,
+                              ob_target.type == OB_MESH ? weights_cache : nullptr);
 }
 
 void BKE_armature_deform_coords_with_editmesh(
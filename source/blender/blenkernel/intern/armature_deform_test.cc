@@ -5,7 +5,9 @@
 #include "BLI_listbase.h"
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
+#include "BLI_rand.hh"
 #include "BLI_string.h"
+#include "BLI_timeit.hh"
 
 #include "BKE_action.hh"
 #include "BKE_armature.hh"
@@ -37,6 +39,8 @@
  */
 // #define USE_PARAMETERIZED_TESTS
 
+#define DO_PERF_TESTS 0
+
 namespace blender::bke::tests {
 
 /* Type of data that is being deformed.
@@ -446,7 +450,8 @@ class ArmatureDeformTestBase {
                  const OutputValueTest output,
                  const WeightingTest weighting,
                  const MaskingTest masking,
-                 const VertexWeightSource dvert_source)
+                 const VertexWeightSource dvert_source,
+                 ArmatureDeformWeightsCache *weights_cache = nullptr)
   {
     Object *ob_arm = this->create_test_armature_object();
     Object *ob_target = this->create_test_mesh_object();
@@ -473,7 +478,8 @@ class ArmatureDeformTestBase {
                                          deform_mats_opt,
                                          deform_flag,
                                          defgrp_name,
-                                         mesh_target);
+                                         mesh_target,
+                                         weights_cache);
 
     EXPECT_EQ_SPAN(expected_positions(TargetDataType::Mesh, weighting, masking),
                    vert_positions.as_span());
@@ -810,6 +816,126 @@ TEST_F(ArmatureDeformTest, MeshDeform)
   }
 }
 
+TEST_F(ArmatureDeformTest, MeshDeformWeightsCache)
+{
+  /* The cache is shared by all cases, so it is also rebuilt for every new mesh. */
+  ArmatureDeformWeightsCache weights_cache;
+  for (InterpolationTest ipol : {InterpolationTest::Linear, InterpolationTest::DualQuaternion}) {
+    for (WeightingTest weight : {WeightingTest::VertexGroups,
+                                 WeightingTest::EnvelopeAndVertexGroups})
+    {
+      for (OutputValueTest output :
+           {OutputValueTest::Position, OutputValueTest::PositionAndDeformMatrix})
+      {
+        for (MaskingTest mask : {MaskingTest::All, MaskingTest::VertexGroup}) {
+          for (VertexWeightSource dvert_source :
+               {VertexWeightSource::TargetObject, VertexWeightSource::SeparateMesh})
+          {
+            mesh_test(ipol, output, weight, mask, dvert_source, &weights_cache);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(ArmatureDeformTest, MeshDeformWeightsCacheUpdate)
+{
+  Object *ob_arm = this->create_test_armature_object();
+  Object *ob_target = this->create_test_mesh_object();
+  Mesh *mesh = static_cast<Mesh *>(ob_target->data);
+  const int deform_flag = get_deform_flag(InterpolationTest::Linear, WeightingTest::VertexGroups);
+
+  ArmatureDeformWeightsCache weights_cache;
+  const auto deform = [&]() {
+    Array<float3> positions(vertex_positions());
+    BKE_armature_deform_coords_with_mesh(*ob_arm,
+                                         *ob_target,
+                                         positions,
+                                         std::nullopt,
+                                         std::nullopt,
+                                         deform_flag,
+                                         "",
+                                         nullptr,
+                                         &weights_cache);
+    return positions;
+  };
+
+  const Span<float3> expected = expected_positions(
+      TargetDataType::Mesh, WeightingTest::VertexGroups, MaskingTest::All);
+  EXPECT_EQ_SPAN(expected, deform().as_span());
+  /* Evaluate again with the cached weights. */
+  EXPECT_EQ_SPAN(expected, deform().as_span());
+
+  /* Changing the weights in place has to invalidate the cache. */
+  for (MDeformVert &dvert : mesh->deform_verts_for_write()) {
+    for (MDeformWeight &dw : MutableSpan(dvert.dw, dvert.totweight)) {
+      if (dw.def_nr == 1) {
+        dw.weight = 0.0f;
+      }
+    }
+  }
+  Array<float3> expected_bone1_only(vertex_positions());
+  for (float3 &position : expected_bone1_only) {
+    position += offset_bone1();
+  }
+  EXPECT_EQ_SPAN(expected_bone1_only.as_span(), deform().as_span());
+
+  BKE_id_delete(bmain, ob_arm);
+  BKE_id_delete(bmain, ob_target);
+}
+
+#  if DO_PERF_TESTS
+
+/* Compare deforming a large mesh with and without the compact weights cache. The first cached
+ * evaluation builds the cache, the following ones reuse it like the armature modifier does. */
+TEST_F(ArmatureDeformTest, MeshDeformWeightsCachePerformance)
+{
+  constexpr int verts_num = 1000000;
+  constexpr int iterations = 10;
+
+  Object *ob_arm = this->create_test_armature_object();
+  Object *ob_target = this->create_test_mesh_object();
+  Mesh *mesh = BKE_mesh_new_nomain(verts_num, 0, 0, 0);
+  RandomNumberGenerator rng;
+  MutableSpan<MDeformVert> dverts = mesh->deform_verts_for_write();
+  for (const int i : dverts.index_range()) {
+    BKE_defvert_add_index_notest(&dverts[i], 0, rng.get_float());
+    BKE_defvert_add_index_notest(&dverts[i], 1, rng.get_float());
+  }
+  BKE_defgroup_copy_list(&mesh->vertex_group_names,
+                         &static_cast<const Mesh *>(ob_target->data)->vertex_group_names);
+  Array<float3> positions(verts_num, float3(0.0f, 0.0f, 0.5f));
+
+  for (InterpolationTest ipol : {InterpolationTest::Linear, InterpolationTest::DualQuaternion}) {
+    const int deform_flag = get_deform_flag(ipol, WeightingTest::VertexGroups);
+    const char *name = ipol == InterpolationTest::Linear ? "linear" : "dual quaternion";
+    ArmatureDeformWeightsCache weights_cache;
+    for (ArmatureDeformWeightsCache *cache :
+         Span<ArmatureDeformWeightsCache *>({nullptr, &weights_cache}))
+    {
+      SCOPED_TIMER(std::string(name) + (cache ? " cached" : " uncached"));
+      for ([[maybe_unused]] const int iteration : IndexRange(iterations)) {
+        BKE_armature_deform_coords_with_mesh(*ob_arm,
+                                             *ob_target,
+                                             positions,
+                                             std::nullopt,
+                                             std::nullopt,
+                                             deform_flag,
+                                             "",
+                                             mesh,
+                                             cache);
+      }
+    }
+  }
+
+  BKE_id_free(nullptr, mesh);
+  BKE_id_delete(bmain, ob_arm);
+  BKE_id_delete(bmain, ob_target);
+}
+
+#  endif
+
 TEST_F(ArmatureDeformTest, EditMeshDeform)
 {
   for (InterpolationTest ipol : {InterpolationTest::Linear, InterpolationTest::DualQuaternion}) {
@@ -2,7 +2,13 @@
  *
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include "BKE_action.hh"
 #include "BKE_armature.hh"
+#include "BKE_constraint.h"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+#include "BKE_object.hh"
 
 #include "BLI_listbase.h"
 #include "BLI_math_matrix.h"
@@ -11,7 +17,11 @@
 #include "BLI_math_vector.h"
 #include "BLI_string.h"
 
+#include "CLG_log.h"
+
 #include "DNA_armature_types.h"
+#include "DNA_constraint_types.h"
+#include "DNA_object_types.h"
 
 #include "testing/testing.h"
 
@@ -420,4 +430,127 @@ TEST_F(BKE_armature_find_selected_bones_test, all_bones_selected)
   EXPECT_FALSE(result.no_bones_selected);
 }
 
+class PoseEvalScheduleTest : public testing::Test {
+ protected:
+  Main *bmain;
+
+  static void SetUpTestSuite()
+  {
+    CLG_init();
+    BKE_idtype_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    CLG_exit();
+  }
+
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+  }
+
+  void TearDown() override
+  {
+    BKE_main_free(bmain);
+  }
+
+  static Bone *add_bone(bArmature *arm, Bone *parent, const char *name)
+  {
+    Bone *bone = MEM_callocN<Bone>(__func__);
+    STRNCPY(bone->name, name);
+    copy_v3_v3(bone->tail, float3(0, 0, 1));
+    bone->parent = parent;
+    BLI_addtail(parent ? &parent->childbase : &arm->bonebase, bone);
+    return bone;
+  }
+
+  /* A root bone with the given number of chains of 20 bones below it. */
+  Object *create_armature_object(const int chains_num)
+  {
+    Object *ob = BKE_object_add_only_object(bmain, OB_ARMATURE, "Armature Object");
+    bArmature *arm = BKE_id_new<bArmature>(bmain, "Armature");
+    ob->data = arm;
+    Bone *root = add_bone(arm, nullptr, "root");
+    for (const int chain : IndexRange(chains_num)) {
+      Bone *parent = root;
+      for (const int i : IndexRange(20)) {
+        char name[64];
+        SNPRINTF(name, "chain%d.%d", chain, i);
+        parent = add_bone(arm, parent, name);
+      }
+    }
+    BKE_armature_where_is(arm);
+    BKE_pose_ensure(bmain, ob, arm, false);
+    return ob;
+  }
+};
+
+TEST_F(PoseEvalScheduleTest, independent_chains)
+{
+  Object *ob = this->create_armature_object(4);
+  std::unique_ptr<PoseEvalSchedule> schedule = PoseEvalSchedule::create(*ob);
+  ASSERT_NE(schedule, nullptr);
+
+  /* The root bone, then the four chains in parallel. */
+  ASSERT_EQ(schedule->stages().size(), 2);
+  EXPECT_EQ(schedule->stages()[0].size(), 1);
+  EXPECT_EQ(schedule->stages()[1].size(), 4);
+  ASSERT_EQ(schedule->chains().size(), 5);
+  EXPECT_EQ(schedule->chains()[0].size(), 1);
+  for (const int chain : IndexRange(1, 4)) {
+    EXPECT_EQ(schedule->chains()[chain].size(), 20);
+  }
+  /* Bones within a chain are ordered from the parent to the children. */
+  const Span<int> chain_bones = schedule->bone_indices().slice(schedule->chains()[3]);
+  for (const int i : chain_bones.index_range()) {
+    char name[64];
+    SNPRINTF(name, "chain2.%d", i);
+    EXPECT_EQ(chain_bones[i],
+              BLI_findindex(&ob->pose->chanbase, BKE_pose_channel_find_name(ob->pose, name)));
+  }
+}
+
+TEST_F(PoseEvalScheduleTest, constraint_target_in_other_chain)
+{
+  Object *ob = this->create_armature_object(4);
+  bPoseChannel *pchan = BKE_pose_channel_find_name(ob->pose, "chain1.0");
+  bConstraint *con = BKE_constraint_add_for_pose(ob, pchan, "Copy", CONSTRAINT_TYPE_LOCLIKE);
+  bLocateLikeConstraint *data = static_cast<bLocateLikeConstraint *>(con->data);
+  data->tar = ob;
+  STRNCPY(data->subtarget, "chain0.19");
+
+  std::unique_ptr<PoseEvalSchedule> schedule = PoseEvalSchedule::create(*ob);
+  ASSERT_NE(schedule, nullptr);
+
+  /* The constrained chain is evaluated after the chain it reads from. */
+  ASSERT_EQ(schedule->stages().size(), 3);
+  EXPECT_EQ(schedule->stages()[1].size(), 3);
+  EXPECT_EQ(schedule->stages()[2].size(), 1);
+  const int last_chain_start = schedule->chains()[schedule->chains().size() - 1].first();
+  EXPECT_EQ(schedule->bone_indices()[last_chain_start], BLI_findindex(&ob->pose->chanbase, pchan));
+}
+
+TEST_F(PoseEvalScheduleTest, unsupported_rigs)
+{
+  /* Too few bones to benefit. */
+  Object *ob_small = this->create_armature_object(1);
+  EXPECT_EQ(PoseEvalSchedule::create(*ob_small), nullptr);
+
+  /* IK solvers are interleaved with the bones. */
+  Object *ob_ik = this->create_armature_object(4);
+  bPoseChannel *pchan = BKE_pose_channel_find_name(ob_ik->pose, "chain0.19");
+  BKE_constraint_add_for_pose(ob_ik, pchan, "IK", CONSTRAINT_TYPE_KINEMATIC);
+  EXPECT_EQ(PoseEvalSchedule::create(*ob_ik), nullptr);
+
+  /* Targets in other objects need relations to individual bones. */
+  Object *ob_target = this->create_armature_object(4);
+  Object *ob_empty = BKE_object_add_only_object(bmain, OB_EMPTY, "Empty");
+  pchan = BKE_pose_channel_find_name(ob_target->pose, "chain0.0");
+  bConstraint *con = BKE_constraint_add_for_pose(
+      ob_target, pchan, "Copy", CONSTRAINT_TYPE_LOCLIKE);
+  static_cast<bLocateLikeConstraint *>(con->data)->tar = ob_empty;
+  EXPECT_EQ(PoseEvalSchedule::create(*ob_target), nullptr);
+}
+
 }  // namespace blender::bke::tests
@@ -11,11 +11,16 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_listbase.h"
+#include "BLI_map.hh"
 #include "BLI_math_matrix.h"
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
+#include "BLI_string.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
+#include "DNA_anim_types.h"
 #include "DNA_armature_types.h"
 #include "DNA_constraint_types.h"
 #include "DNA_curve_types.h"
@@ -24,6 +29,7 @@
 #include "BKE_action.hh"
 #include "BKE_anim_path.h"
 #include "BKE_armature.hh"
+#include "BKE_constraint.h"
 #include "BKE_curve.hh"
 #include "BKE_object_types.hh"
 #include "BKE_scene.hh"
@@ -859,6 +865,16 @@ void BKE_pose_eval_init_ik(Depsgraph *depsgraph, Scene *scene, Object *object)
   BKE_pose_splineik_init_tree(scene, object, ctime);
 }
 
+static void pose_channel_rest_pose_eval(bPoseChannel *pchan)
+{
+  Bone *bone = pchan->bone;
+  if (bone) {
+    copy_m4_m4(pchan->pose_mat, bone->arm_mat);
+    copy_v3_v3(pchan->pose_head, bone->arm_head);
+    copy_v3_v3(pchan->pose_tail, bone->arm_tail);
+  }
+}
+
 void BKE_pose_eval_bone(Depsgraph *depsgraph, Scene *scene, Object *object, int pchan_index)
 {
   const bArmature *armature = (bArmature *)object->data;
@@ -870,12 +886,7 @@ void BKE_pose_eval_bone(Depsgraph *depsgraph, Scene *scene, Object *object, int
       depsgraph, __func__, object->id.name, object, "pchan", pchan->name, pchan);
   BLI_assert(object->type == OB_ARMATURE);
   if (armature->flag & ARM_RESTPOS) {
-    Bone *bone = pchan->bone;
-    if (bone) {
-      copy_m4_m4(pchan->pose_mat, bone->arm_mat);
-      copy_v3_v3(pchan->pose_head, bone->arm_head);
-      copy_v3_v3(pchan->pose_tail, bone->arm_tail);
-    }
+    pose_channel_rest_pose_eval(pchan);
   }
   else {
     /* TODO(sergey): Currently if there are constraints full transform is
@@ -942,19 +953,9 @@ static void pose_channel_flush_to_orig_if_needed(Depsgraph *depsgraph,
   pchan_orig->constflag = pchan->constflag;
 }
 
-void BKE_pose_bone_done(Depsgraph *depsgraph, Object *object, int pchan_index)
+static void pose_channel_done(Depsgraph *depsgraph, Object *object, bPoseChannel *pchan)
 {
-  /* Note: tests in `armature_deform_test.cc` update pose matrices locally to avoid creating a full
-   * depsgraph. Keep these in sync if this function is changed! */
-
-  const bArmature *armature = (bArmature *)object->data;
-  if (armature->edbo != nullptr) {
-    return;
-  }
-  bPoseChannel *pchan = pose_pchan_get_indexed(object, pchan_index);
   float imat[4][4];
-  DEG_debug_print_eval_subdata(
-      depsgraph, __func__, object->id.name, object, "pchan", pchan->name, pchan);
   if (pchan->bone) {
     invert_m4_m4(imat, pchan->bone->arm_mat);
     mul_m4_m4m4(pchan->chan_mat, pchan->pose_mat, imat);
@@ -971,8 +972,11 @@ void BKE_pose_bone_done(Depsgraph *depsgraph, Object *object, int pchan_index)
   }
 }
 
-void BKE_pose_eval_bbone_segments(Depsgraph *depsgraph, Object *object, int pchan_index)
+void BKE_pose_bone_done(Depsgraph *depsgraph, Object *object, int pchan_index)
 {
+  /* Note: tests in `armature_deform_test.cc` update pose matrices locally to avoid creating a full
+   * depsgraph. Keep these in sync if this function is changed! */
+
   const bArmature *armature = (bArmature *)object->data;
   if (armature->edbo != nullptr) {
     return;
@@ -980,6 +984,11 @@ void BKE_pose_eval_bbone_segments(Depsgraph *depsgraph, Object *object, int pcha
   bPoseChannel *pchan = pose_pchan_get_indexed(object, pchan_index);
   DEG_debug_print_eval_subdata(
       depsgraph, __func__, object->id.name, object, "pchan", pchan->name, pchan);
+  pose_channel_done(depsgraph, object, pchan);
+}
+
+static void pose_channel_bbone_segments_eval(Depsgraph *depsgraph, bPoseChannel *pchan)
+{
   if (pchan->bone != nullptr && pchan->bone->segments > 1) {
     BKE_pchan_bbone_segments_cache_compute(pchan);
     if (DEG_is_active(depsgraph)) {
@@ -988,6 +997,323 @@ void BKE_pose_eval_bbone_segments(Depsgraph *depsgraph, Object *object, int pcha
   }
 }
 
+void BKE_pose_eval_bbone_segments(Depsgraph *depsgraph, Object *object, int pchan_index)
+{
+  const bArmature *armature = (bArmature *)object->data;
+  if (armature->edbo != nullptr) {
+    return;
+  }
+  bPoseChannel *pchan = pose_pchan_get_indexed(object, pchan_index);
+  DEG_debug_print_eval_subdata(
+      depsgraph, __func__, object->id.name, object, "pchan", pchan->name, pchan);
+  pose_channel_bbone_segments_eval(depsgraph, pchan);
+}
+
+/* Rigs with fewer bones keep separate operations per bone: the overhead of the operations does
+ * not matter for them, and the finer granularity is easier to inspect in the dependency graph. */
+static constexpr int POSE_EVAL_BATCHED_MIN_BONES = 64;
+
+static bool anim_data_has_drivers_with_prefix(const AnimData *adt, const char *rna_path_prefix)
+{
+  if (adt == nullptr) {
+    return false;
+  }
+  LISTBASE_FOREACH (const FCurve *, fcu, &adt->drivers) {
+    if (fcu->rna_path != nullptr && STRPREFIX(fcu->rna_path, rna_path_prefix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Add the bones the constraints of the pose channel read from to the dependencies.
+ * \return False when the constraints depend on anything else than bones of the same armature.
+ */
+static bool pose_channel_constraint_dependencies(
+    Object &object,
+    bPoseChannel &pchan,
+    const blender::Map<const bPoseChannel *, int> &pchan_indices,
+    blender::Vector<int, 2> &r_dependencies)
+{
+  LISTBASE_FOREACH (bConstraint *, con, &pchan.constraints) {
+    /* Solvers and constraints depending on the scene camera, movie clips and caches need their
+     * own operations. The armature constraint reads the B-Bone shape of its targets. */
+    if (ELEM(con->type,
+             CONSTRAINT_TYPE_KINEMATIC,
+             CONSTRAINT_TYPE_SPLINEIK,
+             CONSTRAINT_TYPE_ARMATURE,
+             CONSTRAINT_TYPE_FOLLOWTRACK,
+             CONSTRAINT_TYPE_CAMERASOLVER,
+             CONSTRAINT_TYPE_OBJECTSOLVER,
+             CONSTRAINT_TYPE_TRANSFORM_CACHE))
+    {
+      return false;
+    }
+    ListBase targets = {nullptr, nullptr};
+    if (!BKE_constraint_targets_get(con, &targets)) {
+      continue;
+    }
+    bool is_supported = true;
+    LISTBASE_FOREACH (bConstraintTarget *, ct, &targets) {
+      if (ct->tar == nullptr) {
+        continue;
+      }
+      if (ct->tar != &object || ct->subtarget[0] == '\0' ||
+          BKE_constraint_target_uses_bbone(con, ct))
+      {
+        is_supported = false;
+        break;
+      }
+      const bPoseChannel *target = BKE_pose_channel_find_name(object.pose, ct->subtarget);
+      if (target == nullptr || target == &pchan) {
+        continue;
+      }
+      const int target_index = pchan_indices.lookup(target);
+      if (!r_dependencies.contains(target_index)) {
+        r_dependencies.append(target_index);
+      }
+    }
+    BKE_constraint_targets_flush(con, &targets, true);
+    if (!is_supported) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace blender::bke {
+
+std::unique_ptr<PoseEvalSchedule> PoseEvalSchedule::create(Object &object)
+{
+  BLI_assert(object.type == OB_ARMATURE);
+  bPose *pose = object.pose;
+  if (pose == nullptr) {
+    return nullptr;
+  }
+  const int bones_num = BLI_listbase_count(&pose->chanbase);
+  if (bones_num < POSE_EVAL_BATCHED_MIN_BONES) {
+    return nullptr;
+  }
+  /* Drivers on pose bones commonly read other bones of the same rig, which requires evaluating
+   * the driver in between of the bones. */
+  const bArmature *armature = static_cast<const bArmature *>(object.data);
+  if (anim_data_has_drivers_with_prefix(object.adt, "pose.bones[") ||
+      anim_data_has_drivers_with_prefix(armature->adt, "bones["))
+  {
+    return nullptr;
+  }
+
+  Array<bPoseChannel *> pchans(bones_num);
+  Map<const bPoseChannel *, int> pchan_indices;
+  pchan_indices.reserve(bones_num);
+  {
+    int pchan_index = 0;
+    LISTBASE_FOREACH (bPoseChannel *, pchan, &pose->chanbase) {
+      pchans[pchan_index] = pchan;
+      pchan_indices.add_new(pchan, pchan_index);
+      pchan_index++;
+    }
+  }
+
+  /* Bones every bone reads the final transform of. */
+  Array<Vector<int, 2>> dependencies(bones_num);
+  for (const int pchan_index : pchans.index_range()) {
+    bPoseChannel *pchan = pchans[pchan_index];
+    if (pchan->parent != nullptr) {
+      dependencies[pchan_index].append(pchan_indices.lookup(pchan->parent));
+    }
+    if (!pose_channel_constraint_dependencies(
+            object, *pchan, pchan_indices, dependencies[pchan_index]))
+    {
+      return nullptr;
+    }
+    /* The B-Bone segments are computed after all bones are done, which only allows reading the
+     * segments of the previous handle when that one doesn't do the same. */
+    if (pchan->bone != nullptr && (pchan->bone->bbone_flag & BBONE_ADD_PARENT_END_ROLL)) {
+      bPoseChannel *prev, *next;
+      BKE_pchan_bbone_handles_get(pchan, &prev, &next);
+      if (prev != nullptr && prev->bone != nullptr &&
+          (prev->bone->bbone_flag & BBONE_ADD_PARENT_END_ROLL))
+      {
+        return nullptr;
+      }
+    }
+  }
+
+  /* Bones depending on every bone. */
+  Array<int> dependent_offsets(bones_num + 1, 0);
+  for (const Span<int> bone_dependencies : dependencies) {
+    for (const int dependency : bone_dependencies) {
+      dependent_offsets[dependency]++;
+    }
+  }
+  const OffsetIndices<int> dependents_by_bone = offset_indices::accumulate_counts_to_offsets(
+      dependent_offsets);
+  Array<int> dependents(dependents_by_bone.total_size());
+  {
+    Array<int> fill_counts(bones_num, 0);
+    for (const int pchan_index : pchans.index_range()) {
+      for (const int dependency : dependencies[pchan_index]) {
+        dependents[dependents_by_bone[dependency][fill_counts[dependency]++]] = pchan_index;
+      }
+    }
+  }
+  const auto dependents_of = [&](const int pchan_index) {
+    return dependents.as_span().slice(dependents_by_bone[pchan_index]);
+  };
+
+  /* Topological order of the bones. Cyclic dependencies between constraints are left to the
+   * per-bone operations, so that they are reported like any other dependency cycle. */
+  Vector<int> order;
+  order.reserve(bones_num);
+  Array<int> pending_dependencies(bones_num);
+  for (const int pchan_index : pchans.index_range()) {
+    pending_dependencies[pchan_index] = dependencies[pchan_index].size();
+    if (pending_dependencies[pchan_index] == 0) {
+      order.append(pchan_index);
+    }
+  }
+  for (int64_t i = 0; i < order.size(); i++) {
+    for (const int dependent : dependents_of(order[i])) {
+      if (--pending_dependencies[dependent] == 0) {
+        order.append(dependent);
+      }
+    }
+  }
+  if (order.size() != bones_num) {
+    return nullptr;
+  }
+
+  /* A bone continues the chain of its only dependency when it is the only bone depending on it.
+   * The stage of a chain follows the stages of the chains its first bone depends on. */
+  const auto continues_chain = [&](const int pchan_index) {
+    return dependencies[pchan_index].size() == 1 &&
+           dependents_of(dependencies[pchan_index][0]).size() == 1;
+  };
+  const auto next_in_chain = [&](const int pchan_index) {
+    const Span<int> bone_dependents = dependents_of(pchan_index);
+    if (bone_dependents.size() == 1 && continues_chain(bone_dependents[0])) {
+      return bone_dependents[0];
+    }
+    return -1;
+  };
+  Array<int> bone_chains(bones_num, -1);
+  Vector<int> chain_first_bones;
+  Vector<int> chain_stages;
+  for (const int pchan_index : order) {
+    if (continues_chain(pchan_index)) {
+      continue;
+    }
+    int stage = 0;
+    for (const int dependency : dependencies[pchan_index]) {
+      stage = std::max(stage, chain_stages[bone_chains[dependency]] + 1);
+    }
+    const int chain = int(chain_first_bones.append_and_get_index(pchan_index));
+    chain_stages.append(stage);
+    for (int bone = pchan_index; bone != -1; bone = next_in_chain(bone)) {
+      bone_chains[bone] = chain;
+    }
+  }
+  const int chains_num = chain_first_bones.size();
+  const int stages_num = chain_stages.is_empty() ?
+                             0 :
+                             *std::max_element(chain_stages.begin(), chain_stages.end()) + 1;
+
+  std::unique_ptr<PoseEvalSchedule> schedule = std::make_unique<PoseEvalSchedule>();
+  schedule->stage_offsets_.reinitialize(stages_num + 1);
+  schedule->stage_offsets_.fill(0);
+  for (const int stage : chain_stages) {
+    schedule->stage_offsets_[stage]++;
+  }
+  const OffsetIndices<int> stages = offset_indices::accumulate_counts_to_offsets(
+      schedule->stage_offsets_);
+
+  /* Sort the chains by stage, keeping their order within a stage. */
+  Array<int> sorted_chains(chains_num);
+  {
+    Array<int> fill_counts(stages_num, 0);
+    for (const int chain : IndexRange(chains_num)) {
+      const int stage = chain_stages[chain];
+      sorted_chains[stages[stage][fill_counts[stage]++]] = chain;
+    }
+  }
+
+  schedule->chain_offsets_.reinitialize(chains_num + 1);
+  schedule->bone_indices_.reinitialize(bones_num);
+  int bone_offset = 0;
+  for (const int i : sorted_chains.index_range()) {
+    const int chain = sorted_chains[i];
+    schedule->chain_offsets_[i] = bone_offset;
+    for (int bone = chain_first_bones[chain]; bone != -1; bone = next_in_chain(bone)) {
+      schedule->bone_indices_[bone_offset++] = bone;
+    }
+  }
+  BLI_assert(bone_offset == bones_num);
+  schedule->chain_offsets_.last() = bone_offset;
+  return schedule;
+}
+
+}  // namespace blender::bke
+
+void BKE_pose_eval_bones_batched(Depsgraph *depsgraph,
+                                 Scene *scene,
+                                 Object *object,
+                                 const blender::bke::PoseEvalSchedule &schedule)
+{
+  using namespace blender;
+  const bArmature *armature = (bArmature *)object->data;
+  if (armature->edbo != nullptr) {
+    return;
+  }
+  DEG_debug_print_eval(depsgraph, __func__, object->id.name, object);
+  BLI_assert(object->type == OB_ARMATURE);
+  BLI_assert(schedule.bone_indices().size() ==
+             MEM_allocN_len(object->pose->chan_array) / sizeof(bPoseChannel *));
+
+  const float ctime = BKE_scene_ctime_get(scene); /* not accurate... */
+  const Span<int> bone_indices = schedule.bone_indices();
+  const OffsetIndices<int> chains = schedule.chains();
+  const OffsetIndices<int> stages = schedule.stages();
+  for (const int stage : stages.index_range()) {
+    /* Chains of the same stage don't depend on each other. Most chains are short, so a task
+     * handles a few of them to keep the scheduling overhead low. */
+    threading::parallel_for(stages[stage], 16, [&](const IndexRange stage_chains) {
+      for (const int chain : stage_chains) {
+        for (const int pchan_index : bone_indices.slice(chains[chain])) {
+          bPoseChannel *pchan = pose_pchan_get_indexed(object, pchan_index);
+          if (armature->flag & ARM_RESTPOS) {
+            pose_channel_rest_pose_eval(pchan);
+          }
+          else if ((pchan->flag & POSE_DONE) == 0) {
+            BKE_pose_where_is_bone(depsgraph, scene, object, pchan, ctime, true);
+          }
+          pose_channel_done(depsgraph, object, pchan);
+        }
+      }
+    });
+  }
+
+  /* B-Bone segments depend on the final transform of their handles, which can be any bone.
+   * Segments inheriting the end roll of their previous handle read its segments, so these are
+   * computed last. The schedule ensures that those previous handles never do the same. */
+  const auto bbone_segments_eval = [&](const bool inherit_end_roll) {
+    threading::parallel_for(bone_indices.index_range(), 256, [&](const IndexRange range) {
+      for (const int pchan_index : range) {
+        bPoseChannel *pchan = pose_pchan_get_indexed(object, pchan_index);
+        if (pchan->bone == nullptr) {
+          continue;
+        }
+        if (bool(pchan->bone->bbone_flag & BBONE_ADD_PARENT_END_ROLL) == inherit_end_roll) {
+          pose_channel_bbone_segments_eval(depsgraph, pchan);
+        }
+      }
+    });
+  };
+  bbone_segments_eval(false);
+  bbone_segments_eval(true);
+}
+
 void BKE_pose_iktree_evaluate(Depsgraph *depsgraph,
                               Scene *scene,
                               Object *object,
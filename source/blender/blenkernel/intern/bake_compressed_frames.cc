@@ -0,0 +1,372 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include <charconv>
+#include <sstream>
+
+#include <zstd.h>
+
+#include "BLI_task.h"
+#include "BLI_task.hh"
+#include "BLI_utildefines.h"
+
+#include "BKE_bake_compressed_frames.hh"
+
+namespace blender::bke::bake {
+
+/** Favor speed, the data is compressed while the simulation is running. */
+static constexpr int compression_level = 1;
+
+/**
+ * Arrays are usually made up of 4 byte values. Grouping the bytes of the same significance makes
+ * the data much more compressible, especially after the difference to the previous frame has been
+ * taken, where the most significant bytes are mostly zero.
+ */
+static constexpr int shuffle_stride = 4;
+
+static bool use_shuffle(const int64_t size)
+{
+  return size >= 64 && size % shuffle_stride == 0;
+}
+
+static void shuffle_bytes(const Span<std::byte> src, MutableSpan<std::byte> dst)
+{
+  const int64_t values_num = src.size() / shuffle_stride;
+  threading::parallel_for(IndexRange(shuffle_stride), 1, [&](const IndexRange range) {
+    for (const int byte : range) {
+      std::byte *dst_plane = dst.data() + byte * values_num;
+      for (const int64_t i : IndexRange(values_num)) {
+        dst_plane[i] = src[i * shuffle_stride + byte];
+      }
+    }
+  });
+}
+
+static void unshuffle_bytes(const Span<std::byte> src, MutableSpan<std::byte> dst)
+{
+  const int64_t values_num = src.size() / shuffle_stride;
+  threading::parallel_for(IndexRange(shuffle_stride), 1, [&](const IndexRange range) {
+    for (const int byte : range) {
+      const std::byte *src_plane = src.data() + byte * values_num;
+      for (const int64_t i : IndexRange(values_num)) {
+        dst[i * shuffle_stride + byte] = src_plane[i];
+      }
+    }
+  });
+}
+
+/** XOR the overlapping part of the arrays, which is its own inverse. */
+static void xor_bytes(const Span<std::byte> base, MutableSpan<std::byte> data)
+{
+  const int64_t size = std::min(base.size(), data.size());
+  threading::parallel_for(IndexRange(size), 1 << 16, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      data[i] ^= base[i];
+    }
+  });
+}
+
+static Array<std::byte> compress(const Span<std::byte> data)
+{
+  Array<std::byte> buffer(ZSTD_compressBound(data.size()), NoInitialization());
+  const size_t size = ZSTD_compress(
+      buffer.data(), buffer.size(), data.data(), data.size(), compression_level);
+  if (ZSTD_isError(size)) {
+    BLI_assert_unreachable();
+    return {};
+  }
+  return Array<std::byte>(buffer.as_span().take_front(size));
+}
+
+[[nodiscard]] static bool decompress(const Span<std::byte> compressed,
+                                     MutableSpan<std::byte> r_data)
+{
+  const size_t size = ZSTD_decompress(
+      r_data.data(), r_data.size(), compressed.data(), compressed.size());
+  return !ZSTD_isError(size) && int64_t(size) == r_data.size();
+}
+
+/**
+ * Every written blob becomes a separate #Blob that is referenced by its index. The slices
+ * returned for deduplicated data can reference blobs of earlier frames.
+ */
+class CompressedFrameStore::Writer : public BlobWriter {
+ public:
+  struct PendingBlob {
+    int blob_index;
+    Array<std::byte> data;
+  };
+
+  CompressedFrameStore &store;
+  bool use_base_blobs;
+  /** Uncompressed data of the blobs written for this frame, in order. */
+  Vector<Array<std::byte>> frame_blobs;
+  /** Data that still has to be compressed. */
+  Vector<PendingBlob> pending;
+
+  Writer(CompressedFrameStore &store, const bool use_base_blobs)
+      : store(store), use_base_blobs(use_base_blobs)
+  {
+  }
+
+  BlobSlice write(const void *data, const int64_t size) override
+  {
+    const Span<std::byte> src(static_cast<const std::byte *>(data), size);
+    const int ordinal = frame_blobs.size();
+    const int blob_index = store.blobs_.size();
+
+    Blob &blob = store.blobs_[store.blobs_.append_and_get_index_as()];
+    blob.size = size;
+    Array<std::byte> encoded(src);
+    /* Arrays that change between frames are written in the same order every frame, so the array
+     * at the same position of the previous frame is the best guess for what the data is similar
+     * to. Any guess gives the correct result, a bad one only compresses worse. */
+    if (use_base_blobs && ordinal < store.last_frame_blobs_.size()) {
+      const Frame &prev_frame = store.frames_.last();
+      blob.base_blob = prev_frame.blobs[ordinal];
+      xor_bytes(store.last_frame_blobs_[ordinal], encoded);
+    }
+    if (use_shuffle(size)) {
+      Array<std::byte> shuffled(size, NoInitialization());
+      shuffle_bytes(encoded, shuffled);
+      encoded = std::move(shuffled);
+    }
+    pending.append({blob_index, std::move(encoded)});
+    frame_blobs.append(Array<std::byte>(src));
+    total_written_size_ += size;
+    return {std::to_string(blob_index), IndexRange(size)};
+  }
+};
+
+class CompressedFrameStore::Reader : public BlobReader {
+ public:
+  CompressedFrameStore &store;
+  /** Decoded blobs used by the frame that is loaded. */
+  mutable Map<int, Array<std::byte>> decoded;
+
+  Reader(CompressedFrameStore &store) : store(store) {}
+
+  [[nodiscard]] bool read(const BlobSlice &slice, void *r_data) const override
+  {
+    if (slice.range.is_empty()) {
+      return true;
+    }
+    int blob_index = -1;
+    const char *name_end = slice.name.data() + slice.name.size();
+    if (std::from_chars(slice.name.data(), name_end, blob_index).ptr != name_end) {
+      return false;
+    }
+    if (!store.blobs_.index_range().contains(blob_index)) {
+      return false;
+    }
+    const Array<std::byte> &data = store.decode_blob(blob_index, decoded);
+    if (!data.index_range().contains(slice.range)) {
+      return false;
+    }
+    memcpy(r_data, data.as_span().slice(slice.range).data(), slice.range.size());
+    return true;
+  }
+};
+
+CompressedFrameStore::~CompressedFrameStore()
+{
+  if (prefetch_pool_) {
+    BLI_task_pool_cancel(prefetch_pool_);
+    BLI_task_pool_free(prefetch_pool_);
+  }
+}
+
+int CompressedFrameStore::add(const BakeState &state)
+{
+  this->wait_for_prefetch();
+  std::lock_guard lock{mutex_};
+
+  const int frame_index = frames_.size();
+  const bool is_keyframe = frame_index % keyframe_interval == 0;
+  const int first_blob = blobs_.size();
+
+  Writer writer{*this, !is_keyframe && !frames_.is_empty()};
+  std::ostringstream meta_stream;
+  /* Encoding and compressing the arrays runs parallel loops while the mutex is locked, and the
+   * caller usually holds the lock of its cache as well. Isolate the work, so that this thread does
+   * not run unrelated tasks while waiting, which might try to take the same locks. */
+  threading::isolate_task([&]() {
+    serialize_bake(state, writer, write_sharing_, meta_stream);
+    threading::parallel_for(writer.pending.index_range(), 1, [&](const IndexRange range) {
+      for (Writer::PendingBlob &pending : writer.pending.as_mutable_span().slice(range)) {
+        blobs_[pending.blob_index].compressed = compress(pending.data);
+        pending.data = {};
+      }
+    });
+  });
+  const std::string meta = meta_stream.str();
+
+  Frame &frame = frames_[frames_.append_and_get_index_as()];
+  frame.meta_compressed = compress(Span(reinterpret_cast<const std::byte *>(meta.data()),
+                                        int64_t(meta.size())));
+  frame.meta_size = meta.size();
+  frame.blobs = IndexRange::from_begin_end(first_blob, blobs_.size());
+
+  compressed_size_ += frame.meta_compressed.size();
+  uncompressed_size_ += frame.meta_size;
+  for (const Blob &blob : blobs_.as_span().drop_front(first_blob)) {
+    compressed_size_ += blob.compressed.size();
+    uncompressed_size_ += blob.size;
+  }
+
+  last_frame_blobs_ = std::move(writer.frame_blobs);
+  return frame_index;
+}
+
+std::optional<BakeState> CompressedFrameStore::load(const int frame_index)
+{
+  std::lock_guard lock{mutex_};
+  if (prefetched_ && prefetched_->first == frame_index) {
+    std::optional<BakeState> state = std::move(prefetched_->second);
+    prefetched_.reset();
+    return state;
+  }
+  return this->load_locked(frame_index);
+}
+
+std::optional<BakeState> CompressedFrameStore::load_locked(const int frame_index)
+{
+  if (!frames_.index_range().contains(frame_index)) {
+    return std::nullopt;
+  }
+  const Frame &frame = frames_[frame_index];
+  std::string meta(frame.meta_size, '\0');
+  if (!decompress(frame.meta_compressed,
+                  MutableSpan(reinterpret_cast<std::byte *>(meta.data()), frame.meta_size)))
+  {
+    return std::nullopt;
+  }
+
+  Reader reader{*this};
+  BlobReadSharing read_sharing;
+  std::istringstream meta_stream{meta};
+  std::optional<BakeState> state;
+  /* Decoding the arrays runs parallel loops while the mutex is locked, see #add. */
+  threading::isolate_task([&]() { state = deserialize_bake(meta_stream, reader, read_sharing); });
+
+  /* The blobs of this frame are the base for the blobs of the next frame, keeping them makes
+   * decoding frames in order cheap. */
+  decoded_blobs_ = std::move(reader.decoded);
+  return state;
+}
+
+const Array<std::byte> &CompressedFrameStore::decode_blob(const int blob_index,
+                                                          Map<int, Array<std::byte>> &decoded)
+{
+  if (const Array<std::byte> *data = decoded.lookup_ptr(blob_index)) {
+    return *data;
+  }
+  if (std::optional<Array<std::byte>> data = decoded_blobs_.pop_try(blob_index)) {
+    return decoded.lookup_or_add(blob_index, std::move(*data));
+  }
+
+  /* Find the chain of blobs the data is stored relative to, up to one that is stored directly or
+   * decoded already. */
+  Vector<int, 16> chain = {blob_index};
+  const Array<std::byte> *root_data = nullptr;
+  while (const std::optional<int> base_blob = blobs_[chain.last()].base_blob) {
+    if (const Array<std::byte> *data = decoded.lookup_ptr(*base_blob)) {
+      root_data = data;
+      break;
+    }
+    if (const Array<std::byte> *data = decoded_blobs_.lookup_ptr(*base_blob)) {
+      root_data = data;
+      break;
+    }
+    chain.append(*base_blob);
+  }
+
+  Array<std::byte> prev_data;
+  Span<std::byte> base = root_data ? Span<std::byte>(*root_data) : Span<std::byte>();
+  for (const int i : chain.index_range()) {
+    const Blob &blob = blobs_[chain[chain.size() - 1 - i]];
+    Array<std::byte> data(blob.size, NoInitialization());
+    if (use_shuffle(blob.size)) {
+      Array<std::byte> shuffled(blob.size, NoInitialization());
+      if (!decompress(blob.compressed, shuffled)) {
+        BLI_assert_unreachable();
+      }
+      unshuffle_bytes(shuffled, data);
+    }
+    else if (!decompress(blob.compressed, data)) {
+      BLI_assert_unreachable();
+    }
+    if (blob.base_blob) {
+      xor_bytes(base, data);
+    }
+    prev_data = std::move(data);
+    base = prev_data;
+  }
+  return decoded.lookup_or_add(blob_index, std::move(prev_data));
+}
+
+void CompressedFrameStore::prefetch(const int frame_index)
+{
+  {
+    std::lock_guard lock{mutex_};
+    if (!frames_.index_range().contains(frame_index)) {
+      return;
+    }
+    if (prefetched_ && prefetched_->first == frame_index) {
+      return;
+    }
+  }
+  if (!prefetch_pool_) {
+    prefetch_pool_ = BLI_task_pool_create_background_serial(this, TASK_PRIORITY_LOW);
+  }
+  BLI_task_pool_push(
+      prefetch_pool_,
+      [](TaskPool *__restrict pool, void *taskdata) {
+        CompressedFrameStore &store = *static_cast<CompressedFrameStore *>(
+            BLI_task_pool_user_data(pool));
+        const int frame_index = POINTER_AS_INT(taskdata);
+        std::lock_guard lock{store.mutex_};
+        if (store.prefetched_ && store.prefetched_->first == frame_index) {
+          return;
+        }
+        std::optional<BakeState> state = store.load_locked(frame_index);
+        if (state) {
+          store.prefetched_.emplace(frame_index, std::move(*state));
+        }
+      },
+      POINTER_FROM_INT(frame_index),
+      false,
+      nullptr);
+}
+
+void CompressedFrameStore::wait_for_prefetch()
+{
+  if (prefetch_pool_) {
+    BLI_task_pool_work_and_wait(prefetch_pool_);
+  }
+}
+
+int CompressedFrameStore::frames_num() const
+{
+  std::lock_guard lock{mutex_};
+  return frames_.size();
+}
+
+int64_t CompressedFrameStore::compressed_size() const
+{
+  std::lock_guard lock{mutex_};
+  return compressed_size_;
+}
+
+int64_t CompressedFrameStore::uncompressed_size() const
+{
+  std::lock_guard lock{mutex_};
+  return uncompressed_size_;
+}
+
+}  // namespace blender::bke::bake
@@ -0,0 +1,163 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_array_utils.hh"
+#include "BLI_math_vector_types.hh"
+
+#include "BKE_attribute.hh"
+#include "BKE_bake_compressed_frames.hh"
+#include "BKE_idtype.hh"
+#include "BKE_pointcloud.hh"
+
+#include "CLG_log.h"
+
+#include "DNA_pointcloud_types.h"
+
+namespace blender::bke::bake::tests {
+
+class CompressedFrameStoreTest : public testing::Test {
+ protected:
+  static constexpr int frames_num = 20;
+  static constexpr int points_num = 1000;
+  /** Frame in which points are added, so that arrays of different sizes are XOR-ed. */
+  static constexpr int resized_frame = 7;
+
+  static void SetUpTestSuite()
+  {
+    CLG_init();
+    BKE_idtype_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    CLG_exit();
+  }
+
+  static int frame_points_num(const int frame)
+  {
+    return frame < resized_frame ? points_num : points_num + 10;
+  }
+
+  static float3 expected_position(const int frame, const int point)
+  {
+    return float3(point, float(frame) * 0.01f, 0.0f);
+  }
+
+  /**
+   * Create the states of all frames. The positions change in every frame, while the ids are
+   * shared with the previous frame except when the points change.
+   */
+  static Vector<BakeState> create_states()
+  {
+    Vector<BakeState> states;
+    GeometrySet geometry;
+    for (const int frame : IndexRange(frames_num)) {
+      if (geometry.is_empty() || frame == resized_frame) {
+        PointCloud *pointcloud = BKE_pointcloud_new_nomain(frame_points_num(frame));
+        MutableAttributeAccessor attributes = pointcloud->attributes_for_write();
+        SpanAttributeWriter<int> ids = attributes.lookup_or_add_for_write_only_span<int>(
+            "id", AttrDomain::Point);
+        array_utils::fill_index_range(ids.span);
+        ids.finish();
+        geometry = GeometrySet::from_pointcloud(pointcloud);
+      }
+      /* The point cloud is shared with the previous state, so it is copied here. The copy shares
+       * its arrays, and only the positions are copied on write. */
+      MutableSpan<float3> positions = geometry.get_pointcloud_for_write()->positions_for_write();
+      for (const int i : positions.index_range()) {
+        positions[i] = expected_position(frame, i);
+      }
+
+      BakeState state;
+      state.items_by_id.add_new(0, std::make_unique<GeometryBakeItem>(geometry));
+      state.items_by_id.add_new(1,
+                                std::make_unique<PrimitiveBakeItem>(CPPType::get<int>(), &frame));
+      states.append(std::move(state));
+    }
+    return states;
+  }
+
+  static void expect_frame(const std::optional<BakeState> &state, const int frame)
+  {
+    ASSERT_TRUE(state.has_value());
+    const auto *frame_item = dynamic_cast<const PrimitiveBakeItem *>(
+        state->items_by_id.lookup(1).get());
+    ASSERT_NE(frame_item, nullptr);
+    EXPECT_EQ(*static_cast<const int *>(frame_item->value()), frame);
+
+    const auto *geometry_item = dynamic_cast<const GeometryBakeItem *>(
+        state->items_by_id.lookup(0).get());
+    ASSERT_NE(geometry_item, nullptr);
+    const PointCloud *pointcloud = geometry_item->geometry.get_pointcloud();
+    ASSERT_NE(pointcloud, nullptr);
+    ASSERT_EQ(pointcloud->totpoint, frame_points_num(frame));
+
+    const Span<float3> positions = pointcloud->positions();
+    const VArraySpan<int> ids = *pointcloud->attributes().lookup<int>("id");
+    for (const int i : positions.index_range()) {
+      EXPECT_EQ(positions[i], expected_position(frame, i));
+      EXPECT_EQ(ids[i], i);
+    }
+  }
+};
+
+TEST_F(CompressedFrameStoreTest, round_trip)
+{
+  static_assert(frames_num > CompressedFrameStore::keyframe_interval);
+  const Vector<BakeState> states = create_states();
+  CompressedFrameStore store;
+  for (const int frame : states.index_range()) {
+    EXPECT_EQ(store.add(states[frame]), frame);
+  }
+  EXPECT_EQ(store.frames_num(), frames_num);
+
+  /* The ids are stored once for every set of points, not for every frame. */
+  const int64_t frame_data_size = points_num * int64_t(sizeof(float3) + sizeof(int));
+  EXPECT_LT(store.uncompressed_size(), frames_num * frame_data_size);
+  /* Positions only change a little between frames, so their differences compress well. */
+  EXPECT_LT(store.compressed_size(), store.uncompressed_size() / 2);
+
+  /* In order, which reuses the blobs decoded for the previous frame. */
+  for (const int frame : IndexRange(frames_num)) {
+    expect_frame(store.load(frame), frame);
+  }
+  /* Out of order, including frames after a keyframe and after the points changed. */
+  for (const int frame : {CompressedFrameStore::keyframe_interval + 2,
+                          3,
+                          CompressedFrameStore::keyframe_interval,
+                          0,
+                          resized_frame,
+                          resized_frame - 1,
+                          frames_num - 1})
+  {
+    expect_frame(store.load(frame), frame);
+  }
+  EXPECT_FALSE(store.load(frames_num).has_value());
+}
+
+TEST_F(CompressedFrameStoreTest, prefetch)
+{
+  const Vector<BakeState> states = create_states();
+  CompressedFrameStore store;
+  for (const BakeState &state : states) {
+    store.add(state);
+  }
+
+  store.prefetch(10);
+  expect_frame(store.load(10), 10);
+  /* A different frame than the prefetched one is decoded directly. */
+  store.prefetch(2);
+  expect_frame(store.load(12), 12);
+  expect_frame(store.load(2), 2);
+  /* Prefetching while frames are added. */
+  store.prefetch(frames_num - 1);
+  store.add(states.last());
+  expect_frame(store.load(frames_num - 1), frames_num - 1);
+  expect_frame(store.load(frames_num), frames_num - 1);
+  store.prefetch(frames_num + 1);
+}
+
+}  // namespace blender::bke::bake::tests
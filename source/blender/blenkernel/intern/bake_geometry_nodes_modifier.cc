@@ -38,6 +38,14 @@ void NodeBakeCache::reset()
   new (this) NodeBakeCache();
 }
 
+BakeStateRef FrameCache::state_ref() const
+{
+  if (this->decompressed_state) {
+    return this->decompressed_state;
+  }
+  return this->state;
+}
+
 IndexRange NodeBakeCache::frame_range() const
 {
   if (this->frames.is_empty()) {
@@ -48,6 +56,62 @@ IndexRange NodeBakeCache::frame_range() const
   return IndexRange::from_begin_end_inclusive(start_frame, end_frame);
 }
 
+/**
+ * Enough for the states that are read in a single evaluation: the previous frame that is the
+ * input of the simulation and the two frames that are interpolated.
+ */
+static constexpr int max_decompressed_frames = 4;
+
+void NodeBakeCache::compress_frame(const int frame_index)
+{
+  FrameCache &frame_cache = *this->frames[frame_index];
+  if (frame_cache.compressed_index || frame_cache.state.items_by_id.is_empty()) {
+    return;
+  }
+  if (!this->compressed_frames) {
+    this->compressed_frames = std::make_unique<CompressedFrameStore>();
+  }
+  frame_cache.compressed_index = this->compressed_frames->add(frame_cache.state);
+  frame_cache.state = {};
+}
+
+void NodeBakeCache::ensure_frame_decompressed(const int frame_index)
+{
+  FrameCache &frame_cache = *this->frames[frame_index];
+  if (!frame_cache.compressed_index) {
+    return;
+  }
+  this->decompressed_frames.remove_if([&](const int index) { return index == frame_index; });
+  if (!frame_cache.decompressed_state) {
+    std::optional<BakeState> state = this->compressed_frames->load(*frame_cache.compressed_index);
+    if (!state) {
+      return;
+    }
+    frame_cache.decompressed_state = std::make_shared<const BakeState>(std::move(*state));
+  }
+  this->decompressed_frames.append(frame_index);
+
+  while (this->decompressed_frames.size() > max_decompressed_frames) {
+    const int old_index = this->decompressed_frames.first();
+    this->decompressed_frames.remove(0);
+    if (this->frames.index_range().contains(old_index)) {
+      /* Evaluations that still read the state keep it alive. */
+      this->frames[old_index]->decompressed_state.reset();
+    }
+  }
+}
+
+void NodeBakeCache::prefetch_frame(const int frame_index)
+{
+  if (!this->frames.index_range().contains(frame_index)) {
+    return;
+  }
+  const FrameCache &frame_cache = *this->frames[frame_index];
+  if (frame_cache.compressed_index && !frame_cache.decompressed_state) {
+    this->compressed_frames->prefetch(*frame_cache.compressed_index);
+  }
+}
+
 SimulationNodeCache *ModifierCache::get_simulation_node_cache(const int id)
 {
   std::unique_ptr<SimulationNodeCache> *ptr = this->simulation_cache_by_id.lookup_ptr(id);
@@ -434,6 +434,17 @@ static std::unique_ptr<BVHTree, BVHTreeDeleter> bvhtree_new_common(int elems_num
   return std::unique_ptr<BVHTree, BVHTreeDeleter>(BLI_bvhtree_new(elems_num, 0.0f, 2, 6));
 }
 
+/**
+ * Triangle trees are mostly used for ray-casts and nearest point queries, for which the
+ * additional wide tree is faster. Small trees are not worth the extra build time and memory.
+ * The wide tree is only built once it is used, see #BVH_BALANCE_WIDE.
+ */
+static void bvhtree_balance_tris(BVHTree &tree, const int tris_num)
+{
+  constexpr int wide_tree_tris_min = 4096;
+  BLI_bvhtree_balance_ex(&tree, tris_num >= wide_tree_tris_min ? BVH_BALANCE_WIDE : 0);
+}
+
 static std::unique_ptr<BVHTree, BVHTreeDeleter> create_tree_from_verts(
     const Span<float3> positions, const IndexMask &verts_mask)
 {
@@ -516,7 +527,7 @@ static std::unique_ptr<BVHTree, BVHTreeDeleter> create_tree_from_tris(const Span
     copy_v3_v3(co[2], positions[corner_verts[corner_tris[tri][2]]]);
     BLI_bvhtree_insert(tree.get(), tri, co[0], 3);
   }
-  BLI_bvhtree_balance(tree.get());
+  bvhtree_balance_tris(*tree, corner_tris.size());
   return tree;
 }
 
@@ -549,7 +560,7 @@ static std::unique_ptr<BVHTree, BVHTreeDeleter> create_tree_from_tris(
       BLI_bvhtree_insert(tree.get(), tri, co[0], 3);
     }
   });
-  BLI_bvhtree_balance(tree.get());
+  bvhtree_balance_tris(*tree, tris_num);
   return tree;
 }
 
@@ -24,7 +24,9 @@
 #include "BLI_listbase.h"
 #include "BLI_math_vector.h"
 #include "BLI_math_vector_types.hh"
+#include "BLI_offset_indices.hh"
 #include "BLI_rect.h"
+#include "BLI_simd.hh"
 #include "BLI_sort_utils.h"
 #include "BLI_string.h"
 #include "BLI_string_utils.hh"
@@ -2462,6 +2464,343 @@ float calculate_fcurve(PathResolvedRNA *anim_rna,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name F-Curve - Compiled Evaluation
+ * \{ */
+
+namespace blender::bke {
+
+/* Same as the threshold used by #fcurve_eval_keyframes_interpolate. */
+static constexpr float compiled_key_threshold = 0.0001f;
+
+/* Slope of the extrapolation, matching #fcurve_eval_keyframes_extrapolate. Zero for constant. */
+static float fcurve_extrapolation_slope(const FCurve &fcu,
+                                        const BezTriple *bezts,
+                                        const int endpoint_offset,
+                                        const int direction_to_neighbor)
+{
+  const BezTriple *endpoint_bezt = bezts + endpoint_offset;
+  const BezTriple *neighbor_bezt = endpoint_bezt + direction_to_neighbor;
+
+  if (endpoint_bezt->ipo == BEZT_IPO_CONST || fcu.extend == FCURVE_EXTRAPOLATE_CONSTANT ||
+      (fcu.flag & FCURVE_DISCRETE_VALUES) != 0)
+  {
+    return 0.0f;
+  }
+  if (endpoint_bezt->ipo == BEZT_IPO_LIN) {
+    if (fcu.totvert == 1) {
+      return 0.0f;
+    }
+    const float fac = neighbor_bezt->vec[1][0] - endpoint_bezt->vec[1][0];
+    if (fac == 0.0f) {
+      return 0.0f;
+    }
+    return (neighbor_bezt->vec[1][1] - endpoint_bezt->vec[1][1]) / fac;
+  }
+  const int handle = direction_to_neighbor > 0 ? 0 : 2;
+  const float fac = endpoint_bezt->vec[1][0] - endpoint_bezt->vec[handle][0];
+  if (fac == 0.0f) {
+    return 0.0f;
+  }
+  return (endpoint_bezt->vec[1][1] - endpoint_bezt->vec[handle][1]) / fac;
+}
+
+CompiledFCurves::CompiledFCurves(const Span<const FCurve *> fcurves)
+    : fcurves_(fcurves),
+      use_generic_(fcurves.size()),
+      use_int_values_(fcurves.size()),
+      key_offsets_(fcurves.size() + 1),
+      extrapolation_slopes_(fcurves.size()),
+      last_segment_(std::make_unique<std::atomic<int>[]>(fcurves.size()))
+{
+  for (const int i : fcurves.index_range()) {
+    const FCurve &fcu = *fcurves[i];
+    use_generic_[i] = fcu.bezt == nullptr || fcu.totvert == 0 || fcu.driver != nullptr ||
+                      !BLI_listbase_is_empty(&fcu.modifiers);
+    use_int_values_[i] = (fcu.flag & FCURVE_INT_VALUES) != 0;
+    key_offsets_[i] = use_generic_[i] ? 0 : int(fcu.totvert);
+    last_segment_[i].store(0, std::memory_order_relaxed);
+  }
+  const OffsetIndices<int> key_offsets = offset_indices::accumulate_counts_to_offsets(
+      key_offsets_);
+
+  key_times_.reinitialize(key_offsets.total_size());
+  key_values_.reinitialize(key_offsets.total_size());
+  segment_types_.reinitialize(key_offsets.total_size());
+  segment_coefficients_.reinitialize(key_offsets.total_size());
+  segment_bezier_x_.reinitialize(key_offsets.total_size());
+
+  threading::parallel_for(fcurves.index_range(), 256, [&](const IndexRange range) {
+    for (const int i : range) {
+      if (!use_generic_[i] && !this->compile_curve(i)) {
+        use_generic_[i] = true;
+      }
+    }
+  });
+}
+
+bool CompiledFCurves::compile_curve(const int curve_index)
+{
+  const FCurve &fcu = *fcurves_[curve_index];
+  const IndexRange keys = OffsetIndices<int>(key_offsets_)[curve_index];
+  const Span<BezTriple> bezts(fcu.bezt, fcu.totvert);
+
+  for (const int key : bezts.index_range()) {
+    key_times_[keys[key]] = bezts[key].vec[1][0];
+    key_values_[keys[key]] = bezts[key].vec[1][1];
+  }
+  extrapolation_slopes_[curve_index] = float2(
+      fcurve_extrapolation_slope(fcu, fcu.bezt, 0, +1),
+      fcurve_extrapolation_slope(fcu, fcu.bezt, fcu.totvert - 1, -1));
+
+  for (const int key : bezts.index_range().drop_back(1)) {
+    const BezTriple &prevbezt = bezts[key];
+    const BezTriple &bezt = bezts[key + 1];
+    const float duration = bezt.vec[1][0] - prevbezt.vec[1][0];
+    if (duration < 0.0f) {
+      /* Unsorted keys, for example while transforming them. */
+      return false;
+    }
+
+    SegmentType &type = segment_types_[keys[key]];
+    float4 &coefficients = segment_coefficients_[keys[key]];
+    type = SegmentType::Constant;
+    if ((prevbezt.ipo == BEZT_IPO_CONST) || (fcu.flag & FCURVE_DISCRETE_VALUES) || (duration == 0))
+    {
+      continue;
+    }
+
+    switch (prevbezt.ipo) {
+      case BEZT_IPO_BEZ: {
+        float v1[2], v2[2], v3[2], v4[2];
+        copy_v2_v2(v1, prevbezt.vec[1]);
+        copy_v2_v2(v2, prevbezt.vec[2]);
+        copy_v2_v2(v3, bezt.vec[0]);
+        copy_v2_v2(v4, bezt.vec[1]);
+        if (fabsf(v1[1] - v4[1]) < FLT_EPSILON && fabsf(v2[1] - v3[1]) < FLT_EPSILON &&
+            fabsf(v3[1] - v4[1]) < FLT_EPSILON)
+        {
+          break;
+        }
+        BKE_fcurve_correct_bezpart(v1, v2, v3, v4);
+
+        /* Same arithmetic as `findzero` and `berekeny`, so the results match exactly. */
+        type = SegmentType::Bezier;
+        segment_bezier_x_[keys[key]] = float4(v1[0],
+                                              3.0f * (v2[0] - v1[0]),
+                                              3.0f * (v1[0] - 2.0f * v2[0] + v3[0]),
+                                              v4[0] - v1[0] + 3.0f * (v2[0] - v3[0]));
+        coefficients = float4(v1[1],
+                              3.0f * (v2[1] - v1[1]),
+                              3.0f * (v1[1] - 2.0f * v2[1] + v3[1]),
+                              v4[1] - v1[1] + 3.0f * (v2[1] - v3[1]));
+        break;
+      }
+      case BEZT_IPO_LIN:
+        type = SegmentType::Linear;
+        coefficients = float4(prevbezt.vec[1][1], bezt.vec[1][1] - prevbezt.vec[1][1], duration, 0.0f);
+        break;
+      default:
+        /* Easing equations are not compiled. */
+        return false;
+    }
+  }
+  return true;
+}
+
+int CompiledFCurves::find_segment(const int curve_index, const float evaltime) const
+{
+  const IndexRange keys = OffsetIndices<int>(key_offsets_)[curve_index];
+  const Span<float> times = key_times_.as_span().slice(keys);
+
+  /* Check the last used segment and the one after it first, for sequential playback. */
+  const int last = last_segment_[curve_index].load(std::memory_order_relaxed);
+  for (const int segment : {last, last + 1}) {
+    if (segment + 1 < times.size() && times[segment] <= evaltime &&
+        evaltime < times[segment + 1])
+    {
+      if (segment != last) {
+        last_segment_[curve_index].store(segment, std::memory_order_relaxed);
+      }
+      return segment;
+    }
+  }
+
+  const int segment = int(std::upper_bound(times.begin(), times.end(), evaltime) -
+                          times.begin()) -
+                      1;
+  last_segment_[curve_index].store(segment, std::memory_order_relaxed);
+  return segment;
+}
+
+namespace {
+
+/* Segment of a curve whose value is computed in a batch, once the parameter is known. */
+struct SegmentEvaluation {
+  int curve_index;
+  int key_index;
+  /* Time since the segment start for linear segments, curve parameter for Bezier segments. */
+  float parameter;
+};
+
+}  // namespace
+
+#if BLI_HAVE_SSE2
+/* Load the coefficients of four segments, transposed so that every register holds one
+ * coefficient of all segments. */
+static void load_segment_coefficients(const Span<float4> coefficients,
+                                      const Span<SegmentEvaluation> segments,
+                                      __m128 r_coefficients[4])
+{
+  for (const int i : IndexRange(4)) {
+    r_coefficients[i] = _mm_loadu_ps(coefficients[segments[i].key_index]);
+  }
+  _MM_TRANSPOSE4_PS(r_coefficients[0], r_coefficients[1], r_coefficients[2], r_coefficients[3]);
+}
+
+static __m128 load_segment_parameters(const Span<SegmentEvaluation> segments)
+{
+  return _mm_setr_ps(
+      segments[0].parameter, segments[1].parameter, segments[2].parameter, segments[3].parameter);
+}
+
+static void store_segment_values(const Span<SegmentEvaluation> segments,
+                                 const __m128 values,
+                                 MutableSpan<float> r_values)
+{
+  float4 result;
+  _mm_storeu_ps(result, values);
+  for (const int i : IndexRange(4)) {
+    r_values[segments[i].curve_index] = result[i];
+  }
+}
+#endif
+
+static void evaluate_linear_segments(const Span<float4> coefficients,
+                                     const Span<SegmentEvaluation> segments,
+                                     MutableSpan<float> r_values)
+{
+  int i = 0;
+#if BLI_HAVE_SSE2
+  for (; i + 4 <= segments.size(); i += 4) {
+    const Span<SegmentEvaluation> batch = segments.slice(i, 4);
+    __m128 c[4];
+    load_segment_coefficients(coefficients, batch, c);
+    const __m128 time = load_segment_parameters(batch);
+    /* Same as #BLI_easing_linear_ease. */
+    const __m128 values = _mm_add_ps(_mm_div_ps(_mm_mul_ps(c[1], time), c[2]), c[0]);
+    store_segment_values(batch, values, r_values);
+  }
+#endif
+  for (; i < segments.size(); i++) {
+    const float4 &c = coefficients[segments[i].key_index];
+    r_values[segments[i].curve_index] = BLI_easing_linear_ease(
+        segments[i].parameter, c[0], c[1], c[2]);
+  }
+}
+
+static void evaluate_bezier_segments(const Span<float4> coefficients,
+                                     const Span<SegmentEvaluation> segments,
+                                     MutableSpan<float> r_values)
+{
+  int i = 0;
+#if BLI_HAVE_SSE2
+  for (; i + 4 <= segments.size(); i += 4) {
+    const Span<SegmentEvaluation> batch = segments.slice(i, 4);
+    __m128 c[4];
+    load_segment_coefficients(coefficients, batch, c);
+    const __m128 t = load_segment_parameters(batch);
+    const __m128 t2 = _mm_mul_ps(t, t);
+    /* Same as `berekeny`. */
+    const __m128 values = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(c[0], _mm_mul_ps(t, c[1])), _mm_mul_ps(t2, c[2])),
+        _mm_mul_ps(_mm_mul_ps(t2, t), c[3]));
+    store_segment_values(batch, values, r_values);
+  }
+#endif
+  for (; i < segments.size(); i++) {
+    const float4 &c = coefficients[segments[i].key_index];
+    const float t = segments[i].parameter;
+    r_values[segments[i].curve_index] = c[0] + t * c[1] + t * t * c[2] + t * t * t * c[3];
+  }
+}
+
+void CompiledFCurves::evaluate(const float evaltime, MutableSpan<float> r_values) const
+{
+  BLI_assert(r_values.size() == fcurves_.size());
+  const OffsetIndices<int> key_offsets(key_offsets_);
+
+  threading::parallel_for(fcurves_.index_range(), 1024, [&](const IndexRange range) {
+    Vector<SegmentEvaluation, 64> linear_segments;
+    Vector<SegmentEvaluation, 64> bezier_segments;
+
+    for (const int curve_index : range) {
+      if (use_generic_[curve_index]) {
+        r_values[curve_index] = evaluate_fcurve(fcurves_[curve_index], evaltime);
+        continue;
+      }
+      const IndexRange keys = key_offsets[curve_index];
+      const float first_time = key_times_[keys.first()];
+      const float last_time = key_times_[keys.last()];
+      if (evaltime <= first_time) {
+        const float dx = first_time - evaltime;
+        r_values[curve_index] = key_values_[keys.first()] -
+                                (extrapolation_slopes_[curve_index].x * dx);
+        continue;
+      }
+      if (last_time <= evaltime) {
+        const float dx = last_time - evaltime;
+        r_values[curve_index] = key_values_[keys.last()] -
+                                (extrapolation_slopes_[curve_index].y * dx);
+        continue;
+      }
+
+      const int key_index = keys[this->find_segment(curve_index, evaltime)];
+      const float start_time = key_times_[key_index];
+      if (IS_EQT(evaltime, start_time, compiled_key_threshold)) {
+        r_values[curve_index] = key_values_[key_index];
+        continue;
+      }
+      if (IS_EQT(evaltime, key_times_[key_index + 1], compiled_key_threshold)) {
+        r_values[curve_index] = key_values_[key_index + 1];
+        continue;
+      }
+
+      switch (segment_types_[key_index]) {
+        case SegmentType::Constant:
+          r_values[curve_index] = key_values_[key_index];
+          break;
+        case SegmentType::Linear:
+          linear_segments.append({curve_index, key_index, evaltime - start_time});
+          break;
+        case SegmentType::Bezier: {
+          const float4 &x = segment_bezier_x_[key_index];
+          float opl[32];
+          if (!solve_cubic(double(x[0] - evaltime), x[1], x[2], x[3], opl)) {
+            r_values[curve_index] = 0.0f;
+            break;
+          }
+          bezier_segments.append({curve_index, key_index, opl[0]});
+          break;
+        }
+      }
+    }
+
+    evaluate_linear_segments(segment_coefficients_, linear_segments, r_values);
+    evaluate_bezier_segments(segment_coefficients_, bezier_segments, r_values);
+
+    for (const int curve_index : range) {
+      if (use_int_values_[curve_index] && !use_generic_[curve_index]) {
+        r_values[curve_index] = floorf(r_values[curve_index] + 0.5f);
+      }
+    }
+  });
+}
+
+}  // namespace blender::bke
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name F-Curve - .blend file API
  * \{ */
@@ -11,7 +11,9 @@
 
 #include "DNA_anim_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_math_vector_types.hh"
+#include "BLI_vector.hh"
 
 namespace blender::bke::tests {
 using namespace blender::animrig;
@@ -232,6 +234,56 @@ TEST(evaluate_fcurve, ExtrapolationBezierKeys)
   BKE_fcurve_free(fcu);
 }
 
+TEST(compiled_fcurves, MatchesEvaluateFCurve)
+{
+  const KeyframeSettings settings = get_keyframe_settings(false);
+  Vector<FCurve *> fcurves;
+  auto add_fcurve = [&](const int key_count, const eBezTriple_Interpolation ipo) {
+    FCurve *fcu = BKE_fcurve_create();
+    for (const int i : IndexRange(key_count)) {
+      insert_vert_fcurve(
+          fcu, {float(i * 3), float((i * 7) % 5) - 2.0f}, settings, INSERTKEY_NOFLAGS);
+    }
+    for (BezTriple &bezt : MutableSpan(fcu->bezt, fcu->totvert)) {
+      bezt.ipo = ipo;
+    }
+    fcu->extend = FCURVE_EXTRAPOLATE_LINEAR;
+    fcurves.append(fcu);
+    return fcu;
+  };
+
+  add_fcurve(1, BEZT_IPO_BEZ);
+  add_fcurve(2, BEZT_IPO_LIN);
+  add_fcurve(6, BEZT_IPO_CONST);
+  add_fcurve(6, BEZT_IPO_LIN);
+  add_fcurve(6, BEZT_IPO_BEZ)->flag |= FCURVE_INT_VALUES;
+  add_fcurve(6, BEZT_IPO_BOUNCE);
+  for (const int i : IndexRange(8)) {
+    FCurve *fcu = add_fcurve(5 + i, BEZT_IPO_BEZ);
+    fcu->bezt[1].vec[2][0] += 0.5f;
+    fcu->bezt[1].vec[2][1] += float(i);
+    if (i % 2) {
+      fcu->extend = FCURVE_EXTRAPOLATE_CONSTANT;
+    }
+  }
+
+  CompiledFCurves compiled(fcurves.as_span().cast<const FCurve *>());
+  Array<float> values(fcurves.size());
+  /* Go forward and backward to test looking up segments from the previous evaluation. */
+  for (const float frame : {-2.0f, 0.0f, 0.5f, 1.0f, 2.99995f, 3.0f, 4.2f, 7.7f, 14.0f, 40.0f,
+                            31.5f, 5.25f, 6.00005f, 1.75f})
+  {
+    compiled.evaluate(frame, values);
+    for (const int i : fcurves.index_range()) {
+      EXPECT_EQ(values[i], evaluate_fcurve(fcurves[i], frame)) << "curve " << i << " at " << frame;
+    }
+  }
+
+  for (FCurve *fcu : fcurves) {
+    BKE_fcurve_free(fcu);
+  }
+}
+
 TEST(fcurve_subdivide, BKE_fcurve_bezt_subdivide_handles)
 {
   FCurve *fcu = BKE_fcurve_create();
@@ -37,6 +37,7 @@
 #include "BKE_lib_id.hh"
 #include "BKE_material.hh"
 #include "BKE_mesh.hh"
+#include "BKE_mesh_eval_share.hh"
 #include "BKE_mesh_iterators.hh"
 #include "BKE_mesh_runtime.hh"
 #include "BKE_mesh_wrapper.hh"
@@ -982,28 +983,47 @@ static void mesh_build_data(Depsgraph &depsgraph,
   }
 #endif
 
+  Mesh *mesh = (Mesh *)ob.data;
   Mesh *mesh_eval = nullptr, *mesh_deform_eval = nullptr;
   GeometrySet *geometry_set_eval = nullptr;
-  mesh_calc_modifiers(depsgraph,
-                      scene,
-                      ob,
-                      true,
-                      need_mapping,
-                      dataMask,
-                      true,
-                      true,
-                      &mesh_deform_eval,
-                      &mesh_eval,
-                      &geometry_set_eval);
-
-  /* The modifier stack evaluation is storing result in mesh->runtime.mesh_eval, but this result
-   * is not guaranteed to be owned by object.
-   *
-   * Check ownership now, since later on we can not go to a mesh owned by someone else via
-   * object's runtime: this could cause access freed data on depsgraph destruction (mesh who owns
-   * the final result might be freed prior to object). */
-  Mesh *mesh = (Mesh *)ob.data;
-  const bool is_mesh_eval_owned = (mesh_eval != mesh->runtime->mesh_eval);
+  CustomData_MeshMasks data_mask_eval = dataMask;
+  bool need_mapping_eval = need_mapping;
+  bool is_mesh_eval_owned;
+
+  /* Reuse the mesh another dependency graph evaluated with the same result, typically the
+   * viewport one when rendering. */
+  if (mesh_eval_share_lookup(depsgraph,
+                             ob,
+                             dataMask,
+                             &mesh_eval,
+                             &mesh_deform_eval,
+                             &data_mask_eval,
+                             &need_mapping_eval))
+  {
+    geometry_set_eval = new GeometrySet();
+    is_mesh_eval_owned = true;
+  }
+  else {
+    mesh_calc_modifiers(depsgraph,
+                        scene,
+                        ob,
+                        true,
+                        need_mapping,
+                        dataMask,
+                        true,
+                        true,
+                        &mesh_deform_eval,
+                        &mesh_eval,
+                        &geometry_set_eval);
+
+    /* The modifier stack evaluation is storing result in mesh->runtime.mesh_eval, but this
+     * result is not guaranteed to be owned by object.
+     *
+     * Check ownership now, since later on we can not go to a mesh owned by someone else via
+     * object's runtime: this could cause access freed data on depsgraph destruction (mesh who
+     * owns the final result might be freed prior to object). */
+    is_mesh_eval_owned = (mesh_eval != mesh->runtime->mesh_eval);
+  }
   BKE_object_eval_assign_data(&ob, &mesh_eval->id, is_mesh_eval_owned);
 
   /* Add the final mesh as a non-owning component to the geometry set. */
@@ -1012,8 +1032,8 @@ static void mesh_build_data(Depsgraph &depsgraph,
   ob.runtime->geometry_set_eval = geometry_set_eval;
 
   ob.runtime->mesh_deform_eval = mesh_deform_eval;
-  ob.runtime->last_data_mask = dataMask;
-  ob.runtime->last_need_mapping = need_mapping;
+  ob.runtime->last_data_mask = data_mask_eval;
+  ob.runtime->last_need_mapping = need_mapping_eval;
 
   /* Make sure that drivers can target shapekey properties.
    * Note that this causes a potential inconsistency, as the shapekey may have a
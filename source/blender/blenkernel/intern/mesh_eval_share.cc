@@ -0,0 +1,544 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include <atomic>
+#include <mutex>
+
+#include "BLI_listbase.h"
+#include "BLI_map.hh"
+#include "BLI_mutex.hh"
+
+#include "DNA_collection_types.h"
+#include "DNA_curve_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meta_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_node_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_customdata.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_lib_query.hh"
+#include "BKE_mesh.h"
+#include "BKE_mesh_eval_share.hh"
+#include "BKE_mesh_types.hh"
+#include "BKE_modifier.hh"
+#include "BKE_node_legacy_types.hh"
+#include "BKE_object_types.hh"
+#include "BKE_scene.hh"
+
+#include "DEG_depsgraph.hh"
+#include "DEG_depsgraph_query.hh"
+
+namespace blender::bke {
+
+namespace {
+
+struct SharedMesh {
+  const Depsgraph *source;
+  uint32_t scene_session_uid;
+  /* Copies of the evaluated meshes, with ID pointers remapped to the original data-blocks. */
+  GeometrySet mesh_final;
+  GeometrySet mesh_deform;
+  CustomData_MeshMasks data_mask;
+  bool need_mapping;
+};
+
+struct SourceState {
+  /* Scene time of the last evaluation. */
+  float ctime = 0.0f;
+  /* The dependency graph has updates which are not evaluated yet. */
+  bool is_outdated = true;
+};
+
+struct MeshEvalShare {
+  Mutex mutex;
+  /* Number of dependency graphs which may reuse shared meshes. */
+  int consumers_num = 0;
+  /* Active viewport dependency graphs, whose meshes can be collected. */
+  Map<const Depsgraph *, SourceState> sources;
+  /* Shared meshes by the session UID of the original object. */
+  Map<uint32_t, SharedMesh> meshes;
+  /* Size of #meshes, read without locking to skip invalidating while nothing is stored. */
+  std::atomic<int64_t> meshes_num = 0;
+};
+
+MeshEvalShare &mesh_eval_share()
+{
+  static MeshEvalShare share;
+  return share;
+}
+
+bool modifier_is_mode_dependent(const Scene &scene, ModifierData &md)
+{
+  const bool is_enabled = BKE_modifier_is_enabled(&scene, &md, eModifierMode_Render);
+  if (is_enabled != BKE_modifier_is_enabled(&scene, &md, eModifierMode_Realtime)) {
+    return true;
+  }
+  if (!is_enabled) {
+    return false;
+  }
+  const ModifierTypeInfo *mti = BKE_modifier_get_info(ModifierType(md.type));
+  if (mti->flags & eModifierTypeFlag_UsesPointCache) {
+    /* Only the active dependency graph writes to the point caches. */
+    return true;
+  }
+  switch (md.type) {
+    case eModifierType_Subsurf: {
+      const SubsurfModifierData &smd = reinterpret_cast<const SubsurfModifierData &>(md);
+      return smd.levels != smd.renderLevels;
+    }
+    case eModifierType_Multires: {
+      const MultiresModifierData &mmd = reinterpret_cast<const MultiresModifierData &>(md);
+      return mmd.lvl != mmd.renderlvl;
+    }
+    case eModifierType_Screw: {
+      const ScrewModifierData &smd = reinterpret_cast<const ScrewModifierData &>(md);
+      return smd.steps != smd.render_steps;
+    }
+    case eModifierType_Ocean: {
+      const OceanModifierData &omd = reinterpret_cast<const OceanModifierData &>(md);
+      return omd.resolution != omd.viewport_resolution;
+    }
+    case eModifierType_ParticleSystem:
+    case eModifierType_GreasePencilLineart:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool node_tree_is_mode_dependent(const bNodeTree &ntree)
+{
+  LISTBASE_FOREACH (const bNode *, node, &ntree.nodes) {
+    if (ELEM(node->type_legacy,
+             GEO_NODE_IS_VIEWPORT,
+             GEO_NODE_VIEWER,
+             GEO_NODE_SIMULATION_OUTPUT,
+             GEO_NODE_BAKE))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Whether evaluating the data-block, or data depending on it, can give a different result in
+ * render mode than in viewport mode. Only checks the data-block itself, not the ones it uses.
+ */
+bool id_is_mode_dependent(const Scene &scene, ID &id)
+{
+  switch (GS(id.name)) {
+    case ID_OB: {
+      Object &object = reinterpret_cast<Object &>(id);
+      if (object.mode != OB_MODE_OBJECT) {
+        return true;
+      }
+      /* Instanced collections only contain the objects visible in the evaluation mode. */
+      if (bool(object.visibility_flag & OB_HIDE_VIEWPORT) !=
+          bool(object.visibility_flag & OB_HIDE_RENDER))
+      {
+        return true;
+      }
+      VirtualModifierData virtual_modifier_data;
+      for (ModifierData *md = BKE_modifiers_get_virtual_modifierlist(&object,
+                                                                     &virtual_modifier_data);
+           md;
+           md = md->next)
+      {
+        if (modifier_is_mode_dependent(scene, *md)) {
+          return true;
+        }
+      }
+      return false;
+    }
+    case ID_GR: {
+      const Collection &collection = reinterpret_cast<const Collection &>(id);
+      return bool(collection.flag & COLLECTION_HIDE_VIEWPORT) !=
+             bool(collection.flag & COLLECTION_HIDE_RENDER);
+    }
+    case ID_NT:
+      return node_tree_is_mode_dependent(reinterpret_cast<const bNodeTree &>(id));
+    case ID_CU_LEGACY: {
+      const Curve &curve = reinterpret_cast<const Curve &>(id);
+      return (curve.resolu_ren != 0 && curve.resolu_ren != curve.resolu) ||
+             (curve.resolv_ren != 0 && curve.resolv_ren != curve.resolv);
+    }
+    case ID_MB: {
+      const MetaBall &mball = reinterpret_cast<const MetaBall &>(id);
+      return mball.rendersize != mball.wiresize;
+    }
+    default:
+      return false;
+  }
+}
+
+/**
+ * Whether evaluating the object can give a different result in render mode than in viewport
+ * mode, checking all the data-blocks its evaluation may depend on.
+ */
+bool object_eval_is_mode_dependent(const Scene &scene, Object &object)
+{
+  if (scene.r.mode & R_SIMPLIFY) {
+    return true;
+  }
+  if (id_is_mode_dependent(scene, object.id)) {
+    return true;
+  }
+  bool is_mode_dependent = false;
+  BKE_library_foreach_ID_link(
+      nullptr,
+      &object.id,
+      [&](LibraryIDLinkCallbackData *cb_data) {
+        ID *id = *cb_data->id_pointer;
+        if (id == nullptr) {
+          return IDWALK_RET_NOP;
+        }
+        if (cb_data->cb_flag & IDWALK_CB_LOOPBACK) {
+          return IDWALK_RET_STOP_RECURSION;
+        }
+        /* Data-blocks which can not affect the evaluated geometry. */
+        if (ELEM(GS(id->name),
+                 ID_SCE,
+                 ID_WO,
+                 ID_MA,
+                 ID_TE,
+                 ID_IM,
+                 ID_LA,
+                 ID_CA,
+                 ID_SPK,
+                 ID_LP,
+                 ID_TXT))
+        {
+          return IDWALK_RET_STOP_RECURSION;
+        }
+        if (id_is_mode_dependent(scene, *id)) {
+          is_mode_dependent = true;
+          return IDWALK_RET_STOP_ITER;
+        }
+        return IDWALK_RET_NOP;
+      },
+      nullptr,
+      IDWALK_RECURSE);
+  return is_mode_dependent;
+}
+
+/* Evaluated data-blocks belong to their dependency graph, the shared meshes can only refer to the
+ * original data-blocks. */
+void remap_id_pointers_to_original(Mesh &mesh)
+{
+  BKE_library_foreach_ID_link(
+      nullptr,
+      &mesh.id,
+      [](LibraryIDLinkCallbackData *cb_data) {
+        if (*cb_data->id_pointer) {
+          *cb_data->id_pointer = DEG_get_original_id(*cb_data->id_pointer);
+        }
+        return IDWALK_RET_NOP;
+      },
+      nullptr,
+      IDWALK_NOP);
+}
+
+bool remap_id_pointers_to_evaluated(const Depsgraph &depsgraph, Mesh &mesh)
+{
+  bool all_evaluated = true;
+  BKE_library_foreach_ID_link(
+      nullptr,
+      &mesh.id,
+      [&](LibraryIDLinkCallbackData *cb_data) {
+        ID *id = *cb_data->id_pointer;
+        if (id == nullptr) {
+          return IDWALK_RET_NOP;
+        }
+        ID *id_eval = DEG_get_evaluated_id(&depsgraph, id);
+        if (id_eval == id) {
+          /* The data-block is not part of this dependency graph. */
+          all_evaluated = false;
+        }
+        *cb_data->id_pointer = id_eval;
+        return IDWALK_RET_NOP;
+      },
+      nullptr,
+      IDWALK_NOP);
+  return all_evaluated;
+}
+
+GeometrySet copy_for_sharing(const Mesh &mesh)
+{
+  Mesh *mesh_copy = BKE_mesh_copy_for_eval(mesh);
+  remap_id_pointers_to_original(*mesh_copy);
+  return GeometrySet::from_mesh(mesh_copy);
+}
+
+Mesh *copy_from_shared(const Depsgraph &depsgraph, const GeometrySet &geometry)
+{
+  Mesh *mesh = BKE_mesh_copy_for_eval(*geometry.get_mesh());
+  if (!remap_id_pointers_to_evaluated(depsgraph, *mesh)) {
+    BKE_id_free(nullptr, mesh);
+    return nullptr;
+  }
+  return mesh;
+}
+
+void store_locked(MeshEvalShare &share,
+                  const Depsgraph &depsgraph,
+                  const Object &object,
+                  const Mesh &mesh_final,
+                  const Mesh *mesh_deform,
+                  const CustomData_MeshMasks &data_mask,
+                  const bool need_mapping)
+{
+  if (!DEG_is_active(&depsgraph) || DEG_get_mode(&depsgraph) != DAG_EVAL_VIEWPORT) {
+    return;
+  }
+  if (object.mode != OB_MODE_OBJECT) {
+    return;
+  }
+  if (mesh_final.runtime->wrapper_type != ME_WRAPPER_TYPE_MDATA ||
+      mesh_final.runtime->subsurf_runtime_data != nullptr)
+  {
+    /* The subdivision is done on the GPU when drawing, the mesh is not the final result. */
+    return;
+  }
+  const Scene &scene = *DEG_get_input_scene(&depsgraph);
+
+  SharedMesh shared_mesh;
+  shared_mesh.source = &depsgraph;
+  shared_mesh.scene_session_uid = scene.id.session_uid;
+  shared_mesh.mesh_final = copy_for_sharing(mesh_final);
+  if (mesh_deform) {
+    shared_mesh.mesh_deform = copy_for_sharing(*mesh_deform);
+  }
+  shared_mesh.data_mask = data_mask;
+  shared_mesh.need_mapping = need_mapping;
+
+  share.sources.lookup_or_add_default(&depsgraph);
+  share.meshes.add_overwrite(object.id.session_uid, std::move(shared_mesh));
+  share.meshes_num = share.meshes.size();
+}
+
+/* Store the mesh of an evaluated object of the source, if it is the final result of evaluating
+ * the modifiers. */
+void store_evaluated_object(MeshEvalShare &share, const Depsgraph &source, const Object &object)
+{
+  if (share.meshes.contains(object.id.session_uid)) {
+    /* Stored meshes are removed when their objects are tagged, so this one is up to date. */
+    return;
+  }
+  /* Objects which are tagged but not evaluated because they are invisible keep their previous
+   * result, and objects which were never evaluated might not even have their data copied. */
+  if (!DEG_id_is_fully_evaluated(&source, &object.id)) {
+    return;
+  }
+  const Object &object_eval = *DEG_get_evaluated(&source, &object);
+  const ObjectRuntime &runtime = *object_eval.runtime;
+  if (object_eval.type != OB_MESH || runtime.data_eval == nullptr || !runtime.is_data_eval_owned) {
+    return;
+  }
+  /* The other components of the geometry would refer to data of the source dependency graph. */
+  if (runtime.geometry_set_eval) {
+    GeometrySet other_geometry = *runtime.geometry_set_eval;
+    other_geometry.remove(GeometryComponent::Type::Mesh);
+    if (!other_geometry.is_empty()) {
+      return;
+    }
+  }
+  store_locked(share,
+               source,
+               object_eval,
+               *reinterpret_cast<const Mesh *>(runtime.data_eval),
+               runtime.mesh_deform_eval,
+               runtime.last_data_mask,
+               runtime.last_need_mapping);
+}
+
+}  // namespace
+
+void mesh_eval_share_consumer_add()
+{
+  MeshEvalShare &share = mesh_eval_share();
+  std::lock_guard lock{share.mutex};
+  share.consumers_num++;
+}
+
+void mesh_eval_share_consumer_remove()
+{
+  MeshEvalShare &share = mesh_eval_share();
+  std::lock_guard lock{share.mutex};
+  share.consumers_num--;
+  if (share.consumers_num == 0) {
+    /* Nothing can use the meshes anymore. */
+    share.meshes.clear();
+    share.meshes_num = 0;
+  }
+}
+
+void mesh_eval_share_collect(const Scene &scene)
+{
+  MeshEvalShare &share = mesh_eval_share();
+  const float ctime = BKE_scene_ctime_get(&scene);
+  /* The lock is held while reading the evaluated data of the sources. Sources take it when they
+   * are tagged for an update, before their evaluated data changes. */
+  std::lock_guard lock{share.mutex};
+  for (const auto item : share.sources.items()) {
+    const Depsgraph &source = *item.key;
+    if (item.value.is_outdated || item.value.ctime != ctime ||
+        DEG_get_input_scene(&source)->id.session_uid != scene.id.session_uid)
+    {
+      continue;
+    }
+    DEG_foreach_ID(&source, [&](ID *id) {
+      if (GS(id->name) == ID_OB) {
+        store_evaluated_object(share, source, *reinterpret_cast<const Object *>(id));
+      }
+    });
+  }
+}
+
+void mesh_eval_share_store(const Depsgraph &depsgraph,
+                           const Object &object,
+                           const Mesh &mesh_final,
+                           const Mesh *mesh_deform,
+                           const CustomData_MeshMasks &data_mask,
+                           const bool need_mapping)
+{
+  MeshEvalShare &share = mesh_eval_share();
+  std::lock_guard lock{share.mutex};
+  store_locked(share, depsgraph, object, mesh_final, mesh_deform, data_mask, need_mapping);
+}
+
+bool mesh_eval_share_lookup(const Depsgraph &depsgraph,
+                            Object &object,
+                            const CustomData_MeshMasks &data_mask,
+                            Mesh **r_mesh_final,
+                            Mesh **r_mesh_deform,
+                            CustomData_MeshMasks *r_data_mask,
+                            bool *r_need_mapping)
+{
+  if (DEG_get_mode(&depsgraph) != DAG_EVAL_RENDER) {
+    return false;
+  }
+  MeshEvalShare &share = mesh_eval_share();
+  /* The original scene has the same settings as the evaluated one, and is available before the
+   * scene is evaluated. */
+  const Scene &scene = *DEG_get_input_scene(&depsgraph);
+  if (share.meshes_num.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  {
+    /* Avoid the more expensive checks below for objects which are not shared at all. */
+    std::lock_guard lock{share.mutex};
+    if (!share.meshes.contains(object.id.session_uid)) {
+      return false;
+    }
+  }
+  if (object_eval_is_mode_dependent(scene, object)) {
+    return false;
+  }
+
+  /* Hold references to the shared geometry, so that it can be copied without locking. */
+  GeometrySet shared_mesh_final;
+  GeometrySet shared_mesh_deform;
+  CustomData_MeshMasks shared_data_mask;
+  bool shared_need_mapping;
+  {
+    std::lock_guard lock{share.mutex};
+    const SharedMesh *shared_mesh = share.meshes.lookup_ptr(object.id.session_uid);
+    if (shared_mesh == nullptr) {
+      return false;
+    }
+    const SourceState &source = share.sources.lookup(shared_mesh->source);
+    if (source.is_outdated || source.ctime != DEG_get_ctime(&depsgraph)) {
+      return false;
+    }
+    if (shared_mesh->scene_session_uid != scene.id.session_uid) {
+      return false;
+    }
+    if (!CustomData_MeshMasks_are_matching(&shared_mesh->data_mask, &data_mask)) {
+      return false;
+    }
+    shared_mesh_final = shared_mesh->mesh_final;
+    shared_mesh_deform = shared_mesh->mesh_deform;
+    shared_data_mask = shared_mesh->data_mask;
+    shared_need_mapping = shared_mesh->need_mapping;
+  }
+
+  Mesh *mesh_final = copy_from_shared(depsgraph, shared_mesh_final);
+  if (mesh_final == nullptr) {
+    return false;
+  }
+  Mesh *mesh_deform = nullptr;
+  if (shared_mesh_deform.has_mesh()) {
+    mesh_deform = copy_from_shared(depsgraph, shared_mesh_deform);
+    if (mesh_deform == nullptr) {
+      BKE_id_free(nullptr, mesh_final);
+      return false;
+    }
+  }
+  *r_mesh_final = mesh_final;
+  *r_mesh_deform = mesh_deform;
+  *r_data_mask = shared_data_mask;
+  *r_need_mapping = shared_need_mapping;
+  return true;
+}
+
+void mesh_eval_share_source_tag_update(const Depsgraph *depsgraph)
+{
+  MeshEvalShare &share = mesh_eval_share();
+  /* Locking also waits for #mesh_eval_share_collect to finish reading the evaluated data. */
+  std::lock_guard lock{share.mutex};
+  if (SourceState *source = share.sources.lookup_ptr(depsgraph)) {
+    source->is_outdated = true;
+  }
+}
+
+void mesh_eval_share_source_evaluated(const Depsgraph *depsgraph, const float ctime)
+{
+  if (!DEG_is_active(depsgraph) || DEG_get_mode(depsgraph) != DAG_EVAL_VIEWPORT) {
+    return;
+  }
+  MeshEvalShare &share = mesh_eval_share();
+  std::lock_guard lock{share.mutex};
+  SourceState &source = share.sources.lookup_or_add_default(depsgraph);
+  source.ctime = ctime;
+  source.is_outdated = false;
+}
+
+void mesh_eval_share_source_invalidate(const Depsgraph *depsgraph,
+                                       const Span<uint32_t> object_session_uids)
+{
+  MeshEvalShare &share = mesh_eval_share();
+  if (share.meshes_num.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  std::lock_guard lock{share.mutex};
+  for (const uint32_t object_session_uid : object_session_uids) {
+    const SharedMesh *shared_mesh = share.meshes.lookup_ptr(object_session_uid);
+    if (shared_mesh && shared_mesh->source == depsgraph) {
+      share.meshes.remove(object_session_uid);
+    }
+  }
+  share.meshes_num = share.meshes.size();
+}
+
+void mesh_eval_share_source_remove(const Depsgraph *depsgraph)
+{
+  MeshEvalShare &share = mesh_eval_share();
+  std::lock_guard lock{share.mutex};
+  if (!share.sources.remove(depsgraph)) {
+    return;
+  }
+  share.meshes.remove_if([&](const auto &item) { return item.value.source == depsgraph; });
+  share.meshes_num = share.meshes.size();
+}
+
+}  // namespace blender::bke
@@ -0,0 +1,260 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "BLI_listbase.h"
+
+#include "BKE_collection.hh"
+#include "BKE_customdata.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+#include "BKE_mesh.hh"
+#include "BKE_mesh_eval_share.hh"
+#include "BKE_modifier.hh"
+#include "BKE_object.hh"
+#include "BKE_scene.hh"
+
+#include "CLG_log.h"
+
+#include "DEG_depsgraph.hh"
+#include "DEG_depsgraph_build.hh"
+#include "DEG_depsgraph_query.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "testing/testing.h"
+
+namespace blender::bke::tests {
+
+class MeshEvalShareTest : public testing::Test {
+ protected:
+  Main *bmain = nullptr;
+  Scene *scene = nullptr;
+  Object *object = nullptr;
+  Depsgraph *viewport_graph = nullptr;
+  Depsgraph *render_graph = nullptr;
+
+  static void SetUpTestSuite()
+  {
+    CLG_init();
+    BKE_idtype_init();
+    BKE_modifier_init();
+    DEG_register_node_types();
+  }
+
+  static void TearDownTestSuite()
+  {
+    DEG_free_node_types();
+    CLG_exit();
+  }
+
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    scene = BKE_scene_add(bmain, "Scene");
+    object = BKE_object_add_only_object(bmain, OB_MESH, "Object");
+    object->data = BKE_mesh_add(bmain, "Mesh");
+    BKE_collection_object_add(bmain, scene->master_collection, object);
+
+    viewport_graph = create_graph(DAG_EVAL_VIEWPORT);
+    DEG_make_active(viewport_graph);
+  }
+
+  void TearDown() override
+  {
+    DEG_graph_free(viewport_graph);
+    if (render_graph) {
+      DEG_graph_free(render_graph);
+    }
+    BKE_main_free(bmain);
+  }
+
+  Depsgraph *create_graph(const eEvaluationMode mode)
+  {
+    ViewLayer *view_layer = static_cast<ViewLayer *>(scene->view_layers.first);
+    Depsgraph *graph = DEG_graph_new(bmain, scene, view_layer, mode);
+    DEG_graph_build_from_view_layer(graph);
+    return graph;
+  }
+
+  /* Create the render graph the way the render engine does before evaluating it. */
+  void create_render_graph()
+  {
+    render_graph = create_graph(DAG_EVAL_RENDER);
+    DEG_reuse_viewport_meshes(render_graph);
+  }
+
+  static Mesh *create_mesh()
+  {
+    Mesh *mesh = BKE_mesh_new_nomain(4, 0, 0, 0);
+    mesh->vert_positions_for_write().copy_from(
+        {float3(0, 0, 0), float3(1, 0, 0), float3(1, 1, 0), float3(0, 1, 0)});
+    return mesh;
+  }
+
+  /* Share the mesh from the viewport graph, as if it was just evaluated. */
+  void store(const Mesh &mesh)
+  {
+    mesh_eval_share_store(*viewport_graph, *object, mesh, nullptr, CD_MASK_BAREMESH, false);
+    mesh_eval_share_source_evaluated(viewport_graph, DEG_get_ctime(viewport_graph));
+  }
+
+  /* Get the mesh shared for the object in the render graph, the caller has to free it. */
+  Mesh *lookup(const CustomData_MeshMasks &data_mask = CD_MASK_BAREMESH)
+  {
+    Mesh *mesh_final = nullptr;
+    Mesh *mesh_deform = nullptr;
+    CustomData_MeshMasks shared_data_mask;
+    bool need_mapping = false;
+    if (!mesh_eval_share_lookup(*render_graph,
+                                *object,
+                                data_mask,
+                                &mesh_final,
+                                &mesh_deform,
+                                &shared_data_mask,
+                                &need_mapping))
+    {
+      return nullptr;
+    }
+    EXPECT_EQ(mesh_deform, nullptr);
+    EXPECT_FALSE(need_mapping);
+    return mesh_final;
+  }
+
+  bool lookup_succeeds(const CustomData_MeshMasks &data_mask = CD_MASK_BAREMESH)
+  {
+    Mesh *mesh = lookup(data_mask);
+    if (mesh == nullptr) {
+      return false;
+    }
+    BKE_id_free(nullptr, mesh);
+    return true;
+  }
+};
+
+TEST_F(MeshEvalShareTest, shared_with_render_graph)
+{
+  create_render_graph();
+  Mesh *mesh = create_mesh();
+  store(*mesh);
+
+  Mesh *shared_mesh = lookup();
+  ASSERT_NE(shared_mesh, nullptr);
+  EXPECT_EQ(shared_mesh->verts_num, 4);
+  /* The attribute arrays are shared, not copied. */
+  EXPECT_EQ(shared_mesh->vert_positions().data(), mesh->vert_positions().data());
+
+  BKE_id_free(nullptr, shared_mesh);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshEvalShareTest, stored_before_render_graph)
+{
+  /* The viewport was evaluated before any render graph existed, as for the first render. */
+  Mesh *mesh = create_mesh();
+  store(*mesh);
+  create_render_graph();
+  EXPECT_TRUE(lookup_succeeds());
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshEvalShareTest, dropped_with_last_render_graph)
+{
+  create_render_graph();
+  Mesh *mesh = create_mesh();
+  store(*mesh);
+  EXPECT_TRUE(lookup_succeeds());
+
+  /* The objects of the viewport graph are not evaluated, so nothing is collected again. */
+  DEG_graph_free(render_graph);
+  create_render_graph();
+  EXPECT_FALSE(lookup_succeeds());
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshEvalShareTest, only_shared_while_source_is_evaluated)
+{
+  create_render_graph();
+  Mesh *mesh = create_mesh();
+  store(*mesh);
+  EXPECT_TRUE(lookup_succeeds());
+
+  mesh_eval_share_source_tag_update(viewport_graph);
+  EXPECT_FALSE(lookup_succeeds());
+  mesh_eval_share_source_evaluated(viewport_graph, DEG_get_ctime(viewport_graph));
+  EXPECT_TRUE(lookup_succeeds());
+
+  /* Evaluated at another frame. */
+  mesh_eval_share_source_evaluated(viewport_graph, DEG_get_ctime(viewport_graph) + 1.0f);
+  EXPECT_FALSE(lookup_succeeds());
+  mesh_eval_share_source_evaluated(viewport_graph, DEG_get_ctime(viewport_graph));
+  EXPECT_TRUE(lookup_succeeds());
+
+  /* Tagging any data-block of the source graph makes its meshes outdated. */
+  DEG_id_tag_update_ex(bmain, &scene->id, ID_RECALC_SYNC_TO_EVAL);
+  EXPECT_FALSE(lookup_succeeds());
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshEvalShareTest, invalidate)
+{
+  create_render_graph();
+  Mesh *mesh = create_mesh();
+
+  store(*mesh);
+  mesh_eval_share_source_invalidate(viewport_graph, {object->id.session_uid});
+  EXPECT_FALSE(lookup_succeeds());
+
+  store(*mesh);
+  mesh_eval_share_source_remove(viewport_graph);
+  EXPECT_FALSE(lookup_succeeds());
+
+  store(*mesh);
+  DEG_make_inactive(viewport_graph);
+  EXPECT_FALSE(lookup_succeeds());
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshEvalShareTest, data_mask)
+{
+  create_render_graph();
+  Mesh *mesh = create_mesh();
+  store(*mesh);
+
+  /* The shared mesh was evaluated without the vertex groups. */
+  CustomData_MeshMasks data_mask = CD_MASK_BAREMESH;
+  data_mask.vmask |= CD_MASK_MDEFORMVERT;
+  EXPECT_FALSE(lookup_succeeds(data_mask));
+  EXPECT_TRUE(lookup_succeeds());
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshEvalShareTest, mode_dependent_modifier)
+{
+  create_render_graph();
+  Mesh *mesh = create_mesh();
+  store(*mesh);
+
+  SubsurfModifierData *smd = reinterpret_cast<SubsurfModifierData *>(
+      BKE_modifier_new(eModifierType_Subsurf));
+  BLI_addtail(&object->modifiers, smd);
+  smd->levels = 1;
+  smd->renderLevels = 2;
+  EXPECT_FALSE(lookup_succeeds());
+
+  smd->renderLevels = 1;
+  EXPECT_TRUE(lookup_succeeds());
+
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
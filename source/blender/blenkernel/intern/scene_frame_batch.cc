@@ -0,0 +1,150 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include <algorithm>
+
+#include "BLI_array.hh"
+#include "BLI_listbase.h"
+#include "BLI_task.hh"
+#include "BLI_threads.h"
+
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_main.hh"
+#include "BKE_pointcache.h"
+#include "BKE_scene.hh"
+#include "BKE_scene_frame_batch.hh"
+
+#include "DEG_depsgraph.hh"
+#include "DEG_depsgraph_build.hh"
+#include "DEG_depsgraph_query.hh"
+
+#ifdef WITH_PYTHON
+#  include "BPY_extern.hh"
+#endif
+
+namespace blender::bke {
+
+/**
+ * Every depsgraph evaluation is multi-threaded already, evaluating more frames at once mainly
+ * helps with the parts of the graph that have little parallelism. Each copy holds a full
+ * evaluated copy of the scene, so their number is kept small.
+ */
+static constexpr int MAX_FRAME_BATCH_SIZE = 4;
+static constexpr int THREADS_PER_BATCH_FRAME = 4;
+
+static bool frames_can_evaluate_concurrently(const Depsgraph *depsgraph)
+{
+#ifdef WITH_PYTHON
+  /* Handlers expect the current frame of the scene to be the one that is being evaluated. */
+  if (BPY_app_handlers_frame_change_used()) {
+    return false;
+  }
+#endif
+
+  /* Point caches are shared with the original data and are meant to be stepped through in order,
+   * reading them for several frames at once is not supported. */
+  Main *bmain = DEG_get_bmain(depsgraph);
+  Scene *scene = DEG_get_input_scene(depsgraph);
+  LISTBASE_FOREACH (Object *, object, &bmain->objects) {
+    if (BKE_ptcache_object_has(scene, object, 0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+SceneFrameBatchEvaluator::SceneFrameBatchEvaluator(
+    Depsgraph *depsgraph,
+    const int frames_num,
+    const FunctionRef<void(Depsgraph *depsgraph)> build_fn)
+    : depsgraph_(depsgraph)
+{
+  const int batch_size = std::min({MAX_FRAME_BATCH_SIZE,
+                                   BLI_system_thread_count() / THREADS_PER_BATCH_FRAME,
+                                   frames_num});
+  if (batch_size <= 1 || !frames_can_evaluate_concurrently(depsgraph)) {
+    return;
+  }
+
+  Main *bmain = DEG_get_bmain(depsgraph);
+  Scene *scene = DEG_get_input_scene(depsgraph);
+  ViewLayer *view_layer = DEG_get_input_view_layer(depsgraph);
+  const eEvaluationMode mode = DEG_get_mode(depsgraph);
+  for ([[maybe_unused]] const int i : IndexRange(batch_size - 1)) {
+    Depsgraph *copy = DEG_graph_new(bmain, scene, view_layer, mode);
+    build_fn(copy);
+    copies_.append(copy);
+  }
+}
+
+SceneFrameBatchEvaluator::~SceneFrameBatchEvaluator()
+{
+  for (Depsgraph *copy : copies_) {
+    DEG_graph_free(copy);
+  }
+}
+
+int SceneFrameBatchEvaluator::batch_size() const
+{
+  return int(copies_.size()) + 1;
+}
+
+void SceneFrameBatchEvaluator::evaluate(
+    const Span<double> frames, const FunctionRef<bool(Depsgraph *depsgraph, double frame)> frame_fn)
+{
+  if (copies_.is_empty()) {
+    Scene *scene = DEG_get_input_scene(depsgraph_);
+    for (const double frame : frames) {
+      scene->r.cfra = int(frame);
+      scene->r.subframe = float(frame - scene->r.cfra);
+      BKE_scene_graph_update_for_newframe(depsgraph_);
+      if (!frame_fn(depsgraph_, frame)) {
+        return;
+      }
+    }
+    return;
+  }
+
+  /* The depsgraph itself takes the last frame of every batch, so that it ends up at the last
+   * frame, like when evaluating the frames one after another. */
+  Array<Depsgraph *> depsgraphs(this->batch_size());
+  depsgraphs.as_mutable_span().drop_back(1).copy_from(copies_);
+  depsgraphs.last() = depsgraph_;
+
+  for (int64_t batch_start = 0; batch_start < frames.size(); batch_start += depsgraphs.size()) {
+    const Span<double> batch_frames = frames.slice(
+        batch_start, std::min(depsgraphs.size(), frames.size() - batch_start));
+    const Span<Depsgraph *> batch_depsgraphs = depsgraphs.as_span().take_back(
+        batch_frames.size());
+
+    /* Relations are only rebuilt when something tagged them, building is not thread-safe. */
+    for (Depsgraph *depsgraph : batch_depsgraphs) {
+      DEG_graph_relations_update(depsgraph);
+    }
+    threading::parallel_for(batch_frames.index_range(), 1, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        /* Keep the thread from picking up the evaluation of another frame while waiting for the
+         * tasks of this one. */
+        threading::isolate_task([&]() {
+          DEG_evaluate_on_framechange(batch_depsgraphs[i], float(batch_frames[i]));
+          DEG_ids_clear_recalc(batch_depsgraphs[i], false);
+        });
+      }
+    });
+
+    for (const int64_t i : batch_frames.index_range()) {
+      if (!frame_fn(batch_depsgraphs[i], batch_frames[i])) {
+        return;
+      }
+    }
+  }
+}
+
+}  // namespace blender::bke
@@ -10,6 +10,7 @@
 
 #include "BLI_function_ref.hh"
 #include "BLI_math_vector_types.hh"
+#include "BLI_span.hh"
 #include "BLI_sys_types.h"
 
 struct BVHTree;
@@ -78,6 +79,16 @@ enum {
    * pair once, rather than twice in different order as usual. */
   BVH_OVERLAP_SELF = (1 << 2),
 };
+enum {
+  /**
+   * Also build a 4-wide tree with the surface area heuristic, which is used by ray-casts and
+   * nearest point queries instead of the k-DOP tree. This takes more time and memory to build,
+   * but is faster to query for large trees. The wide tree is built by the first ray-cast or
+   * batched nearest point query, so trees that are never queried that way don't pay for it. Only
+   * used for k-DOP's that contain the axis aligned bounds (all but 18-DOP's).
+   */
+  BVH_BALANCE_WIDE = (1 << 0),
+};
 enum {
   /* Use a priority queue to process nodes in the optimal order (for slow callbacks) */
   BVH_NEAREST_OPTIMAL_ORDER = (1 << 0),
@@ -145,6 +156,10 @@ BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis);
  */
 void BLI_bvhtree_insert(BVHTree *tree, int index, const float co[3], int numpoints);
 void BLI_bvhtree_balance(BVHTree *tree);
+/**
+ * \param flag: See #BVH_BALANCE_WIDE.
+ */
+void BLI_bvhtree_balance_ex(BVHTree *tree, int flag);
 
 /**
  * Update: first update points/nodes, then call update_tree to refit the bounding volumes.
@@ -333,6 +348,35 @@ inline void BLI_bvhtree_ray_cast_all_cpp(const BVHTree &tree,
       &fn);
 }
 
+/**
+ * Ray-cast all \a rays in parallel, see #BLI_bvhtree_ray_cast_ex.
+ *
+ * \param hits: Initialized like the `hit` argument of #BLI_bvhtree_ray_cast_ex,
+ * typically with an index of -1 and a distance of #BVH_RAYCAST_DIST_MAX.
+ * \note The callback is called from multiple threads concurrently.
+ * The #BVHTreeRay.isect_precalc of the rays is ignored, it's computed for the given \a flag.
+ */
+void BLI_bvhtree_ray_cast_batch(const BVHTree &tree,
+                                Span<BVHTreeRay> rays,
+                                MutableSpan<BVHTreeRayHit> hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag);
+
+/**
+ * Find the nearest node to all \a positions in parallel, see #BLI_bvhtree_find_nearest_ex.
+ *
+ * \param nearest: Initialized like the `nearest` argument of #BLI_bvhtree_find_nearest_ex,
+ * typically with an index of -1 and a squared distance of #FLT_MAX.
+ * \note The callback is called from multiple threads concurrently.
+ */
+void BLI_bvhtree_find_nearest_batch(const BVHTree &tree,
+                                    Span<float3> positions,
+                                    MutableSpan<BVHTreeNearest> nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    int flag);
+
 using BVHTree_RangeQuery_CPP = FunctionRef<void(int index, const float3 &co, float dist_sq)>;
 
 inline void BLI_bvhtree_range_query_cpp(const BVHTree &tree,
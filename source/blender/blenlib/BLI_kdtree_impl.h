@@ -70,6 +70,28 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
 
 int BLI_kdtree_nd_(deduplicate)(KDTree *tree);
 
+/** Batched versions of the searches above, answering the queries of \a co in parallel. */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        uint co_len,
+                                        KDTreeNearest *r_nearest) ATTR_NONNULL(1);
+void BLI_kdtree_nd_(find_nearest_n_batch)(const KDTree *tree,
+                                          const float (*co)[KD_DIMS],
+                                          uint co_len,
+                                          KDTreeNearest *r_nearest,
+                                          uint nearest_len_capacity,
+                                          int *r_nearest_len) ATTR_NONNULL(1);
+void BLI_kdtree_nd_(range_search_batch_cb)(const KDTree *tree,
+                                           const float (*co)[KD_DIMS],
+                                           uint co_len,
+                                           float range,
+                                           bool (*search_cb)(void *user_data,
+                                                             uint co_index,
+                                                             int index,
+                                                             const float co[KD_DIMS],
+                                                             float dist_sq),
+                                           void *user_data) ATTR_NONNULL(1);
+
 /** Versions of find/range search that take a squared distance callback to support bias. */
 int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
     const KDTree *tree,
@@ -124,6 +146,32 @@ inline int BLI_kdtree_nd_(find_nearest_cb_cpp)(const KDTree *tree,
       r_nearest);
 }
 
+/**
+ * \param fn: Called as `fn(co_index, index, co, dist_sq)` from multiple threads concurrently.
+ */
+template<typename Fn>
+inline void BLI_kdtree_nd_(range_search_batch_cb_cpp)(const KDTree *tree,
+                                                      const float (*co)[KD_DIMS],
+                                                      uint co_len,
+                                                      float distance,
+                                                      const Fn &fn)
+{
+  BLI_kdtree_nd_(range_search_batch_cb)(
+      tree,
+      co,
+      co_len,
+      distance,
+      [](void *user_data,
+         const uint co_index,
+         const int index,
+         const float *co,
+         const float dist_sq) {
+        const Fn &fn = *static_cast<const Fn *>(user_data);
+        return fn(co_index, index, co, dist_sq);
+      },
+      const_cast<Fn *>(&fn));
+}
+
 #undef _BLI_CONCAT_AUX
 #undef _BLI_CONCAT
 #undef BLI_kdtree_nd_
@@ -21,20 +21,32 @@
  *   #BLI_bvhtree_overlap, #BVHOverlapData_Shared, #BVHOverlapData_Thread
  * - Range Query:
  *   #BLI_bvhtree_range_query
+ *
+ * Ray-casts and nearest point queries can optionally use a second, 4-wide tree built with the
+ * surface area heuristic on the first ray-cast, see #BVH_BALANCE_WIDE and #BVHWideTree.
  */
 
 #include <algorithm>
+#include <atomic>
 
 #include "MEM_guardedalloc.h"
 
 #include "BLI_alloca.h"
+#include "BLI_array.hh"
+#include "BLI_bounds.hh"
+#include "BLI_cache_mutex.hh"
 #include "BLI_heap_simple.h"
 #include "BLI_kdopbvh.hh"
+#include "BLI_math_bits.h"
 #include "BLI_math_geom.h"
+#include "BLI_math_vector.hh"
 #include "BLI_math_vector_types.hh"
+#include "BLI_simd.hh"
 #include "BLI_stack.h"
 #include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BLI_strict_flags.h" /* IWYU pragma: keep. Keep last. */
 
@@ -56,6 +68,15 @@
 #  define KDOPBVH_THREAD_LEAF_THRESHOLD 1024
 #endif
 
+/* Number of children of the nodes of the wide tree. */
+#define BVH_WIDE_WIDTH 4
+/* Maximum number of leafs in a leaf child of the wide tree. */
+#define BVH_WIDE_LEAFS_MAX 4
+/* Number of bins per axis used to evaluate the surface area heuristic. */
+#define BVH_WIDE_BINS 16
+/* Ranges with more leafs are binned and built with multiple threads. */
+#define BVH_WIDE_THREAD_LEAF_THRESHOLD 4096
+
 /* -------------------------------------------------------------------- */
 /** \name Struct Definitions
  * \{ */
@@ -74,6 +95,29 @@ struct BVHNode {
   char main_axis; /* Axis used to split this node */
 };
 
+/**
+ * Node of the wide tree. The axis aligned bounds of the children are stored per axis,
+ * so all children are tested against a ray or a point at once.
+ */
+struct BVHWideNode {
+  float min[3][BVH_WIDE_WIDTH];
+  float max[3][BVH_WIDE_WIDTH];
+  /* Index of the child node, or of the first leaf in #BVHWideTree.leafs for leaf children. */
+  int child[BVH_WIDE_WIDTH];
+  /* Number of leafs of a leaf child, zero when the child is a node. */
+  int leafs_num[BVH_WIDE_WIDTH];
+  int children_num;
+};
+
+struct BVHWideTree {
+  /* The tree is only built when it is used first, see #bvh_wide_ensure. */
+  blender::CacheMutex build_mutex;
+  /* The root is the first node, child nodes always come after their parent. */
+  blender::Array<BVHWideNode> nodes;
+  /* The leafs of the #BVHTree, ordered so the leafs of every leaf child are contiguous. */
+  blender::Array<BVHNode *> leafs;
+};
+
 /* keep under 26 bytes for speed purposes */
 struct BVHTree {
   BVHNode **nodes;
@@ -86,11 +130,12 @@ struct BVHTree {
   axis_t start_axis, stop_axis; /* bvhtree_kdop_axes array indices according to axis */
   axis_t axis;                  /* KDOP type (6 => OBB, 7 => AABB, ...) */
   char tree_type;               /* type of tree (4 => quad-tree). */
+  BVHWideTree *wide;            /* Optional, used by ray-casts and nearest queries. */
 };
 
 /* optimization, ensure we stay small */
-BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 48) ||
-                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 32),
+BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 56) ||
+                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 36),
                   "over sized")
 
 /* avoid duplicating vars in BVHOverlapData_Thread */
@@ -844,6 +889,411 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Wide Tree Build
+ *
+ * The wide tree is built top-down from the bounds of the leafs. Ranges of leafs are split with
+ * the binned surface area heuristic (SAH), and every node takes the up to #BVH_WIDE_WIDTH ranges
+ * created by splitting the largest of its ranges repeatedly. Large ranges are binned and built
+ * with multiple threads.
+ *
+ * Only the axis aligned part of the k-DOP bounds is used, like the ray-cast and nearest point
+ * queries of the k-DOP tree do.
+ * \{ */
+
+struct BVHWideBin {
+  blender::Bounds<blender::float3> bounds = {blender::float3(FLT_MAX), blender::float3(-FLT_MAX)};
+  int leafs_num = 0;
+};
+
+struct BVHWideBins {
+  BVHWideBin bins[3][BVH_WIDE_BINS];
+};
+
+/* A range of #BVHWideBuildData.order that becomes one child of a wide node. */
+struct BVHWideBuildRange {
+  int begin;
+  int end;
+  blender::Bounds<blender::float3> bounds;
+  /* The range has been tested and is better kept as leaf child. */
+  bool is_leaf;
+};
+
+struct BVHWideBuildData {
+  const BVHTree *tree;
+  BVHWideTree *wide;
+  /* Center of the bounds of every leaf. */
+  blender::Array<blender::float3> centers;
+  /* Indices of the leafs in #BVHTree.nodes, partitioned into the ranges of the children. */
+  blender::Array<int> order;
+  std::atomic<int> nodes_num;
+};
+
+static blender::Bounds<blender::float3> bvh_wide_leaf_bounds(const BVHNode *leaf)
+{
+  const float *bv = leaf->bv;
+  return {blender::float3(bv[0], bv[2], bv[4]), blender::float3(bv[1], bv[3], bv[5])};
+}
+
+/* Half of the surface area, the constant factor doesn't matter for the heuristic. */
+static float bvh_wide_half_area(const blender::Bounds<blender::float3> &bounds)
+{
+  const blender::float3 size = blender::math::max(bounds.max - bounds.min,
+                                                  blender::float3(0.0f));
+  return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+/**
+ * Find the split of the range with the lowest SAH cost and partition its leafs accordingly.
+ *
+ * \return False when the range is better kept as a leaf child.
+ * Ranges with more than #BVH_WIDE_LEAFS_MAX leafs are always split.
+ */
+static bool bvh_wide_split(BVHWideBuildData &data,
+                           const BVHWideBuildRange &range,
+                           BVHWideBuildRange &r_left,
+                           BVHWideBuildRange &r_right)
+{
+  using namespace blender;
+  MutableSpan<int> order = data.order.as_mutable_span().slice(range.begin,
+                                                              range.end - range.begin);
+  const int leafs_num = int(order.size());
+
+  const Bounds<float3> center_bounds = threading::parallel_reduce(
+      order.index_range(),
+      BVH_WIDE_THREAD_LEAF_THRESHOLD,
+      Bounds<float3>(float3(FLT_MAX), float3(-FLT_MAX)),
+      [&](const IndexRange sub_range, const Bounds<float3> &init) {
+        Bounds<float3> result = init;
+        for (const int i : order.slice(sub_range)) {
+          result = bounds::merge(result, Bounds<float3>(data.centers[i]));
+        }
+        return result;
+      },
+      [](const Bounds<float3> &a, const Bounds<float3> &b) { return bounds::merge(a, b); });
+
+  float3 bin_scale;
+  for (int axis = 0; axis < 3; axis++) {
+    const float size = center_bounds.max[axis] - center_bounds.min[axis];
+    bin_scale[axis] = size > 0.0f ? float(BVH_WIDE_BINS) / size : 0.0f;
+  }
+  const auto bin_index = [&](const float3 &center, const int axis) {
+    const float bin = (center[axis] - center_bounds.min[axis]) * bin_scale[axis];
+    /* Clamp before converting, so that NaN coordinates end up in the first bin too. */
+    return bin > 0.0f ? int(std::min(bin, float(BVH_WIDE_BINS - 1))) : 0;
+  };
+
+  const BVHWideBins bins = threading::parallel_reduce(
+      order.index_range(),
+      BVH_WIDE_THREAD_LEAF_THRESHOLD,
+      BVHWideBins(),
+      [&](const IndexRange sub_range, const BVHWideBins &init) {
+        BVHWideBins result = init;
+        for (const int i : order.slice(sub_range)) {
+          const Bounds<float3> leaf_bounds = bvh_wide_leaf_bounds(data.tree->nodes[i]);
+          for (int axis = 0; axis < 3; axis++) {
+            BVHWideBin &bin = result.bins[axis][bin_index(data.centers[i], axis)];
+            bin.bounds = bounds::merge(bin.bounds, leaf_bounds);
+            bin.leafs_num++;
+          }
+        }
+        return result;
+      },
+      [](const BVHWideBins &a, const BVHWideBins &b) {
+        BVHWideBins result;
+        for (int axis = 0; axis < 3; axis++) {
+          for (int bin = 0; bin < BVH_WIDE_BINS; bin++) {
+            result.bins[axis][bin].bounds = bounds::merge(a.bins[axis][bin].bounds,
+                                                          b.bins[axis][bin].bounds);
+            result.bins[axis][bin].leafs_num = a.bins[axis][bin].leafs_num +
+                                               b.bins[axis][bin].leafs_num;
+          }
+        }
+        return result;
+      });
+
+  /* Sweep the bins of every axis to find the split with the lowest cost. */
+  float best_cost = FLT_MAX;
+  int best_axis = -1;
+  int best_bin = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    if (bin_scale[axis] == 0.0f) {
+      continue;
+    }
+    const BVHWideBin *axis_bins = bins.bins[axis];
+    float right_cost[BVH_WIDE_BINS];
+    BVHWideBin right;
+    for (int bin = BVH_WIDE_BINS - 1; bin > 0; bin--) {
+      right.bounds = bounds::merge(right.bounds, axis_bins[bin].bounds);
+      right.leafs_num += axis_bins[bin].leafs_num;
+      right_cost[bin] = bvh_wide_half_area(right.bounds) * float(right.leafs_num);
+    }
+    BVHWideBin left;
+    for (int bin = 0; bin < BVH_WIDE_BINS - 1; bin++) {
+      left.bounds = bounds::merge(left.bounds, axis_bins[bin].bounds);
+      left.leafs_num += axis_bins[bin].leafs_num;
+      if (left.leafs_num == 0 || left.leafs_num == leafs_num) {
+        continue;
+      }
+      const float cost = bvh_wide_half_area(left.bounds) * float(left.leafs_num) +
+                         right_cost[bin + 1];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = bin;
+      }
+    }
+  }
+
+  if (leafs_num <= BVH_WIDE_LEAFS_MAX) {
+    /* Traversing one more node costs about as much as testing one leaf. */
+    const float area = bvh_wide_half_area(range.bounds);
+    if (best_axis == -1 || area + best_cost >= area * float(leafs_num)) {
+      return false;
+    }
+  }
+
+  int left_num;
+  if (best_axis == -1) {
+    /* All centers are the same, split in the middle. */
+    left_num = leafs_num / 2;
+  }
+  else {
+    left_num = int(std::partition(order.begin(),
+                                  order.end(),
+                                  [&](const int i) {
+                                    return bin_index(data.centers[i], best_axis) <= best_bin;
+                                  }) -
+                   order.begin());
+  }
+
+  const auto range_bounds = [&](const IndexRange sub_range) {
+    return threading::parallel_reduce(
+        sub_range,
+        BVH_WIDE_THREAD_LEAF_THRESHOLD,
+        Bounds<float3>(float3(FLT_MAX), float3(-FLT_MAX)),
+        [&](const IndexRange sub_sub_range, const Bounds<float3> &init) {
+          Bounds<float3> result = init;
+          for (const int i : order.slice(sub_sub_range)) {
+            result = bounds::merge(result, bvh_wide_leaf_bounds(data.tree->nodes[i]));
+          }
+          return result;
+        },
+        [](const Bounds<float3> &a, const Bounds<float3> &b) { return bounds::merge(a, b); });
+  };
+
+  r_left.begin = range.begin;
+  r_left.end = range.begin + left_num;
+  r_left.bounds = range_bounds(IndexRange(left_num));
+  r_left.is_leaf = false;
+  r_right.begin = range.begin + left_num;
+  r_right.end = range.end;
+  r_right.bounds = range_bounds(IndexRange::from_begin_end(left_num, leafs_num));
+  r_right.is_leaf = false;
+  return true;
+}
+
+static int bvh_wide_build_node(BVHWideBuildData &data, const BVHWideBuildRange &range)
+{
+  using namespace blender;
+  const int node_index = data.nodes_num.fetch_add(1, std::memory_order_relaxed);
+
+  BVHWideBuildRange children[BVH_WIDE_WIDTH];
+  int children_num = 1;
+  children[0] = range;
+  children[0].is_leaf = false;
+
+  /* Split the child with the largest area until the node is full. */
+  while (children_num < BVH_WIDE_WIDTH) {
+    int split_child = -1;
+    float split_area = -1.0f;
+    for (int i = 0; i < children_num; i++) {
+      if (!children[i].is_leaf && bvh_wide_half_area(children[i].bounds) > split_area) {
+        split_child = i;
+        split_area = bvh_wide_half_area(children[i].bounds);
+      }
+    }
+    if (split_child == -1) {
+      break;
+    }
+    BVHWideBuildRange left, right;
+    if (!bvh_wide_split(data, children[split_child], left, right)) {
+      children[split_child].is_leaf = true;
+      continue;
+    }
+    children[split_child] = left;
+    children[children_num++] = right;
+  }
+
+  BVHWideNode &node = data.wide->nodes[node_index];
+  node.children_num = children_num;
+  for (int i = 0; i < BVH_WIDE_WIDTH; i++) {
+    const bool is_used = i < children_num;
+    for (int axis = 0; axis < 3; axis++) {
+      /* Unused children have empty bounds, so they are never hit. */
+      node.min[axis][i] = is_used ? children[i].bounds.min[axis] : FLT_MAX;
+      node.max[axis][i] = is_used ? children[i].bounds.max[axis] : -FLT_MAX;
+    }
+    node.child[i] = is_used ? children[i].begin : -1;
+    node.leafs_num[i] = is_used ? children[i].end - children[i].begin : 0;
+  }
+
+  /* Ranges that were not split yet become leaf children when they are small enough. */
+  const auto build_child = [&](const int i) {
+    if (node.leafs_num[i] > BVH_WIDE_LEAFS_MAX) {
+      node.child[i] = bvh_wide_build_node(data, children[i]);
+      node.leafs_num[i] = 0;
+    }
+  };
+  if (range.end - range.begin > BVH_WIDE_THREAD_LEAF_THRESHOLD) {
+    threading::parallel_for(IndexRange(children_num), 1, [&](const IndexRange sub_range) {
+      for (const int64_t i : sub_range) {
+        build_child(int(i));
+      }
+    });
+  }
+  else {
+    for (int i = 0; i < children_num; i++) {
+      build_child(i);
+    }
+  }
+  return node_index;
+}
+
+static void bvh_wide_build(const BVHTree *tree, BVHWideTree *wide)
+{
+  using namespace blender;
+  const int leafs_num = tree->leaf_num;
+  BLI_assert(leafs_num > 0);
+
+  BVHWideBuildData data;
+  data.tree = tree;
+  data.wide = wide;
+  data.centers.reinitialize(leafs_num);
+  data.order.reinitialize(leafs_num);
+  threading::parallel_for(IndexRange(leafs_num), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      data.centers[i] = bvh_wide_leaf_bounds(tree->nodes[i]).center();
+      data.order[i] = int(i);
+    }
+  });
+  data.nodes_num = 0;
+
+  /* Every node but the root has at least two children, so there are less nodes than leafs. */
+  wide->nodes = Array<BVHWideNode>(std::max(leafs_num - 1, 1), NoInitialization());
+
+  /* The bounds of the root branch of the k-DOP tree contain all leafs. */
+  BVHWideBuildRange root;
+  root.begin = 0;
+  root.end = leafs_num;
+  root.bounds = bvh_wide_leaf_bounds(tree->nodes[leafs_num]);
+  root.is_leaf = false;
+  bvh_wide_build_node(data, root);
+
+  wide->nodes = Array<BVHWideNode>(wide->nodes.as_span().take_front(data.nodes_num.load()));
+  wide->leafs.reinitialize(leafs_num);
+  threading::parallel_for(IndexRange(leafs_num), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      wide->leafs[i] = tree->nodes[data.order[i]];
+    }
+  });
+}
+
+/**
+ * Get the wide tree, building it if that didn't happen yet.
+ * 
+eturn Null if the tree was balanced without #BVH_BALANCE_WIDE.
+ */
+static const BVHWideTree *bvh_wide_ensure(const BVHTree *tree)
+{
+  BVHWideTree *wide = tree->wide;
+  if (wide == nullptr) {
+    return nullptr;
+  }
+  wide->build_mutex.ensure([&]() { bvh_wide_build(tree, wide); });
+  return wide;
+}
+
+/**
+ * Get the wide tree only if it has been built already, for queries that are not worth building
+ * it for.
+ */
+static const BVHWideTree *bvh_wide_get_if_built(const BVHTree *tree)
+{
+  if (tree->wide == nullptr || tree->wide->build_mutex.is_dirty()) {
+    return nullptr;
+  }
+  /* Doesn't build anything, but synchronizes with the thread that built the tree. */
+  return bvh_wide_ensure(tree);
+}
+
+/* Entry of the traversal stack of the wide tree, see #BVHWideNode.child. */
+struct BVHWideStackItem {
+  int child;
+  int leafs_num;
+  float dist;
+};
+
+/**
+ * Push the children of \a node that are hit onto the stack, the nearest last so it's traversed
+ * first.
+ */
+static void bvh_wide_push_children(blender::Vector<BVHWideStackItem, 64> &stack,
+                                   const BVHWideNode &node,
+                                   int hit_mask,
+                                   const float dist[BVH_WIDE_WIDTH])
+{
+  const int64_t stack_start = stack.size();
+  while (hit_mask) {
+    const int i = bitscan_forward_i(hit_mask);
+    hit_mask &= hit_mask - 1;
+    /* Insertion sort, by decreasing distance. */
+    const BVHWideStackItem item = {node.child[i], node.leafs_num[i], dist[i]};
+    int64_t j = stack.size();
+    stack.append(item);
+    for (; j > stack_start && stack[j - 1].dist < item.dist; j--) {
+      stack[j] = stack[j - 1];
+    }
+    stack[j] = item;
+  }
+}
+
+/**
+ * Update the bounds of the wide tree after the leafs changed, like #node_join does for the k-DOP
+ * nodes.
+ */
+static void bvh_wide_refit(BVHWideTree *wide)
+{
+  using namespace blender;
+  for (int node_index = int(wide->nodes.size()) - 1; node_index >= 0; node_index--) {
+    BVHWideNode &node = wide->nodes[node_index];
+    for (int i = 0; i < node.children_num; i++) {
+      Bounds<float3> bounds(float3(FLT_MAX), float3(-FLT_MAX));
+      if (node.leafs_num[i] > 0) {
+        for (const BVHNode *leaf : wide->leafs.as_span().slice(node.child[i], node.leafs_num[i]))
+        {
+          bounds = bounds::merge(bounds, bvh_wide_leaf_bounds(leaf));
+        }
+      }
+      else {
+        const BVHWideNode &child = wide->nodes[node.child[i]];
+        for (int j = 0; j < child.children_num; j++) {
+          for (int axis = 0; axis < 3; axis++) {
+            bounds.min[axis] = std::min(bounds.min[axis], child.min[axis][j]);
+            bounds.max[axis] = std::max(bounds.max[axis], child.max[axis][j]);
+          }
+        }
+      }
+      for (int axis = 0; axis < 3; axis++) {
+        node.min[axis][i] = bounds.min[axis];
+        node.max[axis][i] = bounds.max[axis];
+      }
+    }
+  }
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
@@ -926,11 +1376,12 @@ void BLI_bvhtree_free(BVHTree *tree)
     MEM_SAFE_FREE(tree->nodearray);
     MEM_SAFE_FREE(tree->nodebv);
     MEM_SAFE_FREE(tree->nodechild);
+    MEM_delete(tree->wide);
     MEM_freeN(tree);
   }
 }
 
-void BLI_bvhtree_balance(BVHTree *tree)
+void BLI_bvhtree_balance_ex(BVHTree *tree, const int flag)
 {
   BVHNode **leafs_array = tree->nodes;
 
@@ -960,6 +1411,16 @@ void BLI_bvhtree_balance(BVHTree *tree)
 #ifdef USE_PRINT_TREE
   bvhtree_info(tree);
 #endif
+
+  /* The wide tree only uses the axis aligned bounds, which are the first axes of the k-DOP. */
+  if ((flag & BVH_BALANCE_WIDE) && tree->start_axis == 0 && tree->leaf_num > 0) {
+    tree->wide = MEM_new<BVHWideTree>(__func__);
+  }
+}
+
+void BLI_bvhtree_balance(BVHTree *tree)
+{
+  BLI_bvhtree_balance_ex(tree, 0);
 }
 
 static void bvhtree_node_inflate(const BVHTree *tree, BVHNode *node, const float dist)
@@ -1026,6 +1487,10 @@ void BLI_bvhtree_update_tree(BVHTree *tree)
   for (; index >= root; index--) {
     node_join(tree, *index);
   }
+
+  if (tree->wide && tree->wide->build_mutex.is_cached()) {
+    bvh_wide_refit(tree->wide);
+  }
 }
 int BLI_bvhtree_get_len(const BVHTree *tree)
 {
@@ -1637,6 +2102,68 @@ static void heap_find_nearest_begin(BVHNearestData *data, BVHNode *root)
   }
 }
 
+/**
+ * Squared distance from the point to the bounds of all children of the node,
+ * like #calc_nearest_point_squared.
+ *
+ * \return A bit mask of the children closer than the current nearest.
+ */
+static int bvh_wide_nearest_hit(const BVHNearestData *data,
+                                const BVHWideNode &node,
+                                float r_dist_sq[BVH_WIDE_WIDTH])
+{
+#if BLI_HAVE_SSE2
+  __m128 dist_sq = _mm_setzero_ps();
+  for (int axis = 0; axis < 3; axis++) {
+    const __m128 co = _mm_set1_ps(data->proj[axis]);
+    /* Operands are ordered to return the same as the scalar code below if any is NaN. */
+    const __m128 nearest = _mm_min_ps(_mm_max_ps(co, _mm_loadu_ps(node.min[axis])),
+                                      _mm_loadu_ps(node.max[axis]));
+    const __m128 delta = _mm_sub_ps(co, nearest);
+    dist_sq = _mm_add_ps(dist_sq, _mm_mul_ps(delta, delta));
+  }
+  _mm_storeu_ps(r_dist_sq, dist_sq);
+  const int hit_mask = _mm_movemask_ps(_mm_cmplt_ps(dist_sq, _mm_set1_ps(data->nearest.dist_sq)));
+#else
+  int hit_mask = 0;
+  for (int i = 0; i < BVH_WIDE_WIDTH; i++) {
+    float dist_sq = 0.0f;
+    for (int axis = 0; axis < 3; axis++) {
+      const float nearest = std::min(node.max[axis][i],
+                                     std::max(node.min[axis][i], data->proj[axis]));
+      dist_sq += square_f(data->proj[axis] - nearest);
+    }
+    r_dist_sq[i] = dist_sq;
+    if (dist_sq < data->nearest.dist_sq) {
+      hit_mask |= 1 << i;
+    }
+  }
+#endif
+  return hit_mask & ((1 << node.children_num) - 1);
+}
+
+static void bvh_wide_find_nearest(BVHNearestData *data, const BVHWideTree &wide)
+{
+  blender::Vector<BVHWideStackItem, 64> stack;
+  stack.append({0, 0, -FLT_MAX});
+  while (!stack.is_empty()) {
+    const BVHWideStackItem item = stack.pop_last();
+    if (item.dist >= data->nearest.dist_sq) {
+      continue;
+    }
+    if (item.leafs_num > 0) {
+      for (BVHNode *leaf : wide.leafs.as_span().slice(item.child, item.leafs_num)) {
+        dfs_find_nearest_begin(data, leaf);
+      }
+      continue;
+    }
+    const BVHWideNode &node = wide.nodes[item.child];
+    float dist_sq[BVH_WIDE_WIDTH];
+    const int hit_mask = bvh_wide_nearest_hit(data, node, dist_sq);
+    bvh_wide_push_children(stack, node, hit_mask, dist_sq);
+  }
+}
+
 int BLI_bvhtree_find_nearest_ex(const BVHTree *tree,
                                 const float co[3],
                                 BVHTreeNearest *nearest,
@@ -1673,6 +2200,9 @@ int BLI_bvhtree_find_nearest_ex(const BVHTree *tree,
     if (flag & BVH_NEAREST_OPTIMAL_ORDER) {
       heap_find_nearest_begin(&data, root);
     }
+    else if (const BVHWideTree *wide = bvh_wide_get_if_built(tree)) {
+      bvh_wide_find_nearest(&data, *wide);
+    }
     else {
       dfs_find_nearest_begin(&data, root);
     }
@@ -1927,6 +2457,96 @@ static void dfs_raycast_all(BVHRayCastData *data, BVHNode *node)
   }
 }
 
+/**
+ * Intersect the ray with the bounds of all children of the node. Like #fast_ray_nearest_hit when
+ * the ray has no radius, and like #ray_nearest_hit otherwise.
+ *
+ * \return A bit mask of the children hit closer than the current hit.
+ */
+static int bvh_wide_ray_hit(const BVHRayCastData *data,
+                            const BVHWideNode &node,
+                            float r_dist[BVH_WIDE_WIDTH])
+{
+  const float radius = data->ray.radius;
+  /* Rays with a radius only hit bounds in front of their origin. */
+  const float dist_min = (radius == 0.0f) ? -FLT_MAX : 0.0f;
+  const float dist_max = data->hit.dist;
+
+#if BLI_HAVE_SSE2
+  __m128 t_enter = _mm_set1_ps(dist_min);
+  __m128 t_exit = _mm_set1_ps(FLT_MAX);
+  for (int axis = 0; axis < 3; axis++) {
+    const bool is_positive = data->idot_axis[axis] >= 0.0f;
+    const __m128 bounds_near = _mm_loadu_ps(is_positive ? node.min[axis] : node.max[axis]);
+    const __m128 bounds_far = _mm_loadu_ps(is_positive ? node.max[axis] : node.min[axis]);
+    const float near_offset = is_positive ? -radius : radius;
+    const __m128 origin_near = _mm_set1_ps(data->ray.origin[axis] - near_offset);
+    const __m128 origin_far = _mm_set1_ps(data->ray.origin[axis] + near_offset);
+    const __m128 idot = _mm_set1_ps(data->idot_axis[axis]);
+    /* The min and max instructions return the second operand if either is NaN. Keep the current
+     * value then, so that NaN doesn't cull the child, like in #fast_ray_nearest_hit. */
+    t_enter = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(bounds_near, origin_near), idot), t_enter);
+    t_exit = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(bounds_far, origin_far), idot), t_exit);
+  }
+  const __m128 is_hit = _mm_and_ps(
+      _mm_and_ps(_mm_cmple_ps(t_enter, t_exit), _mm_cmpge_ps(t_exit, _mm_setzero_ps())),
+      _mm_cmplt_ps(t_enter, _mm_set1_ps(dist_max)));
+  _mm_storeu_ps(r_dist, t_enter);
+  const int hit_mask = _mm_movemask_ps(is_hit);
+#else
+  int hit_mask = 0;
+  for (int i = 0; i < BVH_WIDE_WIDTH; i++) {
+    float t_enter = dist_min;
+    float t_exit = FLT_MAX;
+    for (int axis = 0; axis < 3; axis++) {
+      const bool is_positive = data->idot_axis[axis] >= 0.0f;
+      const float near_offset = is_positive ? -radius : radius;
+      const float bound_near = is_positive ? node.min[axis][i] : node.max[axis][i];
+      const float bound_far = is_positive ? node.max[axis][i] : node.min[axis][i];
+      t_enter = std::max(t_enter,
+                         (bound_near - (data->ray.origin[axis] - near_offset)) *
+                             data->idot_axis[axis]);
+      t_exit = std::min(t_exit,
+                        (bound_far - (data->ray.origin[axis] + near_offset)) *
+                            data->idot_axis[axis]);
+    }
+    r_dist[i] = t_enter;
+    if (t_enter <= t_exit && t_exit >= 0.0f && t_enter < dist_max) {
+      hit_mask |= 1 << i;
+    }
+  }
+#endif
+  return hit_mask & ((1 << node.children_num) - 1);
+}
+
+/**
+ * Ray-cast using the wide tree, \a leaf_fn is #dfs_raycast or #dfs_raycast_all,
+ * which test the bounds of the leaf before calling the callback.
+ */
+static void bvh_wide_raycast(BVHRayCastData *data,
+                             const BVHWideTree &wide,
+                             void (*leaf_fn)(BVHRayCastData *data, BVHNode *node))
+{
+  blender::Vector<BVHWideStackItem, 64> stack;
+  stack.append({0, 0, -FLT_MAX});
+  while (!stack.is_empty()) {
+    const BVHWideStackItem item = stack.pop_last();
+    if (item.dist >= data->hit.dist) {
+      continue;
+    }
+    if (item.leafs_num > 0) {
+      for (BVHNode *leaf : wide.leafs.as_span().slice(item.child, item.leafs_num)) {
+        leaf_fn(data, leaf);
+      }
+      continue;
+    }
+    const BVHWideNode &node = wide.nodes[item.child];
+    float dist[BVH_WIDE_WIDTH];
+    const int hit_mask = bvh_wide_ray_hit(data, node, dist);
+    bvh_wide_push_children(stack, node, hit_mask, dist);
+  }
+}
+
 static void bvhtree_ray_cast_data_precalc(BVHRayCastData *data, int flag)
 {
   int i;
@@ -1995,7 +2615,10 @@ int BLI_bvhtree_ray_cast_ex(const BVHTree *tree,
     data.hit.dist = BVH_RAYCAST_DIST_MAX;
   }
 
-  if (root) {
+  if (const BVHWideTree *wide = bvh_wide_ensure(tree)) {
+    bvh_wide_raycast(&data, *wide, dfs_raycast);
+  }
+  else if (root) {
     dfs_raycast(&data, root);
     //      iterative_raycast(&data, root);
   }
@@ -2075,7 +2698,10 @@ void BLI_bvhtree_ray_cast_all_ex(const BVHTree *tree,
   data.hit.index = -1;
   data.hit.dist = hit_dist;
 
-  if (root) {
+  if (const BVHWideTree *wide = bvh_wide_ensure(tree)) {
+    bvh_wide_raycast(&data, *wide, dfs_raycast_all);
+  }
+  else if (root) {
     dfs_raycast_all(&data, root);
   }
 }
@@ -2381,3 +3007,49 @@ int BLI_bvhtree_find_nearest_projected(const BVHTree *tree,
 }
 
 /** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Batched Queries
+ * \{ */
+
+namespace blender {
+
+void BLI_bvhtree_ray_cast_batch(const BVHTree &tree,
+                                const Span<BVHTreeRay> rays,
+                                MutableSpan<BVHTreeRayHit> hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                const int flag)
+{
+  BLI_assert(rays.size() == hits.size());
+  threading::parallel_for(rays.index_range(), 256, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      const BVHTreeRay &ray = rays[i];
+      BLI_bvhtree_ray_cast_ex(
+          &tree, ray.origin, ray.direction, ray.radius, &hits[i], callback, userdata, flag);
+    }
+  });
+}
+
+void BLI_bvhtree_find_nearest_batch(const BVHTree &tree,
+                                    const Span<float3> positions,
+                                    MutableSpan<BVHTreeNearest> nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    const int flag)
+{
+  BLI_assert(positions.size() == nearest.size());
+  /* Many queries are worth building the wide tree for. */
+  if (!(flag & BVH_NEAREST_OPTIMAL_ORDER)) {
+    bvh_wide_ensure(&tree);
+  }
+  threading::parallel_for(positions.index_range(), 256, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      BLI_bvhtree_find_nearest_ex(&tree, positions[i], &nearest[i], callback, userdata, flag);
+    }
+  });
+}
+
+}  // namespace blender
+
+/** \} */
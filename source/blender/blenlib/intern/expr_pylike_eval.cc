@@ -14,20 +14,28 @@
  *  - Literals:
  *      floating point and decimal integer.
  *  - Constants:
- *      pi, True, False
+ *      pi, e, tau, inf, True, False
  *  - Operators:
  *      +, -, *, /, ==, !=, <, <=, >, >=, and, or, not, ternary if
  *  - Functions:
  *      min, max, radians, degrees,
- *      abs, fabs, floor, ceil, trunc, int,
+ *      abs, fabs, floor, ceil, trunc, int, round, bool, float,
  *      sin, cos, tan, asin, acos, atan, atan2,
- *      exp, log, sqrt, pow, fmod
+ *      sinh, cosh, tanh, asinh, acosh, atanh,
+ *      exp, exp2, expm1, log, log2, log10, log1p, sqrt, cbrt, pow, fmod, hypot, copysign,
+ *      lerp, clamp, smoothstep
+ *
+ * The parsed stack machine program is compiled into register instructions for evaluation: every
+ * evaluation stack slot becomes a register, and constants and parameters are read by the
+ * instructions directly instead of being pushed first.
  *
  * The implementation has no global state and can be used multi-threaded.
  */
 
+#include <algorithm>
 #include <cctype>
 #include <cfenv>
+#include <climits>
 #include <cmath>
 #include <cstddef>
 #include <cstdlib>
@@ -36,7 +44,7 @@
 
 #include "MEM_guardedalloc.h"
 
-#include "BLI_alloca.h"
+#include "BLI_array.hh"
 #include "BLI_expr_pylike_eval.h"
 #include "BLI_math_base.h"
 #include "BLI_utildefines.h"
@@ -86,6 +94,9 @@ struct ExprOp {
 
   int jmp_offset;
 
+  /** Depth of the evaluation stack before the operation. */
+  int stack_ptr;
+
   union {
     int ival;
     double dval;
@@ -96,9 +107,57 @@ struct ExprOp {
   } arg;
 };
 
+/**
+ * Register instructions the stack machine program is compiled to. Operands are indices into the
+ * evaluation frame, which holds the registers, followed by the parameters and the constants.
+ */
+enum eRegOpCode {
+  /** `dst = args[0]`. */
+  REGOP_MOVE,
+  /** `dst = func1(args[0])`. */
+  REGOP_FUNC1,
+  /** `dst = func2(args[0], args[1])`. */
+  REGOP_FUNC2,
+  /** `dst = func3(args[0], args[1], args[2])`. */
+  REGOP_FUNC3,
+  /** `JUMP`. */
+  REGOP_JMP,
+  /** `JUMP IF NOT args[0]`. */
+  REGOP_JMP_IF_ZERO,
+  /** `JUMP IF args[0]`. */
+  REGOP_JMP_IF_NONZERO,
+  /** `(dst = 0; JUMP) IF NOT func2(args[0], args[1]) ELSE (dst = args[1])`. */
+  REGOP_CMP_CHAIN,
+};
+
+struct ExprRegOp {
+  eRegOpCode opcode;
+
+  int dst;
+  int args[3];
+
+  /** Index of the instruction to continue with for jumps. */
+  int jmp_target;
+
+  union {
+    UnaryOpFunc func1;
+    BinaryOpFunc func2;
+    TernaryOpFunc func3;
+  } func;
+};
+
 struct ExprPyLike_Parsed {
   blender::Vector<ExprOp> ops;
   int max_stack;
+
+  /* Register program compiled from the stack machine operations. */
+  blender::Vector<ExprRegOp> reg_ops;
+  /** Number of parameters read by the program. */
+  int params_num = 0;
+  /** Constants, stored after the parameters in the evaluation frame. */
+  blender::Vector<double> consts;
+  /** Frame index of the result. */
+  int result = 0;
 };
 
 /** \} */
@@ -142,7 +201,7 @@ bool BLI_expr_pylike_is_using_param(const ExprPyLike_Parsed *expr, int index)
 /** \} */
 
 /* -------------------------------------------------------------------- */
-/** \name Stack Machine Evaluation
+/** \name Register Machine Evaluation
  * \{ */
 
 eExprPyLike_EvalStatus BLI_expr_pylike_eval(ExprPyLike_Parsed *expr,
@@ -156,107 +215,77 @@ eExprPyLike_EvalStatus BLI_expr_pylike_eval(ExprPyLike_Parsed *expr,
     return EXPR_PYLIKE_INVALID;
   }
 
-#define FAIL_IF(condition) \
-  if (condition) { \
-    return EXPR_PYLIKE_FATAL_ERROR; \
-  } \
-  ((void)0)
-
-  /* Check the stack requirement is at least remotely sane and allocate on the actual stack. */
-  FAIL_IF(expr->max_stack <= 0 || expr->max_stack > 1000);
+  /* Operand indices are checked by #compile_register_ops, only the inputs need checking here. */
+  if (expr->max_stack <= 0 || expr->max_stack > 1000 || param_values_len < expr->params_num) {
+    return EXPR_PYLIKE_FATAL_ERROR;
+  }
 
-  double *stack = BLI_array_alloca(stack, expr->max_stack);
+  /* Set up the evaluation frame: registers, parameters and constants. */
+  const int params_offset = expr->max_stack;
+  const int consts_offset = params_offset + expr->params_num;
+  blender::Array<double, 64> frame(consts_offset + expr->consts.size());
+  std::copy_n(param_values, expr->params_num, frame.data() + params_offset);
+  std::copy_n(expr->consts.data(), expr->consts.size(), frame.data() + consts_offset);
 
   /* Evaluate expression. */
-  ExprOp *ops = expr->ops.data();
-  int sp = 0, pc;
+  const ExprRegOp *ops = expr->reg_ops.data();
+  const int ops_num = expr->reg_ops.size();
+  double *regs = frame.data();
 
   feclearexcept(FE_ALL_EXCEPT);
 
-  for (pc = 0; pc >= 0 && pc < expr->ops.size(); pc++) {
-    switch (ops[pc].opcode) {
-      /* Arithmetic */
-      case OPCODE_CONST:
-        FAIL_IF(sp >= expr->max_stack);
-        stack[sp++] = ops[pc].arg.dval;
+  for (int pc = 0; pc < ops_num;) {
+    const ExprRegOp &op = ops[pc];
+    switch (op.opcode) {
+      case REGOP_MOVE:
+        regs[op.dst] = regs[op.args[0]];
         break;
-      case OPCODE_PARAMETER:
-        FAIL_IF(sp >= expr->max_stack || ops[pc].arg.ival >= param_values_len);
-        stack[sp++] = param_values[ops[pc].arg.ival];
+      case REGOP_FUNC1:
+        regs[op.dst] = op.func.func1(regs[op.args[0]]);
         break;
-      case OPCODE_FUNC1:
-        FAIL_IF(sp < 1);
-        stack[sp - 1] = ops[pc].arg.func1(stack[sp - 1]);
+      case REGOP_FUNC2:
+        regs[op.dst] = op.func.func2(regs[op.args[0]], regs[op.args[1]]);
         break;
-      case OPCODE_FUNC2:
-        FAIL_IF(sp < 2);
-        stack[sp - 2] = ops[pc].arg.func2(stack[sp - 2], stack[sp - 1]);
-        sp--;
-        break;
-      case OPCODE_FUNC3:
-        FAIL_IF(sp < 3);
-        stack[sp - 3] = ops[pc].arg.func3(stack[sp - 3], stack[sp - 2], stack[sp - 1]);
-        sp -= 2;
-        break;
-      case OPCODE_MIN:
-        FAIL_IF(sp < ops[pc].arg.ival);
-        for (int j = 1; j < ops[pc].arg.ival; j++, sp--) {
-          CLAMP_MAX(stack[sp - 2], stack[sp - 1]);
-        }
-        break;
-      case OPCODE_MAX:
-        FAIL_IF(sp < ops[pc].arg.ival);
-        for (int j = 1; j < ops[pc].arg.ival; j++, sp--) {
-          CLAMP_MIN(stack[sp - 2], stack[sp - 1]);
-        }
+      case REGOP_FUNC3:
+        regs[op.dst] = op.func.func3(regs[op.args[0]], regs[op.args[1]], regs[op.args[2]]);
         break;
 
       /* Jumps */
-      case OPCODE_JMP:
-        pc += ops[pc].jmp_offset;
-        break;
-      case OPCODE_JMP_ELSE:
-        FAIL_IF(sp < 1);
-        if (!stack[--sp]) {
-          pc += ops[pc].jmp_offset;
+      case REGOP_JMP:
+        pc = op.jmp_target;
+        continue;
+      case REGOP_JMP_IF_ZERO:
+        if (!regs[op.args[0]]) {
+          pc = op.jmp_target;
+          continue;
         }
         break;
-      case OPCODE_JMP_OR:
-      case OPCODE_JMP_AND:
-        FAIL_IF(sp < 1);
-        if (!stack[sp - 1] == !(ops[pc].opcode == OPCODE_JMP_OR)) {
-          pc += ops[pc].jmp_offset;
-        }
-        else {
-          sp--;
+      case REGOP_JMP_IF_NONZERO:
+        if (regs[op.args[0]]) {
+          pc = op.jmp_target;
+          continue;
         }
         break;
 
       /* For chaining comparisons, i.e. "a < b < c" as "a < b and b < c" */
-      case OPCODE_CMP_CHAIN:
-        FAIL_IF(sp < 2);
+      case REGOP_CMP_CHAIN:
         /* If comparison fails, return 0 and jump to end. */
-        if (!ops[pc].arg.func2(stack[sp - 2], stack[sp - 1])) {
-          stack[sp - 2] = 0.0;
-          pc += ops[pc].jmp_offset;
+        if (!op.func.func2(regs[op.args[0]], regs[op.args[1]])) {
+          regs[op.dst] = 0.0;
+          pc = op.jmp_target;
+          continue;
         }
-        /* Otherwise keep b on the stack and proceed. */
-        else {
-          stack[sp - 2] = stack[sp - 1];
-        }
-        sp--;
+        /* Otherwise keep b and proceed. */
+        regs[op.dst] = regs[op.args[1]];
         break;
 
       default:
         return EXPR_PYLIKE_FATAL_ERROR;
     }
+    pc++;
   }
 
-  FAIL_IF(sp != 1 || pc != expr->ops.size());
-
-#undef FAIL_IF
-
-  *r_result = stack[0];
+  *r_result = regs[expr->result];
 
   /* Detect floating point evaluation errors. */
   int flags = fetestexcept(FE_DIVBYZERO | FE_INVALID);
@@ -337,6 +366,26 @@ static double op_smoothstep(double a, double b, double x)
   return t * t * (3.0 - 2.0 * t);
 }
 
+static double op_bool(double a)
+{
+  return a ? 1.0 : 0.0;
+}
+
+static double op_float(double a)
+{
+  return a;
+}
+
+static double op_min(double a, double b)
+{
+  return b < a ? b : a;
+}
+
+static double op_max(double a, double b)
+{
+  return b > a ? b : a;
+}
+
 static double op_not(double a)
 {
   return a ? 0.0 : 1.0;
@@ -378,7 +427,14 @@ struct BuiltinConstDef {
 };
 
 static BuiltinConstDef builtin_consts[] = {
-    {"pi", M_PI}, {"True", 1.0}, {"False", 0.0}, {nullptr, 0.0}};
+    {"pi", M_PI},
+    {"e", M_E},
+    {"tau", 2.0 * M_PI},
+    {"inf", HUGE_VAL},
+    {"True", 1.0},
+    {"False", 0.0},
+    {nullptr, 0.0},
+};
 
 struct BuiltinOpDef {
   const char *name;
@@ -419,6 +475,8 @@ static BuiltinOpDef builtin_ops[] = {
     {"trunc", UnaryOpFunc(trunc)},
     {"round", UnaryOpFunc(round)},
     {"int", UnaryOpFunc(trunc)},
+    {"bool", UnaryOpFunc(op_bool)},
+    {"float", UnaryOpFunc(op_float)},
     {"sin", UnaryOpFunc(sin)},
     {"cos", UnaryOpFunc(cos)},
     {"tan", UnaryOpFunc(tan)},
@@ -426,12 +484,26 @@ static BuiltinOpDef builtin_ops[] = {
     {"acos", UnaryOpFunc(acos)},
     {"atan", UnaryOpFunc(atan)},
     {"atan2", BinaryOpFunc(atan2)},
+    {"sinh", UnaryOpFunc(sinh)},
+    {"cosh", UnaryOpFunc(cosh)},
+    {"tanh", UnaryOpFunc(tanh)},
+    {"asinh", UnaryOpFunc(asinh)},
+    {"acosh", UnaryOpFunc(acosh)},
+    {"atanh", UnaryOpFunc(atanh)},
     {"exp", UnaryOpFunc(exp)},
+    {"exp2", UnaryOpFunc(exp2)},
+    {"expm1", UnaryOpFunc(expm1)},
     {"log", UnaryOpFunc(log)},
     {"log", BinaryOpFunc(op_log2)},
+    {"log2", UnaryOpFunc(log2)},
+    {"log10", UnaryOpFunc(log10)},
+    {"log1p", UnaryOpFunc(log1p)},
     {"sqrt", UnaryOpFunc(sqrt)},
+    {"cbrt", UnaryOpFunc(cbrt)},
     {"pow", BinaryOpFunc(pow)},
     {"fmod", BinaryOpFunc(fmod)},
+    {"hypot", BinaryOpFunc(hypot)},
+    {"copysign", BinaryOpFunc(copysign)},
     {"lerp", TernaryOpFunc(op_lerp)},
     {"clamp", UnaryOpFunc(op_clamp)},
     {"clamp", TernaryOpFunc(op_clamp3)},
@@ -509,13 +581,15 @@ struct ExprParseState {
 /* Add one operation and track stack usage. */
 static ExprOp *parse_add_op(ExprParseState *state, eOpCode code, int stack_delta)
 {
+  ExprOp op{code};
+  op.stack_ptr = state->stack_ptr;
+
   /* track evaluation stack depth */
   state->stack_ptr += stack_delta;
   CLAMP_MIN(state->stack_ptr, 0);
   CLAMP_MIN(state->max_stack, state->stack_ptr);
 
   /* allocate the new instruction */
-  ExprOp op{code};
   state->ops.append(op);
   return &state->ops.last();
 }
@@ -1031,6 +1105,258 @@ static bool parse_expr(ExprParseState *state)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Register Compilation
+ *
+ * Since the stack depth at every operation is known statically, each stack slot is assigned a
+ * register of its own. Constants and parameters are not copied onto the stack, instead the slot
+ * refers to them directly until the slot is written by an operation. Only values flowing through
+ * jumps need to be materialized in the register of their slot.
+ * \{ */
+
+struct RegCompileState {
+  ExprPyLike_Parsed *expr;
+  /** Frame index each stack slot currently refers to. */
+  blender::Array<int> slots;
+};
+
+static ExprRegOp *compile_add_op(RegCompileState *state, eRegOpCode opcode, int dst)
+{
+  ExprRegOp op{opcode};
+  op.dst = dst;
+  op.args[0] = op.args[1] = op.args[2] = -1;
+  op.jmp_target = -1;
+  state->expr->reg_ops.append(op);
+  return &state->expr->reg_ops.last();
+}
+
+/* Make the register of the slot hold its value. */
+static void compile_materialize(RegCompileState *state, int slot)
+{
+  if (state->slots[slot] != slot) {
+    compile_add_op(state, REGOP_MOVE, slot)->args[0] = state->slots[slot];
+    state->slots[slot] = slot;
+  }
+}
+
+/* Fold a MIN or MAX operation over `count` slots into a chain of binary function calls. */
+static void compile_reduce(RegCompileState *state, BinaryOpFunc func, int base, int count)
+{
+  /* Reduce from the top of the stack, like the stack machine did. */
+  for (int slot = base + count - 2; slot >= base; slot--) {
+    ExprRegOp *op = compile_add_op(state, REGOP_FUNC2, slot);
+    op->args[0] = state->slots[slot];
+    op->args[1] = state->slots[slot + 1];
+    op->func.func2 = func;
+    state->slots[slot] = slot;
+  }
+}
+
+/* Number of stack slots an operation reads and writes, to check the stack depth. */
+static void compile_op_slots(const ExprOp &op, int *r_read, int *r_written)
+{
+  switch (op.opcode) {
+    case OPCODE_CONST:
+    case OPCODE_PARAMETER:
+      *r_read = 0;
+      *r_written = 1;
+      return;
+    case OPCODE_FUNC1:
+    case OPCODE_JMP:
+    case OPCODE_JMP_ELSE:
+    case OPCODE_JMP_OR:
+    case OPCODE_JMP_AND:
+      *r_read = 1;
+      *r_written = 0;
+      return;
+    case OPCODE_FUNC2:
+    case OPCODE_CMP_CHAIN:
+      *r_read = 2;
+      *r_written = 0;
+      return;
+    case OPCODE_FUNC3:
+      *r_read = 3;
+      *r_written = 0;
+      return;
+    case OPCODE_MIN:
+    case OPCODE_MAX:
+      *r_read = std::max(op.arg.ival, 1);
+      *r_written = 0;
+      return;
+  }
+  *r_read = INT_MAX;
+  *r_written = 0;
+}
+
+/**
+ * Compile the register program. The evaluation does not check operand indices, so the stack
+ * depths and jumps of the stack machine program are checked here, also in release builds.
+ * \return False if the program is malformed.
+ */
+static bool compile_register_ops(ExprPyLike_Parsed *expr)
+{
+  const blender::Span<ExprOp> ops = expr->ops;
+  const int ops_num = ops.size();
+
+#define FAIL_IF(condition) \
+  if (condition) { \
+    return false; \
+  } \
+  ((void)0)
+
+  FAIL_IF(expr->max_stack <= 0);
+
+  expr->params_num = 0;
+  for (const int pc : ops.index_range()) {
+    const ExprOp &op = ops[pc];
+    int read, written;
+    compile_op_slots(op, &read, &written);
+    FAIL_IF(op.stack_ptr < read || op.stack_ptr + written > expr->max_stack);
+    if (op.opcode == OPCODE_PARAMETER) {
+      FAIL_IF(op.arg.ival < 0);
+      expr->params_num = std::max(expr->params_num, op.arg.ival + 1);
+    }
+    if (ELEM(op.opcode,
+             OPCODE_JMP,
+             OPCODE_JMP_ELSE,
+             OPCODE_JMP_OR,
+             OPCODE_JMP_AND,
+             OPCODE_CMP_CHAIN))
+    {
+      FAIL_IF(op.jmp_offset < 0 || op.jmp_offset >= ops_num - pc);
+    }
+  }
+
+  const int params_offset = expr->max_stack;
+  const int consts_offset = params_offset + expr->params_num;
+
+  RegCompileState state;
+  state.expr = expr;
+  state.slots.reinitialize(expr->max_stack);
+  for (const int slot : state.slots.index_range()) {
+    state.slots[slot] = slot;
+  }
+
+  /* Jumps to patch once the register instruction of their target is known. */
+  blender::Array<blender::Vector<int>> jumps_to(ops_num + 1);
+  blender::Array<bool> carries_value(ops_num + 1, false);
+
+  auto add_jump = [&](const int pc, const eRegOpCode opcode, const int dst, const bool value) {
+    const int target = pc + 1 + ops[pc].jmp_offset;
+    jumps_to[target].append(expr->reg_ops.size());
+    carries_value[target] |= value;
+    return compile_add_op(&state, opcode, dst);
+  };
+
+  for (int pc = 0; pc <= ops_num; pc++) {
+    /* Resolve jumps landing here. Values passed by jumps are in the register of the top slot, so
+     * the fall-through path has to put its value there as well. */
+    if (carries_value[pc]) {
+      const int depth = (pc < ops_num) ? ops[pc].stack_ptr : 1;
+      FAIL_IF(depth < 1);
+      compile_materialize(&state, depth - 1);
+    }
+    for (const int jump : jumps_to[pc]) {
+      expr->reg_ops[jump].jmp_target = expr->reg_ops.size();
+    }
+
+    if (pc == ops_num) {
+      break;
+    }
+
+    const ExprOp &op = ops[pc];
+    const int sp = op.stack_ptr;
+
+    switch (op.opcode) {
+      case OPCODE_CONST:
+        state.slots[sp] = consts_offset + expr->consts.size();
+        expr->consts.append(op.arg.dval);
+        break;
+      case OPCODE_PARAMETER:
+        state.slots[sp] = params_offset + op.arg.ival;
+        break;
+      case OPCODE_FUNC1: {
+        ExprRegOp *reg_op = compile_add_op(&state, REGOP_FUNC1, sp - 1);
+        reg_op->args[0] = state.slots[sp - 1];
+        reg_op->func.func1 = op.arg.func1;
+        state.slots[sp - 1] = sp - 1;
+        break;
+      }
+      case OPCODE_FUNC2: {
+        ExprRegOp *reg_op = compile_add_op(&state, REGOP_FUNC2, sp - 2);
+        reg_op->args[0] = state.slots[sp - 2];
+        reg_op->args[1] = state.slots[sp - 1];
+        reg_op->func.func2 = op.arg.func2;
+        state.slots[sp - 2] = sp - 2;
+        break;
+      }
+      case OPCODE_FUNC3: {
+        ExprRegOp *reg_op = compile_add_op(&state, REGOP_FUNC3, sp - 3);
+        reg_op->args[0] = state.slots[sp - 3];
+        reg_op->args[1] = state.slots[sp - 2];
+        reg_op->args[2] = state.slots[sp - 1];
+        reg_op->func.func3 = op.arg.func3;
+        state.slots[sp - 3] = sp - 3;
+        break;
+      }
+      case OPCODE_MIN:
+        compile_reduce(&state, op_min, sp - op.arg.ival, op.arg.ival);
+        break;
+      case OPCODE_MAX:
+        compile_reduce(&state, op_max, sp - op.arg.ival, op.arg.ival);
+        break;
+      case OPCODE_JMP:
+        compile_materialize(&state, sp - 1);
+        add_jump(pc, REGOP_JMP, -1, true);
+        break;
+      case OPCODE_JMP_ELSE: {
+        const int cond = state.slots[sp - 1];
+        add_jump(pc, REGOP_JMP_IF_ZERO, -1, false)->args[0] = cond;
+        break;
+      }
+      case OPCODE_JMP_OR:
+        compile_materialize(&state, sp - 1);
+        add_jump(pc, REGOP_JMP_IF_NONZERO, -1, true)->args[0] = sp - 1;
+        break;
+      case OPCODE_JMP_AND:
+        compile_materialize(&state, sp - 1);
+        add_jump(pc, REGOP_JMP_IF_ZERO, -1, true)->args[0] = sp - 1;
+        break;
+      case OPCODE_CMP_CHAIN: {
+        const int a = state.slots[sp - 2];
+        const int b = state.slots[sp - 1];
+        ExprRegOp *reg_op = add_jump(pc, REGOP_CMP_CHAIN, sp - 2, true);
+        reg_op->args[0] = a;
+        reg_op->args[1] = b;
+        reg_op->func.func2 = op.arg.func2;
+        state.slots[sp - 2] = sp - 2;
+        break;
+      }
+    }
+  }
+
+  expr->result = state.slots[0];
+
+  /* Check every frame index the evaluation reads or writes. */
+  const int frame_size = consts_offset + expr->consts.size();
+  for (const ExprRegOp &reg_op : expr->reg_ops) {
+    const bool is_jump = ELEM(reg_op.opcode, REGOP_JMP, REGOP_JMP_IF_ZERO, REGOP_JMP_IF_NONZERO);
+    FAIL_IF(reg_op.dst < (is_jump ? -1 : 0) || reg_op.dst >= expr->max_stack);
+    for (const int arg : reg_op.args) {
+      FAIL_IF(arg < -1 || arg >= frame_size);
+    }
+    FAIL_IF((is_jump || reg_op.opcode == REGOP_CMP_CHAIN) &&
+            (reg_op.jmp_target < 0 || reg_op.jmp_target > expr->reg_ops.size()));
+  }
+  FAIL_IF(expr->result < 0 || expr->result >= frame_size);
+
+#undef FAIL_IF
+
+  return true;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Main Parsing Function
  * \{ */
@@ -1057,6 +1383,12 @@ ExprPyLike_Parsed *BLI_expr_pylike_parse(const char *expression,
 
     expr->max_stack = state.max_stack;
     expr->ops = std::move(state.ops);
+
+    if (!compile_register_ops(expr)) {
+      /* Leave the expression invalid rather than evaluating a malformed program. */
+      expr->ops.clear();
+      expr->reg_ops.clear();
+    }
   }
   else {
     /* Always return a non-nullptr object so that parse failure can be cached. */
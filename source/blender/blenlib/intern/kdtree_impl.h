@@ -8,12 +8,15 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_kdtree_impl.h"
 #include "BLI_math_base.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 #include "BLI_vector.hh"
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 
 #include "BLI_strict_flags.h" /* IWYU pragma: keep. Keep last. */
@@ -54,6 +57,11 @@ struct KDTree {
 #define KD_NEAR_ALLOC_INC 100 /* alloc increment for collecting nearest */
 #define KD_FOUND_ALLOC_INC 50 /* alloc increment for collecting nearest */
 
+#define KD_BALANCE_PARALLEL_MIN 8192    /* smaller sub-trees are balanced on one thread */
+#define KD_BATCH_GRAIN_SIZE 512         /* queries per task for the batched searches */
+#define KD_DUPLICATES_PARALLEL_MIN 8192 /* smaller trees search duplicates on one thread */
+#define KD_DUPLICATES_CHUNK_SIZE 4096   /* nodes per task when gathering duplicates */
+
 #define KD_NODE_UNSET ((uint)-1)
 
 /**
@@ -190,13 +198,18 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
     }
   }
 
-  /* Set node and sort sub-nodes. */
+  /* Set node and sort sub-nodes. Both halves are disjoint ranges of the array,
+   * so large sub-trees are balanced in parallel. */
   node = &nodes[median];
   node->d = axis;
   axis = (axis + 1) % KD_DIMS;
-  node->left = kdtree_balance(nodes, median, axis, ofs);
-  node->right = kdtree_balance(
-      nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
+  blender::threading::parallel_invoke(
+      nodes_len >= KD_BALANCE_PARALLEL_MIN,
+      [&]() { node->left = kdtree_balance(nodes, median, axis, ofs); },
+      [&]() {
+        node->right = kdtree_balance(
+            nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
+      });
 
   return median + ofs;
 }
@@ -801,6 +814,92 @@ finally:
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Batched Searches
+ *
+ * Answer many queries at once, the queries are distributed over multiple threads.
+ * \{ */
+
+/**
+ * Find the nearest node of every coordinate in \a co.
+ *
+ * \param r_nearest: An array of \a co_len results,
+ * the index is -1 when the tree is empty.
+ */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        KDTreeNearest *r_nearest)
+{
+  using namespace blender;
+  threading::parallel_for(IndexRange(co_len), KD_BATCH_GRAIN_SIZE, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      if (BLI_kdtree_nd_(find_nearest)(tree, co[i], &r_nearest[i]) == -1) {
+        r_nearest[i].index = -1;
+      }
+    }
+  });
+}
+
+/**
+ * Find the \a nearest_len_capacity nearest nodes of every coordinate in \a co.
+ *
+ * \param r_nearest: An array of `co_len * nearest_len_capacity` results,
+ * the results of each coordinate are stored contiguously, sorted by distance.
+ * \param r_nearest_len: An array of \a co_len, the number of nodes found for each coordinate.
+ */
+void BLI_kdtree_nd_(find_nearest_n_batch)(const KDTree *tree,
+                                          const float (*co)[KD_DIMS],
+                                          const uint co_len,
+                                          KDTreeNearest *r_nearest,
+                                          const uint nearest_len_capacity,
+                                          int *r_nearest_len)
+{
+  using namespace blender;
+  threading::parallel_for(IndexRange(co_len), KD_BATCH_GRAIN_SIZE, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      r_nearest_len[i] = BLI_kdtree_nd_(find_nearest_n)(
+          tree, co[i], &r_nearest[i * nearest_len_capacity], nearest_len_capacity);
+    }
+  });
+}
+
+/**
+ * A version of #BLI_kdtree_3d_range_search_cb for every coordinate in \a co.
+ *
+ * \param search_cb: Called for every node found in \a range of the coordinate at \a co_index,
+ * false return value ends the search of that coordinate.
+ *
+ * \note The callback is called from multiple threads concurrently.
+ */
+void BLI_kdtree_nd_(range_search_batch_cb)(const KDTree *tree,
+                                           const float (*co)[KD_DIMS],
+                                           const uint co_len,
+                                           const float range,
+                                           bool (*search_cb)(void *user_data,
+                                                             uint co_index,
+                                                             int index,
+                                                             const float co[KD_DIMS],
+                                                             float dist_sq),
+                                           void *user_data)
+{
+  using namespace blender;
+  threading::parallel_for(
+      IndexRange(co_len), KD_BATCH_GRAIN_SIZE, [&](const IndexRange co_range) {
+        for (const int64_t i : co_range) {
+          BLI_kdtree_nd_(range_search_cb_cpp)(
+              tree,
+              co[i],
+              range,
+              [&](const int index, const float *co_node, const float dist_sq) {
+                return search_cb(user_data, uint(i), index, co_node, dist_sq);
+              });
+        }
+      });
+}
+
+/** \} */
+
 /**
  * Use when we want to loop over nodes ordered by index.
  * Requires indices to be aligned with nodes.
@@ -861,12 +960,119 @@ static void deduplicate_recursive(const DeDuplicateParams *p, uint i)
   }
 }
 
+/**
+ * Call \a fn with the index of every node in range of \a co, using the same bounds as
+ * #deduplicate_recursive so both find the same candidates.
+ */
+template<typename Fn>
+static void deduplicate_foreach_in_range(const KDTreeNode *nodes,
+                                         const uint i,
+                                         const float co[KD_DIMS],
+                                         const float range,
+                                         const float range_sq,
+                                         const Fn &fn)
+{
+  const KDTreeNode *node = &nodes[i];
+  if (co[node->d] + range <= node->co[node->d]) {
+    if (node->left != KD_NODE_UNSET) {
+      deduplicate_foreach_in_range(nodes, node->left, co, range, range_sq, fn);
+    }
+  }
+  else if (co[node->d] - range >= node->co[node->d]) {
+    if (node->right != KD_NODE_UNSET) {
+      deduplicate_foreach_in_range(nodes, node->right, co, range, range_sq, fn);
+    }
+  }
+  else {
+    if (len_squared_vnvn(node->co, co) <= range_sq) {
+      fn(node->index);
+    }
+    if (node->left != KD_NODE_UNSET) {
+      deduplicate_foreach_in_range(nodes, node->left, co, range, range_sq, fn);
+    }
+    if (node->right != KD_NODE_UNSET) {
+      deduplicate_foreach_in_range(nodes, node->right, co, range, range_sq, fn);
+    }
+  }
+}
+
+/** Candidates of the nodes in one range of #KDTree.nodes. */
+struct DuplicateCandidates {
+  /** Start of the candidates of each node in #indices, with one extra value for the end. */
+  blender::Vector<int> offsets;
+  /** The indices of the nodes in range, except the node itself. */
+  blender::Vector<int> indices;
+};
+
+/**
+ * Gather the nodes in range of every node in parallel, so the order dependent part of
+ * #BLI_kdtree_3d_calc_duplicates_fast doesn't have to search the tree.
+ *
+ * \return False when the candidates would use too much memory (large ranges on dense points),
+ * the single threaded search should be used then.
+ */
+static bool kdtree_calc_duplicate_candidates(const KDTree *tree,
+                                             const float range,
+                                             blender::Array<DuplicateCandidates> &r_chunks)
+{
+  using namespace blender;
+  const KDTreeNode *nodes = tree->nodes;
+  const float range_sq = square_f(range);
+  const int64_t candidates_max = std::max<int64_t>(int64_t(tree->nodes_len) * 4, 1 << 20);
+  std::atomic<int64_t> candidates_num = 0;
+  std::atomic<bool> cancel = false;
+
+  r_chunks.reinitialize(
+      int64_t(divide_ceil_u(tree->nodes_len, uint(KD_DUPLICATES_CHUNK_SIZE))));
+  threading::parallel_for(r_chunks.index_range(), 1, [&](const IndexRange range_chunks) {
+    for (const int64_t chunk_index : range_chunks) {
+      if (cancel.load(std::memory_order_relaxed)) {
+        return;
+      }
+      DuplicateCandidates &chunk = r_chunks[chunk_index];
+      const int64_t chunk_start = chunk_index * KD_DUPLICATES_CHUNK_SIZE;
+      const IndexRange chunk_nodes = IndexRange::from_begin_end(
+          chunk_start,
+          std::min<int64_t>(chunk_start + KD_DUPLICATES_CHUNK_SIZE, int64_t(tree->nodes_len)));
+      int64_t candidates_pending = 0;
+      chunk.offsets.reserve(chunk_nodes.size() + 1);
+      for (const int64_t node_index : chunk_nodes) {
+        const KDTreeNode &node = nodes[node_index];
+        const int64_t candidates_prev = chunk.indices.size();
+        chunk.offsets.append(int(candidates_prev));
+        deduplicate_foreach_in_range(
+            nodes, tree->root, node.co, range, range_sq, [&](const int index) {
+              if (index != node.index) {
+                chunk.indices.append(index);
+              }
+            });
+        candidates_pending += chunk.indices.size() - candidates_prev;
+        if (candidates_pending >= KD_DUPLICATES_CHUNK_SIZE) {
+          if (candidates_num.fetch_add(candidates_pending) + candidates_pending > candidates_max)
+          {
+            cancel.store(true, std::memory_order_relaxed);
+            return;
+          }
+          candidates_pending = 0;
+        }
+      }
+      chunk.offsets.append(int(chunk.indices.size()));
+      candidates_num.fetch_add(candidates_pending);
+    }
+  });
+
+  return !cancel.load() && candidates_num.load() <= candidates_max;
+}
+
 /**
  * Find duplicate points in \a range.
  * Favors speed over quality since it doesn't find the best target vertex for merging.
  * Nodes are looped over, duplicates are added when found.
  * Nevertheless results are predictable.
  *
+ * For large trees the nodes in range are gathered with multiple threads first,
+ * only merging them is done in order, so the result is the same as a single threaded search.
+ *
  * \param range: Coordinates in this range are candidates to be merged.
  * \param use_index_order: Loop over the coordinates ordered by #KDTreeNode.index
  * At the expense of some performance, this ensures the layout of the tree doesn't influence
@@ -893,7 +1099,46 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
   p.duplicates = duplicates;
   p.duplicates_found = &found;
 
-  if (use_index_order) {
+  blender::Array<DuplicateCandidates> chunks;
+  if (tree->nodes_len >= KD_DUPLICATES_PARALLEL_MIN &&
+      kdtree_calc_duplicate_candidates(tree, range, chunks))
+  {
+    /* Only the merging is done in order, the tree has already been searched. */
+    auto merge_candidates = [&](const uint node_index) {
+      const int index = tree->nodes[node_index].index;
+      if (!ELEM(duplicates[index], -1, index)) {
+        return;
+      }
+      const DuplicateCandidates &chunk = chunks[node_index / uint(KD_DUPLICATES_CHUNK_SIZE)];
+      const uint chunk_node = node_index % uint(KD_DUPLICATES_CHUNK_SIZE);
+      const int found_prev = found;
+      for (int j = chunk.offsets[chunk_node]; j < chunk.offsets[chunk_node + 1]; j++) {
+        const int index_other = chunk.indices[j];
+        if (duplicates[index_other] == -1) {
+          duplicates[index_other] = index;
+          found += 1;
+        }
+      }
+      if (found != found_prev) {
+        /* Prevent chains of doubles. */
+        duplicates[index] = index;
+      }
+    };
+    if (use_index_order) {
+      blender::Vector<int> order = kdtree_order(tree);
+      for (const int node_index : order) {
+        if (node_index != -1) {
+          merge_candidates(uint(node_index));
+        }
+      }
+    }
+    else {
+      for (uint i = 0; i < tree->nodes_len; i++) {
+        merge_candidates(i);
+      }
+    }
+  }
+  else if (use_index_order) {
     blender::Vector<int> order = kdtree_order(tree);
     for (int i = 0; i < tree->max_node_index + 1; i++) {
       const int node_index = order[i];
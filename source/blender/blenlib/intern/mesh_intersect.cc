@@ -59,6 +59,20 @@ static void dump_perfdata();
 /** For debugging, can disable threading in intersect code with this static constant. */
 static constexpr bool intersect_use_threading = true;
 
+/** #threading::parallel_for that runs serially when #intersect_use_threading is off. */
+template<typename Function>
+static void intersect_parallel_for(const IndexRange range,
+                                   const int64_t grain_size,
+                                   const Function &function)
+{
+  if (intersect_use_threading) {
+    threading::parallel_for(range, grain_size, function);
+  }
+  else {
+    function(range);
+  }
+}
+
 Vert::Vert(const mpq3 &mco, const double3 &dco, int id, int orig)
     : co_exact(mco), co(dco), id(id), orig(orig)
 {
@@ -923,6 +937,15 @@ struct ITT_value {
 
 static std::ostream &operator<<(std::ostream &os, const ITT_value &itt);
 
+/**
+ * Temporaries for the exact arithmetic in #intersect_tri_tri. GMP allocates the storage of every
+ * rational on the heap, so the same values are reused for all triangle pairs intersected by one
+ * task, instead of allocating and freeing new ones for every predicate.
+ */
+struct ITTBuffers {
+  mpq3 buf[5];
+};
+
 /**
  * Project a 3d vert to a 2d one by eliding proj_axis. This does not create
  * degeneracies as long as the projection axis is one where the corresponding
@@ -1042,6 +1065,40 @@ static int filter_plane_side(const double3 &p,
   return 0;
 }
 
+/**
+ * Index of `dot(d - a, cross(b - a, c - a))` when the coordinates have index 1:
+ * the differences have index 2, the cross product coordinates index 6 and the
+ * dot product index 11.
+ */
+constexpr int index_orient3d = 11;
+
+/**
+ * Return the approximate sign of `dot(d - a, cross(b - a, c - a))`, or 0 if the error of
+ * calculating it with doubles might change the sign.
+ */
+static int filter_orient3d(const double3 &a, const double3 &b, const double3 &c, const double3 &d)
+{
+  const double3 ba = b - a;
+  const double3 ca = c - a;
+  const double det = math::dot(d - a, math::cross(ba, ca));
+  if (det == 0.0) {
+    return 0;
+  }
+  const double3 abs_a = math::abs(a);
+  const double3 abs_ba = math::abs(b) + abs_a;
+  const double3 abs_ca = math::abs(c) + abs_a;
+  const double3 abs_da = math::abs(d) + abs_a;
+  const double3 abs_cross(abs_ba.y * abs_ca.z + abs_ba.z * abs_ca.y,
+                          abs_ba.z * abs_ca.x + abs_ba.x * abs_ca.z,
+                          abs_ba.x * abs_ca.y + abs_ba.y * abs_ca.x);
+  const double supremum = math::dot(abs_da, abs_cross);
+  const double err_bound = supremum * index_orient3d * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0 ? 1 : -1;
+  }
+  return 0;
+}
+
 /*
  * #intersect_tri_tri and helper functions.
  * This code uses the algorithm of Guigue and Devillers, as described
@@ -1055,48 +1112,55 @@ static int filter_plane_side(const double3 &p,
  * Assumes ab is not perpendicular to n.
  * This works because the ratio of the projections of ab and ac onto n is the same as
  * the ratio along the line ab of the intersection point to the whole of ab.
- * The ab, ac, and dotbuf arguments are used as a temporaries; declaring them
- * in the caller can avoid many allocations and frees of mpq3 and mpq_class structures.
  */
 static inline mpq3 tti_interp(
-    const mpq3 &a, const mpq3 &b, const mpq3 &c, const mpq3 &n, mpq3 &ab, mpq3 &ac, mpq3 &dotbuf)
-{
-  ab = a;
-  ab -= b;
-  ac = a;
-  ac -= c;
+    const Vert *a, const Vert *b, const Vert *c, const mpq3 &n, ITTBuffers &buffers)
+{
+  mpq3 &ab = buffers.buf[0];
+  mpq3 &ac = buffers.buf[1];
+  mpq3 &dotbuf = buffers.buf[2];
+  ab = a->co_exact;
+  ab -= b->co_exact;
+  ac = a->co_exact;
+  ac -= c->co_exact;
   mpq_class den = math::dot_with_buffer(ab, n, dotbuf);
   BLI_assert(den != 0);
   mpq_class alpha = math::dot_with_buffer(ac, n, dotbuf) / den;
-  return a - alpha * ab;
+  return a->co_exact - alpha * ab;
 }
 
 /**
- * Return +1, 0, -1 as a + ad is above, on, or below the oriented plane containing a, b, c in CCW
- * order. This is the same as -oriented(a, b, c, a + ad), but uses fewer arithmetic operations.
- * TODO: change arguments to `const Vert *` and use floating filters.
- * The ba, ca, n, and dotbuf arguments are used as temporaries; declaring them
- * in the caller can avoid many allocations and frees of mpq3 and mpq_class structures.
+ * Return +1, 0, -1 as d is above, on, or below the oriented plane containing a, b, c in CCW
+ * order. This is the same as -oriented(a, b, c, d), but uses fewer arithmetic operations.
+ * The sign is calculated with doubles first, exact arithmetic is only used when the points are
+ * so close to being coplanar that the rounding errors might change the sign.
  */
-static inline int tti_above(const mpq3 &a,
-                            const mpq3 &b,
-                            const mpq3 &c,
-                            const mpq3 &ad,
-                            mpq3 &ba,
-                            mpq3 &ca,
-                            mpq3 &n,
-                            mpq3 &dotbuf)
-{
-  ba = b;
-  ba -= a;
-  ca = c;
-  ca -= a;
+static inline int tti_above(
+    const Vert *a, const Vert *b, const Vert *c, const Vert *d, ITTBuffers &buffers)
+{
+  const int filter_sign = filter_orient3d(a->co, b->co, c->co, d->co);
+  if (filter_sign != 0) {
+    return filter_sign;
+  }
+#  ifdef PERFDEBUG
+  incperfcount(5); /* Triangle-triangle orientation tests needing exact arithmetic. */
+#  endif
+  mpq3 &ba = buffers.buf[0];
+  mpq3 &ca = buffers.buf[1];
+  mpq3 &n = buffers.buf[2];
+  mpq3 &ad = buffers.buf[3];
+  ba = b->co_exact;
+  ba -= a->co_exact;
+  ca = c->co_exact;
+  ca -= a->co_exact;
+  ad = d->co_exact;
+  ad -= a->co_exact;
 
   n.x = ba.y * ca.z - ba.z * ca.y;
   n.y = ba.z * ca.x - ba.x * ca.z;
   n.z = ba.x * ca.y - ba.y * ca.x;
 
-  return sgn(math::dot_with_buffer(ad, n, dotbuf));
+  return sgn(math::dot_with_buffer(ad, n, buffers.buf[4]));
 }
 
 /**
@@ -1112,14 +1176,15 @@ static inline int tti_above(const mpq3 &a,
  *   of the plane and at least one of q1 and r1 are off the plane.
  * Similarly for p2, q2, r2 with respect to the first triangle's plane.
  */
-static ITT_value itt_canon2(const mpq3 &p1,
-                            const mpq3 &q1,
-                            const mpq3 &r1,
-                            const mpq3 &p2,
-                            const mpq3 &q2,
-                            const mpq3 &r2,
+static ITT_value itt_canon2(const Vert *p1,
+                            const Vert *q1,
+                            const Vert *r1,
+                            const Vert *p2,
+                            const Vert *q2,
+                            const Vert *r2,
                             const mpq3 &n1,
-                            const mpq3 &n2)
+                            const mpq3 &n2,
+                            ITTBuffers &buffers)
 {
   constexpr int dbg_level = 0;
   if (dbg_level > 0) {
@@ -1128,33 +1193,25 @@ static ITT_value itt_canon2(const mpq3 &p1,
     std::cout << "p2=" << p2 << " q2=" << q2 << " r2=" << r2 << "\n";
     std::cout << "n1=" << n1 << " n2=" << n2 << "\n";
     std::cout << "approximate values:\n";
-    std::cout << "p1=(" << p1[0].get_d() << "," << p1[1].get_d() << "," << p1[2].get_d() << ")\n";
-    std::cout << "q1=(" << q1[0].get_d() << "," << q1[1].get_d() << "," << q1[2].get_d() << ")\n";
-    std::cout << "r1=(" << r1[0].get_d() << "," << r1[1].get_d() << "," << r1[2].get_d() << ")\n";
-    std::cout << "p2=(" << p2[0].get_d() << "," << p2[1].get_d() << "," << p2[2].get_d() << ")\n";
-    std::cout << "q2=(" << q2[0].get_d() << "," << q2[1].get_d() << "," << q2[2].get_d() << ")\n";
-    std::cout << "r2=(" << r2[0].get_d() << "," << r2[1].get_d() << "," << r2[2].get_d() << ")\n";
     std::cout << "n1=(" << n1[0].get_d() << "," << n1[1].get_d() << "," << n1[2].get_d() << ")\n";
     std::cout << "n2=(" << n2[0].get_d() << "," << n2[1].get_d() << "," << n2[2].get_d() << ")\n";
   }
-  mpq3 p1p2 = p2 - p1;
   mpq3 intersect_1;
   mpq3 intersect_2;
-  mpq3 buf[4];
   bool no_overlap = false;
   /* Top test in classification tree. */
-  if (tti_above(p1, q1, r2, p1p2, buf[0], buf[1], buf[2], buf[3]) > 0) {
+  if (tti_above(p1, q1, r2, p2, buffers) > 0) {
     /* Middle right test in classification tree. */
-    if (tti_above(p1, r1, r2, p1p2, buf[0], buf[1], buf[2], buf[3]) <= 0) {
+    if (tti_above(p1, r1, r2, p2, buffers) <= 0) {
       /* Bottom right test in classification tree. */
-      if (tti_above(p1, r1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) > 0) {
+      if (tti_above(p1, r1, q2, p2, buffers) > 0) {
         /* Overlap is [k [i l] j]. */
         if (dbg_level > 0) {
           std::cout << "overlap [k [i l] j]\n";
         }
         /* i is intersect with p1r1. l is intersect with p2r2. */
-        intersect_1 = tti_interp(p1, r1, p2, n2, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p2, r2, p1, n1, buf[0], buf[1], buf[2]);
+        intersect_1 = tti_interp(p1, r1, p2, n2, buffers);
+        intersect_2 = tti_interp(p2, r2, p1, n1, buffers);
       }
       else {
         /* Overlap is [i [k l] j]. */
@@ -1162,8 +1219,8 @@ static ITT_value itt_canon2(const mpq3 &p1,
           std::cout << "overlap [i [k l] j]\n";
         }
         /* k is intersect with p2q2. l is intersect is p2r2. */
-        intersect_1 = tti_interp(p2, q2, p1, n1, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p2, r2, p1, n1, buf[0], buf[1], buf[2]);
+        intersect_1 = tti_interp(p2, q2, p1, n1, buffers);
+        intersect_2 = tti_interp(p2, r2, p1, n1, buffers);
       }
     }
     else {
@@ -1176,7 +1233,7 @@ static ITT_value itt_canon2(const mpq3 &p1,
   }
   else {
     /* Middle left test in classification tree. */
-    if (tti_above(p1, q1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) < 0) {
+    if (tti_above(p1, q1, q2, p2, buffers) < 0) {
       /* No overlap: [i j] [k l]. */
       if (dbg_level > 0) {
         std::cout << "no overlap: [i j] [k l]\n";
@@ -1185,14 +1242,14 @@ static ITT_value itt_canon2(const mpq3 &p1,
     }
     else {
       /* Bottom left test in classification tree. */
-      if (tti_above(p1, r1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) >= 0) {
+      if (tti_above(p1, r1, q2, p2, buffers) >= 0) {
         /* Overlap is [k [i j] l]. */
         if (dbg_level > 0) {
           std::cout << "overlap [k [i j] l]\n";
         }
         /* i is intersect with p1r1. j is intersect with p1q1. */
-        intersect_1 = tti_interp(p1, r1, p2, n2, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p1, q1, p2, n2, buf[0], buf[1], buf[2]);
+        intersect_1 = tti_interp(p1, r1, p2, n2, buffers);
+        intersect_2 = tti_interp(p1, q1, p2, n2, buffers);
       }
       else {
         /* Overlap is [i [k j] l]. */
@@ -1200,8 +1257,8 @@ static ITT_value itt_canon2(const mpq3 &p1,
           std::cout << "overlap [i [k j] l]\n";
         }
         /* k is intersect with p2q2. j is intersect with p1q1. */
-        intersect_1 = tti_interp(p2, q2, p1, n1, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p1, q1, p2, n2, buf[0], buf[1], buf[2]);
+        intersect_1 = tti_interp(p2, q2, p1, n1, buffers);
+        intersect_2 = tti_interp(p1, q1, p2, n2, buffers);
       }
     }
   }
@@ -1222,54 +1279,55 @@ static ITT_value itt_canon2(const mpq3 &p1,
 
 /* Helper function for intersect_tri_tri. Arguments have been canonicalized for triangle 1. */
 
-static ITT_value itt_canon1(const mpq3 &p1,
-                            const mpq3 &q1,
-                            const mpq3 &r1,
-                            const mpq3 &p2,
-                            const mpq3 &q2,
-                            const mpq3 &r2,
+static ITT_value itt_canon1(const Vert *p1,
+                            const Vert *q1,
+                            const Vert *r1,
+                            const Vert *p2,
+                            const Vert *q2,
+                            const Vert *r2,
                             const mpq3 &n1,
                             const mpq3 &n2,
                             int sp2,
                             int sq2,
-                            int sr2)
+                            int sr2,
+                            ITTBuffers &buffers)
 {
   constexpr int dbg_level = 0;
   if (sp2 > 0) {
     if (sq2 > 0) {
-      return itt_canon2(p1, r1, q1, r2, p2, q2, n1, n2);
+      return itt_canon2(p1, r1, q1, r2, p2, q2, n1, n2, buffers);
     }
     if (sr2 > 0) {
-      return itt_canon2(p1, r1, q1, q2, r2, p2, n1, n2);
+      return itt_canon2(p1, r1, q1, q2, r2, p2, n1, n2, buffers);
     }
-    return itt_canon2(p1, q1, r1, p2, q2, r2, n1, n2);
+    return itt_canon2(p1, q1, r1, p2, q2, r2, n1, n2, buffers);
   }
   if (sp2 < 0) {
     if (sq2 < 0) {
-      return itt_canon2(p1, q1, r1, r2, p2, q2, n1, n2);
+      return itt_canon2(p1, q1, r1, r2, p2, q2, n1, n2, buffers);
     }
     if (sr2 < 0) {
-      return itt_canon2(p1, q1, r1, q2, r2, p2, n1, n2);
+      return itt_canon2(p1, q1, r1, q2, r2, p2, n1, n2, buffers);
     }
-    return itt_canon2(p1, r1, q1, p2, q2, r2, n1, n2);
+    return itt_canon2(p1, r1, q1, p2, q2, r2, n1, n2, buffers);
   }
   if (sq2 < 0) {
     if (sr2 >= 0) {
-      return itt_canon2(p1, r1, q1, q2, r2, p2, n1, n2);
+      return itt_canon2(p1, r1, q1, q2, r2, p2, n1, n2, buffers);
     }
-    return itt_canon2(p1, q1, r1, p2, q2, r2, n1, n2);
+    return itt_canon2(p1, q1, r1, p2, q2, r2, n1, n2, buffers);
   }
   if (sq2 > 0) {
     if (sr2 > 0) {
-      return itt_canon2(p1, r1, q1, p2, q2, r2, n1, n2);
+      return itt_canon2(p1, r1, q1, p2, q2, r2, n1, n2, buffers);
     }
-    return itt_canon2(p1, q1, r1, q2, r2, p2, n1, n2);
+    return itt_canon2(p1, q1, r1, q2, r2, p2, n1, n2, buffers);
   }
   if (sr2 > 0) {
-    return itt_canon2(p1, q1, r1, r2, p2, q2, n1, n2);
+    return itt_canon2(p1, q1, r1, r2, p2, q2, n1, n2, buffers);
   }
   if (sr2 < 0) {
-    return itt_canon2(p1, r1, q1, r2, p2, q2, n1, n2);
+    return itt_canon2(p1, r1, q1, r2, p2, q2, n1, n2, buffers);
   }
   if (dbg_level > 0) {
     std::cout << "triangles are co-planar\n";
@@ -1277,7 +1335,7 @@ static ITT_value itt_canon1(const mpq3 &p1,
   return ITT_value(ICOPLANAR);
 }
 
-static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
+static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2, ITTBuffers &buffers)
 {
   constexpr int dbg_level = 0;
 #  ifdef PERFDEBUG
@@ -1352,7 +1410,7 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
     return ITT_value(INONE);
   }
 
-  mpq3 buf[2];
+  mpq3 *buf = buffers.buf;
   const mpq3 &p1 = vp1->co_exact;
   const mpq3 &q1 = vq1->co_exact;
   const mpq3 &r1 = vr1->co_exact;
@@ -1429,49 +1487,49 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
   ITT_value ans;
   if (sp1 > 0) {
     if (sq1 > 0) {
-      ans = itt_canon1(r1, p1, q1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vr1, vp1, vq1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2, buffers);
     }
     else if (sr1 > 0) {
-      ans = itt_canon1(q1, r1, p1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vq1, vr1, vp1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2, buffers);
     }
     else {
-      ans = itt_canon1(p1, q1, r1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vp1, vq1, vr1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2, buffers);
     }
   }
   else if (sp1 < 0) {
     if (sq1 < 0) {
-      ans = itt_canon1(r1, p1, q1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vr1, vp1, vq1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2, buffers);
     }
     else if (sr1 < 0) {
-      ans = itt_canon1(q1, r1, p1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vq1, vr1, vp1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2, buffers);
     }
     else {
-      ans = itt_canon1(p1, q1, r1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vp1, vq1, vr1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2, buffers);
     }
   }
   else {
     if (sq1 < 0) {
       if (sr1 >= 0) {
-        ans = itt_canon1(q1, r1, p1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vq1, vr1, vp1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2, buffers);
       }
       else {
-        ans = itt_canon1(p1, q1, r1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vp1, vq1, vr1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2, buffers);
       }
     }
     else if (sq1 > 0) {
       if (sr1 > 0) {
-        ans = itt_canon1(p1, q1, r1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vp1, vq1, vr1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2, buffers);
       }
       else {
-        ans = itt_canon1(q1, r1, p1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vq1, vr1, vp1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2, buffers);
       }
     }
     else {
       if (sr1 > 0) {
-        ans = itt_canon1(r1, p1, q1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vr1, vp1, vq1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2, buffers);
       }
       else if (sr1 < 0) {
-        ans = itt_canon1(r1, p1, q1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vr1, vp1, vq1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2, buffers);
       }
       else {
         if (dbg_level > 0) {
@@ -2327,7 +2385,12 @@ class TriOverlaps {
       overlap_num_ += overlap_num_;
     }
     /* Sort the overlaps to bring all the intersects with a given indexA together. */
-    std::sort(overlap_, overlap_ + overlap_num_, bvhtreeverlap_cmp);
+    if (intersect_use_threading) {
+      parallel_sort(overlap_, overlap_ + overlap_num_, bvhtreeverlap_cmp);
+    }
+    else {
+      std::sort(overlap_, overlap_ + overlap_num_, bvhtreeverlap_cmp);
+    }
     if (dbg_level > 0) {
       std::cout << overlap_num_ << " overlaps found:\n";
       for (BVHTreeOverlap ov : overlap()) {
@@ -2374,21 +2437,6 @@ class TriOverlaps {
   }
 };
 
-/**
- * Data needed for parallelization of #calc_overlap_itts.
- */
-struct OverlapIttsData {
-  Vector<std::pair<int, int>> intersect_pairs;
-  Map<std::pair<int, int>, ITT_value> &itt_map;
-  const IMesh &tm;
-  IMeshArena *arena;
-
-  OverlapIttsData(Map<std::pair<int, int>, ITT_value> &itt_map, const IMesh &tm, IMeshArena *arena)
-      : itt_map(itt_map), tm(tm), arena(arena)
-  {
-  }
-};
-
 /**
  * Return a std::pair containing a and b in canonical order:
  * With a <= b.
@@ -2401,52 +2449,39 @@ static std::pair<int, int> canon_int_pair(int a, int b)
   return std::pair<int, int>(a, b);
 }
 
-static void calc_overlap_itts_range_func(void *__restrict userdata,
-                                         const int iter,
-                                         const TaskParallelTLS *__restrict /*tls*/)
-{
-  constexpr int dbg_level = 0;
-  OverlapIttsData *data = static_cast<OverlapIttsData *>(userdata);
-  std::pair<int, int> tri_pair = data->intersect_pairs[iter];
-  int a = tri_pair.first;
-  int b = tri_pair.second;
-  if (dbg_level > 0) {
-    std::cout << "calc_overlap_itts_range_func a=" << a << ", b=" << b << "\n";
-  }
-  ITT_value itt = intersect_tri_tri(data->tm, a, b);
-  if (dbg_level > 0) {
-    std::cout << "result of intersecting " << a << " and " << b << " = " << itt << "\n";
-  }
-  BLI_assert(data->itt_map.contains(tri_pair));
-  data->itt_map.add_overwrite(tri_pair, itt);
-}
-
 /**
  * Fill in itt_map with the vector of ITT_values that result from intersecting the triangles in
  * ov. Use a canonical order for triangles: (a,b) where  a < b.
  */
 static void calc_overlap_itts(Map<std::pair<int, int>, ITT_value> &itt_map,
                               const IMesh &tm,
-                              const TriOverlaps &ov,
-                              IMeshArena *arena)
+                              const TriOverlaps &ov)
 {
-  OverlapIttsData data(itt_map, tm, arena);
+  constexpr int dbg_level = 0;
   /* Put dummy values in `itt_map` initially,
-   * so map entries will exist when doing the range function.
+   * so map entries will exist when doing the parallel loop.
    * This means we won't have to protect the `itt_map.add_overwrite` function with a lock. */
+  Vector<std::pair<int, int>> intersect_pairs;
   for (const BVHTreeOverlap &olap : ov.overlap()) {
     std::pair<int, int> key = canon_int_pair(olap.indexA, olap.indexB);
     if (!itt_map.contains(key)) {
       itt_map.add_new(key, ITT_value());
-      data.intersect_pairs.append(key);
+      intersect_pairs.append(key);
     }
   }
-  int tot_intersect_pairs = data.intersect_pairs.size();
-  TaskParallelSettings settings;
-  BLI_parallel_range_settings_defaults(&settings);
-  settings.min_iter_per_thread = 1000;
-  settings.use_threading = intersect_use_threading;
-  BLI_task_parallel_range(0, tot_intersect_pairs, &data, calc_overlap_itts_range_func, &settings);
+  intersect_parallel_for(intersect_pairs.index_range(), 1024, [&](IndexRange range) {
+    /* Reuse the exact arithmetic temporaries for all pairs handled by this task. */
+    ITTBuffers buffers;
+    for (const int i : range) {
+      const std::pair<int, int> tri_pair = intersect_pairs[i];
+      ITT_value itt = intersect_tri_tri(tm, tri_pair.first, tri_pair.second, buffers);
+      if (dbg_level > 0) {
+        std::cout << "result of intersecting " << tri_pair.first << " and " << tri_pair.second
+                  << " = " << itt << "\n";
+      }
+      itt_map.lookup(tri_pair) = std::move(itt);
+    }
+  });
 }
 
 /**
@@ -2694,13 +2729,22 @@ static CoplanarClusterInfo find_clusters(const IMesh &tm,
    * triangles that form intersection bridges between two or more clusters. */
   Map<Plane, Vector<CoplanarCluster>> plane_cls;
   plane_cls.reserve(maybe_coplanar_tris.size());
-  for (int t : maybe_coplanar_tris) {
-    /* Use a canonical version of the plane for map index.
-     * We can't just store the canonical version in the face
-     * since canonicalizing loses the orientation of the normal. */
-    Plane tplane = *tm.face(t)->plane;
-    BLI_assert(tplane.exact_populated());
-    tplane.make_canonical();
+  /* Use a canonical version of the plane for map index.
+   * We can't just store the canonical version in the face
+   * since canonicalizing loses the orientation of the normal.
+   * Canonicalizing needs exact divisions, so do it for all triangles in parallel first. */
+  Array<Plane> canon_planes(maybe_coplanar_tris.size(), NoInitialization());
+  intersect_parallel_for(maybe_coplanar_tris.index_range(), 256, [&](IndexRange range) {
+    for (const int i : range) {
+      Plane *tplane = new (static_cast<void *>(&canon_planes[i]))
+          Plane(*tm.face(maybe_coplanar_tris[i])->plane);
+      BLI_assert(tplane->exact_populated());
+      tplane->make_canonical();
+    }
+  });
+  for (const int i : maybe_coplanar_tris.index_range()) {
+    const int t = maybe_coplanar_tris[i];
+    const Plane &tplane = canon_planes[i];
     if (dbg_level > 0) {
       std::cout << "plane for tri " << t << " = " << &tplane << "\n";
     }
@@ -2922,7 +2966,7 @@ IMesh trimesh_nary_intersect(const IMesh &tm_in,
    * triangles with indices a and b, where a < b. */
   Map<std::pair<int, int>, ITT_value> itt_map;
   itt_map.reserve(tri_ov.overlap().size());
-  calc_overlap_itts(itt_map, *tm_clean, tri_ov, arena);
+  calc_overlap_itts(itt_map, *tm_clean, tri_ov);
 #  ifdef PERFDEBUG
   double itt_time = BLI_time_now_seconds();
   std::cout << "itts found, time = " << itt_time - plane_populate << "\n";
@@ -2945,9 +2989,15 @@ IMesh trimesh_nary_intersect(const IMesh &tm_in,
             << "\n";
 #  endif
   Array<CDT_data> cluster_subdivided(clinfo.tot_cluster());
-  for (int c : clinfo.index_range()) {
-    cluster_subdivided[c] = calc_cluster_subdivided(clinfo, c, *tm_clean, tri_ov, itt_map, arena);
-  }
+  /* Clusters are independent of each other and can be very different in size, so every cluster
+   * is its own task. The faces are still extracted serially below, to keep the output
+   * repeatable. */
+  intersect_parallel_for(clinfo.index_range(), 1, [&](IndexRange range) {
+    for (int c : range) {
+      cluster_subdivided[c] = calc_cluster_subdivided(
+          clinfo, c, *tm_clean, tri_ov, itt_map, arena);
+    }
+  });
 #  ifdef PERFDEBUG
   double cluster_subdivide_time = BLI_time_now_seconds();
   std::cout << "subdivided clusters found, time = "
@@ -3100,6 +3150,10 @@ static void perfdata_init()
   perfdata->count.append(0);
   perfdata->count_name.append("final non-NONE intersects");
 
+  /* count 5. */
+  perfdata->count.append(0);
+  perfdata->count_name.append("tri tri orientation tests needing exact arithmetic");
+
   /* max 0. */
   perfdata->max.append(0);
   perfdata->max_name.append("total faces");
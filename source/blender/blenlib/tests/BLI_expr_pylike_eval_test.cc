@@ -114,6 +114,7 @@ TEST_PARSE_FAIL(Truncated7, "1 and")
 TEST_PARSE_FAIL(Truncated8, "1 or")
 TEST_PARSE_FAIL(Truncated9, "sqrt(1")
 TEST_PARSE_FAIL(Truncated10, "fmod(1,")
+TEST_PARSE_FAIL(BadId2, "math.pi")
 
 /* Constant expression with working constant folding */
 #define TEST_CONST(name, str, value) \
@@ -148,6 +149,8 @@ TEST_CONST(Half, ".5", 0.5)
 TEST_CONST(Pi, "pi", M_PI)
 TEST_CONST(True, "True", TRUE_VAL)
 TEST_CONST(False, "False", FALSE_VAL)
+TEST_CONST(E, "e", M_E)
+TEST_CONST(Tau, "tau", 2.0 * M_PI)
 
 TEST_CONST(Sqrt, "sqrt(4)", 2.0)
 TEST_EVAL(Sqrt, "sqrt(x)", 4.0, 2.0)
@@ -159,6 +162,19 @@ TEST_CONST(Pow, "pow(4, 0.5)", 2.0)
 TEST_EVAL(Pow, "pow(4, x)", 0.5, 2.0)
 
 TEST_CONST(Log2_1, "log(4, 2)", 2.0)
+TEST_CONST(Log2_2, "log2(8)", 3.0)
+TEST_CONST(Log10, "log10(100)", 2.0)
+
+TEST_CONST(Sin, "sin(0)", 0.0)
+TEST_EVAL(Sin, "sin(x)", M_PI_2, 1.0)
+TEST_EVAL(Tanh, "tanh(x)", 0.0, 0.0)
+TEST_EVAL(Exp2, "exp2(x)", 3.0, 8.0)
+TEST_EVAL(Hypot, "hypot(x, 4)", 3.0, 5.0)
+TEST_EVAL(CopySign, "copysign(2, x)", -1.0, -2.0)
+
+TEST_CONST(Bool1, "bool(2)", TRUE_VAL)
+TEST_CONST(Bool2, "bool(0)", FALSE_VAL)
+TEST_EVAL(Float, "float(x)", 1.5, 1.5)
 
 TEST_CONST(Round1, "round(-0.5)", -1.0)
 TEST_CONST(Round2, "round(-0.4)", 0.0)
@@ -190,6 +206,11 @@ TEST_RESULT(Min2, "min(1,2,3)", 1.0)
 TEST_RESULT(Max2, "max(1,2,3)", 3.0)
 TEST_RESULT(Min3, "min(2,3,1)", 1.0)
 TEST_RESULT(Max3, "max(2,3,1)", 3.0)
+TEST_RESULT(Min4, "min(2)", 2.0)
+
+TEST_EVAL(Min1, "min(x, 2, 3)", 1.0, 1.0)
+TEST_EVAL(Min2, "min(x, 2, 3)", 4.0, 2.0)
+TEST_EVAL(Max1, "max(1, x + 1, 3)", 4.0, 5.0)
 
 TEST_CONST(UnaryPlus, "+1", 1.0)
 
@@ -276,6 +297,12 @@ TEST_RESULT(Or2, "0 or 3", 3.0)
 TEST_RESULT(Bool1, "2 or 3 and 4", 2.0)
 TEST_RESULT(Bool2, "not 2 or 3 and 4", 4.0)
 
+TEST_EVAL(And1, "x and 2", 0.0, 0.0)
+TEST_EVAL(And2, "x and 2", 3.0, 2.0)
+TEST_EVAL(Or1, "x or 2", 0.0, 2.0)
+TEST_EVAL(Or2, "x or 2", 3.0, 3.0)
+TEST_EVAL(Bool1, "1 + (x or 2) * (x and 3)", 4.0, 13.0)
+
 TEST(expr_pylike, Eval_Ternary1)
 {
   ExprPyLike_Parsed *expr = parse_for_eval("x / 2 if x < 4 else x - 2 if x < 8 else x*2 - 12",
@@ -291,6 +318,20 @@ TEST(expr_pylike, Eval_Ternary1)
   BLI_expr_pylike_free(expr);
 }
 
+TEST(expr_pylike, Eval_Ternary2)
+{
+  ExprPyLike_Parsed *expr = parse_for_eval("(1 if x else 2) + (x < 5 < 2 * x or -x)", true);
+
+  for (int i = 0; i <= 10; i++) {
+    double x = i;
+    double v = (x ? 1 : 2) + ((x < 5 && 5 < 2 * x) ? 1 : -x);
+
+    verify_eval_result(expr, x, v);
+  }
+
+  BLI_expr_pylike_free(expr);
+}
+
 TEST(expr_pylike, MultipleArgs)
 {
   const char *names[3] = {"x", "y", "x"};
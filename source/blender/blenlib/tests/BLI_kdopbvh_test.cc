@@ -8,10 +8,17 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_compiler_attrs.h"
 #include "BLI_kdopbvh.hh"
+#include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
 #include "BLI_rand.h"
+#include "BLI_vector.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
 
 /* -------------------------------------------------------------------- */
 /* Helper Functions */
@@ -134,3 +141,299 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/* -------------------------------------------------------------------- */
+/* Wide Tree */
+
+struct WideTestTris {
+  blender::Array<std::array<blender::float3, 3>> tris;
+};
+
+static WideTestTris wide_test_tris(const int tris_num, const int random_seed)
+{
+  RNG *rng = BLI_rng_new(random_seed);
+  WideTestTris data;
+  data.tris.reinitialize(tris_num);
+  for (std::array<blender::float3, 3> &tri : data.tris) {
+    float center[3], offset[3];
+    rng_v3_round(center, 3, rng, 100000, 10.0f);
+    for (blender::float3 &co : tri) {
+      rng_v3_round(offset, 3, rng, 100000, 0.2f);
+      co = blender::float3(center) + blender::float3(offset);
+    }
+  }
+  BLI_rng_free(rng);
+  return data;
+}
+
+static BVHTree *wide_test_tree(const WideTestTris &data, const int flag)
+{
+  BVHTree *tree = BLI_bvhtree_new(int(data.tris.size()), 0.0f, 2, 6);
+  for (const int i : data.tris.index_range()) {
+    BLI_bvhtree_insert(tree, i, data.tris[i][0], 3);
+  }
+  BLI_bvhtree_balance_ex(tree, flag);
+  return tree;
+}
+
+static void wide_test_ray_cast_cb(void *userdata,
+                                  int index,
+                                  const BVHTreeRay *ray,
+                                  BVHTreeRayHit *hit)
+{
+  const WideTestTris &data = *static_cast<const WideTestTris *>(userdata);
+  const std::array<blender::float3, 3> &tri = data.tris[index];
+  float dist;
+  if (isect_ray_tri_v3(ray->origin, ray->direction, tri[0], tri[1], tri[2], &dist, nullptr) &&
+      dist < hit->dist)
+  {
+    hit->index = index;
+    hit->dist = dist;
+  }
+}
+
+static void wide_test_nearest_cb(void *userdata,
+                                 int index,
+                                 const float co[3],
+                                 BVHTreeNearest *nearest)
+{
+  const WideTestTris &data = *static_cast<const WideTestTris *>(userdata);
+  const std::array<blender::float3, 3> &tri = data.tris[index];
+  float closest[3];
+  closest_on_tri_to_point_v3(closest, co, tri[0], tri[1], tri[2]);
+  const float dist_sq = len_squared_v3v3(co, closest);
+  if (dist_sq < nearest->dist_sq) {
+    nearest->index = index;
+    nearest->dist_sq = dist_sq;
+    copy_v3_v3(nearest->co, closest);
+  }
+}
+
+static blender::Array<BVHTreeRay> wide_test_rays(const int rays_num, const float radius)
+{
+  RNG *rng = BLI_rng_new(rays_num);
+  blender::Array<BVHTreeRay> rays(rays_num);
+  for (BVHTreeRay &ray : rays) {
+    rng_v3_round(ray.origin, 3, rng, 100000, 12.0f);
+    rng_v3_round(ray.direction, 3, rng, 100000, 1.0f);
+    normalize_v3(ray.direction);
+    ray.radius = radius;
+  }
+  BLI_rng_free(rng);
+  return rays;
+}
+
+static void wide_test_compare_ray_casts(const WideTestTris &data,
+                                        const BVHTree *tree,
+                                        const blender::Span<BVHTreeRay> rays)
+{
+  for (const BVHTreeRay &ray : rays) {
+    /* Compare with a brute force search. */
+    BVHTreeRayHit expected = {};
+    expected.index = -1;
+    expected.dist = BVH_RAYCAST_DIST_MAX;
+    for (const int i : data.tris.index_range()) {
+      wide_test_ray_cast_cb((void *)&data, i, &ray, &expected);
+    }
+    BVHTreeRayHit hit = {};
+    hit.index = -1;
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast_ex(tree,
+                            ray.origin,
+                            ray.direction,
+                            ray.radius,
+                            &hit,
+                            wide_test_ray_cast_cb,
+                            (void *)&data,
+                            0);
+    EXPECT_EQ(hit.index, expected.index);
+    EXPECT_EQ(hit.dist, expected.dist);
+  }
+}
+
+TEST(kdopbvh, WideRayCast)
+{
+  const WideTestTris data = wide_test_tris(5000, 4);
+  BVHTree *tree = wide_test_tree(data, BVH_BALANCE_WIDE);
+  wide_test_compare_ray_casts(data, tree, wide_test_rays(500, 0.0f));
+  wide_test_compare_ray_casts(data, tree, wide_test_rays(500, 0.5f));
+  BLI_bvhtree_free(tree);
+}
+
+TEST(kdopbvh, WideRayCastUpdate)
+{
+  WideTestTris data = wide_test_tris(2000, 5);
+  BVHTree *tree = wide_test_tree(data, BVH_BALANCE_WIDE);
+  /* Build the wide tree before the update, so that it's refit. */
+  wide_test_compare_ray_casts(data, tree, wide_test_rays(100, 0.0f));
+  for (const int i : data.tris.index_range()) {
+    for (blender::float3 &co : data.tris[i]) {
+      co.z += float(i % 7) * 0.5f;
+    }
+    BLI_bvhtree_update_node(tree, i, data.tris[i][0], nullptr, 3);
+  }
+  BLI_bvhtree_update_tree(tree);
+  wide_test_compare_ray_casts(data, tree, wide_test_rays(500, 0.0f));
+  BLI_bvhtree_free(tree);
+}
+
+TEST(kdopbvh, WideFindNearest)
+{
+  const WideTestTris data = wide_test_tris(5000, 6);
+  BVHTree *tree = wide_test_tree(data, 0);
+  BVHTree *tree_wide = wide_test_tree(data, BVH_BALANCE_WIDE);
+  /* Nearest point queries only use the wide tree once a ray-cast built it. */
+  wide_test_compare_ray_casts(data, tree_wide, wide_test_rays(10, 0.0f));
+  RNG *rng = BLI_rng_new(7);
+  for (int i = 0; i < 500; i++) {
+    float co[3];
+    rng_v3_round(co, 3, rng, 100000, 12.0f);
+    BVHTreeNearest expected = {};
+    expected.index = -1;
+    expected.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, co, &expected, wide_test_nearest_cb, (void *)&data);
+    BVHTreeNearest nearest = {};
+    nearest.index = -1;
+    nearest.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree_wide, co, &nearest, wide_test_nearest_cb, (void *)&data);
+    EXPECT_EQ(nearest.index, expected.index);
+    EXPECT_EQ(nearest.dist_sq, expected.dist_sq);
+  }
+  BLI_rng_free(rng);
+  BLI_bvhtree_free(tree);
+  BLI_bvhtree_free(tree_wide);
+}
+
+static void wide_test_collect_leafs_cb(void *userdata,
+                                       int index,
+                                       const BVHTreeRay * /*ray*/,
+                                       BVHTreeRayHit * /*hit*/)
+{
+  static_cast<blender::Vector<int> *>(userdata)->append(index);
+}
+
+static blender::Vector<int> wide_test_ray_cast_leafs(const BVHTree *tree,
+                                                     const float co[3],
+                                                     const float dir[3])
+{
+  blender::Vector<int> leafs;
+  BLI_bvhtree_ray_cast_all(
+      tree, co, dir, 0.0f, BVH_RAYCAST_DIST_MAX, wide_test_collect_leafs_cb, &leafs);
+  std::sort(leafs.begin(), leafs.end());
+  return leafs;
+}
+
+/* Build a row of unit boxes along the X axis. */
+static BVHTree *wide_test_boxes_tree(const int boxes_num, const int flag, const int nan_box = -1)
+{
+  BVHTree *tree = BLI_bvhtree_new(boxes_num, 0.0f, 2, 6);
+  for (const int i : blender::IndexRange(boxes_num)) {
+    float box[2][3] = {{float(i), 0.0f, 0.0f}, {float(i + 1), 1.0f, 1.0f}};
+    if (i == nan_box) {
+      box[1][1] = NAN;
+    }
+    BLI_bvhtree_insert(tree, i, box[0], 2);
+  }
+  BLI_bvhtree_balance_ex(tree, flag);
+  return tree;
+}
+
+TEST(kdopbvh, WideRayCastOnFace)
+{
+  const int boxes_num = 100;
+  BVHTree *tree = wide_test_boxes_tree(boxes_num, 0);
+  BVHTree *tree_wide = wide_test_boxes_tree(boxes_num, BVH_BALANCE_WIDE);
+
+  /* Axis aligned rays with their origin on a face of the boxes, or on the plane of one. */
+  for (const int i : blender::IndexRange(boxes_num)) {
+    const float rays[][2][3] = {
+        {{float(i) + 0.5f, 0.0f, -1.0f}, {0.0f, 0.0f, 1.0f}},
+        {{float(i) + 0.5f, 1.0f, 2.0f}, {0.0f, 0.0f, -1.0f}},
+        {{float(i), 0.5f, -1.0f}, {0.0f, 0.0f, 1.0f}},
+        {{float(i) + 0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+        {{float(i) + 0.5f, 0.0f, 0.5f}, {0.0f, 1.0f, 0.0f}},
+    };
+    for (const auto &ray : rays) {
+      const blender::Vector<int> expected = wide_test_ray_cast_leafs(tree, ray[0], ray[1]);
+      EXPECT_TRUE(expected.contains(i));
+      EXPECT_EQ(wide_test_ray_cast_leafs(tree_wide, ray[0], ray[1]), expected);
+    }
+  }
+  BLI_bvhtree_free(tree);
+  BLI_bvhtree_free(tree_wide);
+}
+
+TEST(kdopbvh, WideNaN)
+{
+  /* Bounds with NaN are culled the same way by both trees. */
+  BVHTree *tree = wide_test_boxes_tree(100, 0, 50);
+  BVHTree *tree_wide = wide_test_boxes_tree(100, BVH_BALANCE_WIDE, 50);
+  const float rays[][2][3] = {
+      {{50.5f, 0.5f, -1.0f}, {0.0f, 0.0f, 1.0f}},
+      {{50.5f, -1.0f, 0.5f}, {0.0f, 1.0f, 0.0f}},
+      {{-1.0f, 0.5f, 0.5f}, {1.0f, 0.0f, 0.0f}},
+  };
+  for (const auto &ray : rays) {
+    EXPECT_EQ(wide_test_ray_cast_leafs(tree_wide, ray[0], ray[1]),
+              wide_test_ray_cast_leafs(tree, ray[0], ray[1]));
+  }
+  BLI_bvhtree_free(tree);
+  BLI_bvhtree_free(tree_wide);
+}
+
+TEST(kdopbvh, Batch)
+{
+  const WideTestTris data = wide_test_tris(2000, 8);
+  BVHTree *tree = wide_test_tree(data, BVH_BALANCE_WIDE);
+
+  const blender::Array<BVHTreeRay> rays = wide_test_rays(1000, 0.0f);
+  blender::Array<BVHTreeRayHit> hits(rays.size());
+  for (BVHTreeRayHit &hit : hits) {
+    hit.index = -1;
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+  }
+  blender::BLI_bvhtree_ray_cast_batch(
+      *tree, rays, hits, wide_test_ray_cast_cb, (void *)&data, BVH_RAYCAST_DEFAULT);
+
+  blender::Array<blender::float3> positions(rays.size());
+  for (const int i : rays.index_range()) {
+    positions[i] = rays[i].origin;
+  }
+  blender::Array<BVHTreeNearest> nearest(rays.size());
+  for (BVHTreeNearest &item : nearest) {
+    item.index = -1;
+    item.dist_sq = FLT_MAX;
+  }
+  blender::BLI_bvhtree_find_nearest_batch(
+      *tree, positions, nearest, wide_test_nearest_cb, (void *)&data, 0);
+
+  for (const int i : rays.index_range()) {
+    BVHTreeRayHit hit = {};
+    hit.index = -1;
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree,
+                         rays[i].origin,
+                         rays[i].direction,
+                         0.0f,
+                         &hit,
+                         wide_test_ray_cast_cb,
+                         (void *)&data);
+    EXPECT_EQ(hits[i].index, hit.index);
+    EXPECT_EQ(hits[i].dist, hit.dist);
+
+    const int nearest_index = BLI_bvhtree_find_nearest(
+        tree, positions[i], nullptr, wide_test_nearest_cb, (void *)&data);
+    EXPECT_EQ(nearest[i].index, nearest_index);
+  }
+  BLI_bvhtree_free(tree);
+}
+
+TEST(kdopbvh, WideEmpty)
+{
+  BVHTree *tree = BLI_bvhtree_new(0, 0.0, 2, 6);
+  BLI_bvhtree_balance_ex(tree, BVH_BALANCE_WIDE);
+  const float co[3] = {0.0f, 0.0f, 0.0f};
+  const float dir[3] = {0.0f, 0.0f, 1.0f};
+  EXPECT_EQ(BLI_bvhtree_ray_cast(tree, co, dir, 0.0f, nullptr, nullptr, nullptr), -1);
+  BLI_bvhtree_free(tree);
+}
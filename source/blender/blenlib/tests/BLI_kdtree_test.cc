@@ -4,8 +4,13 @@
 
 #include "testing/testing.h"
 
+#include "BLI_array.hh"
 #include "BLI_kdtree.h"
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
 
+#include <array>
+#include <atomic>
 #include <cmath>
 
 /* -------------------------------------------------------------------- */
@@ -63,3 +68,134 @@ TEST(kdtree, Deduplicate)
 {
   deduplicate_test();
 }
+
+/* Points on a jittered grid, so there are both isolated points and points close to each other. */
+static blender::Vector<std::array<float, 3>> random_points(const int points_num)
+{
+  blender::RandomNumberGenerator rng(0);
+  blender::Vector<std::array<float, 3>> points;
+  for (int i = 0; i < points_num; i++) {
+    const float x = float(i % 40) * 0.25f;
+    const float y = float((i / 40) % 40) * 0.25f;
+    const float z = float(i / 1600);
+    points.append({x + rng.get_float() * 0.2f, y + rng.get_float() * 0.2f, z});
+  }
+  return points;
+}
+
+static KDTree_3d *build_tree(const blender::Span<std::array<float, 3>> points)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(uint(points.size()));
+  for (const int i : points.index_range()) {
+    BLI_kdtree_3d_insert(tree, i, points[i].data());
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+static float len_squared(const std::array<float, 3> &a, const std::array<float, 3> &b)
+{
+  return (a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) +
+         (a[2] - b[2]) * (a[2] - b[2]);
+}
+
+TEST(kdtree, FindNearestBatch)
+{
+  const blender::Vector<std::array<float, 3>> points = random_points(20000);
+  KDTree_3d *tree = build_tree(points);
+
+  blender::Vector<std::array<float, 3>> queries;
+  blender::RandomNumberGenerator rng(1);
+  for (int i = 0; i < 500; i++) {
+    queries.append({rng.get_float() * 10.0f, rng.get_float() * 10.0f, rng.get_float() * 13.0f});
+  }
+  const float(*co)[3] = reinterpret_cast<const float(*)[3]>(queries.data());
+
+  blender::Array<KDTreeNearest_3d> nearest(queries.size());
+  BLI_kdtree_3d_find_nearest_batch(tree, co, uint(queries.size()), nearest.data());
+
+  const uint n = 4;
+  blender::Array<KDTreeNearest_3d> nearest_n(queries.size() * n);
+  blender::Array<int> nearest_n_len(queries.size());
+  BLI_kdtree_3d_find_nearest_n_batch(
+      tree, co, uint(queries.size()), nearest_n.data(), n, nearest_n_len.data());
+
+  for (const int i : queries.index_range()) {
+    /* The tree has been balanced in parallel, compare with a brute force search. */
+    int expected = 0;
+    for (const int j : points.index_range()) {
+      if (len_squared(points[j], queries[i]) < len_squared(points[expected], queries[i])) {
+        expected = j;
+      }
+    }
+    EXPECT_EQ(nearest[i].index, expected);
+    EXPECT_EQ(nearest_n_len[i], n);
+    EXPECT_EQ(nearest_n[i * n].index, expected);
+  }
+
+  std::atomic<int> found_num = 0;
+  BLI_kdtree_3d_range_search_batch_cb_cpp(
+      tree,
+      co,
+      uint(queries.size()),
+      0.5f,
+      [&](const uint co_index, const int index, const float * /*co*/, const float dist_sq) {
+        EXPECT_LE(dist_sq, 0.25f);
+        EXPECT_NEAR(len_squared(points[index], queries[co_index]), dist_sq, 1e-5f);
+        found_num++;
+        return true;
+      });
+  int expected_found_num = 0;
+  for (const std::array<float, 3> &query : queries) {
+    for (const std::array<float, 3> &point : points) {
+      expected_found_num += len_squared(point, query) <= 0.25f;
+    }
+  }
+  EXPECT_EQ(found_num, expected_found_num);
+
+  BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, CalcDuplicatesFastParallel)
+{
+  const float range = 0.15f;
+  for (const bool use_index_order : {false, true}) {
+    const blender::Vector<std::array<float, 3>> points = random_points(10000);
+    KDTree_3d *tree = build_tree(points);
+    blender::Array<int> duplicates(points.size(), -1);
+    const int found = BLI_kdtree_3d_calc_duplicates_fast(
+        tree, range, use_index_order, duplicates.data());
+    BLI_kdtree_3d_free(tree);
+
+    /* Every point is either kept or merged into a kept point in range. */
+    int merged_num = 0;
+    for (const int i : points.index_range()) {
+      if (ELEM(duplicates[i], -1, i)) {
+        continue;
+      }
+      merged_num++;
+      EXPECT_TRUE(ELEM(duplicates[duplicates[i]], -1, duplicates[i]));
+      EXPECT_LE(len_squared(points[i], points[duplicates[i]]), range * range);
+    }
+    EXPECT_EQ(found, merged_num);
+    EXPECT_GT(found, 0);
+
+    if (use_index_order) {
+      /* The result doesn't depend on the threads, compare with a single threaded greedy merge. */
+      blender::Array<int> expected(points.size(), -1);
+      for (const int i : points.index_range()) {
+        if (!ELEM(expected[i], -1, i)) {
+          continue;
+        }
+        for (const int j : points.index_range()) {
+          if (j != i && expected[j] == -1 && len_squared(points[i], points[j]) <= range * range)
+          {
+            expected[j] = i;
+            expected[i] = i;
+          }
+        }
+      }
+      EXPECT_EQ_SPAN<int>(expected, duplicates);
+    }
+  }
+}
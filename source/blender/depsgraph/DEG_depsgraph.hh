@@ -234,6 +234,12 @@ bool DEG_is_active(const Depsgraph *depsgraph);
 void DEG_make_active(Depsgraph *depsgraph);
 void DEG_make_inactive(Depsgraph *depsgraph);
 
+/**
+ * Reuse the meshes of active viewport dependency graphs which are fully evaluated at the current
+ * frame, instead of evaluating their modifiers again. Call right before evaluating the graph.
+ */
+void DEG_reuse_viewport_meshes(Depsgraph *depsgraph);
+
 /* Returns the number of times the graph has been evaluated. */
 uint64_t DEG_get_update_count(const Depsgraph *depsgraph);
 
@@ -71,6 +71,15 @@ void DEG_graph_relations_update(Depsgraph *graph);
 /** Tag all relations in the database for update. */
 void DEG_relations_tag_update(Main *bmain);
 
+/**
+ * Tag relations of the given ID for update, in all dependency graphs.
+ *
+ * Unlike #DEG_relations_tag_update, allows the graphs to only rebuild the part which depends on
+ * this ID. Use it when a change only affects dependencies of the ID itself, such as adding or
+ * removing modifiers and constraints of an object.
+ */
+void DEG_id_tag_relations_update(Main *bmain, ID *id);
+
 /* Add Dependencies  ----------------------------- */
 
 /**
@@ -53,6 +53,25 @@ void DEG_debug_stats_gnuplot(const Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/* ************************************************ */
+/* Evaluation Timeline */
+
+/**
+ * Start writing the evaluation timeline of all dependency graphs to the given file, in the
+ * Chrome trace event format. Only evaluations done while #G_DEBUG_DEPSGRAPH_TRACE is enabled are
+ * recorded. The timeline of a graph is written when the graph is freed, the file is finished by
+ * #DEG_free_node_types.
+ *
+ * \return False when the file could not be opened.
+ */
+bool DEG_debug_eval_trace_file_set(const char *filepath);
+
+/**
+ * Write the evaluations of the graph recorded since the last write to the given file, in the
+ * Chrome trace event format.
+ */
+bool DEG_debug_eval_trace_write(Depsgraph *depsgraph, const char *filepath);
+
 /* ************************************************ */
 
 /** Compare two dependency graphs. */
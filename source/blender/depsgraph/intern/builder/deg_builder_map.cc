@@ -14,6 +14,9 @@ namespace blender::deg {
 
 bool BuilderMap::check_is_built(ID *id, int tag) const
 {
+  if (check_callback) {
+    check_callback(id);
+  }
   return (this->get_ID_tag(id) & tag) == tag;
 }
 
@@ -24,6 +27,9 @@ void BuilderMap::tag_built(ID *id, int tag)
 
 bool BuilderMap::check_is_built_and_tag(ID *id, int tag)
 {
+  if (check_callback) {
+    check_callback(id);
+  }
   int &id_tag = id_tags_.lookup_or_add(id, 0);
   const bool result = (id_tag & tag) == tag;
   id_tag |= tag;
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "BLI_map.hh"
 
 struct ID;
@@ -61,6 +63,10 @@ class BuilderMap {
     return this->check_is_built_and_tag(&datablock->id, tag);
   }
 
+  /* Called for every ID which is checked, allowing the builder to record which IDs it traverses
+   * into, regardless of whether they are already built. */
+  std::function<void(const ID *id)> check_callback;
+
  protected:
   int get_ID_tag(ID *id) const;
 
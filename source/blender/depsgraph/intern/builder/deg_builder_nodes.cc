@@ -167,9 +167,13 @@ IDNode *DepsgraphNodeBuilder::add_id_node(ID *id)
     id_info->id_cow = nullptr;
   }
   id_node = graph_->add_id_node(id, id_cow);
-  id_node->previously_visible_components_mask = previously_visible_components_mask;
-  id_node->previous_eval_flags = previous_eval_flags;
-  id_node->previous_customdata_masks = previous_customdata_masks;
+  if (id_info != nullptr) {
+    /* Nodes without the previous state are either newly created, or are kept from the previous
+     * state of the graph by the partial build. In both cases they already have proper values. */
+    id_node->previously_visible_components_mask = previously_visible_components_mask;
+    id_node->previous_eval_flags = previous_eval_flags;
+    id_node->previous_customdata_masks = previous_customdata_masks;
+  }
 
   /* NOTE: Zero number of components indicates that ID node was just created. */
   const bool is_newly_created = id_node->components.is_empty();
@@ -563,6 +567,113 @@ void DepsgraphNodeBuilder::end_build()
   update_invalid_cow_pointers();
 }
 
+void DepsgraphNodeBuilder::begin_partial_build(Span<IDNode *> id_nodes)
+{
+  Set<IDNode *> removed_id_nodes;
+  for (IDNode *id_node : id_nodes) {
+    BLI_assert(id_node->id_type == ID_OB);
+    IDInfo id_info{};
+    if (id_node->id_orig != id_node->id_cow) {
+      if (deg_eval_copy_is_expanded(id_node->id_cow)) {
+        id_info.id_cow = id_node->id_cow;
+      }
+      else {
+        MEM_SAFE_FREE(id_node->id_cow);
+      }
+    }
+    id_info.previously_visible_components_mask = id_node->visible_components_mask;
+    id_info.previous_eval_flags = id_node->eval_flags;
+    id_info.previous_customdata_masks = id_node->customdata_masks;
+    id_info_hash_.add_new(id_node->id_orig_session_uid, std::move(id_info));
+    id_node->id_cow = nullptr;
+
+    for (ComponentNode *comp_node : id_node->components.values()) {
+      for (OperationNode *op_node : comp_node->operations) {
+        if (graph_->entry_tags.contains(op_node)) {
+          saved_entry_tags_.append_as(op_node);
+        }
+        if (op_node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
+          needs_update_operations_.append_as(op_node);
+        }
+        if (op_node->is_noop()) {
+          partial_noop_operations_.append_as(op_node);
+        }
+      }
+    }
+
+    partial_objects_.append({reinterpret_cast<Object *>(id_node->id_orig),
+                             id_node->linked_state,
+                             id_node->is_visible_on_build,
+                             id_node->has_base});
+    removed_id_nodes.add_new(id_node);
+  }
+
+  graph_->remove_id_nodes(removed_id_nodes);
+
+  /* Kept nodes are considered built, and are opened for the operations which builders of the
+   * rebuilt objects might add to them. */
+  for (IDNode *id_node : graph_->id_nodes) {
+    built_map_.tag_built(id_node->id_orig,
+                         BuilderMap::TAG_COMPLETE | BuilderMap::TAG_COLLECTION_CHILDREN_HIERARCHY);
+    id_node->reopen_build();
+    id_node->previously_visible_components_mask = id_node->visible_components_mask;
+    id_node->previous_eval_flags = id_node->eval_flags;
+    id_node->previous_customdata_masks = id_node->customdata_masks;
+  }
+}
+
+void DepsgraphNodeBuilder::build_partial_objects(Scene *scene, ViewLayer *view_layer)
+{
+  scene_ = scene;
+  view_layer_ = view_layer;
+  view_layer_index_ = 0;
+
+  /* Base index of the object, matching the indexing used by #build_view_layer(). */
+  Map<const Object *, int> base_index_map;
+  int base_index = 0;
+  BKE_view_layer_synced_ensure(scene, view_layer);
+  LISTBASE_FOREACH (Base *, base, BKE_view_layer_object_bases_get(view_layer)) {
+    if (need_pull_base_into_graph(base)) {
+      base_index_map.add(base->object, base_index++);
+    }
+  }
+
+  for (const PartialObject &partial_object : partial_objects_) {
+    Object *object = partial_object.object;
+    const int object_base_index = partial_object.has_base ?
+                                      base_index_map.lookup_default(object, -1) :
+                                      -1;
+    build_object(object_base_index,
+                 object,
+                 partial_object.linked_state,
+                 partial_object.is_visible_on_build);
+    if (object_base_index != -1 && !graph_->has_animated_visibility) {
+      graph_->has_animated_visibility |= is_object_visibility_animated(object);
+    }
+  }
+}
+
+void DepsgraphNodeBuilder::end_partial_build()
+{
+  for (const PersistentOperationKey &key : partial_noop_operations_) {
+    if (find_id_node(key.id) == nullptr) {
+      continue;
+    }
+    ensure_operation_node(const_cast<ID *>(key.id),
+                          key.component_type,
+                          key.component_name,
+                          key.opcode,
+                          nullptr,
+                          key.name,
+                          key.name_tag);
+  }
+  tag_previously_tagged_nodes();
+  /* Evaluated copies of the kept IDs might be pointing to the original of an ID which is now added
+   * to the graph, and the nodes of the rebuilt objects were removed and created again. Check all
+   * of them, the same way as for a full build. */
+  update_invalid_cow_pointers();
+}
+
 void DepsgraphNodeBuilder::build_id(ID *id, const bool force_be_visible)
 {
   if (id == nullptr) {
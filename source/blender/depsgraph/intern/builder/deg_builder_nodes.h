@@ -91,6 +91,13 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   virtual void begin_build();
   virtual void end_build();
 
+  /* Partial rebuild of the given object nodes, the rest of the graph is kept as-is.
+   * The nodes are removed from the graph and are built again by #build_partial_objects(), their
+   * evaluated copies, update tags and view layer state are transferred to the new nodes. */
+  virtual void begin_partial_build(Span<IDNode *> id_nodes);
+  virtual void build_partial_objects(Scene *scene, ViewLayer *view_layer);
+  virtual void end_partial_build();
+
   /**
    * `id_cow_self` is the user of `id_pointer`,
    * see also `LibraryIDLinkCallbackData` struct definition.
@@ -206,6 +213,7 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   virtual void build_light_linking_collection(Collection *collection);
 
   virtual void build_pose_constraints(Object *object, bPoseChannel *pchan, int pchan_index);
+  virtual void build_pose_idproperties(Object *object, bPoseChannel *pchan);
   virtual void build_rigidbody(Scene *scene);
   virtual void build_particle_systems(Object *object, bool is_object_visible);
   virtual void build_particle_settings(ParticleSettings *part);
@@ -308,6 +316,20 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   Vector<PersistentOperationKey> saved_entry_tags_;
   Vector<PersistentOperationKey> needs_update_operations_;
 
+  /* State of the objects which are rebuilt by the partial build, as it was accumulated by the
+   * builders of the whole graph. */
+  struct PartialObject {
+    Object *object;
+    eDepsNode_LinkedState_Type linked_state;
+    bool is_visible_on_build;
+    bool has_base;
+  };
+  Vector<PartialObject> partial_objects_;
+  /* No-op operations of the rebuilt objects. Some of them are added by builders of other IDs
+   * (for example, ID properties used as driver variables), which are not run again by the partial
+   * build. */
+  Vector<PersistentOperationKey> partial_noop_operations_;
+
   struct BuilderWalkUserData {
     DepsgraphNodeBuilder *builder;
   };
@@ -11,6 +11,7 @@
 #include "intern/builder/deg_builder_nodes.h"
 
 #include <cstdlib>
+#include <memory>
 
 #include "DNA_armature_types.h"
 #include "DNA_constraint_types.h"
@@ -56,6 +57,23 @@ void DepsgraphNodeBuilder::build_pose_constraints(Object *object,
                      });
 }
 
+void DepsgraphNodeBuilder::build_pose_idproperties(Object *object, bPoseChannel *pchan)
+{
+  bool add_idprops_operation = false;
+  if (pchan->prop != nullptr) {
+    build_idproperties(pchan->prop);
+    add_idprops_operation = true;
+  }
+  if (pchan->system_properties != nullptr) {
+    build_idproperties(pchan->system_properties);
+    add_idprops_operation = true;
+  }
+  if (add_idprops_operation) {
+    add_operation_node(
+        &object->id, NodeType::PARAMETERS, OperationCode::PARAMETERS_EVAL, nullptr, pchan->name);
+  }
+}
+
 void DepsgraphNodeBuilder::build_ik_pose(Object *object, bPoseChannel *pchan, bConstraint *con)
 {
   bKinematicConstraint *data = (bKinematicConstraint *)con->data;
@@ -197,6 +215,19 @@ void DepsgraphNodeBuilder::build_rig(Object *object)
       OperationCode::POSE_DONE,
       [object_cow](::Depsgraph *depsgraph) { BKE_pose_eval_done(depsgraph, object_cow); });
   op_node->set_as_exit();
+  /* Bones of large rigs which don't interleave with evaluation outside of the pose are all
+   * evaluated by a single operation, avoiding the overhead of scheduling thousands of them. */
+  std::shared_ptr<const bke::PoseEvalSchedule> batched_schedule = bke::PoseEvalSchedule::create(
+      *object);
+  if (batched_schedule) {
+    add_operation_node(&object->id,
+                       NodeType::EVAL_POSE,
+                       OperationCode::POSE_EVAL_BONES,
+                       [scene_cow, object_cow, batched_schedule](::Depsgraph *depsgraph) {
+                         BKE_pose_eval_bones_batched(
+                             depsgraph, scene_cow, object_cow, *batched_schedule);
+                       });
+  }
   /* Bones. */
   int pchan_index = 0;
   LISTBASE_FOREACH (bPoseChannel *, pchan, &object->pose->chanbase) {
@@ -205,6 +236,28 @@ void DepsgraphNodeBuilder::build_rig(Object *object)
         &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_LOCAL);
     op_node->set_as_entry();
 
+    if (batched_schedule) {
+      /* Only no-op entry and exit operations, so that relations of others to the bone resolve. */
+      op_node = add_operation_node(
+          &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_DONE);
+      if (check_pchan_has_bbone(object, pchan)) {
+        op_node = add_operation_node(
+            &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_SEGMENTS);
+      }
+      op_node->set_as_exit();
+      build_pose_idproperties(object, pchan);
+      /* Pull indirect dependencies via constraints. */
+      BuilderWalkUserData data;
+      data.builder = this;
+      BKE_constraints_id_loop(&pchan->constraints, constraint_walk, IDWALK_NOP, &data);
+      /* Custom shape. */
+      if (pchan->custom != nullptr) {
+        build_object(-1, pchan->custom, DEG_ID_LINKED_INDIRECTLY, false);
+      }
+      pchan_index++;
+      continue;
+    }
+
     add_operation_node(&object->id,
                        NodeType::BONE,
                        pchan->name,
@@ -239,19 +292,7 @@ void DepsgraphNodeBuilder::build_rig(Object *object)
     op_node->set_as_exit();
 
     /* Custom properties. */
-    bool add_idprops_operation = false;
-    if (pchan->prop != nullptr) {
-      build_idproperties(pchan->prop);
-      add_idprops_operation = true;
-    }
-    if (pchan->system_properties != nullptr) {
-      build_idproperties(pchan->system_properties);
-      add_idprops_operation = true;
-    }
-    if (add_idprops_operation) {
-      add_operation_node(
-          &object->id, NodeType::PARAMETERS, OperationCode::PARAMETERS_EVAL, nullptr, pchan->name);
-    }
+    build_pose_idproperties(object, pchan);
     /* Build constraints. */
     if (pchan->constraints.first != nullptr) {
       build_pose_constraints(object, pchan, pchan_index);
@@ -256,6 +256,34 @@ DepsgraphRelationBuilder::DepsgraphRelationBuilder(Main *bmain,
                                                    DepsgraphBuilderCache *cache)
     : DepsgraphBuilder(bmain, graph, cache), scene_(nullptr), rna_node_query_(graph, this)
 {
+  built_map_.check_callback = [this](const ID *id) { this->record_traversal(id); };
+}
+
+void DepsgraphRelationBuilder::record_traversal(const ID *id) const
+{
+  const ID *current_id = stack_.current_id();
+  /* The view layer builder traverses into objects of its bases, which does not depend on the
+   * content of the objects. Whatever it looks up in them is recorded by #record_lookup. */
+  if (current_id == nullptr || current_id == id) {
+    return;
+  }
+  graph_->relation_builder_inputs.lookup_or_add_default(current_id).add(id);
+}
+
+void DepsgraphRelationBuilder::record_lookup(const ID *id, const NodeType component_type) const
+{
+  const ID *current_id = stack_.current_id();
+  if (id == nullptr || current_id == id) {
+    return;
+  }
+  /* The view layer and collection hierarchy relations are linked to components which every
+   * object has, regardless of its content. They are re-attached when an object is rebuilt. */
+  if (current_id == nullptr &&
+      ELEM(component_type, NodeType::HIERARCHY, NodeType::OBJECT_FROM_LAYER))
+  {
+    return;
+  }
+  graph_->relation_builder_inputs.lookup_or_add_default(current_id).add(id);
 }
 
 TimeSourceNode *DepsgraphRelationBuilder::get_node(const TimeSourceKey & /*key*/) const
@@ -265,6 +293,7 @@ TimeSourceNode *DepsgraphRelationBuilder::get_node(const TimeSourceKey & /*key*/
 
 ComponentNode *DepsgraphRelationBuilder::get_node(const ComponentKey &key) const
 {
+  record_lookup(key.id, key.type);
   IDNode *id_node = graph_->find_id_node(key.id);
   if (!id_node) {
     fprintf(stderr,
@@ -291,11 +320,13 @@ OperationNode *DepsgraphRelationBuilder::get_node(const OperationKey &key) const
 
 Node *DepsgraphRelationBuilder::get_node(const RNAPathKey &key)
 {
+  record_lookup(key.ptr.owner_id, NodeType::UNDEFINED);
   return rna_node_query_.find_node(&key.ptr, key.prop, key.source);
 }
 
 ComponentNode *DepsgraphRelationBuilder::find_node(const ComponentKey &key) const
 {
+  record_lookup(key.id, key.type);
   IDNode *id_node = graph_->find_id_node(key.id);
   if (!id_node) {
     return nullptr;
@@ -305,6 +336,7 @@ ComponentNode *DepsgraphRelationBuilder::find_node(const ComponentKey &key) cons
 
 OperationNode *DepsgraphRelationBuilder::find_node(const OperationKey &key) const
 {
+  record_lookup(key.id, key.component_type);
   IDNode *id_node = graph_->find_id_node(key.id);
   if (!id_node) {
     return nullptr;
@@ -342,6 +374,7 @@ void DepsgraphRelationBuilder::add_customdata_mask(Object *object,
 {
   if (customdata_masks != DEGCustomDataMeshMasks() && object != nullptr && object->type == OB_MESH)
   {
+    record_lookup(&object->id, NodeType::GEOMETRY);
     IDNode *id_node = graph_->find_id_node(&object->id);
 
     if (id_node == nullptr) {
@@ -355,6 +388,7 @@ void DepsgraphRelationBuilder::add_customdata_mask(Object *object,
 
 void DepsgraphRelationBuilder::add_special_eval_flag(ID *id, uint32_t flag)
 {
+  record_lookup(id, NodeType::UNDEFINED);
   IDNode *id_node = graph_->find_id_node(id);
   if (id_node == nullptr) {
     BLI_assert_msg(0, "ID should always be valid");
@@ -370,7 +404,7 @@ Relation *DepsgraphRelationBuilder::add_time_relation(TimeSourceNode *timesrc,
                                                       int flags)
 {
   if (timesrc && node_to) {
-    return graph_->add_new_relation(timesrc, node_to, description, flags);
+    return graph_->add_new_relation(timesrc, node_to, description, flags, stack_.current_id());
   }
 
   DEG_DEBUG_PRINTF((::Depsgraph *)graph_,
@@ -398,7 +432,8 @@ Relation *DepsgraphRelationBuilder::add_operation_relation(OperationNode *node_f
                                                            int flags)
 {
   if (node_from && node_to) {
-    return graph_->add_new_relation(node_from, node_to, description, flags);
+    return graph_->add_new_relation(
+        node_from, node_to, description, flags, stack_.current_id());
   }
 
   DEG_DEBUG_PRINTF((::Depsgraph *)graph_,
@@ -512,6 +547,19 @@ Depsgraph *DepsgraphRelationBuilder::getGraph()
 
 void DepsgraphRelationBuilder::begin_build() {}
 
+void DepsgraphRelationBuilder::begin_partial_build(Scene *scene,
+                                                   const Set<const ID *> &rebuild_ids)
+{
+  scene_ = scene;
+  for (IDNode *id_node : graph_->id_nodes) {
+    if (!rebuild_ids.contains(id_node->id_orig)) {
+      built_map_.tag_built(id_node->id_orig,
+                           BuilderMap::TAG_COMPLETE |
+                               BuilderMap::TAG_COLLECTION_CHILDREN_HIERARCHY);
+    }
+  }
+}
+
 void DepsgraphRelationBuilder::build_id(ID *id)
 {
   if (id == nullptr) {
@@ -671,12 +719,12 @@ void DepsgraphRelationBuilder::build_collection(LayerCollection *from_layer_coll
     return;
   }
 
+  const BuilderStack::ScopedEntry stack_entry = stack_.trace(collection->id);
+
   build_idproperties(collection->id.properties);
   build_idproperties(collection->id.system_properties);
   build_parameters(&collection->id);
 
-  const BuilderStack::ScopedEntry stack_entry = stack_.trace(collection->id);
-
   const OperationKey collection_geometry_key{
       &collection->id, NodeType::GEOMETRY, OperationCode::GEOMETRY_EVAL_DONE};
 
@@ -1649,6 +1697,7 @@ void DepsgraphRelationBuilder::build_animdata_fcurve_target(
   if (!RNA_path_resolve_full(&id_ptr, fcu->rna_path, &ptr, &prop, &index)) {
     return;
   }
+  record_lookup(ptr.owner_id, NodeType::UNDEFINED);
   Node *node_to = rna_node_query_.find_node(&ptr, prop, RNAPointerSource::ENTRY);
   if (node_to == nullptr) {
     return;
@@ -1662,8 +1711,11 @@ void DepsgraphRelationBuilder::build_animdata_fcurve_target(
     add_relation(adt_key, pose_init_key, "Animation -> Prop", RELATION_CHECK_BEFORE_ADD);
     return;
   }
-  graph_->add_new_relation(
-      operation_from, operation_to, "Animation -> Prop", RELATION_CHECK_BEFORE_ADD);
+  graph_->add_new_relation(operation_from,
+                           operation_to,
+                           "Animation -> Prop",
+                           RELATION_CHECK_BEFORE_ADD,
+                           stack_.current_id());
   /* It is possible that animation is writing to a nested ID data-block,
    * need to make sure animation is evaluated after target ID is copied. */
   const IDNode *id_node_from = operation_from->owner->owner;
@@ -3554,6 +3606,8 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
     return;
   }
 
+  const BuilderStack::ScopedEntry stack_entry = stack_.trace(*id_orig);
+
   OperationKey copy_on_write_key(id_orig, NodeType::COPY_ON_EVAL, OperationCode::COPY_ON_EVAL);
   /* XXX: This is a quick hack to make Alt-A to work. */
   // add_relation(time_source_key, copy_on_write_key, "Fluxgate capacitor hack");
@@ -3608,7 +3662,8 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
      * copy of ID. */
     OperationNode *op_entry = comp_node->get_entry_operation();
     if (op_entry != nullptr) {
-      Relation *rel = graph_->add_new_relation(op_cow, op_entry, "Copy-on-Eval Dependency");
+      Relation *rel = graph_->add_new_relation(
+          op_cow, op_entry, "Copy-on-Eval Dependency", 0, id_orig);
       rel->flag |= rel_flag;
     }
     /* All dangling operations should also be executed after copy-on-evaluation. */
@@ -3617,7 +3672,8 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
         continue;
       }
       if (op_node->inlinks.is_empty()) {
-        Relation *rel = graph_->add_new_relation(op_cow, op_node, "Copy-on-Eval Dependency");
+        Relation *rel = graph_->add_new_relation(
+            op_cow, op_node, "Copy-on-Eval Dependency", 0, id_orig);
         rel->flag |= rel_flag;
       }
       else {
@@ -3633,7 +3689,8 @@ void DepsgraphRelationBuilder::build_copy_on_write_relations(IDNode *id_node)
           }
         }
         if (!has_same_comp_dependency) {
-          Relation *rel = graph_->add_new_relation(op_cow, op_node, "Copy-on-Eval Dependency");
+          Relation *rel = graph_->add_new_relation(
+              op_cow, op_node, "Copy-on-Eval Dependency", 0, id_orig);
           rel->flag |= rel_flag;
         }
       }
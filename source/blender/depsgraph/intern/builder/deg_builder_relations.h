@@ -83,6 +83,9 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   DepsgraphRelationBuilder(Main *bmain, Depsgraph *graph, DepsgraphBuilderCache *cache);
 
   void begin_build();
+  /* Begin building relations of the given IDs only. All other IDs of the graph are considered
+   * built, their relations are kept from the previous state of the graph. */
+  void begin_partial_build(Scene *scene, const Set<const ID *> &rebuild_ids);
 
   template<typename KeyFrom, typename KeyTo>
   Relation *add_relation(const KeyFrom &key_from,
@@ -293,6 +296,11 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   bool has_node(const ComponentKey &key) const;
   bool has_node(const OperationKey &key) const;
 
+  /* Record in the graph that relations of the ID which is being built depend on the given ID,
+   * see #Depsgraph::relation_builder_inputs. */
+  void record_traversal(const ID *id) const;
+  void record_lookup(const ID *id, NodeType component_type) const;
+
   Relation *add_time_relation(TimeSourceNode *timesrc,
                               Node *node_to,
                               const char *description,
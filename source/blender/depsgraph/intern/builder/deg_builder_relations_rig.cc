@@ -365,6 +365,13 @@ void DepsgraphRelationBuilder::build_rig(Object *object)
     ComponentKey local_transform_key(&object->id, NodeType::TRANSFORM);
     add_relation(local_transform_key, pose_key, "Local Transforms");
   }
+  /* All bones evaluated by a single operation, see #DepsgraphNodeBuilder::build_rig(). */
+  OperationKey pose_eval_bones_key(
+      &object->id, NodeType::EVAL_POSE, OperationCode::POSE_EVAL_BONES);
+  const bool use_batched_bones = has_node(pose_eval_bones_key);
+  if (use_batched_bones) {
+    add_relation(pose_init_key, pose_eval_bones_key, "Pose Init -> Bones Eval");
+  }
   /* Links between operations for each bone. */
   LISTBASE_FOREACH (bPoseChannel *, pchan, &object->pose->chanbase) {
     const BuilderStack::ScopedEntry stack_entry = stack_.trace(*pchan);
@@ -381,50 +388,63 @@ void DepsgraphRelationBuilder::build_rig(Object *object)
     pchan->flag &= ~POSE_DONE;
     /* Pose init to bone local. */
     add_relation(pose_init_key, bone_local_key, "Pose Init - Bone Local", RELATION_FLAG_GODMODE);
-    /* Local to pose parenting operation. */
-    add_relation(bone_local_key, bone_pose_key, "Bone Local - Bone Pose");
-    /* Parent relation. */
-    if (pchan->parent != nullptr) {
-      OperationCode parent_key_opcode;
-      /* NOTE: this difference in handling allows us to prevent lockups
-       * while ensuring correct poses for separate chains. */
-      if (root_map.has_common_root(pchan->name, pchan->parent->name)) {
-        parent_key_opcode = OperationCode::BONE_READY;
-      }
-      else {
-        parent_key_opcode = OperationCode::BONE_DONE;
-      }
-
-      OperationKey parent_key(&object->id, NodeType::BONE, pchan->parent->name, parent_key_opcode);
-      add_relation(parent_key, bone_pose_key, "Parent Bone -> Child Bone");
-    }
-    /* Build constraints. */
-    if (pchan->constraints.first != nullptr) {
+    if (use_batched_bones) {
+      /* Dependencies between the bones are handled by the schedule of the operation. */
+      add_relation(bone_local_key, pose_eval_bones_key, "Bone Local -> Bones Eval");
+      add_relation(pose_eval_bones_key, bone_done_key, "Bones Eval -> Bone Done");
       /* Build relations for indirectly linked objects. */
       BuilderWalkUserData data;
       data.builder = this;
       BKE_constraints_id_loop(&pchan->constraints, constraint_walk, IDWALK_NOP, &data);
-      /* Constraints stack and constraint dependencies. */
-      build_constraints(&object->id, NodeType::BONE, pchan->name, &pchan->constraints, &root_map);
-      /* Pose -> constraints. */
-      OperationKey constraints_key(
-          &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_CONSTRAINTS);
-      add_relation(bone_pose_key, constraints_key, "Pose -> Constraints Stack");
-      add_relation(bone_local_key, constraints_key, "Local -> Constraints Stack");
-      /* Constraints -> ready/ */
-      /* TODO(sergey): When constraint stack is exploded, this step should
-       * occur before the first IK solver. */
-      add_relation(constraints_key, bone_ready_key, "Constraints -> Ready");
     }
     else {
-      /* Pose -> Ready */
-      add_relation(bone_pose_key, bone_ready_key, "Pose -> Ready");
+      /* Local to pose parenting operation. */
+      add_relation(bone_local_key, bone_pose_key, "Bone Local - Bone Pose");
+      /* Parent relation. */
+      if (pchan->parent != nullptr) {
+        OperationCode parent_key_opcode;
+        /* NOTE: this difference in handling allows us to prevent lockups
+         * while ensuring correct poses for separate chains. */
+        if (root_map.has_common_root(pchan->name, pchan->parent->name)) {
+          parent_key_opcode = OperationCode::BONE_READY;
+        }
+        else {
+          parent_key_opcode = OperationCode::BONE_DONE;
+        }
+
+        OperationKey parent_key(
+            &object->id, NodeType::BONE, pchan->parent->name, parent_key_opcode);
+        add_relation(parent_key, bone_pose_key, "Parent Bone -> Child Bone");
+      }
+      /* Build constraints. */
+      if (pchan->constraints.first != nullptr) {
+        /* Build relations for indirectly linked objects. */
+        BuilderWalkUserData data;
+        data.builder = this;
+        BKE_constraints_id_loop(&pchan->constraints, constraint_walk, IDWALK_NOP, &data);
+        /* Constraints stack and constraint dependencies. */
+        build_constraints(
+            &object->id, NodeType::BONE, pchan->name, &pchan->constraints, &root_map);
+        /* Pose -> constraints. */
+        OperationKey constraints_key(
+            &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_CONSTRAINTS);
+        add_relation(bone_pose_key, constraints_key, "Pose -> Constraints Stack");
+        add_relation(bone_local_key, constraints_key, "Local -> Constraints Stack");
+        /* Constraints -> ready/ */
+        /* TODO(sergey): When constraint stack is exploded, this step should
+         * occur before the first IK solver. */
+        add_relation(constraints_key, bone_ready_key, "Constraints -> Ready");
+      }
+      else {
+        /* Pose -> Ready */
+        add_relation(bone_pose_key, bone_ready_key, "Pose -> Ready");
+      }
+      /* Bone ready -> Bone done.
+       * NOTE: For bones without IK, this is all that's needed.
+       *       For IK chains however, an additional rel is created from IK
+       *       to done, with transitive reduction removing this one. */
+      add_relation(bone_ready_key, bone_done_key, "Ready -> Done");
     }
-    /* Bone ready -> Bone done.
-     * NOTE: For bones without IK, this is all that's needed.
-     *       For IK chains however, an additional rel is created from IK
-     *       to done, with transitive reduction removing this one. */
-    add_relation(bone_ready_key, bone_done_key, "Ready -> Done");
     /* B-Bone shape is the real final step after Done if present. */
     if (check_pchan_has_bbone(object, pchan)) {
       OperationKey bone_segments_key(
@@ -462,7 +482,9 @@ void DepsgraphRelationBuilder::build_rig(Object *object)
       /* Bones must be traversed before cleanup. */
       add_relation(bone_done_key, pose_cleanup_key, "Done -> Cleanup");
 
-      add_relation(bone_ready_key, pose_cleanup_key, "Ready -> Cleanup");
+      if (!use_batched_bones) {
+        add_relation(bone_ready_key, pose_cleanup_key, "Ready -> Cleanup");
+      }
     }
     /* Custom shape. */
     if (pchan->custom != nullptr) {
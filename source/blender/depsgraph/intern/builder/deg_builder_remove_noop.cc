@@ -86,10 +86,12 @@ void deg_graph_remove_unused_noops(Depsgraph *graph)
     /* TODO(Sybren): Remove the node itself. */
   }
 
-  /* Remove the relations. */
+  /* Remove the relations. They are remembered by the graph, so that a partial relations update
+   * can link them back when the no-op becomes used again. */
   for (Relation *relation : relations_to_remove) {
     relation->unlink();
   }
+  graph->unused_noop_relations.extend(relations_to_remove);
 
   DEG_DEBUG_PRINTF((::Depsgraph *)graph,
                    BUILD,
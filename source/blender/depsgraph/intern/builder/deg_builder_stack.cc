@@ -56,6 +56,17 @@ void print(std::ostream &stream, const bPoseChannel *pchan)
 
 }  // namespace
 
+const ID *BuilderStack::current_id() const
+{
+  for (int i = stack_.size() - 1; i >= 0; i--) {
+    const ID *id = stack_[i].id_;
+    if (id != nullptr && (id->flag & ID_FLAG_EMBEDDED_DATA) == 0) {
+      return id;
+    }
+  }
+  return nullptr;
+}
+
 void BuilderStack::print_backtrace(std::ostream &stream)
 {
   const std::ios_base::fmtflags old_flags(stream.flags());
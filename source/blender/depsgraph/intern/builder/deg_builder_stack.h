@@ -116,6 +116,10 @@ class BuilderStack {
 
   void print_backtrace(std::ostream &stream);
 
+  /* Innermost ID which is being built, or nullptr when the builder is not inside of any ID.
+   * Embedded IDs are built as a part of their owner, so the owner is returned for them. */
+  const ID *current_id() const;
+
   template<class... Args> ScopedEntry trace(const Args &...args)
   {
     stack_.append_as(args...);
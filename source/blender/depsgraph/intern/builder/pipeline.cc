@@ -34,6 +34,8 @@ void AbstractBuilderPipeline::build()
   }
 
   build_step_sanity_check();
+  /* Other dependency graphs must not read the evaluated data while nodes are rebuilt. */
+  deg_graph_->tag_shared_meshes_outdated();
   build_step_nodes();
   build_step_relations();
   build_step_finalize();
@@ -93,6 +95,7 @@ void AbstractBuilderPipeline::build_step_finalize()
 #endif
   /* Relations are up to date. */
   deg_graph_->need_update_relations = false;
+  deg_graph_->relations_update_ids.clear();
 }
 
 std::unique_ptr<DepsgraphNodeBuilder> AbstractBuilderPipeline::construct_node_builder()
@@ -0,0 +1,448 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "pipeline_incremental.h"
+
+#include <optional>
+
+#include "BLI_listbase.h"
+#include "BLI_time.h"
+
+#include "BKE_global.hh"
+
+#include "DNA_modifier_types.h"
+#include "DNA_object_force_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "intern/builder/deg_builder_key.h"
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+#include "intern/depsgraph.hh"
+#include "intern/depsgraph_physics.hh"
+#include "intern/depsgraph_relation.hh"
+#include "intern/node/deg_node.hh"
+#include "intern/node/deg_node_component.hh"
+#include "intern/node/deg_node_id.hh"
+#include "intern/node/deg_node_operation.hh"
+
+namespace blender::deg {
+
+namespace {
+
+/* Relation between a rebuilt ID and the kept part of the graph which is not owned by any of the
+ * IDs whose relations are rebuilt. It is removed together with the nodes of the rebuilt ID, and
+ * is added back once the ID is built again.
+ *
+ * Endpoints in the rebuilt ID are stored as keys, other endpoints are kept as nodes. */
+struct BoundaryRelation {
+  std::optional<PersistentOperationKey> from_key;
+  std::optional<PersistentOperationKey> to_key;
+  Node *from = nullptr;
+  Node *to = nullptr;
+  const char *name;
+  int flag;
+  const ID *owner;
+};
+
+IDNode *get_operation_id_node(const Node *node)
+{
+  if (node->type != NodeType::OPERATION) {
+    return nullptr;
+  }
+  return static_cast<const OperationNode *>(node)->owner->owner;
+}
+
+OperationNode *find_operation_node(const Depsgraph &graph, const OperationKey &key)
+{
+  const IDNode *id_node = graph.find_id_node(key.id);
+  if (id_node == nullptr) {
+    return nullptr;
+  }
+  const ComponentNode *comp_node = id_node->find_component(key.component_type,
+                                                           key.component_name);
+  if (comp_node == nullptr) {
+    return nullptr;
+  }
+  return comp_node->find_operation(key.opcode, key.name, key.name_tag);
+}
+
+/* Removed relations are marked as such by clearing their endpoints, until their memory is reused
+ * by new relations. */
+void kill_relation(Depsgraph &graph, Relation *relation)
+{
+  graph.free_relation(relation);
+  relation->from = nullptr;
+  relation->to = nullptr;
+}
+
+bool is_relation_alive(const Relation *relation)
+{
+  return relation->from != nullptr;
+}
+
+template<typename Fn> void foreach_operation_relation(const IDNode &id_node, Fn &&fn)
+{
+  for (const ComponentNode *comp_node : id_node.components.values()) {
+    for (OperationNode *op_node : comp_node->operations) {
+      for (Relation *relation : op_node->inlinks) {
+        fn(relation);
+      }
+      for (Relation *relation : op_node->outlinks) {
+        fn(relation);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+IncrementalBuilderPipeline::IncrementalBuilderPipeline(::Depsgraph *graph)
+    : ViewLayerBuilderPipeline(graph)
+{
+}
+
+bool IncrementalBuilderPipeline::can_rebuild_in_isolation(const IDNode &id_node) const
+{
+  /* Only objects are handled: they are the IDs whose dependencies are typically edited (modifiers
+   * and constraints), and their nodes do not affect view layer and collection level nodes. */
+  if (id_node.id_type != ID_OB) {
+    return false;
+  }
+  /* Objects from the set scenes are built with the state of a different view layer. */
+  if (id_node.linked_state == DEG_ID_LINKED_VIA_SET) {
+    return false;
+  }
+  const Object *object = reinterpret_cast<const Object *>(id_node.id_orig);
+  /* Rigid body world, light linking and particle systems are built on a scene level, or are
+   * cached for the whole graph. */
+  if (object->rigidbody_object != nullptr || object->rigidbody_constraint != nullptr) {
+    return false;
+  }
+  if (object->light_linking != nullptr) {
+    return false;
+  }
+  if (!BLI_listbase_is_empty(&object->particlesystem)) {
+    return false;
+  }
+  /* Effector and collision relations are cached for the whole graph, they need to be rebuilt
+   * both when the object becomes a part of them and when it stops to be. */
+  if (object->pd != nullptr && object->pd->forcefield != 0) {
+    return false;
+  }
+  LISTBASE_FOREACH (const ModifierData *, md, &object->modifiers) {
+    if (ELEM(md->type, eModifierType_Collision, eModifierType_Fluid, eModifierType_DynamicPaint))
+    {
+      return false;
+    }
+  }
+  if (physics_relations_contain_object(deg_graph_, object)) {
+    return false;
+  }
+  return true;
+}
+
+bool IncrementalBuilderPipeline::build_partial()
+{
+  if (deg_graph_->relations_update_ids.is_empty()) {
+    return false;
+  }
+  /* Objects of the set scene are linked to its view layer, which is not built again. */
+  if (scene_->set != nullptr) {
+    return false;
+  }
+
+  double start_time = 0.0;
+  if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+    start_time = BLI_time_now_seconds();
+  }
+
+  /* Tagged IDs which are in the graph. IDs which are not in the graph are not pulled into it by
+   * their own relations, so they are ignored. */
+  Vector<IDNode *> rebuild_id_nodes;
+  Set<const IDNode *> rebuild_id_nodes_set;
+  for (const ID *id : deg_graph_->relations_update_ids) {
+    IDNode *id_node = deg_graph_->find_id_node(id);
+    if (id_node == nullptr) {
+      continue;
+    }
+    if (!can_rebuild_in_isolation(*id_node)) {
+      return false;
+    }
+    rebuild_id_nodes.append(id_node);
+    rebuild_id_nodes_set.add(id_node);
+  }
+  if (rebuild_id_nodes.is_empty()) {
+    deg_graph_->need_update_relations = false;
+    deg_graph_->relations_update_ids.clear();
+    return true;
+  }
+
+  const auto is_rebuilt_node = [&](const Node *node) {
+    const IDNode *id_node = get_operation_id_node(node);
+    return id_node != nullptr && rebuild_id_nodes_set.contains(id_node);
+  };
+
+  /* IDs whose relations are to be rebuilt. Besides the tagged objects these are all IDs whose
+   * builders traversed into the objects or looked up their nodes, as the relations they add might
+   * depend on the content of the objects. */
+  Set<const ID *> rebuild_ids;
+  for (const IDNode *id_node : rebuild_id_nodes) {
+    rebuild_ids.add(id_node->id_orig);
+  }
+  for (const auto item : deg_graph_->relation_builder_inputs.items()) {
+    for (const IDNode *id_node : rebuild_id_nodes) {
+      if (!item.value.contains(id_node->id_orig)) {
+        continue;
+      }
+      if (item.key == nullptr) {
+        /* The builder is not a part of any ID, it is not run again by the partial update. */
+        return false;
+      }
+      rebuild_ids.add(item.key);
+      break;
+    }
+  }
+  /* Owners of relations of the tagged objects are expected to be found above already, unless a
+   * builder links to an operation without looking it up. */
+  for (const IDNode *id_node : rebuild_id_nodes) {
+    foreach_operation_relation(*id_node, [&](const Relation *relation) {
+      if (relation->owner != nullptr) {
+        rebuild_ids.add(relation->owner);
+      }
+    });
+  }
+  for (const Relation *relation : deg_graph_->unused_noop_relations) {
+    if (relation->owner != nullptr &&
+        (is_rebuilt_node(relation->from) || is_rebuilt_node(relation->to)))
+    {
+      rebuild_ids.add(relation->owner);
+    }
+  }
+  /* Relations owned by the rebuilt IDs are removed, so all builders which requested them need to
+   * add them again. */
+  Vector<const ID *> shared_queue;
+  shared_queue.extend(rebuild_ids.begin(), rebuild_ids.end());
+  while (!shared_queue.is_empty()) {
+    const ID *id = shared_queue.pop_last();
+    const Set<const ID *> *users = deg_graph_->shared_relation_users.lookup_ptr(id);
+    if (users == nullptr) {
+      continue;
+    }
+    for (const ID *user : *users) {
+      if (user == nullptr) {
+        return false;
+      }
+      if (rebuild_ids.add(user)) {
+        shared_queue.append(user);
+      }
+    }
+  }
+  for (const ID *id : rebuild_ids) {
+    const IDNode *id_node = deg_graph_->find_id_node(id);
+    /* Scene relations are built by the view layer builder, which is not run here. */
+    if (id_node == nullptr || id_node->id_type == ID_SCE) {
+      return false;
+    }
+  }
+
+  /* From now on the graph is modified. */
+  deg_graph_->tag_shared_meshes_outdated();
+
+  /* Relations between the rebuilt objects and the kept part of the graph which are added outside
+   * of any ID builder. Their endpoints in the rebuilt objects always exist, see
+   * #DepsgraphRelationBuilder::record_lookup(). */
+  Vector<BoundaryRelation> boundary_relations;
+  const auto add_boundary_relation = [&](const Relation *relation) {
+    boundary_relations.append_as();
+    BoundaryRelation &boundary = boundary_relations.last();
+    if (is_rebuilt_node(relation->from)) {
+      boundary.from_key.emplace(static_cast<const OperationNode *>(relation->from));
+    }
+    else {
+      boundary.from = relation->from;
+    }
+    if (is_rebuilt_node(relation->to)) {
+      boundary.to_key.emplace(static_cast<const OperationNode *>(relation->to));
+    }
+    else {
+      boundary.to = relation->to;
+    }
+    boundary.name = relation->name;
+    /* Cycles are detected again for the new graph. */
+    boundary.flag = relation->flag & ~RELATION_FLAG_CYCLIC;
+    boundary.owner = relation->owner;
+  };
+  const auto is_rebuilt_relation = [&](const Relation *relation) {
+    return relation->owner != nullptr && rebuild_ids.contains(relation->owner);
+  };
+
+  /* Relations which were removed by the no-op pass are not linked to the nodes, so handle them
+   * first: this way all other relations which are still alive are known to be linked. */
+  deg_graph_->unused_noop_relations.remove_if([&](Relation *relation) {
+    const bool is_rebuilt_owner = is_rebuilt_relation(relation);
+    const bool is_rebuilt_endpoint = is_rebuilt_node(relation->from) ||
+                                     is_rebuilt_node(relation->to);
+    if (!is_rebuilt_owner && !is_rebuilt_endpoint) {
+      return false;
+    }
+    if (!is_rebuilt_owner) {
+      add_boundary_relation(relation);
+    }
+    relation->from = nullptr;
+    relation->to = nullptr;
+    deg_graph_->free_relations.append(relation);
+    return true;
+  });
+
+  /* Remove all relations of the operations of the rebuilt nodes. */
+  for (IDNode *id_node : rebuild_id_nodes) {
+    for (const ComponentNode *comp_node : id_node->components.values()) {
+      for (OperationNode *op_node : comp_node->operations) {
+        while (!op_node->inlinks.is_empty()) {
+          Relation *relation = op_node->inlinks.last();
+          if (!is_rebuilt_relation(relation)) {
+            add_boundary_relation(relation);
+          }
+          kill_relation(*deg_graph_, relation);
+        }
+        while (!op_node->outlinks.is_empty()) {
+          Relation *relation = op_node->outlinks.last();
+          if (!is_rebuilt_relation(relation)) {
+            add_boundary_relation(relation);
+          }
+          kill_relation(*deg_graph_, relation);
+        }
+      }
+    }
+  }
+
+  /* Remove relations owned by the other IDs whose relations are rebuilt. */
+  for (const ID *id : rebuild_ids) {
+    const IDNode *id_node = deg_graph_->find_id_node(id);
+    if (rebuild_id_nodes_set.contains(id_node)) {
+      continue;
+    }
+    Vector<Relation *> owned_relations;
+    foreach_operation_relation(*id_node, [&](Relation *relation) {
+      if (relation->owner == id) {
+        owned_relations.append_non_duplicates(relation);
+      }
+    });
+    for (Relation *relation : owned_relations) {
+      kill_relation(*deg_graph_, relation);
+    }
+  }
+  for (const ID *id : rebuild_ids) {
+    Vector<Relation *> *detached_relations = deg_graph_->detached_relations.lookup_ptr(id);
+    if (detached_relations == nullptr) {
+      continue;
+    }
+    for (Relation *relation : *detached_relations) {
+      if (is_relation_alive(relation)) {
+        kill_relation(*deg_graph_, relation);
+      }
+    }
+    deg_graph_->detached_relations.remove(id);
+  }
+
+  /* The builders of the rebuilt IDs record their inputs again. The previous inputs are kept to
+   * find IDs which are not used by them anymore. */
+  Map<const ID *, Set<const ID *>> previous_inputs;
+  for (const ID *id : rebuild_ids) {
+    if (std::optional<Set<const ID *>> inputs = deg_graph_->relation_builder_inputs.pop_try(id)) {
+      previous_inputs.add_new(id, std::move(*inputs));
+    }
+    deg_graph_->shared_relation_users.remove(id);
+  }
+
+  /* Rebuild nodes of the tagged objects. */
+  std::unique_ptr<DepsgraphNodeBuilder> node_builder = construct_node_builder();
+  node_builder->begin_partial_build(rebuild_id_nodes);
+  const int64_t num_kept_id_nodes = deg_graph_->id_nodes.size();
+  node_builder->build_partial_objects(scene_, view_layer_);
+  node_builder->end_partial_build();
+  node_builder.reset();
+
+  for (BoundaryRelation &boundary : boundary_relations) {
+    Node *from = boundary.from_key ? find_operation_node(*deg_graph_, *boundary.from_key) :
+                                     boundary.from;
+    Node *to = boundary.to_key ? find_operation_node(*deg_graph_, *boundary.to_key) : boundary.to;
+    if (from == nullptr || to == nullptr) {
+      /* The operation does not exist in the new state of the object. */
+      continue;
+    }
+    deg_graph_->add_new_relation(from, to, boundary.name, boundary.flag, boundary.owner);
+  }
+
+  /* Rebuild relations of the rebuilt objects, of the IDs which depend on them, and of the IDs
+   * which were pulled into the graph by the new state of the objects. */
+  Vector<IDNode *> relations_id_nodes;
+  for (const ID *id : rebuild_ids) {
+    IDNode *id_node = deg_graph_->find_id_node(id);
+    if (id_node != nullptr) {
+      relations_id_nodes.append(id_node);
+    }
+  }
+  for (IDNode *id_node : deg_graph_->id_nodes.as_span().drop_front(num_kept_id_nodes)) {
+    if (rebuild_ids.add(id_node->id_orig)) {
+      relations_id_nodes.append(id_node);
+    }
+  }
+
+  std::unique_ptr<DepsgraphRelationBuilder> relation_builder = construct_relation_builder();
+  relation_builder->begin_partial_build(scene_, rebuild_ids);
+  for (IDNode *id_node : relations_id_nodes) {
+    relation_builder->build_id(id_node->id_orig);
+  }
+  for (IDNode *id_node : relations_id_nodes) {
+    relation_builder->build_copy_on_write_relations(id_node);
+    relation_builder->build_driver_relations(id_node);
+  }
+  relation_builder.reset();
+
+  /* An ID which is not used by a rebuilt ID anymore might not be needed in the graph at all. That
+   * is only known by building the graph from scratch, which replaces what is done here. */
+  for (const auto item : previous_inputs.items()) {
+    const Set<const ID *> *inputs = deg_graph_->relation_builder_inputs.lookup_ptr(item.key);
+    for (const ID *id : item.value) {
+      if (inputs != nullptr && inputs->contains(id)) {
+        continue;
+      }
+      const IDNode *id_node = deg_graph_->find_id_node(id);
+      if (id_node == nullptr || id_node->has_base) {
+        continue;
+      }
+      return false;
+    }
+  }
+
+  /* Link back relations to no-ops which are used again. Linking a relation makes its source used,
+   * so repeat until nothing changes. */
+  bool has_relinked_relations = true;
+  while (has_relinked_relations) {
+    has_relinked_relations = false;
+    deg_graph_->unused_noop_relations.remove_if([&](Relation *relation) {
+      if (relation->to->outlinks.is_empty()) {
+        return false;
+      }
+      relation->from->outlinks.append(relation);
+      relation->to->inlinks.append(relation);
+      has_relinked_relations = true;
+      return true;
+    });
+  }
+
+  build_step_finalize();
+
+  if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+    printf("Depsgraph relations of %d IDs updated in %f seconds.\n",
+           int(relations_id_nodes.size()),
+           BLI_time_now_seconds() - start_time);
+  }
+
+  return true;
+}
+
+}  // namespace blender::deg
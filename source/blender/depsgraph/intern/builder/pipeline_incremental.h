@@ -0,0 +1,35 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+#include "pipeline_view_layer.h"
+
+namespace blender::deg {
+
+struct IDNode;
+
+/* Builder pipeline which updates relations of the view layer graph incrementally.
+ *
+ * Only the objects tagged with #DEG_id_tag_relations_update() have their nodes rebuilt, together
+ * with relations of all IDs whose relation builders depend on them. The rest of the graph is kept
+ * as-is. When the result can not be guaranteed to match a full rebuild the regular #build() is to
+ * be used. */
+class IncrementalBuilderPipeline : public ViewLayerBuilderPipeline {
+ public:
+  IncrementalBuilderPipeline(::Depsgraph *graph);
+
+  /* Returns false when the graph is to be fully rebuilt instead. The graph might have been
+   * partially updated at that point, the full rebuild replaces it. */
+  bool build_partial();
+
+ protected:
+  bool can_rebuild_in_isolation(const IDNode &id_node) const;
+};
+
+}  // namespace blender::deg
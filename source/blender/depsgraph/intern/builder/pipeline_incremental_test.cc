@@ -0,0 +1,288 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <string>
+
+#include "BLI_listbase.h"
+#include "BLI_set.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_collection.hh"
+#include "BKE_constraint.h"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+#include "BKE_mesh.h"
+#include "BKE_modifier.hh"
+#include "BKE_object.hh"
+#include "BKE_scene.hh"
+
+#include "CLG_log.h"
+
+#include "DEG_depsgraph.hh"
+#include "DEG_depsgraph_build.hh"
+
+#include "DNA_constraint_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "intern/builder/pipeline_incremental.h"
+#include "intern/depsgraph.hh"
+#include "intern/depsgraph_relation.hh"
+#include "intern/node/deg_node.hh"
+#include "intern/node/deg_node_id.hh"
+#include "intern/node/deg_node_operation.hh"
+#include "intern/node/deg_node_time.hh"
+
+namespace blender::deg::tests {
+
+class IncrementalRelationsUpdateTest : public ::testing::Test {
+ protected:
+  Main *bmain = nullptr;
+  Scene *scene = nullptr;
+  ViewLayer *view_layer = nullptr;
+  ::Depsgraph *graph = nullptr;
+
+  static void SetUpTestSuite()
+  {
+    CLG_init();
+    BKE_idtype_init();
+    BKE_modifier_init();
+    DEG_register_node_types();
+  }
+
+  static void TearDownTestSuite()
+  {
+    DEG_free_node_types();
+    CLG_exit();
+  }
+
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    scene = BKE_scene_add(bmain, "Scene");
+    view_layer = static_cast<ViewLayer *>(scene->view_layers.first);
+  }
+
+  void TearDown() override
+  {
+    if (graph != nullptr) {
+      DEG_graph_free(graph);
+    }
+    BKE_main_free(bmain);
+  }
+
+  Object *add_mesh_object(const char *name, const bool in_scene = true)
+  {
+    Object *object = BKE_object_add_only_object(bmain, OB_MESH, name);
+    object->data = BKE_mesh_add(bmain, name);
+    if (in_scene) {
+      BKE_collection_object_add(bmain, scene->master_collection, object);
+    }
+    return object;
+  }
+
+  void build_graph()
+  {
+    graph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(graph);
+  }
+
+  /* Update relations of the graph the same way #DEG_graph_relations_update() does. Returns
+   * whether the partial update was used. */
+  bool update_relations(ID *id)
+  {
+    DEG_id_tag_relations_update(bmain, id);
+    IncrementalBuilderPipeline builder(graph);
+    if (builder.build_partial()) {
+      return true;
+    }
+    builder.build();
+    return false;
+  }
+
+  static std::string node_identifier(const Node *node)
+  {
+    if (node->type == NodeType::OPERATION) {
+      return static_cast<const OperationNode *>(node)->full_identifier();
+    }
+    return node->identifier();
+  }
+
+  /* Sorted identifiers of all relations which are linked to nodes of the graph. */
+  static Vector<std::string> relation_identifiers(const ::Depsgraph *graph)
+  {
+    const Depsgraph *deg_graph = reinterpret_cast<const Depsgraph *>(graph);
+    Vector<std::string> identifiers;
+    const auto add_node_relations = [&](const Node *node) {
+      for (const Relation *relation : node->outlinks) {
+        identifiers.append(node_identifier(relation->from) + " -> " +
+                           node_identifier(relation->to) + " (" + relation->name + ")");
+      }
+    };
+    add_node_relations(deg_graph->time_source);
+    for (const OperationNode *op_node : deg_graph->operations) {
+      add_node_relations(op_node);
+    }
+    std::sort(identifiers.begin(), identifiers.end());
+    return identifiers;
+  }
+
+  static Set<std::string> id_names(const ::Depsgraph *graph)
+  {
+    const Depsgraph *deg_graph = reinterpret_cast<const Depsgraph *>(graph);
+    Set<std::string> names;
+    for (const IDNode *id_node : deg_graph->id_nodes) {
+      names.add(id_node->id_orig->name);
+    }
+    return names;
+  }
+
+  /* Compare the graph with one built from scratch for the current state of the scene. The order
+   * in which builders run is not the same, so relations which are added by several builders might
+   * be merged differently: only compare which relations exist. */
+  void expect_graph_matches_full_build()
+  {
+    ::Depsgraph *full_graph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(full_graph);
+
+    const Vector<std::string> relations = relation_identifiers(graph);
+    const Vector<std::string> full_relations = relation_identifiers(full_graph);
+    const Set<std::string> relations_set(relations.as_span());
+    const Set<std::string> full_relations_set(full_relations.as_span());
+    for (const std::string &relation : full_relations_set) {
+      EXPECT_TRUE(relations_set.contains(relation)) << "Missing relation: " << relation;
+    }
+    for (const std::string &relation : relations_set) {
+      EXPECT_TRUE(full_relations_set.contains(relation)) << "Extra relation: " << relation;
+    }
+    EXPECT_EQ(id_names(graph), id_names(full_graph));
+
+    DEG_graph_free(full_graph);
+  }
+
+  static int64_t relations_num(const ::Depsgraph *graph)
+  {
+    return relation_identifiers(graph).size();
+  }
+};
+
+static ArrayModifierData *add_array_modifier(Object *object, Object *offset_object)
+{
+  ArrayModifierData *amd = reinterpret_cast<ArrayModifierData *>(
+      BKE_modifier_new(eModifierType_Array));
+  amd->offset_ob = offset_object;
+  amd->offset_type |= MOD_ARR_OFF_OBJ;
+  id_us_plus(&offset_object->id);
+  BLI_addtail(&object->modifiers, amd);
+  return amd;
+}
+
+static void remove_modifier(Object *object, ModifierData *md)
+{
+  BKE_modifier_remove_from_list(object, md);
+  BKE_modifier_free(md);
+}
+
+static bConstraint *add_copy_location_constraint(Object *object, Object *target)
+{
+  bConstraint *con = BKE_constraint_add_for_object(
+      object, "Copy Location", CONSTRAINT_TYPE_LOCLIKE);
+  static_cast<bLocateLikeConstraint *>(con->data)->tar = target;
+  id_us_plus(&target->id);
+  return con;
+}
+
+TEST_F(IncrementalRelationsUpdateTest, add_and_remove_modifier)
+{
+  Object *object_a = add_mesh_object("OBa");
+  Object *object_b = add_mesh_object("OBb");
+  add_mesh_object("OBc");
+  build_graph();
+
+  ArrayModifierData *amd = add_array_modifier(object_a, object_b);
+  EXPECT_TRUE(update_relations(&object_a->id));
+  expect_graph_matches_full_build();
+
+  remove_modifier(object_a, &amd->modifier);
+  EXPECT_TRUE(update_relations(&object_a->id));
+  expect_graph_matches_full_build();
+}
+
+TEST_F(IncrementalRelationsUpdateTest, dependent_objects)
+{
+  /* Relations of objects which depend on the rebuilt object are rebuilt as well. */
+  Object *object_a = add_mesh_object("OBa");
+  Object *object_b = add_mesh_object("OBb");
+  Object *object_c = add_mesh_object("OBc");
+  add_copy_location_constraint(object_b, object_a);
+  add_array_modifier(object_c, object_a);
+  build_graph();
+
+  add_copy_location_constraint(object_a, object_c);
+  EXPECT_TRUE(update_relations(&object_a->id));
+  expect_graph_matches_full_build();
+
+  add_array_modifier(object_a, object_b);
+  EXPECT_TRUE(update_relations(&object_a->id));
+  expect_graph_matches_full_build();
+}
+
+TEST_F(IncrementalRelationsUpdateTest, repeated_updates)
+{
+  /* Relations must not accumulate when the same state is rebuilt again and again. */
+  Object *object_a = add_mesh_object("OBa");
+  Object *object_b = add_mesh_object("OBb");
+  add_copy_location_constraint(object_b, object_a);
+  build_graph();
+  const int64_t initial_relations_num = relations_num(graph);
+
+  int64_t modified_relations_num = -1;
+  for (int i = 0; i < 4; i++) {
+    ArrayModifierData *amd = add_array_modifier(object_a, object_b);
+    EXPECT_TRUE(update_relations(&object_a->id));
+    expect_graph_matches_full_build();
+    if (modified_relations_num == -1) {
+      modified_relations_num = relations_num(graph);
+    }
+    EXPECT_EQ(relations_num(graph), modified_relations_num);
+
+    remove_modifier(object_a, &amd->modifier);
+    EXPECT_TRUE(update_relations(&object_a->id));
+    expect_graph_matches_full_build();
+    EXPECT_EQ(relations_num(graph), initial_relations_num);
+
+    EXPECT_TRUE(update_relations(&object_b->id));
+    expect_graph_matches_full_build();
+    EXPECT_EQ(relations_num(graph), initial_relations_num);
+  }
+}
+
+TEST_F(IncrementalRelationsUpdateTest, unused_id_falls_back_to_full_build)
+{
+  /* An object which is not in the view layer is only in the graph while it is used. */
+  Object *object_a = add_mesh_object("OBa");
+  Object *object_d = add_mesh_object("OBd", false);
+  build_graph();
+
+  ArrayModifierData *amd = add_array_modifier(object_a, object_d);
+  EXPECT_TRUE(update_relations(&object_a->id));
+  expect_graph_matches_full_build();
+  EXPECT_TRUE(id_names(graph).contains(object_d->id.name));
+
+  remove_modifier(object_a, &amd->modifier);
+  EXPECT_FALSE(update_relations(&object_a->id));
+  expect_graph_matches_full_build();
+  EXPECT_FALSE(id_names(graph).contains(object_d->id.name));
+}
+
+}  // namespace blender::deg::tests
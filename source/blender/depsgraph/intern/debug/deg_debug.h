@@ -19,6 +19,7 @@ class DepsgraphDebug {
   DepsgraphDebug();
 
   bool do_time_debug() const;
+  bool do_eval_trace() const;
 
   void begin_graph_evaluation();
   void end_graph_evaluation();
@@ -17,6 +17,7 @@
 
 #include "BKE_global.hh"
 #include "BKE_idtype.hh"
+#include "BKE_mesh_eval_share.hh"
 #include "BKE_scene.hh"
 
 #include "DEG_depsgraph.hh"
@@ -54,11 +55,14 @@ Depsgraph::Depsgraph(Main *bmain, Scene *scene, ViewLayer *view_layer, eEvaluati
       ctime(BKE_scene_ctime_get(scene)),
       scene_cow(nullptr),
       is_active(false),
+      shared_meshes_outdated(false),
+      is_mesh_share_consumer(false),
       use_visibility_optimization(true),
       is_evaluating(false),
       is_render_pipeline_depsgraph(false),
       use_editors_update(false),
       update_count(0),
+      critical_path_update_countdown(0),
       sync_writeback(DEG_EVALUATE_SYNC_WRITEBACK_NO)
 {
   BLI_spin_init(&lock);
@@ -72,6 +76,11 @@ Depsgraph::Depsgraph(Main *bmain, Scene *scene, ViewLayer *view_layer, eEvaluati
 
 Depsgraph::~Depsgraph()
 {
+  deg_eval_trace_flush_to_file(*this);
+  bke::mesh_eval_share_source_remove(reinterpret_cast<::Depsgraph *>(this));
+  if (is_mesh_share_consumer) {
+    bke::mesh_eval_share_consumer_remove();
+  }
   clear_id_nodes();
   delete time_source;
   BLI_spin_end(&lock);
@@ -96,6 +105,7 @@ TimeSourceNode *Depsgraph::find_time_source() const
 void Depsgraph::tag_time_source()
 {
   time_source->tag_update(this, DEG_UPDATE_SOURCE_TIME);
+  tag_shared_meshes_outdated();
 }
 
 IDNode *Depsgraph::find_id_node(const ID *id) const
@@ -170,7 +180,35 @@ void Depsgraph::clear_id_nodes()
   light_linking_cache.clear();
 }
 
-Relation *Depsgraph::add_new_relation(Node *from, Node *to, const char *description, int flags)
+void Depsgraph::remove_id_nodes(const Set<IDNode *> &nodes)
+{
+  if (nodes.is_empty()) {
+    return;
+  }
+  operations.remove_if([&](OperationNode *op_node) {
+    if (!nodes.contains(op_node->owner->owner)) {
+      return false;
+    }
+    entry_tags.remove(op_node);
+    return true;
+  });
+  id_nodes.remove_if([&](IDNode *id_node) { return nodes.contains(id_node); });
+  for (IDNode *id_node : nodes) {
+    id_hash.remove(id_node->id_orig);
+    delete id_node;
+  }
+}
+
+static const ID *node_id_orig(const Node *node)
+{
+  if (node->type != NodeType::OPERATION) {
+    return nullptr;
+  }
+  return static_cast<const OperationNode *>(node)->owner->owner->id_orig;
+}
+
+Relation *Depsgraph::add_new_relation(
+    Node *from, Node *to, const char *description, int flags, const ID *owner)
 {
   Relation *rel = nullptr;
   if (flags & RELATION_CHECK_BEFORE_ADD) {
@@ -178,6 +216,9 @@ Relation *Depsgraph::add_new_relation(Node *from, Node *to, const char *descript
   }
   if (rel != nullptr) {
     rel->flag |= flags;
+    if (rel->owner != nullptr && rel->owner != owner) {
+      shared_relation_users.lookup_or_add_default(rel->owner).add(owner);
+    }
     return rel;
   }
 
@@ -195,13 +236,28 @@ Relation *Depsgraph::add_new_relation(Node *from, Node *to, const char *descript
    * either the `inlinks` or `outlinks`. But since so many #Relation structs are allocated, it's
    * probably better for it be a simple type anyway. */
   static_assert(std::is_trivially_destructible_v<Relation>);
-  rel = this->build_allocator.construct<Relation>(from, to, description).release();
+  if (free_relations.is_empty()) {
+    rel = this->build_allocator.construct<Relation>(from, to, description).release();
+  }
+  else {
+    rel = new (free_relations.pop_last()) Relation(from, to, description);
+  }
   from->outlinks.append(rel);
   to->inlinks.append(rel);
   rel->flag |= flags;
+  rel->owner = owner;
+  if (owner != nullptr && !ELEM(owner, node_id_orig(from), node_id_orig(to))) {
+    detached_relations.lookup_or_add_default(owner).append(rel);
+  }
   return rel;
 }
 
+void Depsgraph::free_relation(Relation *relation)
+{
+  relation->unlink();
+  free_relations.append(relation);
+}
+
 Relation *Depsgraph::check_nodes_connected(const Node *from,
                                            const Node *to,
                                            const char *description)
@@ -232,6 +288,18 @@ void Depsgraph::add_entry_tag(OperationNode *node)
    * NOTE: this is necessary since we have several thousand nodes to play
    * with. */
   entry_tags.add(node);
+  tag_shared_meshes_outdated();
+}
+
+void Depsgraph::tag_shared_meshes_outdated()
+{
+  /* Only the first tag after an evaluation needs to be passed on, all the meshes of the graph are
+   * outdated at once. */
+  if (!is_active || shared_meshes_outdated) {
+    return;
+  }
+  shared_meshes_outdated = true;
+  bke::mesh_eval_share_source_tag_update(reinterpret_cast<::Depsgraph *>(this));
 }
 
 void Depsgraph::clear_all_nodes()
@@ -239,6 +307,11 @@ void Depsgraph::clear_all_nodes()
   clear_id_nodes();
   delete time_source;
   time_source = nullptr;
+  detached_relations.clear();
+  unused_noop_relations.clear();
+  free_relations.clear();
+  relation_builder_inputs.clear();
+  shared_relation_users.clear();
   /* Memory used by the build allocator is now unused. Rebuild it from scratch. */
   std::destroy_at(&this->build_allocator);
   new (&this->build_allocator) LinearAllocator<>();
@@ -344,6 +417,18 @@ void DEG_make_inactive(Depsgraph *depsgraph)
 {
   deg::Depsgraph *deg_graph = reinterpret_cast<deg::Depsgraph *>(depsgraph);
   deg_graph->is_active = false;
+  /* Only active dependency graphs keep their shared meshes up to date. */
+  blender::bke::mesh_eval_share_source_remove(depsgraph);
+}
+
+void DEG_reuse_viewport_meshes(Depsgraph *depsgraph)
+{
+  deg::Depsgraph *deg_graph = reinterpret_cast<deg::Depsgraph *>(depsgraph);
+  if (!deg_graph->is_mesh_share_consumer) {
+    deg_graph->is_mesh_share_consumer = true;
+    blender::bke::mesh_eval_share_consumer_add();
+  }
+  blender::bke::mesh_eval_share_collect(*deg_graph->scene);
 }
 
 void DEG_disable_visibility_optimization(Depsgraph *depsgraph)
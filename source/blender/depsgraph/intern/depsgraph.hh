@@ -16,6 +16,7 @@
 
 #include <cstdlib>
 #include <functional>
+#include <memory>
 
 #include "MEM_guardedalloc.h"
 
@@ -31,6 +32,7 @@
 
 #include "intern/debug/deg_debug.h"
 #include "intern/depsgraph_light_linking.hh"
+#include "intern/eval/deg_eval_trace.h"
 
 struct ID;
 struct Scene;
@@ -59,9 +61,17 @@ struct Depsgraph {
   IDNode *find_id_node(const ID *id) const;
   IDNode *add_id_node(ID *id, ID *id_cow_hint = nullptr);
   void clear_id_nodes();
+  /* Remove given ID nodes with all their operations from the graph. The caller is responsible
+   * for unlinking relations of the operations and for taking ownership of the evaluated copies
+   * which are to be preserved. */
+  void remove_id_nodes(const Set<IDNode *> &nodes);
 
   /** Add new relationship between two nodes. */
-  Relation *add_new_relation(Node *from, Node *to, const char *description, int flags = 0);
+  Relation *add_new_relation(
+      Node *from, Node *to, const char *description, int flags = 0, const ID *owner = nullptr);
+  /* Unlink the relation from its nodes. Its memory is reused by relations added later, so the
+   * caller must make sure it is not referenced anymore. */
+  void free_relation(Relation *relation);
 
   /* Check whether two nodes are connected by relation with given
    * description. Description might be nullptr to check ANY relation between
@@ -71,6 +81,9 @@ struct Depsgraph {
   /* Tag a specific node as needing updates. */
   void add_entry_tag(OperationNode *node);
 
+  /* Meshes this graph shares with other dependency graphs are outdated until it is evaluated. */
+  void tag_shared_meshes_outdated();
+
   /* Clear storage used by all nodes. */
   void clear_all_nodes();
 
@@ -105,6 +118,11 @@ struct Depsgraph {
   /* Indicates whether relations needs to be updated. */
   bool need_update_relations;
 
+  /* IDs which were tagged with #DEG_id_tag_relations_update since the last relations update.
+   * When it is empty while #need_update_relations is set the whole graph is to be rebuilt,
+   * otherwise only these IDs and the IDs which depend on them need their relations rebuilt. */
+  Set<const ID *> relations_update_ids;
+
   /* Indicates whether indirect effect of nodes on a directly visible ones needs to be updated. */
   bool need_update_nodes_visibility;
 
@@ -126,6 +144,30 @@ struct Depsgraph {
   /* Nodes which have been tagged as "directly modified". */
   Set<OperationNode *> entry_tags;
 
+  /* Relations whose owner is not the ID of either of the connected operations, indexed by the
+   * owner. Together with the links of the owner's operations these are all relations of an ID,
+   * which allows to remove them without going over the whole graph. */
+  Map<const ID *, Vector<Relation *>> detached_relations;
+
+  /* Relations removed by #deg_graph_remove_unused_noops. They are linked back when a partial
+   * relations update makes the no-op they lead to used again. */
+  Vector<Relation *> unused_noop_relations;
+
+  /* Relations removed by a partial relations update. Relations are allocated by the build
+   * allocator which can not free them individually, so they are reused by #add_new_relation. */
+  Vector<Relation *> free_relations;
+
+  /* IDs which the relations builder of an ID traversed into or looked up nodes of, indexed by
+   * the ID being built. The key is nullptr for builders outside of any ID, such as the view
+   * layer. Besides the ID itself this is all its relations depend on, which allows a partial
+   * relations update to find the builders which are to be run again. */
+  Map<const ID *, Set<const ID *>> relation_builder_inputs;
+
+  /* IDs whose builders requested a relation which is owned by another ID, indexed by the owner.
+   * The relation is removed when relations of its owner are rebuilt, so these IDs need to be
+   * rebuilt as well. Builders outside of any ID are stored as nullptr. */
+  Map<const ID *, Set<const ID *>> shared_relation_users;
+
   /* Convenience Data ................... */
 
   /* XXX: should be collected after building (if actually needed?) */
@@ -160,11 +202,21 @@ struct Depsgraph {
    * to read stuff from. */
   bool is_active;
 
+  /* The meshes shared with other dependency graphs were marked outdated since the last
+   * evaluation, see #tag_shared_meshes_outdated. */
+  bool shared_meshes_outdated;
+
+  /* Registered with #bke::mesh_eval_share_consumer_add, see #DEG_reuse_viewport_meshes. */
+  bool is_mesh_share_consumer;
+
   /* Optimize out evaluation of operations which affect hidden objects or disabled modifiers. */
   bool use_visibility_optimization;
 
   DepsgraphDebug debug;
 
+  /* Timeline of the evaluations, recorded when #G_DEBUG_DEPSGRAPH_TRACE is enabled. */
+  std::unique_ptr<EvalTrace> eval_trace;
+
   bool is_evaluating;
 
   /* Is set to truth for dependency graph which are used for post-processing (compositor and
@@ -185,6 +237,10 @@ struct Depsgraph {
   /* The number of times this graph has been evaluated. */
   uint64_t update_count;
 
+  /* Number of evaluations until the critical path of operations is updated from their timings.
+   * Reset when relations are rebuilt. */
+  int critical_path_update_countdown;
+
   /* If this mode does not allow writing back to original data any callbacks will be discarded. */
   DepsgraphEvaluateSyncWriteback sync_writeback;
   /**
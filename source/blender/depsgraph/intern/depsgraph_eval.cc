@@ -8,6 +8,7 @@
  * Evaluation engine entry-points for Depsgraph Engine.
  */
 
+#include "BKE_mesh_eval_share.hh"
 #include "BKE_scene.hh"
 
 #include "DNA_scene_types.h"
@@ -40,6 +41,9 @@ static void deg_flush_updates_and_refresh(deg::Depsgraph *deg_graph,
   BLI_assert(deg_graph->sync_writeback_callbacks.is_empty());
   deg_graph->sync_writeback = sync_writeback;
   deg::deg_evaluate_on_refresh(deg_graph);
+  blender::bke::mesh_eval_share_source_evaluated(reinterpret_cast<Depsgraph *>(deg_graph),
+                                                 deg_graph->ctime);
+  deg_graph->shared_meshes_outdated = false;
 
   if ((deg_graph->sync_writeback == DEG_EVALUATE_SYNC_WRITEBACK_YES) && deg_graph->is_active) {
     for (std::function<void()> &fn : deg_graph->sync_writeback_callbacks) {
@@ -10,6 +10,7 @@
 
 struct Collection;
 struct ListBase;
+struct Object;
 
 namespace blender::deg {
 
@@ -20,5 +21,8 @@ ListBase *build_collision_relations(Depsgraph *graph,
                                     Collection *collection,
                                     unsigned int modifier_type);
 void clear_physics_relations(Depsgraph *graph);
+/* Check whether the object is a part of any of the effector or collision relations which were
+ * cached while building the graph. */
+bool physics_relations_contain_object(const Depsgraph *graph, const Object *object);
 
 }  // namespace blender::deg
@@ -8,6 +8,8 @@
 
 #pragma once
 
+struct ID;
+
 namespace blender::deg {
 
 struct Node;
@@ -46,6 +48,12 @@ struct Relation {
   /* relationship attributes */
   const char *name; /* label for debugging */
   int flag = 0;     /* Bitmask of RelationFlag) */
+
+  /* Original ID whose builder added this relation, used to find the relations which are to be
+   * rebuilt on a partial relations update. Is nullptr for relations added outside of any ID
+   * builder (view layer, scene). Other builders requesting the same relation are recorded in
+   * #Depsgraph::shared_relation_users. */
+  const ID *owner = nullptr;
 };
 
 }  // namespace blender::deg
@@ -8,6 +8,7 @@
  * Evaluation engine entry-points for Depsgraph Engine.
  */
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 
@@ -17,6 +18,7 @@
 #include "BLI_gsqueue.h"
 #include "BLI_task.h"
 #include "BLI_time.h"
+#include "BLI_vector.hh"
 
 #include "BKE_global.hh"
 
@@ -36,8 +38,10 @@
 #include "intern/depsgraph_relation.hh"
 #include "intern/depsgraph_tag.hh"
 #include "intern/eval/deg_eval_copy_on_write.h"
+#include "intern/eval/deg_eval_critical_path.h"
 #include "intern/eval/deg_eval_flush.h"
 #include "intern/eval/deg_eval_stats.h"
+#include "intern/eval/deg_eval_trace.h"
 #include "intern/eval/deg_eval_visibility.h"
 #include "intern/node/deg_node.hh"
 #include "intern/node/deg_node_component.hh"
@@ -79,11 +83,23 @@ enum class EvaluationStage {
 struct DepsgraphEvalState {
   Depsgraph *graph;
   bool do_stats;
+  /* Recorder of the evaluation timeline, null when not tracing. */
+  EvalTrace *trace = nullptr;
   EvaluationStage stage;
   bool need_update_pending_parents = true;
   bool need_single_thread_pass = false;
+
+  /* Prefer ready operations with a longer critical path during the threaded evaluation stage,
+   * instead of evaluating them in the order in which they became ready. */
+  bool use_critical_path_scheduling = false;
 };
 
+bool critical_path_scheduling_active(const DepsgraphEvalState *state)
+{
+  return state->use_critical_path_scheduling &&
+         state->stage == EvaluationStage::THREADED_EVALUATION;
+}
+
 void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
 {
   ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(state->graph);
@@ -91,10 +107,20 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
   /* Sanity checks. */
   BLI_assert_msg(!operation_node->is_noop(), "NOOP nodes should not actually be scheduled");
   /* Perform operation. */
-  if (state->do_stats) {
+  if (state->do_stats || state->trace || critical_path_scheduling_active(state)) {
     const double start_time = BLI_time_now_seconds();
     operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += BLI_time_now_seconds() - start_time;
+    const double end_time = BLI_time_now_seconds();
+    const double time = end_time - start_time;
+    if (state->trace) {
+      state->trace->add_operation(*operation_node, start_time, end_time);
+    }
+    if (state->do_stats) {
+      operation_node->stats.current_time += time;
+    }
+    if (critical_path_scheduling_active(state)) {
+      deg_eval_critical_path_add_timing(operation_node, time);
+    }
   }
   else {
     operation_node->evaluate(depsgraph);
@@ -122,6 +148,37 @@ void deg_task_run_func(TaskPool *pool, void *taskdata)
   });
 }
 
+bool operation_critical_path_less(const OperationNode *a, const OperationNode *b)
+{
+  return a->critical_path_time < b->critical_path_time;
+}
+
+/* Same as #deg_task_run_func, but the thread continues with the ready child that has the longest
+ * critical path, and only pushes the other ready children to the task pool. This keeps every
+ * thread on a chain of expensive operations without any shared ready queue. */
+void deg_task_run_critical_path_func(TaskPool *pool, void *taskdata)
+{
+  DepsgraphEvalState *state = static_cast<DepsgraphEvalState *>(BLI_task_pool_user_data(pool));
+
+  OperationNode *operation_node = static_cast<OperationNode *>(taskdata);
+  while (operation_node != nullptr) {
+    evaluate_node(state, operation_node);
+
+    OperationNode *next_node = nullptr;
+    schedule_children(state, operation_node, [&](OperationNode *node) {
+      if (next_node == nullptr) {
+        next_node = node;
+        return;
+      }
+      if (operation_critical_path_less(next_node, node)) {
+        std::swap(next_node, node);
+      }
+      BLI_task_pool_push(pool, deg_task_run_critical_path_func, node, false, nullptr);
+    });
+    operation_node = next_node;
+  }
+}
+
 bool check_operation_node_visible(const DepsgraphEvalState *state, OperationNode *op_node)
 {
   const ComponentNode *comp_node = op_node->owner;
@@ -193,6 +250,13 @@ void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
       node->stats.reset_current();
     }
   }
+  if (state->trace) {
+    /* Ready times are set when scheduling, don't let them carry over from a previous
+     * evaluation. */
+    for (OperationNode *node : graph->operations) {
+      node->trace_ready_time = 0.0;
+    }
+  }
 }
 
 bool is_metaball_object_operation(const OperationNode *operation_node)
@@ -277,6 +341,9 @@ void schedule_node(DepsgraphEvalState *state,
     }
     else {
       /* children are scheduled once this task is completed */
+      if (state->trace) {
+        node->trace_ready_time = BLI_time_now_seconds();
+      }
       schedule_fn(node);
     }
   }
@@ -285,6 +352,18 @@ void schedule_node(DepsgraphEvalState *state,
 void schedule_graph(DepsgraphEvalState *state,
                     const FunctionRef<void(OperationNode *node)> schedule_fn)
 {
+  if (state->trace) {
+    /* Operations scheduled here have no pending dependencies, they are all ready when the stage
+     * starts. */
+    const double stage_start_time = BLI_time_now_seconds();
+    for (OperationNode *node : state->graph->operations) {
+      schedule_node(state, node, false, [&](OperationNode *ready_node) {
+        ready_node->trace_ready_time = stage_start_time;
+        schedule_fn(ready_node);
+      });
+    }
+    return;
+  }
   for (OperationNode *node : state->graph->operations) {
     schedule_node(state, node, false, schedule_fn);
   }
@@ -316,9 +395,24 @@ void evaluate_graph_threaded_stage(DepsgraphEvalState *state,
 
   calculate_pending_parents_if_needed(state);
 
-  schedule_graph(state, [&](OperationNode *node) {
-    BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
-  });
+  if (critical_path_scheduling_active(state)) {
+    /* Push the operations with the longest critical path first, so that they start first. */
+    Vector<OperationNode *> ready_operations;
+    schedule_graph(state, [&](OperationNode *node) { ready_operations.append(node); });
+    std::sort(ready_operations.begin(),
+              ready_operations.end(),
+              [](const OperationNode *a, const OperationNode *b) {
+                return operation_critical_path_less(b, a);
+              });
+    for (OperationNode *node : ready_operations) {
+      BLI_task_pool_push(task_pool, deg_task_run_critical_path_func, node, false, nullptr);
+    }
+  }
+  else {
+    schedule_graph(state, [&](OperationNode *node) {
+      BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
+    });
+  }
   BLI_task_pool_work_and_wait(task_pool);
 }
 
@@ -410,10 +504,28 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   DepsgraphEvalState state;
   state.graph = graph;
   state.do_stats = graph->debug.do_time_debug();
+  state.use_critical_path_scheduling = deg_eval_critical_path_use(graph);
+  if (graph->debug.do_eval_trace()) {
+    if (!graph->eval_trace) {
+      graph->eval_trace = std::make_unique<EvalTrace>();
+    }
+    state.trace = graph->eval_trace.get();
+    state.trace->begin_evaluation();
+  }
 
   /* Prepare all nodes for evaluation. */
   initialize_execution(&state, graph);
 
+  /* The timings only change slowly, so the critical path does not need to be updated on every
+   * evaluation. */
+  if (state.use_critical_path_scheduling) {
+    if (graph->critical_path_update_countdown <= 0) {
+      deg_eval_critical_path_update(graph);
+      graph->critical_path_update_countdown = DEG_CRITICAL_PATH_UPDATE_INTERVAL;
+    }
+    graph->critical_path_update_countdown--;
+  }
+
   /* Evaluation happens in several incremental steps:
    *
    * - Start with the copy-on-evaluation operations which never form dependency cycles. This will
@@ -464,6 +576,9 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   if (state.do_stats) {
     deg_eval_stats_aggregate(graph);
   }
+  if (state.trace) {
+    state.trace->end_evaluation();
+  }
 
   /* Clear any uncleared tags. */
   deg_graph_clear_tags(graph);
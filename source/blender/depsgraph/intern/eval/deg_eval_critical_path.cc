@@ -0,0 +1,123 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/eval/deg_eval_critical_path.h"
+
+#include <algorithm>
+
+#include "BLI_task.h"
+#include "BLI_vector.hh"
+
+#include "BKE_global.hh"
+
+#include "intern/depsgraph.hh"
+#include "intern/depsgraph_relation.hh"
+#include "intern/node/deg_node_operation.hh"
+
+namespace blender::deg {
+
+/* Cost of an operation without measured timing. Makes the critical path follow the longest
+ * chain of operations until timings are available. */
+static constexpr float operation_time_min = 1e-6f;
+
+/* Weight of the most recent timing in the average, keeps it responsive to changes of the scene
+ * while filtering out noise of individual evaluations. */
+static constexpr float timing_weight = 0.25f;
+
+/* Smaller graphs rarely have more ready operations than threads, so choosing between them does
+ * not pay off the cost of timing every operation. In simulations of scenes with a few hundred
+ * operations there was no measurable difference. */
+static constexpr int64_t critical_path_operations_min = 1024;
+
+static constexpr float critical_path_unvisited = -1.0f;
+static constexpr float critical_path_in_progress = -2.0f;
+
+bool deg_eval_critical_path_use(const Depsgraph *graph)
+{
+  if (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) {
+    return false;
+  }
+  if (BLI_task_scheduler_num_threads() <= 1) {
+    return false;
+  }
+  return graph->operations.size() >= critical_path_operations_min;
+}
+
+void deg_eval_critical_path_add_timing(OperationNode *node, const double time)
+{
+  if (node->eval_time_average == 0.0f) {
+    node->eval_time_average = float(time);
+    return;
+  }
+  node->eval_time_average += (float(time) - node->eval_time_average) * timing_weight;
+}
+
+static float operation_cost(const OperationNode *node)
+{
+  if (node->is_noop()) {
+    return 0.0f;
+  }
+  return std::max(node->eval_time_average, operation_time_min);
+}
+
+static OperationNode *relation_child_get(const Relation *rel)
+{
+  if (rel->flag & RELATION_FLAG_CYCLIC) {
+    return nullptr;
+  }
+  BLI_assert(rel->to->type == NodeType::OPERATION);
+  return static_cast<OperationNode *>(rel->to);
+}
+
+void deg_eval_critical_path_update(Depsgraph *graph)
+{
+  for (OperationNode *node : graph->operations) {
+    node->critical_path_time = critical_path_unvisited;
+  }
+
+  /* Depth-first traversal which computes the critical path of children before their parents.
+   * Uses an explicit stack since operation chains can be very long. */
+  struct StackEntry {
+    OperationNode *node;
+    int64_t next_link;
+  };
+  Vector<StackEntry> stack;
+
+  for (OperationNode *root : graph->operations) {
+    if (root->critical_path_time != critical_path_unvisited) {
+      continue;
+    }
+    root->critical_path_time = critical_path_in_progress;
+    stack.append({root, 0});
+
+    while (!stack.is_empty()) {
+      StackEntry &entry = stack.last();
+      OperationNode *node = entry.node;
+      if (entry.next_link < node->outlinks.size()) {
+        OperationNode *child = relation_child_get(node->outlinks[entry.next_link++]);
+        if (child && child->critical_path_time == critical_path_unvisited) {
+          child->critical_path_time = critical_path_in_progress;
+          stack.append({child, 0});
+        }
+        continue;
+      }
+
+      /* Children which are still in progress are part of an unflagged cycle, ignore them. */
+      float children_time = 0.0f;
+      for (const Relation *rel : node->outlinks) {
+        if (const OperationNode *child = relation_child_get(rel)) {
+          children_time = std::max(children_time, child->critical_path_time);
+        }
+      }
+      node->critical_path_time = operation_cost(node) + children_time;
+      stack.remove_last();
+    }
+  }
+}
+
+}  // namespace blender::deg
@@ -0,0 +1,33 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+namespace blender::deg {
+
+struct Depsgraph;
+struct OperationNode;
+
+/* Number of evaluations between updates of the critical path from the measured timings. */
+constexpr int DEG_CRITICAL_PATH_UPDATE_INTERVAL = 16;
+
+/* Whether ready operations of the graph are scheduled by their critical path. Only done for
+ * threaded evaluation of large graphs, where there are enough ready operations to choose from. */
+bool deg_eval_critical_path_use(const Depsgraph *graph);
+
+/* Accumulate the time it took to evaluate the operation into its average evaluation time. */
+void deg_eval_critical_path_add_timing(OperationNode *node, double time);
+
+/* Update the critical path time of all operations from their average evaluation time.
+ *
+ * The critical path time of an operation is the time it takes to evaluate it and the longest
+ * chain of operations depending on it. Evaluating operations with a longer critical path first
+ * lowers the total evaluation time when there are more ready operations than threads. */
+void deg_eval_critical_path_update(Depsgraph *graph);
+
+}  // namespace blender::deg
@@ -18,6 +18,7 @@
 
 #include "BKE_global.hh"
 #include "BKE_key.hh"
+#include "BKE_mesh_eval_share.hh"
 #include "BKE_object.hh"
 #include "BKE_scene.hh"
 
@@ -300,6 +301,30 @@ void invalidate_tagged_evaluated_data(Depsgraph *graph)
 #endif
 }
 
+/* Meshes shared with other dependency graphs are the result of a previous evaluation, remove the
+ * ones of objects whose geometry is tagged for update. This also covers objects which are not
+ * evaluated again because they are invisible. */
+void invalidate_shared_evaluated_geometry(Depsgraph *graph)
+{
+  if (!graph->is_active) {
+    return;
+  }
+  Vector<uint32_t> object_session_uids;
+  for (IDNode *id_node : graph->id_nodes) {
+    if (id_node->custom_flags != ID_STATE_MODIFIED || GS(id_node->id_orig->name) != ID_OB) {
+      continue;
+    }
+    const ComponentNode *geometry_comp = id_node->find_component(NodeType::GEOMETRY);
+    if (geometry_comp && geometry_comp->custom_flags == COMPONENT_STATE_DONE) {
+      object_session_uids.append(id_node->id_orig_session_uid);
+    }
+  }
+  if (!object_session_uids.is_empty()) {
+    bke::mesh_eval_share_source_invalidate(reinterpret_cast<::Depsgraph *>(graph),
+                                           object_session_uids);
+  }
+}
+
 }  // namespace
 
 void deg_graph_flush_updates(Depsgraph *graph)
@@ -343,6 +368,7 @@ void deg_graph_flush_updates(Depsgraph *graph)
   }
   /* Inform editors about all changes. */
   flush_editors_id_update(graph, &update_ctx);
+  invalidate_shared_evaluated_geometry(graph);
   /* Reset evaluation result tagged which is tagged for update to some state
    * which is obvious to catch. */
   invalidate_tagged_evaluated_data(graph);
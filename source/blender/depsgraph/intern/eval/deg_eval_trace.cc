@@ -0,0 +1,252 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/eval/deg_eval_trace.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <mutex>
+
+#include "BLI_fileops.h"
+#include "BLI_mutex.hh"
+#include "BLI_set.hh"
+#include "BLI_time.h"
+
+#include "DEG_depsgraph_debug.hh"
+
+#include "intern/depsgraph.hh"
+#include "intern/node/deg_node_component.hh"
+#include "intern/node/deg_node_id.hh"
+#include "intern/node/deg_node_operation.hh"
+
+namespace blender::deg {
+
+namespace {
+
+/* Index of the calling thread, stable for the lifetime of the thread. Used as thread identifier
+ * in the trace, as it is short and the same for all graphs. */
+int trace_thread_index()
+{
+  static std::atomic<int> next_index = 0;
+  static thread_local const int index = next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+/* File collecting the traces of all graphs, see #DEG_debug_eval_trace_file_set. */
+struct TraceFile {
+  Mutex mutex;
+  FILE *file = nullptr;
+  /* Identifier of the next graph written to the file. */
+  int next_process_id = 1;
+};
+
+TraceFile &trace_file()
+{
+  static TraceFile trace_file;
+  return trace_file;
+}
+
+void write_json_string(FILE *file, const std::string &str)
+{
+  fputc('"', file);
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        fputs("\\\"", file);
+        break;
+      case '\\':
+        fputs("\\\\", file);
+        break;
+      default:
+        if (uint8_t(c) < 0x20) {
+          fprintf(file, "\\u%04x", int(c));
+        }
+        else {
+          fputc(c, file);
+        }
+        break;
+    }
+  }
+  fputc('"', file);
+}
+
+/* Timestamps of trace events are in microseconds. */
+int64_t trace_time_us(const double time)
+{
+  return int64_t(time * 1e6);
+}
+
+}  // namespace
+
+void EvalTrace::begin_evaluation()
+{
+  evaluation_start_time_ = BLI_time_now_seconds();
+  evaluation_thread_ = trace_thread_index();
+}
+
+void EvalTrace::add_operation(const OperationNode &node,
+                              const double start_time,
+                              const double end_time)
+{
+  ThreadOperations &local = thread_operations_.local();
+  if (local.thread == -1) {
+    local.thread = trace_thread_index();
+  }
+  /* Operations which were not scheduled through the task graph have no ready time. */
+  const double ready_time = node.trace_ready_time > 0.0 ? node.trace_ready_time : start_time;
+  local.operations.append({&node, ready_time, start_time, end_time});
+}
+
+void EvalTrace::end_evaluation()
+{
+  const double evaluation_end_time = BLI_time_now_seconds();
+
+  auto add_event = [&](Event &&event) {
+    if (events_.size() >= max_events) {
+      dropped_events_num_++;
+      return;
+    }
+    events_.append(std::move(event));
+  };
+
+  add_event({"Evaluation",
+             "Depsgraph",
+             evaluation_start_time_,
+             evaluation_start_time_,
+             evaluation_end_time,
+             evaluation_thread_});
+
+  for (ThreadOperations &local : thread_operations_) {
+    for (const RecordedOperation &operation : local.operations) {
+      const OperationNode &node = *operation.node;
+      const ComponentNode &component = *node.owner;
+      add_event({component.owner->name + " " + node.identifier(),
+                 nodeTypeAsString(component.type),
+                 operation.ready_time,
+                 operation.start_time,
+                 operation.end_time,
+                 local.thread});
+    }
+    local.operations.clear();
+  }
+}
+
+bool EvalTrace::is_empty() const
+{
+  return events_.is_empty();
+}
+
+void EvalTrace::write_events(FILE *file, const int process_id, const std::string &process_name)
+{
+  fprintf(file,
+          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":",
+          process_id);
+  write_json_string(file, process_name);
+  fputs("}}", file);
+
+  Set<int> threads;
+  for (const Event &event : events_) {
+    if (threads.add(event.thread)) {
+      fprintf(file,
+              ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+              "\"args\":{\"name\":\"Thread %d\"}}",
+              process_id,
+              event.thread,
+              event.thread);
+    }
+
+    fputs(",\n{\"name\":", file);
+    write_json_string(file, event.name);
+    fputs(",\"cat\":", file);
+    write_json_string(file, event.category);
+    fprintf(file,
+            ",\"ph\":\"X\",\"ts\":%" PRId64 ",\"dur\":%" PRId64
+            ",\"pid\":%d,\"tid\":%d,\"args\":{\"wait_us\":%" PRId64 "}}",
+            trace_time_us(event.start_time),
+            trace_time_us(event.end_time) - trace_time_us(event.start_time),
+            process_id,
+            event.thread,
+            trace_time_us(event.start_time) - trace_time_us(event.ready_time));
+  }
+
+  if (dropped_events_num_ != 0) {
+    fprintf(file,
+            ",\n{\"name\":\"Dropped %" PRId64 " events\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%" PRId64
+            ",\"pid\":%d,\"tid\":%d}",
+            dropped_events_num_,
+            trace_time_us(events_.last().end_time),
+            process_id,
+            events_.last().thread);
+  }
+
+  events_.clear();
+  dropped_events_num_ = 0;
+}
+
+void deg_eval_trace_flush_to_file(Depsgraph &graph)
+{
+  if (!graph.eval_trace || graph.eval_trace->is_empty()) {
+    return;
+  }
+  TraceFile &trace = trace_file();
+  std::lock_guard lock(trace.mutex);
+  if (trace.file == nullptr) {
+    return;
+  }
+  fputs(",\n", trace.file);
+  graph.eval_trace->write_events(trace.file, trace.next_process_id++, graph.debug.name);
+}
+
+void deg_eval_trace_file_close()
+{
+  TraceFile &trace = trace_file();
+  std::lock_guard lock(trace.mutex);
+  if (trace.file == nullptr) {
+    return;
+  }
+  fputs("\n]\n", trace.file);
+  fclose(trace.file);
+  trace.file = nullptr;
+}
+
+}  // namespace blender::deg
+
+namespace deg = blender::deg;
+
+bool DEG_debug_eval_trace_file_set(const char *filepath)
+{
+  deg::deg_eval_trace_file_close();
+
+  deg::TraceFile &trace = deg::trace_file();
+  std::lock_guard lock(trace.mutex);
+  trace.file = BLI_fopen(filepath, "w");
+  if (trace.file == nullptr) {
+    return false;
+  }
+  /* The traces of the graphs are appended as they are freed. The closing bracket is optional in
+   * the trace event format, so the file stays readable when it is not finished. */
+  fputs("[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Blender\"}}",
+        trace.file);
+  return true;
+}
+
+bool DEG_debug_eval_trace_write(Depsgraph *depsgraph, const char *filepath)
+{
+  deg::Depsgraph *deg_graph = reinterpret_cast<deg::Depsgraph *>(depsgraph);
+  FILE *file = BLI_fopen(filepath, "w");
+  if (file == nullptr) {
+    return false;
+  }
+  fputs("[\n", file);
+  if (deg_graph->eval_trace) {
+    deg_graph->eval_trace->write_events(file, 1, deg_graph->debug.name);
+  }
+  fputs("\n]\n", file);
+  fclose(file);
+  return true;
+}
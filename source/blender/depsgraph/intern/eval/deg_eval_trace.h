@@ -0,0 +1,86 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+#include "BLI_enumerable_thread_specific.hh"
+#include "BLI_vector.hh"
+
+namespace blender::deg {
+
+struct Depsgraph;
+struct OperationNode;
+
+/* Recorder of the timeline of dependency graph evaluations: which thread evaluated which
+ * operation, when, and how long the operation waited for a thread after its last dependency was
+ * evaluated. Enabled with #G_DEBUG_DEPSGRAPH_TRACE, and exported in the Chrome trace event format
+ * which can be viewed in Perfetto or `chrome://tracing`. */
+class EvalTrace {
+ public:
+  /* Evaluation of one operation. Times are in seconds, from #BLI_time_now_seconds. */
+  struct Event {
+    std::string name;
+    std::string category;
+    double ready_time;
+    double start_time;
+    double end_time;
+    int thread;
+  };
+
+  /* Start recording an evaluation of the graph. */
+  void begin_evaluation();
+  /* Record the evaluation of an operation, can be called from any evaluation thread. */
+  void add_operation(const OperationNode &node, double start_time, double end_time);
+  /* Finish recording the evaluation, resolving the names of the evaluated operations while the
+   * nodes of the graph still exist. */
+  void end_evaluation();
+
+  bool is_empty() const;
+
+  /* Write the recorded events as a comma separated list of trace events, without the enclosing
+   * JSON array. The events are grouped as one process in the trace. The recorded events are
+   * cleared afterwards. */
+  void write_events(FILE *file, int process_id, const std::string &process_name);
+
+ private:
+  struct RecordedOperation {
+    const OperationNode *node;
+    double ready_time;
+    double start_time;
+    double end_time;
+  };
+
+  struct ThreadOperations {
+    int thread = -1;
+    Vector<RecordedOperation> operations;
+  };
+
+  threading::EnumerableThreadSpecific<ThreadOperations> thread_operations_;
+
+  double evaluation_start_time_ = 0.0;
+  int evaluation_thread_ = 0;
+
+  Vector<Event> events_;
+  /* Number of events that were not recorded because #max_events was reached. */
+  int64_t dropped_events_num_ = 0;
+
+  /* Limit the memory used when tracing for a long time without writing the trace. */
+  static constexpr int64_t max_events = 1 << 20;
+};
+
+/* Write the events recorded for the graph to the file opened with
+ * #DEG_debug_eval_trace_file_set, if any. Called when the graph is freed. */
+void deg_eval_trace_flush_to_file(Depsgraph &graph);
+
+/* Finish the file opened with #DEG_debug_eval_trace_file_set. */
+void deg_eval_trace_file_close();
+
+}  // namespace blender::deg
@@ -253,6 +253,20 @@ void ComponentNode::finalize_build(Depsgraph * /*graph*/)
   operations_map = nullptr;
 }
 
+void ComponentNode::reopen_build()
+{
+  if (operations_map != nullptr) {
+    return;
+  }
+  operations_map = new Map<ComponentNode::OperationIDKey, OperationNode *>();
+  operations_map->reserve(operations.size());
+  for (OperationNode *op_node : operations) {
+    operations_map->add_new(OperationIDKey(op_node->opcode, op_node->name, op_node->name_tag),
+                            op_node);
+  }
+  operations.clear();
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -112,6 +112,9 @@ struct ComponentNode : public Node {
   OperationNode *get_exit_operation() override;
 
   void finalize_build(Depsgraph *graph);
+  /* Move operations back to the build-time hash map, so that more operations can be added to a
+   * component of an already built graph. Used by the partial relations update. */
+  void reopen_build();
 
   IDNode *owner;
 
@@ -165,6 +165,13 @@ void IDNode::finalize_build(Depsgraph *graph)
   visible_components_mask = get_visible_components_mask();
 }
 
+void IDNode::reopen_build()
+{
+  for (ComponentNode *comp_node : components.values()) {
+    comp_node->reopen_build();
+  }
+}
+
 IDComponentsMask IDNode::get_visible_components_mask() const
 {
   IDComponentsMask result = 0;
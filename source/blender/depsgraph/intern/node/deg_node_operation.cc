@@ -116,6 +116,8 @@ const char *operationCodeAsString(OperationCode opcode)
       return "POSE_IK_SOLVER";
     case OperationCode::POSE_SPLINE_IK_SOLVER:
       return "POSE_SPLINE_IK_SOLVER";
+    case OperationCode::POSE_EVAL_BONES:
+      return "POSE_EVAL_BONES";
     /* Bone. */
     case OperationCode::BONE_LOCAL:
       return "BONE_LOCAL";
@@ -209,7 +211,14 @@ const char *operationCodeAsString(OperationCode opcode)
   return "UNKNOWN";
 }
 
-OperationNode::OperationNode() : name_tag(-1), flag(0) {}
+OperationNode::OperationNode()
+    : eval_time_average(0.0f),
+      critical_path_time(0.0f),
+      trace_ready_time(0.0),
+      name_tag(-1),
+      flag(0)
+{
+}
 
 std::string OperationNode::identifier() const
 {
@@ -121,6 +121,9 @@ enum class OperationCode {
   /* IK/Spline Solvers */
   POSE_IK_SOLVER,
   POSE_SPLINE_IK_SOLVER,
+  /* All bones evaluated by a single operation, for rigs which don't need per-bone operations. The
+   * bone components only contain no-op entry and exit operations then. */
+  POSE_EVAL_BONES,
 
   /* Bone. ---------------------------------------------------------------- */
   /* Bone local transforms - entry point */
@@ -287,6 +290,15 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Running average of the evaluation time of this operation, in seconds. */
+  float eval_time_average;
+  /* Estimated time to evaluate this operation and the longest chain of operations which depend
+   * on it. Ready operations with a longer critical path are evaluated first. */
+  float critical_path_time;
+  /* Time at which the operation was scheduled for evaluation, only set while tracing the
+   * evaluation (see #EvalTrace). */
+  double trace_ready_time;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
@@ -250,7 +250,7 @@ ModifierData *modifier_add(
   BKE_object_modifier_set_active(ob, new_md);
 
   DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
-  DEG_relations_tag_update(bmain);
+  DEG_id_tag_relations_update(bmain, &ob->id);
 
   return new_md;
 }
@@ -397,7 +397,8 @@ static bool object_modifier_remove(
 
 bool modifier_remove(ReportList *reports, Main *bmain, Scene *scene, Object *ob, ModifierData *md)
 {
-  bool sort_depsgraph = false;
+  /* Particle systems are a part of the scene-wide physics relations. */
+  bool sort_depsgraph = md->type == eModifierType_ParticleSystem;
 
   bool ok = object_modifier_remove(bmain, scene, ob, md, &sort_depsgraph);
 
@@ -407,7 +408,12 @@ bool modifier_remove(ReportList *reports, Main *bmain, Scene *scene, Object *ob,
   }
 
   DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
-  DEG_relations_tag_update(bmain);
+  if (sort_depsgraph) {
+    DEG_relations_tag_update(bmain);
+  }
+  else {
+    DEG_id_tag_relations_update(bmain, &ob->id);
+  }
 
   return true;
 }
@@ -424,13 +430,19 @@ void modifiers_clear(Main *bmain, Scene *scene, Object *ob)
   while (md) {
     ModifierData *next_md = md->next;
 
+    sort_depsgraph |= md->type == eModifierType_ParticleSystem;
     object_modifier_remove(bmain, scene, ob, md, &sort_depsgraph);
 
     md = next_md;
   }
 
   DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
-  DEG_relations_tag_update(bmain);
+  if (sort_depsgraph) {
+    DEG_relations_tag_update(bmain);
+  }
+  else {
+    DEG_id_tag_relations_update(bmain, &ob->id);
+  }
 }
 
 static bool object_modifier_check_move_before(ReportList *reports,
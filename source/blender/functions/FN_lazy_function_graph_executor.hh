@@ -11,6 +11,8 @@
  * another #Graph again).
  */
 
+#include <optional>
+
 #include "BLI_generic_pointer.hh"
 #include "BLI_vector.hh"
 
@@ -118,6 +120,41 @@ class GraphExecutor : public LazyFunction {
     int total_size;
   } init_buffer_info_;
 
+  /**
+   * Precomputed evaluation order for graphs in which every node needs all its inputs. Those graphs
+   * can be executed in a single pass without tracking the evaluation state of every node, which
+   * has much less overhead for graphs of many small nodes. The schedule only exists when the graph
+   * supports it.
+   */
+  struct EagerSchedule {
+    /**
+     * Larger schedules are only used when the caller doesn't allow multi-threading, because
+     * independent nodes in them can be evaluated in parallel with the dynamic scheduling.
+     */
+    static constexpr int max_nodes_with_multi_threading = 64;
+
+    /** Function nodes that graph outputs depend on. Every node comes after its dependencies. */
+    Vector<const FunctionNode *> nodes;
+    /** Index in #nodes for every node in the graph, or -1 if the node is not evaluated. */
+    Array<int> schedule_index_by_node;
+    /**
+     * Where the sockets of every scheduled node start in the socket arrays below. The inputs of a
+     * node come first, followed by its outputs.
+     */
+    Array<int> sockets_start;
+    /** Offset of the value of every socket in the buffer that is allocated for an evaluation. */
+    Array<int> value_offsets;
+    /** Whether the value of an output socket is forwarded to any node or graph output. */
+    Array<bool> output_is_used;
+    /** Indices of graph inputs that are needed to compute the graph outputs. */
+    Vector<int> used_graph_inputs;
+    /** Offset of the flags that indicate which output values have been set. */
+    int output_flags_offset;
+    int buffer_size;
+    int buffer_alignment;
+  };
+  std::optional<EagerSchedule> eager_schedule_;
+
   friend class Executor;
 
  public:
@@ -141,6 +178,8 @@ class GraphExecutor : public LazyFunction {
 
  private:
   void execute_impl(Params &params, const Context &context) const override;
+
+  void build_eager_schedule();
 };
 
 }  // namespace blender::fn::lazy_function
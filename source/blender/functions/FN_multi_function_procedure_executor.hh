@@ -8,6 +8,8 @@
  * \ingroup fn
  */
 
+#include "BLI_enumerable_thread_specific.hh"
+
 #include "FN_multi_function_procedure.hh"
 
 namespace blender::fn::multi_function {
@@ -15,11 +17,20 @@ namespace blender::fn::multi_function {
 /** A multi-function that executes a procedure internally. */
 class ProcedureExecutor : public MultiFunction {
  private:
+  class ThreadScratch;
+
   Signature signature_;
   const Procedure &procedure_;
+  /**
+   * Buffers for intermediate values that are reused when the executor is called multiple times,
+   * e.g. for the different chunks of a large mask.
+   */
+  mutable threading::EnumerableThreadSpecific<std::unique_ptr<ThreadScratch>> thread_scratch_;
+  bool use_thread_scratch_ = true;
 
  public:
   ProcedureExecutor(const Procedure &procedure);
+  ~ProcedureExecutor();
 
   void call(const IndexMask &mask, Params params, Context context) const override;
 
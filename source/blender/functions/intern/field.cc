@@ -278,6 +278,129 @@ static void build_multi_function_procedure_for_fields(mf::Procedure &procedure,
   BLI_assert(procedure.validate());
 }
 
+/**
+ * Evaluate the procedure for the indices of a chunk that are spread over a much larger range.
+ * The inputs are copied into buffers with one element per index, so that the outputs only need as
+ * much temporary memory as well. The outputs are moved to their destination afterwards.
+ */
+static void evaluate_procedure_compressed(const mf::ProcedureExecutor &executor,
+                                          const IndexMask &mask,
+                                          const Span<GVArray> inputs,
+                                          const Span<GMutableSpan> output_spans,
+                                          const Span<GVMutableArray> streamed_outputs)
+{
+  const IndexMask compressed_mask(mask.size());
+  mf::ParamsBuilder params{executor, &compressed_mask};
+  mf::ContextBuilder context;
+
+  LinearAllocator<> allocator;
+  Array<void *> input_buffers(inputs.size());
+  for (const int i : inputs.index_range()) {
+    const CPPType &type = inputs[i].type();
+    input_buffers[i] = allocator.allocate_array(type, mask.size());
+    inputs[i].materialize_compressed_to_uninitialized(mask, input_buffers[i]);
+    params.add_readonly_single_input(GSpan(type, input_buffers[i], mask.size()));
+  }
+  const auto output_type = [&](const int i) -> const CPPType & {
+    return streamed_outputs[i] ? streamed_outputs[i].type() : output_spans[i].type();
+  };
+  Array<void *> output_buffers(output_spans.size());
+  for (const int i : output_spans.index_range()) {
+    const CPPType &type = output_type(i);
+    output_buffers[i] = allocator.allocate_array(type, mask.size());
+    params.add_uninitialized_single_output({type, output_buffers[i], mask.size()});
+  }
+
+  executor.call(compressed_mask, params, context);
+
+  for (const int i : inputs.index_range()) {
+    inputs[i].type().destruct_n(input_buffers[i], mask.size());
+  }
+  for (const int i : output_spans.index_range()) {
+    const CPPType &type = output_type(i);
+    if (GVMutableArray dst_varray = streamed_outputs[i]) {
+      mask.foreach_index([&](const int64_t index, const int64_t pos) {
+        dst_varray.set_by_relocate(index, POINTER_OFFSET(output_buffers[i], type.size * pos));
+      });
+    }
+    else {
+      mask.foreach_index([&](const int64_t index, const int64_t pos) {
+        type.relocate_construct(POINTER_OFFSET(output_buffers[i], type.size * pos),
+                                output_spans[i][index]);
+      });
+    }
+  }
+}
+
+/**
+ * Evaluate the procedure in chunks and move the values of the streamed outputs into their
+ * destination virtual arrays after every chunk. Compared to computing these outputs for the entire
+ * mask first, this only requires temporary memory proportional to the chunk size.
+ *
+ * \param output_spans: Storage for the outputs that are not streamed.
+ * \param streamed_outputs: Destination for the outputs that are streamed, empty for other outputs.
+ */
+static void evaluate_procedure_with_streamed_outputs(const mf::ProcedureExecutor &executor,
+                                                     const IndexMask &mask,
+                                                     const Span<GVArray> inputs,
+                                                     const Span<GMutableSpan> output_spans,
+                                                     const Span<GVMutableArray> streamed_outputs)
+{
+  const int64_t chunk_size = 8192;
+  threading::parallel_for(mask.index_range(), chunk_size, [&](const IndexRange range) {
+    /* The range may be larger than the grain size, split it up further to bound the memory. */
+    for (int64_t chunk_start = range.start(); chunk_start < range.one_after_last();
+         chunk_start += chunk_size)
+    {
+      const IndexRange chunk = IndexRange::from_begin_end(
+          chunk_start, std::min(chunk_start + chunk_size, range.one_after_last()));
+      const IndexMask chunk_mask = mask.slice(chunk);
+      const IndexRange chunk_bounds = chunk_mask.bounds();
+      if (chunk_bounds.size() > 2 * chunk.size()) {
+        /* Buffers for the entire range of a sparse chunk would be much larger than the chunk. */
+        evaluate_procedure_compressed(
+            executor, chunk_mask, inputs, output_spans, streamed_outputs);
+        continue;
+      }
+      const int64_t offset = chunk_bounds.start();
+      IndexMaskMemory memory;
+      const IndexMask shifted_mask = mask.slice_and_shift(chunk, -offset, memory);
+
+      mf::ParamsBuilder params{executor, &shifted_mask};
+      mf::ContextBuilder context;
+      for (const GVArray &varray : inputs) {
+        params.add_readonly_single_input(varray.slice(chunk_bounds));
+      }
+
+      LinearAllocator<> allocator;
+      Array<void *> buffers(output_spans.size(), nullptr);
+      for (const int i : output_spans.index_range()) {
+        if (!streamed_outputs[i]) {
+          params.add_uninitialized_single_output(output_spans[i].slice(chunk_bounds));
+          continue;
+        }
+        const CPPType &type = streamed_outputs[i].type();
+        buffers[i] = allocator.allocate_array(type, chunk_bounds.size());
+        params.add_uninitialized_single_output({type, buffers[i], chunk_bounds.size()});
+      }
+
+      executor.call(shifted_mask, params, context);
+
+      for (const int i : output_spans.index_range()) {
+        if (!streamed_outputs[i]) {
+          continue;
+        }
+        GVMutableArray dst_varray = streamed_outputs[i];
+        const CPPType &type = dst_varray.type();
+        shifted_mask.foreach_index([&](const int64_t index) {
+          void *value = POINTER_OFFSET(buffers[i], type.size * index);
+          dst_varray.set_by_relocate(index + offset, value);
+        });
+      }
+    }
+  });
+}
+
 Vector<GVArray> evaluate_fields(ResourceScope &scope,
                                 Span<GFieldRef> fields_to_evaluate,
                                 const IndexMask &mask,
@@ -373,14 +496,8 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
         procedure, scope, field_tree_info, varying_fields_to_evaluate);
     mf::ProcedureExecutor procedure_executor{procedure};
 
-    mf::ParamsBuilder mf_params{procedure_executor, &mask};
-    mf::ContextBuilder mf_context;
-
-    /* Provide inputs to the procedure executor. */
-    for (const GVArray &varray : field_context_inputs) {
-      mf_params.add_readonly_single_input(varray);
-    }
-
+    Array<GMutableSpan> output_spans(varying_fields_to_evaluate.size());
+    Array<GVMutableArray> streamed_outputs(varying_fields_to_evaluate.size());
     for (const int i : varying_fields_to_evaluate.index_range()) {
       const GFieldRef &field = varying_fields_to_evaluate[i];
       const CPPType &type = field.cpp_type();
@@ -388,10 +505,9 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
 
       /* Try to get an existing virtual array that the result should be written into. */
       GVMutableArray dst_varray = get_dst_varray(out_index);
-      void *buffer;
-      if (!dst_varray || !dst_varray.is_span()) {
+      if (!dst_varray) {
         /* Allocate a new buffer for the computed result. */
-        buffer = scope.allocator().allocate_array(type, array_size);
+        void *buffer = scope.allocator().allocate_array(type, array_size);
 
         if (!type.is_trivially_destructible) {
           /* Destruct values in the end. */
@@ -399,22 +515,46 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
               [buffer, mask, &type]() { type.destruct_indices(buffer, mask); });
         }
 
-        r_varrays[out_index] = GVArray::ForSpan({type, buffer, array_size});
+        output_spans[i] = GMutableSpan{type, buffer, array_size};
+        r_varrays[out_index] = GVArray::ForSpan(output_spans[i]);
       }
-      else {
+      else if (dst_varray.is_span()) {
         /* Write the result into the existing span. */
-        buffer = dst_varray.get_internal_span().data();
-
+        output_spans[i] = dst_varray.get_internal_span().take_front(array_size);
         r_varrays[out_index] = dst_varray;
         is_output_written_to_dst[out_index] = true;
       }
+      else {
+        /* Move the result into the destination in chunks, so that it does not have to be stored
+         * for the entire mask first. */
+        streamed_outputs[i] = dst_varray;
+        r_varrays[out_index] = dst_varray;
+        is_output_written_to_dst[out_index] = true;
+      }
+    }
 
-      /* Pass output buffer to the procedure executor. */
-      const GMutableSpan span{type, buffer, array_size};
-      mf_params.add_uninitialized_single_output(span);
+    if (std::any_of(streamed_outputs.begin(),
+                    streamed_outputs.end(),
+                    [](const GVMutableArray &varray) { return bool(varray); }))
+    {
+      evaluate_procedure_with_streamed_outputs(
+          procedure_executor, mask, field_context_inputs, output_spans, streamed_outputs);
     }
+    else {
+      mf::ParamsBuilder mf_params{procedure_executor, &mask};
+      mf::ContextBuilder mf_context;
+
+      /* Provide inputs to the procedure executor. */
+      for (const GVArray &varray : field_context_inputs) {
+        mf_params.add_readonly_single_input(varray);
+      }
+      /* Pass output buffers to the procedure executor. */
+      for (const GMutableSpan &span : output_spans) {
+        mf_params.add_uninitialized_single_output(span);
+      }
 
-    procedure_executor.call_auto(mask, mf_params, mf_context);
+      procedure_executor.call_auto(mask, mf_params, mf_context);
+    }
   }
 
   /* Evaluate constant fields if necessary. */
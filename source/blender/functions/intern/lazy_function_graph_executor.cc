@@ -39,6 +39,13 @@
  * When all tasks are completed, the executor gives back control to the caller which may later
  * provide new inputs to the graph which in turn leads to new nodes being scheduled and the process
  * starts again.
+ *
+ * Many graphs are made up of nodes that always need all their inputs, e.g. small node groups that
+ * only do some math. For those, the dynamic scheduling above is mostly overhead. When all inputs
+ * of the graph are available right away and no node has side effects, such graphs are executed
+ * in a precomputed order instead, with the values of all sockets stored in a single buffer (see
+ * #GraphExecutor::EagerSchedule). Since that order is executed on a single thread, larger graphs
+ * only use it when the caller doesn't allow multi-threading.
  */
 
 #include <atomic>
@@ -213,6 +220,78 @@ struct LockedNode {
 class Executor;
 class GraphExecutorLFParams;
 
+/**
+ * Parameters for a node that is executed as part of the eager schedule. All inputs are available
+ * and the values of all sockets are stored in one buffer.
+ */
+class EagerGraphExecutorLFParams final : public Params {
+ private:
+  Params &graph_params_;
+  char *buffer_;
+  bool *output_flags_;
+  Span<int> input_offsets_;
+  Span<int> output_offsets_;
+  Span<bool> output_is_used_;
+
+ public:
+  EagerGraphExecutorLFParams(const LazyFunction &fn,
+                             Params &graph_params,
+                             char *buffer,
+                             bool *output_flags,
+                             const Span<int> input_offsets,
+                             const Span<int> output_offsets,
+                             const Span<bool> output_is_used)
+      : Params(fn, false),
+        graph_params_(graph_params),
+        buffer_(buffer),
+        output_flags_(output_flags),
+        input_offsets_(input_offsets),
+        output_offsets_(output_offsets),
+        output_is_used_(output_is_used)
+  {
+  }
+
+ private:
+  void *try_get_input_data_ptr_impl(const int index) const override
+  {
+    return buffer_ + input_offsets_[index];
+  }
+
+  void *try_get_input_data_ptr_or_request_impl(const int index) override
+  {
+    return buffer_ + input_offsets_[index];
+  }
+
+  void *get_output_data_ptr_impl(const int index) override
+  {
+    return buffer_ + output_offsets_[index];
+  }
+
+  void output_set_impl(const int index) override
+  {
+    output_flags_[index] = true;
+  }
+
+  bool output_was_set_impl(const int index) const override
+  {
+    return output_flags_[index];
+  }
+
+  ValueUsage get_output_usage_impl(const int index) const override
+  {
+    return output_is_used_[index] ? ValueUsage::Used : ValueUsage::Unused;
+  }
+
+  void set_input_unused_impl(const int /*index*/) override {}
+
+  bool try_enable_multi_threading_impl() override
+  {
+    /* Nodes only access their own sockets in the buffer, so they can do that from multiple
+     * threads if the caller of the graph allows it. */
+    return graph_params_.try_enable_multi_threading();
+  }
+};
+
 /**
  * Keeps track of nodes that are currently scheduled on a thread. A node can only be scheduled by
  * one thread at the same time.
@@ -326,6 +405,11 @@ class Executor {
    * Set to false when the first execution ends.
    */
   bool is_first_execution_ = true;
+  /**
+   * Set to true when the graph has been executed using the eager schedule. All outputs have been
+   * computed then.
+   */
+  bool executed_eagerly_ = false;
 
   friend GraphExecutorLFParams;
 
@@ -366,6 +450,9 @@ class Executor {
    */
   void execute(Params &params, const Context &context)
   {
+    if (executed_eagerly_) {
+      return;
+    }
     params_ = &params;
     context_ = &context;
 #ifdef FN_LAZY_FUNCTION_DEBUG_THREADS
@@ -386,6 +473,17 @@ class Executor {
 
     CurrentTask current_task;
     if (is_first_execution_) {
+      Vector<const FunctionNode *> side_effect_nodes;
+      if (self_.side_effect_provider_ != nullptr) {
+        side_effect_nodes = self_.side_effect_provider_->get_nodes_with_side_effects(context);
+      }
+      if (side_effect_nodes.is_empty() && self_.eager_schedule_.has_value()) {
+        if (this->try_execute_eagerly(local_data)) {
+          executed_eagerly_ = true;
+          return;
+        }
+      }
+
       /* Allocate a single large buffer instead of making many smaller allocations below. */
       char *buffer = static_cast<char *>(
           local_data.allocator->allocate(self_.init_buffer_info_.total_size, alignof(void *)));
@@ -401,16 +499,12 @@ class Executor {
       this->set_always_unused_graph_inputs();
       this->set_defaulted_graph_outputs(local_data);
 
-      /* Retrieve and tag side effect nodes. */
-      Vector<const FunctionNode *> side_effect_nodes;
-      if (self_.side_effect_provider_ != nullptr) {
-        side_effect_nodes = self_.side_effect_provider_->get_nodes_with_side_effects(context);
-        for (const FunctionNode *node : side_effect_nodes) {
-          BLI_assert(self_.graph_.nodes().contains(node));
-          const int node_index = node->index_in_graph();
-          NodeState &node_state = *node_states_[node_index];
-          node_state.has_side_effects = true;
-        }
+      /* Tag side effect nodes. */
+      for (const FunctionNode *node : side_effect_nodes) {
+        BLI_assert(self_.graph_.nodes().contains(node));
+        const int node_index = node->index_in_graph();
+        NodeState &node_state = *node_states_[node_index];
+        node_state.has_side_effects = true;
       }
 
       this->initialize_static_value_usages(side_effect_nodes);
@@ -428,6 +522,218 @@ class Executor {
   }
 
  private:
+  /**
+   * Execute every node of the eager schedule once.
+   * \return False if the graph can't be executed eagerly, because not all graph inputs are
+   * available yet or some outputs are not used. Nothing has been computed then.
+   */
+  bool try_execute_eagerly(const LocalData &local_data)
+  {
+    const GraphExecutor::EagerSchedule &schedule = *self_.eager_schedule_;
+    for (const int graph_output_index : self_.graph_outputs_.index_range()) {
+      if (params_->get_output_usage(graph_output_index) != ValueUsage::Used) {
+        /* Avoid requesting inputs and computing values that the caller doesn't need. */
+        return false;
+      }
+    }
+    if (schedule.nodes.size() > GraphExecutor::EagerSchedule::max_nodes_with_multi_threading &&
+        this->try_enable_multi_threading())
+    {
+      return false;
+    }
+    Array<void *, 16> graph_input_values(self_.graph_inputs_.size(), nullptr);
+    bool all_inputs_available = true;
+    for (const int graph_input_index : schedule.used_graph_inputs) {
+      /* Request all inputs at once, so that the caller can compute them together. */
+      void *value = params_->try_get_input_data_ptr_or_request(graph_input_index);
+      graph_input_values[graph_input_index] = value;
+      all_inputs_available &= value != nullptr;
+    }
+    if (!all_inputs_available) {
+      return false;
+    }
+
+    for (const int graph_input_index : self_.graph_inputs_.index_range()) {
+      if (graph_input_values[graph_input_index] == nullptr) {
+        params_->set_input_unused(graph_input_index);
+      }
+    }
+    this->set_defaulted_graph_outputs(local_data);
+
+    LinearAllocator<> &allocator = *local_data.allocator;
+    char *buffer = static_cast<char *>(
+        allocator.allocate(schedule.buffer_size, schedule.buffer_alignment));
+    bool *output_flags = reinterpret_cast<bool *>(buffer + schedule.output_flags_offset);
+    const Context local_context{
+        context_->storage, context_->user_data, local_data.local_user_data};
+
+    for (const int graph_input_index : schedule.used_graph_inputs) {
+      const OutputSocket &socket = *self_.graph_inputs_[graph_input_index];
+      this->forward_value_eagerly(socket,
+                                  {socket.type(), graph_input_values[graph_input_index]},
+                                  false,
+                                  buffer,
+                                  local_context);
+    }
+
+    for (const int schedule_index : schedule.nodes.index_range()) {
+      const FunctionNode &node = *schedule.nodes[schedule_index];
+      const LazyFunction &fn = node.function();
+      const int inputs_num = node.inputs().size();
+      const int outputs_num = node.outputs().size();
+      const IndexRange input_sockets(schedule.sockets_start[schedule_index], inputs_num);
+      const IndexRange output_sockets(input_sockets.one_after_last(), outputs_num);
+
+      /* Load unlinked inputs. */
+      for (const int input_index : IndexRange(inputs_num)) {
+        const InputSocket &input_socket = node.input(input_index);
+        if (input_socket.origin() != nullptr) {
+          continue;
+        }
+        const CPPType &type = input_socket.type();
+        const void *default_value = input_socket.default_value();
+        BLI_assert(default_value != nullptr);
+        if (self_.logger_ != nullptr) {
+          self_.logger_->log_socket_value(input_socket, {type, default_value}, local_context);
+        }
+        type.copy_construct(default_value,
+                            buffer + schedule.value_offsets[input_sockets[input_index]]);
+      }
+
+      bool *node_output_flags = output_flags + output_sockets.start();
+      std::fill_n(node_output_flags, outputs_num, false);
+      const Span<int> value_offsets = schedule.value_offsets;
+      const Span<bool> output_is_used = schedule.output_is_used;
+      EagerGraphExecutorLFParams node_params{fn,
+                                             *params_,
+                                             buffer,
+                                             node_output_flags,
+                                             value_offsets.slice(input_sockets),
+                                             value_offsets.slice(output_sockets),
+                                             output_is_used.slice(output_sockets)};
+      void *storage = fn.init_storage(allocator);
+      const Context fn_context{storage, context_->user_data, local_data.local_user_data};
+      if (self_.logger_ != nullptr) {
+        self_.logger_->log_before_node_execute(node, node_params, fn_context);
+      }
+      if (self_.node_execute_wrapper_) {
+        self_.node_execute_wrapper_->execute_node(node, node_params, fn_context);
+      }
+      else {
+        fn.execute(node_params, fn_context);
+      }
+      if (self_.logger_ != nullptr) {
+        self_.logger_->log_after_node_execute(node, node_params, fn_context);
+      }
+      if (storage != nullptr) {
+        fn.destruct_storage(storage);
+      }
+
+      for (const int input_index : IndexRange(inputs_num)) {
+        const CPPType &type = node.input(input_index).type();
+        type.destruct(buffer + schedule.value_offsets[input_sockets[input_index]]);
+      }
+      this->handle_missing_eager_outputs(node, output_sockets, buffer, local_context);
+      for (const int output_index : IndexRange(outputs_num)) {
+        const int socket_index = output_sockets[output_index];
+        if (!output_flags[socket_index]) {
+          continue;
+        }
+        const OutputSocket &output_socket = node.output(output_index);
+        this->forward_value_eagerly(
+            output_socket,
+            {output_socket.type(), buffer + schedule.value_offsets[socket_index]},
+            true,
+            buffer,
+            local_context);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * A node is expected to compute all used outputs when all its inputs are available. Fill in
+   * default values if it didn't, because linked inputs have to be initialized.
+   */
+  void handle_missing_eager_outputs(const FunctionNode &node,
+                                    const IndexRange output_sockets,
+                                    char *buffer,
+                                    const Context &local_context)
+  {
+    const GraphExecutor::EagerSchedule &schedule = *self_.eager_schedule_;
+    bool *output_flags = reinterpret_cast<bool *>(buffer + schedule.output_flags_offset);
+    Vector<const OutputSocket *> missing_outputs;
+    for (const int output_index : output_sockets.index_range()) {
+      const int socket_index = output_sockets[output_index];
+      if (schedule.output_is_used[socket_index] && !output_flags[socket_index]) {
+        const OutputSocket &output_socket = node.output(output_index);
+        output_socket.type().value_initialize(buffer + schedule.value_offsets[socket_index]);
+        output_flags[socket_index] = true;
+        missing_outputs.append(&output_socket);
+      }
+    }
+    if (!missing_outputs.is_empty()) {
+      if (self_.logger_ != nullptr) {
+        self_.logger_->dump_when_outputs_are_missing(node, missing_outputs, local_context);
+      }
+      BLI_assert_unreachable();
+    }
+  }
+
+  /**
+   * Copy the value to all linked inputs that are evaluated. If the value is owned, it is moved
+   * into the last target and destructed otherwise.
+   */
+  void forward_value_eagerly(const OutputSocket &from_socket,
+                             GMutablePointer value_to_forward,
+                             const bool value_is_owned,
+                             char *buffer,
+                             const Context &local_context)
+  {
+    const GraphExecutor::EagerSchedule &schedule = *self_.eager_schedule_;
+    const CPPType &type = *value_to_forward.type();
+    if (self_.logger_ != nullptr) {
+      self_.logger_->log_socket_value(from_socket, value_to_forward, local_context);
+    }
+    const Span<const InputSocket *> targets = from_socket.targets();
+    for (const int i : targets.index_range()) {
+      const InputSocket &target_socket = *targets[i];
+      const Node &target_node = target_socket.node();
+      void *dst_buffer = nullptr;
+      if (target_node.is_interface()) {
+        const int graph_output_index =
+            self_.graph_output_index_by_socket_index_[target_socket.index()];
+        if (graph_output_index == -1) {
+          continue;
+        }
+        dst_buffer = params_->get_output_data_ptr(graph_output_index);
+      }
+      else {
+        const int schedule_index = schedule.schedule_index_by_node[target_node.index_in_graph()];
+        if (schedule_index == -1) {
+          continue;
+        }
+        const int socket_index = schedule.sockets_start[schedule_index] + target_socket.index();
+        dst_buffer = buffer + schedule.value_offsets[socket_index];
+      }
+      if (self_.logger_ != nullptr) {
+        self_.logger_->log_socket_value(target_socket, value_to_forward, local_context);
+      }
+      if (i == targets.size() - 1) {
+        type.move_construct(value_to_forward.get(), dst_buffer);
+      }
+      else {
+        type.copy_construct(value_to_forward.get(), dst_buffer);
+      }
+      if (target_node.is_interface()) {
+        params_->output_set(self_.graph_output_index_by_socket_index_[target_socket.index()]);
+      }
+    }
+    if (value_is_owned) {
+      type.destruct(value_to_forward.get());
+    }
+  }
+
   void initialize_node_states(char *buffer)
   {
     Span<const Node *> nodes = self_.graph_.nodes();
@@ -1529,6 +1835,143 @@ GraphExecutor::GraphExecutor(const Graph &graph,
   }
 
   init_buffer_info_.total_size = offset;
+
+  this->build_eager_schedule();
+}
+
+void GraphExecutor::build_eager_schedule()
+{
+  const Span<const Node *> nodes = graph_.nodes();
+  BLI_assert(graph_.node_indices_are_valid());
+
+  enum class VisitState : uint8_t { NotVisited, InProgress, Visited };
+  Array<VisitState> visit_states(nodes.size(), VisitState::NotVisited);
+  Array<bool> graph_input_is_used(graph_inputs_.size(), false);
+  Vector<const FunctionNode *> sorted_nodes;
+
+  struct StackItem {
+    const FunctionNode *node;
+    int next_input_index;
+  };
+  Vector<StackItem> stack;
+
+  /* Returns false if the graph can't be executed eagerly because of the linked node. */
+  auto visit_origin = [&](const OutputSocket *origin) {
+    if (origin == nullptr) {
+      return true;
+    }
+    const Node &node = origin->node();
+    if (node.is_interface()) {
+      const int graph_input_index = graph_input_index_by_socket_index_[origin->index()];
+      if (graph_input_index == -1) {
+        return false;
+      }
+      graph_input_is_used[graph_input_index] = true;
+      return true;
+    }
+    switch (visit_states[node.index_in_graph()]) {
+      case VisitState::Visited:
+        return true;
+      case VisitState::InProgress:
+        /* Cycles are only allowed when the nodes don't need all their inputs. */
+        return false;
+      case VisitState::NotVisited:
+        break;
+    }
+    const FunctionNode &function_node = static_cast<const FunctionNode &>(node);
+    const LazyFunction &fn = function_node.function();
+    if (fn.allow_missing_requested_inputs()) {
+      return false;
+    }
+    for (const Input &input : fn.inputs()) {
+      if (input.usage != ValueUsage::Used) {
+        return false;
+      }
+    }
+    visit_states[node.index_in_graph()] = VisitState::InProgress;
+    stack.append({&function_node, 0});
+    return true;
+  };
+
+  /* Depth-first search that adds nodes after all the nodes they depend on. */
+  for (const InputSocket *graph_output : graph_outputs_) {
+    if (!visit_origin(graph_output->origin())) {
+      return;
+    }
+    while (!stack.is_empty()) {
+      StackItem &item = stack.last();
+      const FunctionNode &node = *item.node;
+      if (item.next_input_index < node.inputs().size()) {
+        const InputSocket &input_socket = node.input(item.next_input_index);
+        item.next_input_index++;
+        if (!visit_origin(input_socket.origin())) {
+          return;
+        }
+        continue;
+      }
+      visit_states[node.index_in_graph()] = VisitState::Visited;
+      sorted_nodes.append(&node);
+      stack.pop_last();
+    }
+  }
+
+  EagerSchedule &schedule = eager_schedule_.emplace();
+  schedule.nodes = std::move(sorted_nodes);
+  schedule.schedule_index_by_node.reinitialize(nodes.size());
+  schedule.schedule_index_by_node.fill(-1);
+  schedule.sockets_start.reinitialize(schedule.nodes.size());
+  int sockets_num = 0;
+  for (const int schedule_index : schedule.nodes.index_range()) {
+    const FunctionNode &node = *schedule.nodes[schedule_index];
+    schedule.schedule_index_by_node[node.index_in_graph()] = schedule_index;
+    schedule.sockets_start[schedule_index] = sockets_num;
+    sockets_num += node.inputs().size() + node.outputs().size();
+  }
+
+  schedule.value_offsets.reinitialize(sockets_num);
+  schedule.output_is_used.reinitialize(sockets_num);
+  schedule.output_is_used.fill(false);
+  int offset = 0;
+  int alignment = 1;
+  auto add_value = [&](const CPPType &type) {
+    offset = (offset + type.alignment - 1) / type.alignment * type.alignment;
+    const int value_offset = offset;
+    offset += type.size;
+    alignment = std::max<int>(alignment, type.alignment);
+    return value_offset;
+  };
+  for (const int schedule_index : schedule.nodes.index_range()) {
+    const FunctionNode &node = *schedule.nodes[schedule_index];
+    int socket_index = schedule.sockets_start[schedule_index];
+    for (const InputSocket *input_socket : node.inputs()) {
+      schedule.value_offsets[socket_index] = add_value(input_socket->type());
+      socket_index++;
+    }
+    for (const OutputSocket *output_socket : node.outputs()) {
+      schedule.value_offsets[socket_index] = add_value(output_socket->type());
+      for (const InputSocket *target_socket : output_socket->targets()) {
+        const Node &target_node = target_socket->node();
+        if (target_node.is_interface() ?
+                graph_output_index_by_socket_index_[target_socket->index()] != -1 :
+                schedule.schedule_index_by_node[target_node.index_in_graph()] != -1)
+        {
+          schedule.output_is_used[socket_index] = true;
+          break;
+        }
+      }
+      socket_index++;
+    }
+  }
+  schedule.output_flags_offset = offset;
+  offset += sizeof(bool) * sockets_num;
+
+  schedule.buffer_size = offset;
+  schedule.buffer_alignment = alignment;
+  for (const int graph_input_index : graph_input_is_used.index_range()) {
+    if (graph_input_is_used[graph_input_index]) {
+      schedule.used_graph_inputs.append(graph_input_index);
+    }
+  }
 }
 
 void GraphExecutor::execute_impl(Params &params, const Context &context) const
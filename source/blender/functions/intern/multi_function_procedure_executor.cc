@@ -8,17 +8,6 @@
 
 namespace blender::fn::multi_function {
 
-ProcedureExecutor::ProcedureExecutor(const Procedure &procedure) : procedure_(procedure)
-{
-  SignatureBuilder builder("Procedure Executor", signature_);
-
-  for (const ConstParameter &param : procedure.params()) {
-    builder.add("Parameter", ParamType(param.type, param.variable->data_type()));
-  }
-
-  this->set_signature(&signature_);
-}
-
 using IndicesSplitVectors = std::array<Vector<int64_t>, 2>;
 
 namespace {
@@ -119,16 +108,23 @@ class VariableState;
  * manages the reuse of buffers to improve performance.
  */
 class ValueAllocator : NonCopyable, NonMovable {
- private:
+ public:
   /**
    * Allocate with 64 byte alignment for better reusability of buffers and improved cache
    * performance.
    */
   static constexpr int min_alignment = 64;
 
+ private:
   /** All buffers in the free-lists below have been allocated with this allocator. */
   LinearAllocator<> &linear_allocator_;
 
+  /**
+   * Number of elements that every span buffer has space for. Using the same size for all buffers
+   * allows reusing them when the allocator is used for multiple masks of different sizes.
+   */
+  int64_t span_buffer_size_;
+
   /**
    * Use stacks so that the most recently used buffers are reused first. This improves cache
    * efficiency.
@@ -149,7 +145,15 @@ class ValueAllocator : NonCopyable, NonMovable {
   Map<const CPPType *, Stack<void *>> single_value_free_lists_;
 
  public:
-  ValueAllocator(LinearAllocator<> &linear_allocator) : linear_allocator_(linear_allocator) {}
+  ValueAllocator(LinearAllocator<> &linear_allocator, const int64_t span_buffer_size)
+      : linear_allocator_(linear_allocator), span_buffer_size_(span_buffer_size)
+  {
+  }
+
+  int64_t span_buffer_size() const
+  {
+    return span_buffer_size_;
+  }
 
   VariableValue_GVArray *obtain_GVArray(const GVArray &varray)
   {
@@ -168,6 +172,7 @@ class ValueAllocator : NonCopyable, NonMovable {
 
   VariableValue_Span *obtain_Span(const CPPType &type, int size)
   {
+    BLI_assert(size <= span_buffer_size_);
     void *buffer = nullptr;
 
     const int64_t element_size = type.size;
@@ -184,7 +189,8 @@ class ValueAllocator : NonCopyable, NonMovable {
                                  span_buffers_free_lists_.lookup_ptr(element_size);
       if (stack == nullptr || stack->is_empty()) {
         buffer = linear_allocator_.allocate(
-            std::max<int64_t>(element_size, small_value_max_size) * size, min_alignment);
+            std::max<int64_t>(element_size, small_value_max_size) * span_buffer_size_,
+            min_alignment);
       }
       else {
         /* Reuse existing buffer. */
@@ -813,17 +819,17 @@ class VariableState : NonCopyable, NonMovable {
 /** Keeps track of the states of all variables during evaluation. */
 class VariableStates {
  private:
-  ValueAllocator value_allocator_;
+  ValueAllocator &value_allocator_;
   const Procedure &procedure_;
   /** The state of every variable, indexed by #Variable::index_in_procedure(). */
   Array<VariableState> variable_states_;
   const IndexMask &full_mask_;
 
  public:
-  VariableStates(LinearAllocator<> &linear_allocator,
+  VariableStates(ValueAllocator &value_allocator,
                  const Procedure &procedure,
                  const IndexMask &full_mask)
-      : value_allocator_(linear_allocator),
+      : value_allocator_(value_allocator),
         procedure_(procedure),
         variable_states_(procedure.variables().size()),
         full_mask_(full_mask)
@@ -1157,19 +1163,18 @@ class InstructionScheduler {
   }
 };
 
-void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context context) const
+static void execute_procedure(const ProcedureExecutor &fn,
+                              const Procedure &procedure,
+                              const IndexMask &full_mask,
+                              Params &params,
+                              const Context &context,
+                              ValueAllocator &value_allocator)
 {
-  BLI_assert(procedure_.validate());
-
-  AlignedBuffer<512, 64> local_buffer;
-  LinearAllocator<> linear_allocator;
-  linear_allocator.provide_buffer(local_buffer);
-
-  VariableStates variable_states{linear_allocator, procedure_, full_mask};
-  variable_states.add_initial_variable_states(*this, procedure_, params);
+  VariableStates variable_states{value_allocator, procedure, full_mask};
+  variable_states.add_initial_variable_states(fn, procedure, params);
 
   InstructionScheduler scheduler;
-  scheduler.add_referenced_indices(*procedure_.entry(), full_mask);
+  scheduler.add_referenced_indices(*procedure.entry(), full_mask);
 
   /* Loop until all indices got to a return instruction. */
   while (!scheduler.is_done()) {
@@ -1218,9 +1223,9 @@ void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context
     }
   }
 
-  for (const int param_index : this->param_indices()) {
-    const ParamType param_type = this->param_type(param_index);
-    const Variable *variable = procedure_.params()[param_index].variable;
+  for (const int param_index : fn.param_indices()) {
+    const ParamType param_type = fn.param_type(param_index);
+    const Variable *variable = procedure.params()[param_index].variable;
     VariableState &variable_state = variable_states.get_variable_state(*variable);
     switch (param_type.interface_type()) {
       case ParamType::Input: {
@@ -1241,6 +1246,76 @@ void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context
   }
 }
 
+/**
+ * Memory that is reused by consecutive calls of the same executor on one thread. This is mostly
+ * useful when the executor is called for many chunks of a large mask (see
+ * #MultiFunction::call_auto), because then buffers for intermediate values don't have to be
+ * allocated again for every chunk.
+ */
+class ProcedureExecutor::ThreadScratch : blender::NonCopyable, blender::NonMovable {
+ public:
+  LinearAllocator<> linear_allocator;
+  ValueAllocator value_allocator;
+  bool in_use = false;
+
+  ThreadScratch(const int64_t span_buffer_size)
+      : value_allocator(linear_allocator, span_buffer_size)
+  {
+  }
+};
+
+ProcedureExecutor::ProcedureExecutor(const Procedure &procedure) : procedure_(procedure)
+{
+  SignatureBuilder builder("Procedure Executor", signature_);
+
+  for (const ConstParameter &param : procedure.params()) {
+    builder.add("Parameter", ParamType(param.type, param.variable->data_type()));
+  }
+
+  this->set_signature(&signature_);
+
+  for (const Variable *variable : procedure.variables()) {
+    if (variable->data_type().is_single() &&
+        variable->data_type().single_type().alignment > ValueAllocator::min_alignment)
+    {
+      /* Buffers for these types are not reused, so they would accumulate in the scratch memory. */
+      use_thread_scratch_ = false;
+    }
+  }
+}
+
+ProcedureExecutor::~ProcedureExecutor() = default;
+
+void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context context) const
+{
+  BLI_assert(procedure_.validate());
+
+  const int64_t array_size = full_mask.min_array_size();
+  /* Small masks are evaluated with a buffer on the stack, which is cheaper than looking up the
+   * thread local memory. Very large masks are not split into chunks, so their buffers are not
+   * kept around. */
+  if (use_thread_scratch_ && array_size >= 1024 && array_size <= (1 << 16)) {
+    std::unique_ptr<ThreadScratch> &scratch = thread_scratch_.local();
+    /* The scratch memory can't be used when this is a nested call on the same thread, e.g. when
+     * the thread started working on another task while waiting. */
+    if (!scratch || !scratch->in_use) {
+      if (!scratch || scratch->value_allocator.span_buffer_size() < array_size) {
+        scratch = std::make_unique<ThreadScratch>(array_size);
+      }
+      scratch->in_use = true;
+      execute_procedure(*this, procedure_, full_mask, params, context, scratch->value_allocator);
+      scratch->in_use = false;
+      return;
+    }
+  }
+
+  AlignedBuffer<512, 64> local_buffer;
+  LinearAllocator<> linear_allocator;
+  linear_allocator.provide_buffer(local_buffer);
+  ValueAllocator value_allocator{linear_allocator, array_size};
+  execute_procedure(*this, procedure_, full_mask, params, context, value_allocator);
+}
+
 MultiFunction::ExecutionHints ProcedureExecutor::get_execution_hints() const
 {
   ExecutionHints hints;
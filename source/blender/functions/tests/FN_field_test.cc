@@ -5,6 +5,7 @@
 #include "testing/testing.h"
 
 #include "BLI_cpp_type.hh"
+#include "BLI_math_vector_types.hh"
 #include "FN_field.hh"
 #include "FN_multi_function_builder.hh"
 #include "FN_multi_function_test_common.hh"
@@ -281,4 +282,67 @@ TEST(field, IgnoredOutput)
   EXPECT_EQ(results.get(3), 5);
 }
 
+static int get_first(const int2 &value)
+{
+  return value[0];
+}
+
+static void set_first(int2 &value, const int new_value)
+{
+  value[0] = new_value;
+}
+
+TEST(field, VirtualDestinationLargeMask)
+{
+  GField index_field{std::make_shared<IndexFieldInput>()};
+  auto add_fn = mf::build::SI2_SO<int, int, int>("add", [](int a, int b) { return a + b; });
+  Field<int> output_field{FieldOperation::Create(add_fn, {index_field, index_field}), 0};
+
+  /* Large enough to be evaluated in multiple chunks. */
+  const int size = 100'000;
+  Array<int2> result(size, int2(-1));
+  IndexMaskMemory memory;
+  const IndexMask mask = IndexMask::from_predicate(
+      IndexRange(size), GrainSize(4096), memory, [](const int64_t i) { return i % 3 != 0; });
+
+  FieldContext context;
+  FieldEvaluator evaluator{context, &mask};
+  evaluator.add_with_destination(
+      output_field, VMutableArray<int>::ForDerivedSpan<int2, get_first, set_first>(result));
+  evaluator.evaluate();
+  for (const int i : IndexRange(size)) {
+    EXPECT_EQ(result[i][0], (i % 3 != 0) ? i * 2 : -1);
+    EXPECT_EQ(result[i][1], -1);
+  }
+}
+
+TEST(field, VirtualDestinationSparseMask)
+{
+  GField index_field{std::make_shared<IndexFieldInput>()};
+  auto add_fn = mf::build::SI2_SO<int, int, int>("add", [](int a, int b) { return a + b; });
+  Field<int> output_field{FieldOperation::Create(add_fn, {index_field, index_field}), 0};
+  auto negate_fn = mf::build::SI1_SO<int, int>("negate", [](int a) { return -a; });
+  Field<int> negated_field{FieldOperation::Create(negate_fn, {index_field}), 0};
+
+  /* The indices of every chunk are spread over a much larger range. */
+  const int size = 2'000'000;
+  Array<int2> result(size, int2(-1));
+  IndexMaskMemory memory;
+  const IndexMask mask = IndexMask::from_predicate(
+      IndexRange(size), GrainSize(4096), memory, [](const int64_t i) { return i % 100 == 0; });
+
+  FieldContext context;
+  FieldEvaluator evaluator{context, &mask};
+  evaluator.add_with_destination(
+      output_field, VMutableArray<int>::ForDerivedSpan<int2, get_first, set_first>(result));
+  const int negated_index = evaluator.add(negated_field);
+  evaluator.evaluate();
+  const VArray<int> negated = evaluator.get_evaluated<int>(negated_index);
+  for (const int i : IndexRange(size)) {
+    EXPECT_EQ(result[i][0], (i % 100 == 0) ? i * 2 : -1);
+    EXPECT_EQ(result[i][1], -1);
+  }
+  mask.foreach_index([&](const int64_t i) { EXPECT_EQ(negated[i], -i); });
+}
+
 }  // namespace blender::fn::tests
@@ -8,7 +8,10 @@
 #include "FN_lazy_function_graph.hh"
 #include "FN_lazy_function_graph_executor.hh"
 
+#include "BLI_array.hh"
+#include "BLI_lazy_threading.hh"
 #include "BLI_task.h"
+#include "BLI_timeit.hh"
 
 namespace blender::fn::lazy_function::tests {
 
@@ -115,6 +118,93 @@ TEST(lazy_function, SideEffects)
   EXPECT_EQ(dst2, 105);
 }
 
+class ConcatLazyFunction : public LazyFunction {
+ public:
+  ConcatLazyFunction()
+  {
+    debug_name_ = "Concat";
+    inputs_.append({"A", CPPType::get<std::string>()});
+    inputs_.append({"B", CPPType::get<std::string>()});
+    outputs_.append({"Result", CPPType::get<std::string>()});
+  }
+
+  void execute_impl(Params &params, const Context & /*context*/) const override
+  {
+    std::string a = params.extract_input<std::string>(0);
+    const std::string &b = params.get_input<std::string>(1);
+    params.set_output(0, a + b);
+  }
+};
+
+TEST(lazy_function, EagerGraph)
+{
+  const AddLazyFunction add_fn;
+
+  Graph graph;
+  FunctionNode &add_node_1 = graph.add_function(add_fn);
+  FunctionNode &add_node_2 = graph.add_function(add_fn);
+  FunctionNode &unused_node = graph.add_function(add_fn);
+  GraphInputSocket &graph_input = graph.add_input(CPPType::get<int>());
+  GraphOutputSocket &graph_output_1 = graph.add_output(CPPType::get<int>());
+  GraphOutputSocket &graph_output_2 = graph.add_output(CPPType::get<int>());
+
+  const int value_10 = 10;
+  add_node_1.input(1).set_default_value(&value_10);
+  graph.add_link(graph_input, add_node_1.input(0));
+  graph.add_link(add_node_1.output(0), add_node_2.input(0));
+  graph.add_link(add_node_1.output(0), add_node_2.input(1));
+  graph.add_link(add_node_1.output(0), graph_output_2);
+  graph.add_link(add_node_2.output(0), graph_output_1);
+  graph.add_link(add_node_2.output(0), unused_node.input(0));
+  unused_node.input(1).set_default_value(&value_10);
+
+  graph.update_node_indices();
+
+  GraphExecutor executor_fn{graph, nullptr, nullptr, nullptr};
+  int result_1 = 0;
+  int result_2 = 0;
+  execute_lazy_function_eagerly(
+      executor_fn, nullptr, nullptr, std::make_tuple(5), std::make_tuple(&result_1, &result_2));
+
+  EXPECT_EQ(result_1, 30);
+  EXPECT_EQ(result_2, 15);
+}
+
+TEST(lazy_function, EagerGraphNonTrivialType)
+{
+  const ConcatLazyFunction concat_fn;
+
+  Graph graph;
+  FunctionNode &concat_node_1 = graph.add_function(concat_fn);
+  FunctionNode &concat_node_2 = graph.add_function(concat_fn);
+  GraphInputSocket &graph_input = graph.add_input(CPPType::get<std::string>());
+  GraphOutputSocket &graph_output_1 = graph.add_output(CPPType::get<std::string>());
+  GraphOutputSocket &graph_output_2 = graph.add_output(CPPType::get<std::string>());
+
+  graph.add_link(graph_input, concat_node_1.input(0));
+  graph.add_link(graph_input, concat_node_1.input(1));
+  graph.add_link(concat_node_1.output(0), concat_node_2.input(0));
+  graph.add_link(graph_input, concat_node_2.input(1));
+  graph.add_link(concat_node_1.output(0), graph_output_1);
+  graph.add_link(concat_node_2.output(0), graph_output_2);
+
+  graph.update_node_indices();
+
+  GraphExecutor executor_fn{graph, nullptr, nullptr, nullptr};
+  /* Use a string that is too long for the small buffer optimization. */
+  const std::string input = "a string that is long enough to be allocated ";
+  std::string result_1;
+  std::string result_2;
+  execute_lazy_function_eagerly(executor_fn,
+                                nullptr,
+                                nullptr,
+                                std::make_tuple(input),
+                                std::make_tuple(&result_1, &result_2));
+
+  EXPECT_EQ(result_1, input + input);
+  EXPECT_EQ(result_2, input + input + input);
+}
+
 class PartialEvaluationTestFunction : public LazyFunction {
  public:
   PartialEvaluationTestFunction()
@@ -178,4 +268,116 @@ TEST(lazy_function, GraphWithCycle)
   EXPECT_EQ(result, 10 * 2 * 5);
 }
 
+/**
+ * Build a graph that adds the graph input to every value and sums up the results. All nodes
+ * need all their inputs, so the graph has an eager schedule.
+ */
+static void build_sum_graph(Graph &graph, const LazyFunction &fn, const Span<int> values)
+{
+  GraphInputSocket &graph_input = graph.add_input(CPPType::get<int>());
+  GraphOutputSocket &graph_output = graph.add_output(CPPType::get<int>());
+  OutputSocket *sum = nullptr;
+  for (const int &value : values) {
+    FunctionNode &term_node = graph.add_function(fn);
+    graph.add_link(graph_input, term_node.input(0));
+    term_node.input(1).set_default_value(&value);
+    if (sum == nullptr) {
+      sum = &term_node.output(0);
+      continue;
+    }
+    FunctionNode &sum_node = graph.add_function(fn);
+    graph.add_link(*sum, sum_node.input(0));
+    graph.add_link(term_node.output(0), sum_node.input(1));
+    sum = &sum_node.output(0);
+  }
+  graph.add_link(*sum, graph_output);
+  graph.update_node_indices();
+}
+
+TEST(lazy_function, LargeEagerGraph)
+{
+  BLI_task_scheduler_init();
+  const AddLazyFunction add_fn;
+
+  /* Enough nodes that the dynamic scheduling is used when multi-threading is allowed. */
+  Array<int> values(100);
+  for (const int i : values.index_range()) {
+    values[i] = i;
+  }
+  Graph graph;
+  build_sum_graph(graph, add_fn, values);
+
+  GraphExecutor executor_fn{graph, nullptr, nullptr, nullptr};
+  int result = 0;
+  execute_lazy_function_eagerly(
+      executor_fn, nullptr, nullptr, std::make_tuple(3), std::make_tuple(&result));
+
+  EXPECT_EQ(result, 100 * 3 + 99 * 100 / 2);
+}
+
+/**
+ * Set this to 1 to activate the benchmark. It is disabled by default, because it prints a lot.
+ */
+#if 0
+/** Like #AddLazyFunction, but takes a while and tells the executor about it. */
+class SlowAddLazyFunction : public LazyFunction {
+ public:
+  SlowAddLazyFunction()
+  {
+    debug_name_ = "Slow Add";
+    inputs_.append({"A", CPPType::get<int>()});
+    inputs_.append({"B", CPPType::get<int>()});
+    outputs_.append({"Result", CPPType::get<int>()});
+  }
+
+  void execute_impl(Params &params, const Context & /*context*/) const override
+  {
+    lazy_threading::send_hint();
+    const int a = params.get_input<int>(0);
+    int b = params.get_input<int>(1);
+    for (int i = 0; i < 1000000; i++) {
+      b = (b * 31 + i) % 1000;
+    }
+    params.set_output(0, a + b);
+  }
+};
+
+static void benchmark_sum_graph(const LazyFunction &fn,
+                                const int values_num,
+                                const int iterations)
+{
+  Array<int> values(values_num, 1);
+  Graph graph;
+  build_sum_graph(graph, fn, values);
+  GraphExecutor executor_fn{graph, nullptr, nullptr, nullptr};
+
+  int result_sum = 0;
+  {
+    SCOPED_TIMER(std::string(fn.name()) + " graph with " + std::to_string(graph.nodes().size()) +
+                 " nodes, " + std::to_string(iterations) + " times");
+    for ([[maybe_unused]] const int i : IndexRange(iterations)) {
+      int result = 0;
+      execute_lazy_function_eagerly(
+          executor_fn, nullptr, nullptr, std::make_tuple(i), std::make_tuple(&result));
+      result_sum += result;
+    }
+  }
+  /* Print the value for simple error checking and to avoid some compiler optimizations. */
+  std::cout << "Result: " << result_sum << "\n";
+}
+
+TEST(lazy_function, EagerGraphBenchmark)
+{
+  BLI_task_scheduler_init();
+  const AddLazyFunction add_fn;
+  const SlowAddLazyFunction slow_add_fn;
+  /* Small graphs of cheap nodes use the eager schedule. */
+  benchmark_sum_graph(add_fn, 5, 100000);
+  benchmark_sum_graph(add_fn, 30, 10000);
+  /* Larger graphs use the dynamic scheduling, so that slow nodes run in parallel. */
+  benchmark_sum_graph(add_fn, 1000, 100);
+  benchmark_sum_graph(slow_add_fn, 100, 1);
+}
+#endif /* Benchmark */
+
 }  // namespace blender::fn::lazy_function::tests
@@ -617,20 +617,69 @@ static Vector<std::pair<int, GSpan>> prepare_attribute_fallbacks(
   return attributes_to_override;
 }
 
+template<typename T> static void append_moved(Vector<T> &dst, Vector<T> &src)
+{
+  if (dst.is_empty()) {
+    dst = std::move(src);
+    return;
+  }
+  dst.reserve(dst.size() + src.size());
+  for (T &value : src) {
+    dst.append(std::move(value));
+  }
+}
+
 /**
- * Calls #fn for every geometry in the given #InstanceReference. Also passes on the transformation
- * that is applied to every instance.
+ * Append the tasks gathered into #src to the tasks in #dst. The element offsets in #src start at
+ * zero, so they are shifted by the current offsets of #dst.
  */
-static void foreach_geometry_in_reference(
-    const InstanceReference &reference,
-    const float4x4 &base_transform,
-    const uint32_t id,
-    FunctionRef<void(const bke::GeometrySet &geometry_set, const float4x4 &transform, uint32_t id)>
-        fn)
+static void append_gathered_tasks(GatherTasksInfo &dst, GatherTasksInfo &src)
 {
-  bke::GeometrySet geometry_set;
-  reference.to_geometry_set(geometry_set);
-  fn(geometry_set, base_transform, id);
+  const GatherOffsets &offsets = dst.r_offsets;
+  for (RealizePointCloudTask &task : src.r_tasks.pointcloud_tasks) {
+    task.start_index += offsets.pointcloud_offset;
+  }
+  for (RealizeMeshTask &task : src.r_tasks.mesh_tasks) {
+    task.start_indices.vertex += offsets.mesh_offsets.vertex;
+    task.start_indices.edge += offsets.mesh_offsets.edge;
+    task.start_indices.face += offsets.mesh_offsets.face;
+    task.start_indices.loop += offsets.mesh_offsets.loop;
+  }
+  for (RealizeCurveTask &task : src.r_tasks.curve_tasks) {
+    task.start_indices.point += offsets.curves_offsets.point;
+    task.start_indices.curve += offsets.curves_offsets.curve;
+    task.start_indices.custom_knot += offsets.curves_offsets.custom_knot;
+  }
+  for (RealizeGreasePencilTask &task : src.r_tasks.grease_pencil_tasks) {
+    task.start_index += offsets.grease_pencil_layer_offset;
+  }
+  append_moved(dst.r_tasks.pointcloud_tasks, src.r_tasks.pointcloud_tasks);
+  append_moved(dst.r_tasks.mesh_tasks, src.r_tasks.mesh_tasks);
+  append_moved(dst.r_tasks.curve_tasks, src.r_tasks.curve_tasks);
+  append_moved(dst.r_tasks.grease_pencil_tasks, src.r_tasks.grease_pencil_tasks);
+  append_moved(dst.r_tasks.edit_data_tasks, src.r_tasks.edit_data_tasks);
+  if (!dst.r_tasks.first_volume) {
+    dst.r_tasks.first_volume = std::move(src.r_tasks.first_volume);
+  }
+
+  append_moved(dst.instances.attribute_fallback, src.instances.attribute_fallback);
+  append_moved(dst.instances.instances_components_to_merge,
+               src.instances.instances_components_to_merge);
+  append_moved(dst.instances.instances_components_transforms,
+               src.instances.instances_components_transforms);
+  append_moved(dst.r_temporary_arrays, src.r_temporary_arrays);
+
+  GatherOffsets &dst_offsets = dst.r_offsets;
+  const GatherOffsets &src_offsets = src.r_offsets;
+  dst_offsets.pointcloud_offset += src_offsets.pointcloud_offset;
+  dst_offsets.mesh_offsets.vertex += src_offsets.mesh_offsets.vertex;
+  dst_offsets.mesh_offsets.edge += src_offsets.mesh_offsets.edge;
+  dst_offsets.mesh_offsets.face += src_offsets.mesh_offsets.face;
+  dst_offsets.mesh_offsets.loop += src_offsets.mesh_offsets.loop;
+  dst_offsets.curves_offsets.point += src_offsets.curves_offsets.point;
+  dst_offsets.curves_offsets.curve += src_offsets.curves_offsets.curve;
+  dst_offsets.curves_offsets.custom_knot += src_offsets.curves_offsets.custom_knot;
+  dst_offsets.grease_pencil_layer_offset += src_offsets.grease_pencil_layer_offset;
 }
 
 static void gather_realize_tasks_for_instances(GatherTasksInfo &gather_info,
@@ -653,7 +702,6 @@ static void gather_realize_tasks_for_instances(GatherTasksInfo &gather_info,
   }
 
   /* Prepare attribute fallbacks. */
-  InstanceContext instance_context = base_instance_context;
   Vector<std::pair<int, GSpan>> pointcloud_attributes_to_override = prepare_attribute_fallbacks(
       gather_info, instances, gather_info.pointclouds.attributes);
   Vector<std::pair<int, GSpan>> mesh_attributes_to_override = prepare_attribute_fallbacks(
@@ -665,62 +713,105 @@ static void gather_realize_tasks_for_instances(GatherTasksInfo &gather_info,
   Vector<std::pair<int, GSpan>> instance_attributes_to_override = prepare_attribute_fallbacks(
       gather_info, instances, gather_info.instances_attriubutes);
 
+  /* Get the geometry of every reference only once instead of for every instance, because that
+   * can be expensive, e.g. for collection references. */
+  Array<bke::GeometrySet> reference_geometries(references.size());
+  threading::parallel_for(references.index_range(), 64, [&](const IndexRange range) {
+    for (const int i : range) {
+      references[i].to_geometry_set(reference_geometries[i]);
+    }
+  });
+
   const bool is_top_level = current_depth == 0;
   /* If at top level, get instance indices from selection field, else use all instances. */
   const IndexMask indices = is_top_level ? gather_info.selection :
                                            IndexMask(IndexRange(instances.instances_num()));
-  indices.foreach_index([&](const int i) {
-    /* If at top level, retrieve depth from gather_info, else continue with target_depth. */
-    const int child_target_depth = is_top_level ? gather_info.depths[i] : target_depth;
-    const int handle = handles[i];
-    const float4x4 &transform = transforms[i];
-    const InstanceReference &reference = references[handle];
-    const float4x4 new_base_transform = base_transform * transform;
 
-    /* Update attribute fallbacks for the current instance. */
-    for (const std::pair<int, GSpan> &pair : pointcloud_attributes_to_override) {
-      instance_context.pointclouds.array[pair.first] = pair.second[i];
-    }
-    for (const std::pair<int, GSpan> &pair : mesh_attributes_to_override) {
-      instance_context.meshes.array[pair.first] = pair.second[i];
-    }
-    for (const std::pair<int, GSpan> &pair : curve_attributes_to_override) {
-      instance_context.curves.array[pair.first] = pair.second[i];
-    }
-    for (const std::pair<int, GSpan> &pair : grease_pencil_attributes_to_override) {
-      instance_context.grease_pencils.array[pair.first] = pair.second[i];
-    }
-    for (const std::pair<int, GSpan> &pair : instance_attributes_to_override) {
-      instance_context.instances.array[pair.first] = pair.second[i];
-    }
+  const auto gather_for_instance =
+      [&](const int i, GatherTasksInfo &dst_gather_info, InstanceContext &instance_context) {
+        /* If at top level, retrieve depth from gather_info, else continue with target_depth. */
+        const int child_target_depth = is_top_level ? gather_info.depths[i] : target_depth;
+        const int handle = handles[i];
+        const float4x4 &transform = transforms[i];
+        const float4x4 new_base_transform = base_transform * transform;
+
+        /* Update attribute fallbacks for the current instance. */
+        for (const std::pair<int, GSpan> &pair : pointcloud_attributes_to_override) {
+          instance_context.pointclouds.array[pair.first] = pair.second[i];
+        }
+        for (const std::pair<int, GSpan> &pair : mesh_attributes_to_override) {
+          instance_context.meshes.array[pair.first] = pair.second[i];
+        }
+        for (const std::pair<int, GSpan> &pair : curve_attributes_to_override) {
+          instance_context.curves.array[pair.first] = pair.second[i];
+        }
+        for (const std::pair<int, GSpan> &pair : grease_pencil_attributes_to_override) {
+          instance_context.grease_pencils.array[pair.first] = pair.second[i];
+        }
+        for (const std::pair<int, GSpan> &pair : instance_attributes_to_override) {
+          instance_context.instances.array[pair.first] = pair.second[i];
+        }
 
-    uint32_t local_instance_id = 0;
-    if (gather_info.create_id_attribute_on_any_component) {
-      if (stored_instance_ids.is_empty()) {
-        local_instance_id = uint32_t(i);
-      }
-      else {
-        local_instance_id = uint32_t(stored_instance_ids[i]);
-      }
+        uint32_t local_instance_id = 0;
+        if (gather_info.create_id_attribute_on_any_component) {
+          if (stored_instance_ids.is_empty()) {
+            local_instance_id = uint32_t(i);
+          }
+          else {
+            local_instance_id = uint32_t(stored_instance_ids[i]);
+          }
+        }
+        instance_context.id = noise::hash(base_instance_context.id, local_instance_id);
+
+        /* Add realize tasks for all referenced geometry sets recursively. */
+        gather_realize_tasks_recursive(dst_gather_info,
+                                       current_depth + 1,
+                                       child_target_depth,
+                                       reference_geometries[handle],
+                                       new_base_transform,
+                                       instance_context);
+      };
+
+  /* Number of instances that are gathered together. This is large enough that the overhead of
+   * merging the gathered tasks is negligible. */
+  const int64_t chunk_size = 1024;
+  if (indices.size() <= chunk_size) {
+    InstanceContext instance_context = base_instance_context;
+    indices.foreach_index(
+        [&](const int i) { gather_for_instance(i, gather_info, instance_context); });
+    return;
+  }
+
+  /* With many instances, gather the tasks for chunks of instances in parallel. The tasks of every
+   * chunk are gathered separately and appended in the original order afterwards, so that the
+   * result does not depend on the multi-threading. */
+  const int64_t chunks_num = divide_ceil_ul(indices.size(), chunk_size);
+  Array<Vector<std::unique_ptr<GArray<>>>> chunk_temporary_arrays(chunks_num);
+  Array<std::unique_ptr<GatherTasksInfo>> chunk_gather_infos(chunks_num);
+  threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange range) {
+    for (const int64_t chunk_i : range) {
+      chunk_gather_infos[chunk_i] = std::make_unique<GatherTasksInfo>(
+          GatherTasksInfo{gather_info.pointclouds,
+                          gather_info.meshes,
+                          gather_info.curves,
+                          gather_info.grease_pencils,
+                          gather_info.instances_attriubutes,
+                          gather_info.create_id_attribute_on_any_component,
+                          gather_info.selection,
+                          gather_info.depths,
+                          chunk_temporary_arrays[chunk_i]});
+      GatherTasksInfo &chunk_info = *chunk_gather_infos[chunk_i];
+      InstanceContext instance_context = base_instance_context;
+      const IndexMask chunk_indices = indices.slice(
+          IndexRange::from_begin_size(chunk_i * chunk_size, chunk_size)
+              .intersect(indices.index_range()));
+      chunk_indices.foreach_index(
+          [&](const int i) { gather_for_instance(i, chunk_info, instance_context); });
     }
-    const uint32_t instance_id = noise::hash(base_instance_context.id, local_instance_id);
-
-    /* Add realize tasks for all referenced geometry sets recursively. */
-    foreach_geometry_in_reference(reference,
-                                  new_base_transform,
-                                  instance_id,
-                                  [&](const bke::GeometrySet &instance_geometry_set,
-                                      const float4x4 &transform,
-                                      const uint32_t id) {
-                                    instance_context.id = id;
-                                    gather_realize_tasks_recursive(gather_info,
-                                                                   current_depth + 1,
-                                                                   child_target_depth,
-                                                                   instance_geometry_set,
-                                                                   transform,
-                                                                   instance_context);
-                                  });
   });
+  for (std::unique_ptr<GatherTasksInfo> &chunk_info : chunk_gather_infos) {
+    append_gathered_tasks(gather_info, *chunk_info);
+  }
 }
 
 /**
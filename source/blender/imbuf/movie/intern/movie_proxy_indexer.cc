@@ -7,10 +7,16 @@
  * \ingroup imbuf
  */
 
+#include <condition_variable>
 #include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_endian_defines.h"
 #include "BLI_endian_switch.h"
 #include "BLI_fileops.h"
@@ -356,19 +362,35 @@ static void get_tc_filepath(MovieReader *anim, IMB_Timecode_Type tc, char *filep
 
 #ifdef WITH_FFMPEG
 
+/* Maximum number of decoded frames waiting to be scaled and encoded by a proxy output. Keeps
+ * decoding from running too far ahead of the slowest encoder. */
+static constexpr int64_t proxy_output_queue_max = 8;
+
 struct proxy_output_ctx {
-  AVFormatContext *of;
-  AVStream *st;
-  AVCodecContext *c;
-  const AVCodec *codec;
-  SwsContext *sws_ctx;
-  AVFrame *frame;
-  int cfra;
-  IMB_Proxy_Size proxy_size;
-  int orig_height;
-  MovieReader *anim;
+  AVFormatContext *of = nullptr;
+  AVStream *st = nullptr;
+  AVCodecContext *c = nullptr;
+  const AVCodec *codec = nullptr;
+  SwsContext *sws_ctx = nullptr;
+  AVFrame *frame = nullptr;
+  int cfra = 0;
+  IMB_Proxy_Size proxy_size = IMB_PROXY_NONE;
+  int orig_height = 0;
+  MovieReader *anim = nullptr;
+
+  /* Every proxy output scales and encodes the decoded frames on its own thread, so all proxy
+   * sizes are built in parallel, overlapping with the decoding. */
+  std::thread thread;
+  std::mutex queue_mutex;
+  std::condition_variable queue_cond;
+  std::deque<AVFrame *> queue;
+  bool queue_finished = false;
+  bool queue_cancelled = false;
 };
 
+static void add_to_proxy_output_ffmpeg(proxy_output_ctx *ctx, AVFrame *frame);
+static void proxy_output_thread_run(proxy_output_ctx *ctx);
+
 static proxy_output_ctx *alloc_proxy_output_ffmpeg(MovieReader *anim,
                                                    AVCodecContext *codec_ctx,
                                                    AVStream *st,
@@ -377,7 +399,7 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(MovieReader *anim,
                                                    int height,
                                                    int quality)
 {
-  proxy_output_ctx *rv = MEM_callocN<proxy_output_ctx>("alloc_proxy_output");
+  proxy_output_ctx *rv = MEM_new<proxy_output_ctx>("alloc_proxy_output");
 
   char filepath[FILE_MAX];
 
@@ -386,7 +408,7 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(MovieReader *anim,
 
   get_proxy_filepath(rv->anim, rv->proxy_size, filepath, true);
   if (!BLI_file_ensure_parent_dir_exists(filepath)) {
-    MEM_freeN(rv);
+    MEM_delete(rv);
     return nullptr;
   }
 
@@ -409,7 +431,7 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(MovieReader *anim,
     fprintf(stderr, "Could not build proxy '%s': failed to create video encoder\n", filepath);
     avcodec_free_context(&rv->c);
     avformat_free_context(rv->of);
-    MEM_freeN(rv);
+    MEM_delete(rv);
     return nullptr;
   }
 
@@ -483,7 +505,7 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(MovieReader *anim,
             error_str);
     avcodec_free_context(&rv->c);
     avformat_free_context(rv->of);
-    MEM_freeN(rv);
+    MEM_delete(rv);
     return nullptr;
   }
 
@@ -498,7 +520,7 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(MovieReader *anim,
             error_str);
     avcodec_free_context(&rv->c);
     avformat_free_context(rv->of);
-    MEM_freeN(rv);
+    MEM_delete(rv);
     return nullptr;
   }
 
@@ -544,10 +566,12 @@ static proxy_output_ctx *alloc_proxy_output_ffmpeg(MovieReader *anim,
 
     avcodec_free_context(&rv->c);
     avformat_free_context(rv->of);
-    MEM_freeN(rv);
+    MEM_delete(rv);
     return nullptr;
   }
 
+  rv->thread = std::thread(proxy_output_thread_run, rv);
+
   return rv;
 }
 
@@ -623,6 +647,66 @@ static void add_to_proxy_output_ffmpeg(proxy_output_ctx *ctx, AVFrame *frame)
   av_packet_free(&packet);
 }
 
+static void proxy_output_thread_run(proxy_output_ctx *ctx)
+{
+  std::unique_lock lock(ctx->queue_mutex);
+  while (true) {
+    ctx->queue_cond.wait(lock, [&]() { return !ctx->queue.empty() || ctx->queue_finished; });
+    if (ctx->queue.empty()) {
+      break;
+    }
+    AVFrame *frame = ctx->queue.front();
+    ctx->queue.pop_front();
+    const bool cancelled = ctx->queue_cancelled;
+    lock.unlock();
+    ctx->queue_cond.notify_all();
+
+    if (!cancelled) {
+      add_to_proxy_output_ffmpeg(ctx, frame);
+    }
+    av_frame_free(&frame);
+
+    lock.lock();
+  }
+}
+
+/* Pass a reference to the decoded frame to the thread of the proxy output, waiting while its
+ * queue is full. */
+static void proxy_output_queue_frame(proxy_output_ctx *ctx, const AVFrame *frame)
+{
+  if (!ctx) {
+    return;
+  }
+
+  AVFrame *frame_ref = av_frame_clone(frame);
+  if (frame_ref == nullptr) {
+    return;
+  }
+
+  {
+    std::unique_lock lock(ctx->queue_mutex);
+    ctx->queue_cond.wait(
+        lock, [&]() { return int64_t(ctx->queue.size()) < proxy_output_queue_max; });
+    ctx->queue.push_back(frame_ref);
+  }
+  ctx->queue_cond.notify_all();
+}
+
+/* Wait for the thread of the proxy output to encode the queued frames, or to drop them when
+ * cancelled. */
+static void proxy_output_thread_finish(proxy_output_ctx *ctx, const bool cancel)
+{
+  {
+    std::lock_guard lock(ctx->queue_mutex);
+    ctx->queue_finished = true;
+    ctx->queue_cancelled = cancel;
+  }
+  ctx->queue_cond.notify_all();
+  if (ctx->thread.joinable()) {
+    ctx->thread.join();
+  }
+}
+
 static void free_proxy_output_ffmpeg(proxy_output_ctx *ctx, int rollback)
 {
   char filepath[FILE_MAX];
@@ -632,6 +716,8 @@ static void free_proxy_output_ffmpeg(proxy_output_ctx *ctx, int rollback)
     return;
   }
 
+  proxy_output_thread_finish(ctx, rollback);
+
   if (!rollback) {
     /* Flush the remaining packets. */
     add_to_proxy_output_ffmpeg(ctx, nullptr);
@@ -665,7 +751,7 @@ static void free_proxy_output_ffmpeg(proxy_output_ctx *ctx, int rollback)
     BLI_rename_overwrite(filepath_tmp, filepath);
   }
 
-  MEM_freeN(ctx);
+  MEM_delete(ctx);
 }
 
 static IMB_Timecode_Type tc_types[IMB_TC_NUM_TYPES] = {IMB_TC_RECORD_RUN,
@@ -862,7 +948,7 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(MovieProxyBuilder *context,
   uint64_t pts = av_get_pts_from_frame(in_frame);
 
   for (i = 0; i < context->num_proxy_sizes; i++) {
-    add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+    proxy_output_queue_frame(context->proxy_ctx[i], in_frame);
   }
 
   if (!context->start_pts_set) {
@@ -899,6 +985,15 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(MovieProxyBuilder *context,
   context->frameno_gapless++;
 }
 
+/**
+ * The stop flag is set from another thread while building, e.g. by the sequencer proxy job, which
+ * builds several movies at once.
+ */
+static bool index_rebuild_is_stopped(const bool *stop)
+{
+  return atomic_load_uint8(reinterpret_cast<const uint8_t *>(stop)) != 0;
+}
+
 static int index_rebuild_ffmpeg(MovieProxyBuilder *context,
                                 const bool *stop,
                                 bool *do_update,
@@ -919,11 +1014,11 @@ static int index_rebuild_ffmpeg(MovieProxyBuilder *context,
         float(int(floor(double(next_packet->pos) * 100 / double(stream_size) + 0.5))) / 100;
 
     if (*progress != next_progress) {
-      *progress = next_progress;
+      atomic_store_fl(progress, next_progress);
       *do_update = true;
     }
 
-    if (*stop) {
+    if (index_rebuild_is_stopped(stop)) {
       break;
     }
 
@@ -962,7 +1057,7 @@ static int index_rebuild_ffmpeg(MovieProxyBuilder *context,
    *
    * At least, if we haven't already stopped... */
 
-  if (!*stop) {
+  if (!index_rebuild_is_stopped(stop)) {
     int ret = avcodec_send_packet(context->iCodecCtx, nullptr);
 
     while (ret >= 0) {
@@ -1209,6 +1304,11 @@ void MOV_close_proxies(MovieReader *anim)
     return;
   }
 
+#ifdef WITH_FFMPEG
+  /* Frames decoded ahead may have used the indices freed below. */
+  movie_decode_ahead_free(anim);
+#endif
+
   for (int i = 0; i < IMB_PROXY_MAX_SLOT; i++) {
     if (anim->proxy_anim[i]) {
       MOV_close(anim->proxy_anim[i]);
@@ -1268,6 +1368,7 @@ MovieReader *movie_open_proxy(MovieReader *anim, IMB_Proxy_Size preview_size)
 
 const MovieIndex *movie_open_index(MovieReader *anim, IMB_Timecode_Type tc)
 {
+  std::lock_guard lock(anim->index_mutex);
   char filepath[FILE_MAX];
 
   MovieIndex **index = nullptr;
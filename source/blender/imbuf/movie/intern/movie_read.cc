@@ -11,15 +11,20 @@
 #include <cctype>
 #include <climits>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <mutex>
 #include <sys/types.h>
 
 #include "BLI_path_utils.hh"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_task.hh"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "DNA_scene_types.h"
 
@@ -722,22 +727,16 @@ static void ffmpeg_postprocess(MovieReader *anim, AVFrame *input, ImBuf *ibuf)
       /* Decode, then do vertical flip into destination. */
       ffmpeg_sws_scale_frame(anim->img_convert_ctx, anim->pFrameRGB, input);
 
-      /* Use negative line size to do vertical image flip. */
-      const int src_linesize[4] = {-rgb_linesize, 0, 0, 0};
-      const uint8_t *const src[4] = {
-          rgb_data + (anim->y - 1) * rgb_linesize, nullptr, nullptr, nullptr};
-      int dst_size = av_image_get_buffer_size(AVPixelFormat(anim->pFrameRGB->format),
-                                              anim->pFrameRGB->width,
-                                              anim->pFrameRGB->height,
-                                              1);
-      av_image_copy_to_buffer(ibuf->byte_buffer.data,
-                              dst_size,
-                              src,
-                              src_linesize,
-                              AVPixelFormat(anim->pFrameRGB->format),
-                              anim->x,
-                              anim->y,
-                              1);
+      /* Do the vertical flip into the destination, in slices of rows. */
+      const int size_y = anim->y;
+      blender::threading::parallel_for(
+          blender::IndexRange(size_y), 256, [&](const blender::IndexRange y_range) {
+            for (const int64_t y : y_range) {
+              memcpy(ibuf->byte_buffer.data + y * ibuf_linesize,
+                     rgb_data + (size_y - y - 1) * rgb_linesize,
+                     ibuf_linesize);
+            }
+          });
     }
   }
 
@@ -1180,9 +1179,28 @@ static bool ffmpeg_must_decode(MovieReader *anim, int position)
   return !anim->pFrame_complete || anim->cur_position != position;
 }
 
-static bool ffmpeg_must_seek(MovieReader *anim, int position)
+static bool ffmpeg_must_seek(MovieReader *anim,
+                             int position,
+                             const MovieIndex *tc_index,
+                             int64_t pts_to_search)
 {
   bool must_seek = position != anim->cur_position + 1 || ffmpeg_is_first_frame_decode(anim);
+
+  /* When the index tells that the key frame of the requested frame was already passed by the
+   * decoder, decoding forward from the current state reaches the frame without seeking and
+   * flushing the codec. This avoids decoding the whole GOP again when frames are requested with
+   * small gaps, like multiple prefetch threads or playback that skips frames do. */
+  if (must_seek && tc_index && !ffmpeg_is_first_frame_decode(anim) &&
+      anim->cur_pts < pts_to_search)
+  {
+    const int frame_index = tc_index->get_frame_index(position);
+    const int64_t key_frame_pts = timestamp_from_pts_or_dts(
+        tc_index->get_seek_pos_pts(frame_index), tc_index->get_seek_pos_dts(frame_index));
+    if (key_frame_pts <= anim->cur_pts) {
+      must_seek = false;
+    }
+  }
+
   anim->seek_before_decode = must_seek;
   return must_seek;
 }
@@ -1220,7 +1238,7 @@ static ImBuf *ffmpeg_fetchibuf(MovieReader *anim, int position, IMB_Timecode_Typ
            start_pts);
 
     if (ffmpeg_must_decode(anim, position)) {
-      if (ffmpeg_must_seek(anim, position)) {
+      if (ffmpeg_must_seek(anim, position, tc_index, pts_to_search)) {
         ffmpeg_seek_to_key_frame(anim, position, tc_index, pts_to_search);
       }
 
@@ -1273,12 +1291,248 @@ static ImBuf *ffmpeg_fetchibuf(MovieReader *anim, int position, IMB_Timecode_Typ
   return cur_frame_final;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Decode Ahead
+ *
+ * During playback frames are requested one after another, and decoding and color conversion of
+ * each of them is done on the calling thread. To hide that latency, once frames are requested
+ * close to each other a background task keeps decoding the following frames, from which the next
+ * requests are served. Requests don't have to be strictly sequential: several sequencer prefetch
+ * workers request frames of the same movie slightly out of order. Any request far away from the
+ * previous ones discards the decoded frames and decodes synchronously, which keeps seeking
+ * behavior the same as before.
+ * \{ */
+
+/* Upper bound for the memory used by the decoded frames of a single movie. */
+static constexpr int64_t decode_ahead_memory_max = 128 * 1024 * 1024;
+static constexpr int decode_ahead_frames_max = 4;
+/**
+ * Requests within this many frames of the furthest requested frame count as playback. Decoded
+ * frames before that range are not requested anymore and are freed.
+ */
+static constexpr int decode_ahead_window = 16;
+
+struct MovieDecodeAheadFrame {
+  int position = 0;
+  IMB_Timecode_Type tc = IMB_TC_NONE;
+  ImBuf *ibuf = nullptr;
+};
+
+struct MovieDecodeAhead {
+  /**
+   * Guards the decoder state of the movie, held while decoding a frame by either the task or a
+   * caller that did not find its frame.
+   */
+  std::mutex decode_mutex;
+  /** Guards everything below. Never held while decoding, so that hits don't wait for a decode. */
+  std::mutex mutex;
+  /** Signaled when the task finished decoding a frame. */
+  std::condition_variable frame_cond;
+  /** Runs the decode task, created when it is needed for the first time. */
+  TaskPool *task_pool = nullptr;
+  /** True while a decode task is pushed and did not finish yet. */
+  bool task_running = false;
+  bool stop = false;
+
+  /** Decoded frames that were not requested yet. */
+  Vector<MovieDecodeAheadFrame, decode_ahead_frames_max> frames;
+  int frames_capacity = 1;
+
+  /** Frames in `[next_position, end_position)` are yet to be decoded by the task. */
+  int next_position = 0;
+  int end_position = 0;
+  IMB_Timecode_Type tc = IMB_TC_NONE;
+
+  /** Frame the task is decoding right now, -1 when it is idle. */
+  int decoding_position = -1;
+  IMB_Timecode_Type decoding_tc = IMB_TC_NONE;
+  /**
+   * Incremented when the requests jump to another part of the movie, so that the frame the task
+   * is decoding at that time is not kept anymore.
+   */
+  int generation = 0;
+
+  /** Furthest frame requested during the current playback, -1 before the first request. */
+  int last_position = -1;
+  IMB_Timecode_Type last_tc = IMB_TC_NONE;
+};
+
+static void ffmpeg_decode_ahead_frames_clear(MovieDecodeAhead &decode_ahead)
+{
+  for (MovieDecodeAheadFrame &frame : decode_ahead.frames) {
+    IMB_freeImBuf(frame.ibuf);
+  }
+  decode_ahead.frames.clear();
+}
+
+/* Take the frame at `position` out of the decoded frames, and free frames that are too old to be
+ * requested anymore. Returns nullptr when the frame is not there. */
+static ImBuf *ffmpeg_decode_ahead_frame_pop(MovieDecodeAhead &decode_ahead,
+                                            int position,
+                                            IMB_Timecode_Type tc)
+{
+  ImBuf *ibuf = nullptr;
+  decode_ahead.frames.remove_if([&](const MovieDecodeAheadFrame &frame) {
+    if (frame.tc == tc && frame.position == position) {
+      ibuf = frame.ibuf;
+      return true;
+    }
+    if (frame.tc != tc || frame.position < position - decode_ahead_window) {
+      IMB_freeImBuf(frame.ibuf);
+      return true;
+    }
+    return false;
+  });
+  return ibuf;
+}
+
+static void ffmpeg_decode_ahead_task_run(TaskPool *__restrict pool, void * /*taskdata*/)
+{
+  MovieReader *anim = static_cast<MovieReader *>(BLI_task_pool_user_data(pool));
+  MovieDecodeAhead &decode_ahead = *anim->decode_ahead;
+  std::unique_lock lock(decode_ahead.mutex);
+  while (!decode_ahead.stop && decode_ahead.next_position < decode_ahead.end_position &&
+         decode_ahead.frames.size() < decode_ahead.frames_capacity)
+  {
+    const int position = decode_ahead.next_position++;
+    const IMB_Timecode_Type tc = decode_ahead.tc;
+    const int generation = decode_ahead.generation;
+    decode_ahead.decoding_position = position;
+    decode_ahead.decoding_tc = tc;
+    lock.unlock();
+
+    ImBuf *ibuf;
+    {
+      std::lock_guard decode_lock(decode_ahead.decode_mutex);
+      ibuf = ffmpeg_fetchibuf(anim, position, tc);
+    }
+
+    lock.lock();
+    decode_ahead.decoding_position = -1;
+    if (generation == decode_ahead.generation && ibuf != nullptr) {
+      decode_ahead.frames.append({position, tc, ibuf});
+    }
+    else {
+      IMB_freeImBuf(ibuf);
+    }
+    decode_ahead.frame_cond.notify_all();
+  }
+  decode_ahead.task_running = false;
+}
+
+static MovieDecodeAhead &ffmpeg_decode_ahead_ensure(MovieReader *anim)
+{
+  std::lock_guard lock(anim->decode_ahead_mutex);
+  if (anim->decode_ahead == nullptr) {
+    anim->decode_ahead = MEM_new<MovieDecodeAhead>(__func__);
+    const int64_t frame_size = int64_t(anim->x) * anim->y * (anim->is_float ? 16 : 4);
+    anim->decode_ahead->frames_capacity = int(std::clamp<int64_t>(
+        decode_ahead_memory_max / std::max<int64_t>(frame_size, 1), 1, decode_ahead_frames_max));
+  }
+  return *anim->decode_ahead;
+}
+
+/* Same as #ffmpeg_fetchibuf, but serves requests during playback from frames decoded ahead of
+ * time. */
+static ImBuf *ffmpeg_fetchibuf_decode_ahead(MovieReader *anim, int position, IMB_Timecode_Type tc)
+{
+  if (anim->never_seek_decode_one_frame) {
+    return ffmpeg_fetchibuf(anim, position, tc);
+  }
+
+  MovieDecodeAhead &decode_ahead = ffmpeg_decode_ahead_ensure(anim);
+
+  std::unique_lock lock(decode_ahead.mutex);
+  const bool is_playback = decode_ahead.last_position != -1 && tc == decode_ahead.last_tc &&
+                           position >= decode_ahead.last_position - decode_ahead_window &&
+                           position <= decode_ahead.last_position + decode_ahead_window;
+  if (is_playback) {
+    decode_ahead.last_position = std::max(decode_ahead.last_position, position);
+  }
+  else {
+    /* Don't keep decoding frames of the previous part of the movie. */
+    decode_ahead.generation++;
+    decode_ahead.last_position = position;
+    decode_ahead.next_position = position + 1;
+    ffmpeg_decode_ahead_frames_clear(decode_ahead);
+  }
+  decode_ahead.last_tc = tc;
+
+  ImBuf *ibuf = ffmpeg_decode_ahead_frame_pop(decode_ahead, position, tc);
+  /* Waiting for the frame the task is decoding is faster than decoding it once more. */
+  while (ibuf == nullptr && decode_ahead.decoding_position == position &&
+         decode_ahead.decoding_tc == tc)
+  {
+    decode_ahead.frame_cond.wait(lock);
+    ibuf = ffmpeg_decode_ahead_frame_pop(decode_ahead, position, tc);
+  }
+
+  if (ibuf == nullptr) {
+    /* Decode on this thread. The task continues after this frame, or stays where it is when it
+     * is ahead already. */
+    decode_ahead.next_position = std::max(decode_ahead.next_position, position + 1);
+    lock.unlock();
+    {
+      std::lock_guard decode_lock(decode_ahead.decode_mutex);
+      ibuf = ffmpeg_fetchibuf(anim, position, tc);
+    }
+    lock.lock();
+  }
+
+  decode_ahead.tc = tc;
+  if (is_playback) {
+    decode_ahead.end_position = std::min(
+        decode_ahead.last_position + 1 + decode_ahead.frames_capacity, anim->duration_in_frames);
+  }
+  else {
+    decode_ahead.end_position = decode_ahead.next_position;
+  }
+  if (!decode_ahead.task_running && !decode_ahead.stop &&
+      decode_ahead.next_position < decode_ahead.end_position &&
+      decode_ahead.frames.size() < decode_ahead.frames_capacity)
+  {
+    if (decode_ahead.task_pool == nullptr) {
+      decode_ahead.task_pool = BLI_task_pool_create_background_serial(anim, TASK_PRIORITY_LOW);
+    }
+    decode_ahead.task_running = true;
+    BLI_task_pool_push(
+        decode_ahead.task_pool, ffmpeg_decode_ahead_task_run, nullptr, false, nullptr);
+  }
+
+  return ibuf;
+}
+
+void movie_decode_ahead_free(MovieReader *anim)
+{
+  std::lock_guard lock(anim->decode_ahead_mutex);
+  if (anim->decode_ahead == nullptr) {
+    return;
+  }
+  MovieDecodeAhead *decode_ahead = anim->decode_ahead;
+  {
+    std::lock_guard lock(decode_ahead->mutex);
+    decode_ahead->stop = true;
+  }
+  if (decode_ahead->task_pool) {
+    /* Waits for the running task, which stops after its current frame. */
+    BLI_task_pool_cancel(decode_ahead->task_pool);
+    BLI_task_pool_free(decode_ahead->task_pool);
+  }
+  ffmpeg_decode_ahead_frames_clear(*decode_ahead);
+  MEM_delete(decode_ahead);
+  anim->decode_ahead = nullptr;
+}
+
+/** \} */
+
 static void free_anim_ffmpeg(MovieReader *anim)
 {
   if (anim == nullptr) {
     return;
   }
 
+  movie_decode_ahead_free(anim);
+
   if (anim->pCodecCtx) {
     avcodec_free_context(&anim->pCodecCtx);
     avformat_close_input(&anim->pFormatCtx);
@@ -1396,16 +1650,14 @@ ImBuf *MOV_decode_frame(MovieReader *anim,
 
 #ifdef WITH_FFMPEG
   if (anim->state == MovieReader::State::Valid) {
-    ibuf = ffmpeg_fetchibuf(anim, position, tc);
-    if (ibuf) {
-      anim->cur_position = position;
-    }
+    ibuf = ffmpeg_fetchibuf_decode_ahead(anim, position, tc);
   }
 #endif
 
   if (ibuf) {
+    /* The decoder position can be ahead of the requested frame, when it was decoded ahead. */
     STRNCPY(ibuf->filepath, anim->filepath);
-    ibuf->fileframe = anim->cur_position + 1;
+    ibuf->fileframe = position + 1;
   }
   return ibuf;
 }
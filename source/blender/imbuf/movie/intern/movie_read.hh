@@ -10,6 +10,7 @@
 #pragma once
 
 #include <cstdint>
+#include <mutex>
 
 #include "IMB_imbuf_enums.h"
 
@@ -25,6 +26,7 @@ struct AVCodec;
 struct AVFrame;
 struct AVPacket;
 struct SwsContext;
+struct MovieDecodeAhead;
 #endif
 
 struct IDProperty;
@@ -77,12 +79,20 @@ struct MovieReader {
    * ffmpeg crashes/aborts when trying to seek within them
    * (https://trac.ffmpeg.org/ticket/10755). */
   bool never_seek_decode_one_frame = false;
+
+  /* Frames decoded ahead of the playback position by a background task, created on the first
+   * decode. Its decode mutex guards the decoder state above while the task is running. */
+  MovieDecodeAhead *decode_ahead = nullptr;
+  /** Guards creating and freeing #decode_ahead, which several threads may decode from. */
+  std::mutex decode_ahead_mutex;
 #endif
 
   char index_dir[768] = {};
 
   int proxies_tried = 0;
   int indices_tried = 0;
+  /** Guards opening the timecode indices, which the decode ahead task does as well. */
+  std::mutex index_mutex;
 
   MovieReader *proxy_anim[IMB_PROXY_MAX_SLOT] = {};
   MovieIndex *record_run = nullptr;
@@ -93,3 +103,11 @@ struct MovieReader {
 
   IDProperty *metadata = nullptr;
 };
+
+#ifdef WITH_FFMPEG
+/**
+ * Stop decoding frames ahead of the playback position and free the frames decoded so far.
+ * Must be called before changing state the decoding depends on, like the timecode indices.
+ */
+void movie_decode_ahead_free(MovieReader *anim);
+#endif
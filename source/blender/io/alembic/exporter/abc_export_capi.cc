@@ -20,11 +20,13 @@
 #include "BKE_lib_id.hh"
 #include "BKE_main.hh"
 #include "BKE_scene.hh"
+#include "BKE_scene_frame_batch.hh"
 
 #include "BLI_fileops.h"
 #include "BLI_path_utils.hh"
 #include "BLI_string.h"
 #include "BLI_timeit.hh"
+#include "BLI_vector.hh"
 
 #include "WM_api.hh"
 #include "WM_types.hh"
@@ -37,6 +39,8 @@ static CLG_LogRef LOG = {"io.alembic"};
 struct ExportJobData {
   Main *bmain = nullptr;
   Depsgraph *depsgraph = nullptr;
+  /** Evaluates several frames of an animation at once, only created when exporting one. */
+  std::unique_ptr<blender::bke::SceneFrameBatchEvaluator> frame_evaluator;
   wmWindowManager *wm = nullptr;
 
   char filepath[FILE_MAX] = {};
@@ -50,7 +54,7 @@ struct ExportJobData {
 namespace blender::io::alembic {
 
 /* Construct the depsgraph for exporting. */
-static bool build_depsgraph(ExportJobData *job)
+static bool build_depsgraph(ExportJobData *job, Depsgraph *depsgraph)
 {
   if (job->params.collection[0]) {
     Collection *collection = reinterpret_cast<Collection *>(
@@ -61,13 +65,13 @@ static bool build_depsgraph(ExportJobData *job)
       return false;
     }
 
-    DEG_graph_build_from_collection(job->depsgraph, collection);
+    DEG_graph_build_from_collection(depsgraph, collection);
   }
   else if (job->params.visible_objects_only) {
-    DEG_graph_build_from_view_layer(job->depsgraph);
+    DEG_graph_build_from_view_layer(depsgraph);
   }
   else {
-    DEG_graph_build_for_all_objects(job->depsgraph);
+    DEG_graph_build_for_all_objects(depsgraph);
   }
 
   return true;
@@ -141,29 +145,23 @@ static void export_startjob(void *customdata, wmJobWorkerStatus *worker_status)
 
     /* Writing the animated frames is not 100% of the work, but it's our best guess. */
     const float progress_per_frame = 1.0f / std::max(size_t(1), abc_archive->total_frame_count());
-    ABCArchive::Frames::const_iterator frame_it = abc_archive->frames_begin();
-    const ABCArchive::Frames::const_iterator frames_end = abc_archive->frames_end();
-
-    for (; frame_it != frames_end; frame_it++) {
-      double frame = *frame_it;
+    const blender::Vector<double> frames(abc_archive->frames_begin(), abc_archive->frames_end());
 
+    data->frame_evaluator->evaluate(frames, [&](Depsgraph *depsgraph, const double frame) {
       if (G.is_break || worker_status->stop) {
-        break;
+        return false;
       }
 
-      /* Update the scene for the next frame to render. */
-      scene->r.cfra = int(frame);
-      scene->r.subframe = float(frame - scene->r.cfra);
-      BKE_scene_graph_update_for_newframe(data->depsgraph);
-
       CLOG_DEBUG(&LOG, "Exporting frame %.2f", frame);
       ExportSubset export_subset = abc_archive->export_subset_for_frame(frame);
+      iter.set_depsgraph(depsgraph);
       iter.set_export_subset(export_subset);
       iter.iterate_and_write();
 
       worker_status->progress += progress_per_frame;
       worker_status->do_update = true;
-    }
+      return true;
+    });
   }
   else {
     /* If we're not animating, a single iteration over all objects is enough. */
@@ -188,6 +186,7 @@ static void export_endjob(void *customdata)
 {
   ExportJobData *data = static_cast<ExportJobData *>(customdata);
 
+  data->frame_evaluator.reset();
   DEG_graph_free(data->depsgraph);
 
   if (data->was_canceled && BLI_exists(data->filepath)) {
@@ -223,10 +222,18 @@ bool ABC_export(Scene *scene,
    *
    * Has to be done from main thread currently, as it may affect Main original data (e.g. when
    * doing deferred update of the view-layers, see #112534 for details). */
-  if (!blender::io::alembic::build_depsgraph(job)) {
+  if (!blender::io::alembic::build_depsgraph(job, job->depsgraph)) {
     return false;
   }
 
+  if (params->frame_start != params->frame_end) {
+    const int frames_num = int(params->frame_end - params->frame_start) + 1;
+    job->frame_evaluator = std::make_unique<blender::bke::SceneFrameBatchEvaluator>(
+        job->depsgraph, frames_num, [&](Depsgraph *depsgraph) {
+          blender::io::alembic::build_depsgraph(job, depsgraph);
+        });
+  }
+
   bool export_ok = false;
   if (as_background_job) {
     wmJob *wm_job = WM_jobs_get(job->wm,
@@ -273,6 +273,16 @@ class AbstractHierarchyIterator {
    * previous iteration. */
   void set_export_subset(ExportSubset export_subset);
 
+  /* Iterate over another depsgraph that was built in the same way, but evaluated for a different
+   * frame (see #blender::bke::SceneFrameBatchEvaluator). Set this before calling
+   * iterate_and_write().
+   *
+   * Writers are created for the first frame, so they have to read frame-dependent data from
+   * #get_depsgraph() rather than keep the depsgraph they were created with. */
+  void set_depsgraph(Depsgraph *depsgraph);
+  /* The depsgraph of the frame that is currently being written. */
+  Depsgraph *get_depsgraph() const;
+
   /* Convert the given name to something that is valid for the exported file format.
    * This base implementation is a no-op; override in a concrete subclass. */
   virtual std::string make_valid_name(const std::string &name) const;
@@ -4,6 +4,9 @@
 
 #include <fmt/core.h>
 
+#include <memory>
+#include <optional>
+
 #include "IO_subdiv_disabler.hh"
 #include "usd.hh"
 #include "usd_hierarchy_iterator.hh"
@@ -43,6 +46,7 @@
 #include "BKE_lib_id.hh"
 #include "BKE_report.hh"
 #include "BKE_scene.hh"
+#include "BKE_scene_frame_batch.hh"
 
 #include "BLI_fileops.h"
 #include "BLI_math_matrix.h"
@@ -51,6 +55,7 @@
 #include "BLI_path_utils.hh"
 #include "BLI_string.h"
 #include "BLI_timeit.hh"
+#include "BLI_vector.hh"
 
 #include <IMB_imbuf.hh>
 #include <IMB_imbuf_types.hh>
@@ -66,6 +71,8 @@ namespace blender::io::usd {
 struct ExportJobData {
   Main *bmain = nullptr;
   Depsgraph *depsgraph = nullptr;
+  /** Evaluates several frames of an animation at once, only created when exporting one. */
+  std::unique_ptr<bke::SceneFrameBatchEvaluator> frame_evaluator;
   wmWindowManager *wm = nullptr;
   Scene *scene = nullptr;
 
@@ -474,7 +481,8 @@ static void collect_point_instancer_prototypes_and_set_extent(
 
 pxr::UsdStageRefPtr export_to_stage(const USDExportParams &params,
                                     Depsgraph *depsgraph,
-                                    const char *filepath)
+                                    const char *filepath,
+                                    bke::SceneFrameBatchEvaluator *frame_evaluator)
 {
   pxr::UsdStageRefPtr usd_stage = pxr::UsdStage::CreateNew(filepath);
   if (!usd_stage) {
@@ -542,22 +550,32 @@ pxr::UsdStageRefPtr export_to_stage(const USDExportParams &params,
     /* Writing the animated frames is not 100% of the work, here it's assumed to be 75% of it. */
     float progress_per_frame = 0.75f / std::max(1, (scene->r.efra - scene->r.sfra + 1));
 
-    for (float frame = scene->r.sfra; frame <= scene->r.efra; frame++) {
+    Vector<double> frames;
+    for (int frame = scene->r.sfra; frame <= scene->r.efra; frame++) {
+      frames.append(frame);
+    }
+
+    /* Without an evaluator the frames are evaluated one after another on the depsgraph. */
+    std::optional<bke::SceneFrameBatchEvaluator> serial_frame_evaluator;
+    if (!frame_evaluator) {
+      serial_frame_evaluator.emplace(depsgraph, 1, [](Depsgraph * /*depsgraph*/) {});
+      frame_evaluator = &*serial_frame_evaluator;
+    }
+
+    frame_evaluator->evaluate(frames, [&](Depsgraph *frame_depsgraph, const double frame) {
       if (G.is_break || worker_status->stop) {
-        break;
+        return false;
       }
 
-      /* Update the scene for the next frame to render. */
-      scene->r.cfra = int(frame);
-      scene->r.subframe = frame - scene->r.cfra;
-      BKE_scene_graph_update_for_newframe(depsgraph);
-
-      iter.set_export_frame(frame);
+      iter.set_depsgraph(frame_depsgraph);
+      iter.set_export_frame(float(frame));
       iter.iterate_and_write();
 
       worker_status->progress += progress_per_frame;
       worker_status->do_update = true;
-    }
+      return true;
+    });
+    iter.set_depsgraph(depsgraph);
   }
   else {
     /* If we're not animating, a single iteration over all objects is enough. */
@@ -640,7 +658,7 @@ static void export_startjob(void *customdata, wmJobWorkerStatus *worker_status)
   data->params.worker_status = worker_status;
 
   pxr::UsdStageRefPtr usd_stage = export_to_stage(
-      data->params, data->depsgraph, data->unarchived_filepath);
+      data->params, data->depsgraph, data->unarchived_filepath, data->frame_evaluator.get());
   if (!usd_stage) {
     /* This happens when the USD JSON files cannot be found. When that happens,
      * the USD library doesn't know it has the functionality to write USDA and
@@ -705,6 +723,7 @@ static void export_endjob(void *customdata)
 {
   ExportJobData *data = static_cast<ExportJobData *>(customdata);
 
+  data->frame_evaluator.reset();
   DEG_graph_free(data->depsgraph);
 
   if (data->targets_usdz()) {
@@ -793,8 +812,9 @@ bool USD_export(const bContext *C,
    *
    * Has to be done from main thread currently, as it may affect Main original data (e.g. when
    * doing deferred update of the view-layers, see #112534 for details). */
+  Collection *collection = nullptr;
   if (job->params.collection[0]) {
-    Collection *collection = reinterpret_cast<Collection *>(
+    collection = reinterpret_cast<Collection *>(
         BKE_libblock_find_name(job->bmain, ID_GR, job->params.collection));
     if (!collection) {
       BKE_reportf(reports,
@@ -803,14 +823,25 @@ bool USD_export(const bContext *C,
                   job->params.collection);
       return false;
     }
-
-    DEG_graph_build_from_collection(job->depsgraph, collection);
-  }
-  else if (job->params.visible_objects_only) {
-    DEG_graph_build_from_view_layer(job->depsgraph);
   }
-  else {
-    DEG_graph_build_for_all_objects(job->depsgraph);
+
+  const auto build_depsgraph = [&](Depsgraph *depsgraph) {
+    if (collection) {
+      DEG_graph_build_from_collection(depsgraph, collection);
+    }
+    else if (job->params.visible_objects_only) {
+      DEG_graph_build_from_view_layer(depsgraph);
+    }
+    else {
+      DEG_graph_build_for_all_objects(depsgraph);
+    }
+  };
+  build_depsgraph(job->depsgraph);
+
+  if (job->params.export_animation) {
+    const int frames_num = scene->r.efra - scene->r.sfra + 1;
+    job->frame_evaluator = std::make_unique<blender::bke::SceneFrameBatchEvaluator>(
+        job->depsgraph, frames_num, build_depsgraph);
   }
 
   bool export_ok = false;
@@ -38,6 +38,18 @@ struct USDExporterContext {
 
   /** Optional callback for skel/shape-key path registration (used by USDPointInstancerWriter). */
   std::function<void(const Object *, const pxr::SdfPath &)> add_skel_mapping_fn;
+
+  /**
+   * Optional function which returns the depsgraph of the frame that is being exported. When
+   * exporting animation, frames may be evaluated on copies of #depsgraph, so writers should read
+   * frame-dependent data through #current_depsgraph().
+   */
+  std::function<Depsgraph *()> get_depsgraph;
+
+  Depsgraph *current_depsgraph() const
+  {
+    return get_depsgraph ? get_depsgraph() : depsgraph;
+  }
 };
 
 }  // namespace blender::io::usd
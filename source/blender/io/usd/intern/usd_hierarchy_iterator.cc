@@ -141,6 +141,7 @@ USDExporterContext USDHierarchyIterator::create_usd_export_context(const Hierarc
 
   /* Provides optional skel mapping hook. Now it's been used in USDPointInstancerWriter for write
    * base layer. */
+  exporter_context.get_depsgraph = [this]() { return this->depsgraph_; };
   exporter_context.add_skel_mapping_fn = [this](const Object *obj, const pxr::SdfPath &path) {
     this->add_usd_skel_export_mapping(obj, path);
   };
@@ -23,7 +23,8 @@ Mesh *USDTextWriter::get_export_mesh(Object *object_eval, bool &r_needsfree)
     return mesh_eval;
   }
   r_needsfree = true;
-  return BKE_mesh_new_from_object(usd_export_context_.depsgraph, object_eval, false, false, true);
+  return BKE_mesh_new_from_object(
+      usd_export_context_.current_depsgraph(), object_eval, false, false, true);
 }
 
 void USDTextWriter::free_export_mesh(Mesh *mesh)
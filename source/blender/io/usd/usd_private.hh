@@ -12,11 +12,20 @@
 
 struct Depsgraph;
 
+namespace blender::bke {
+class SceneFrameBatchEvaluator;
+}
+
 namespace blender::io::usd {
 
+/**
+ * \param frame_evaluator: Used to evaluate the frames of an animation several at a time, when
+ * not given the frames are evaluated one after another on `depsgraph`.
+ */
 pxr::UsdStageRefPtr export_to_stage(const USDExportParams &params,
                                     Depsgraph *depsgraph,
-                                    const char *filepath);
+                                    const char *filepath,
+                                    bke::SceneFrameBatchEvaluator *frame_evaluator = nullptr);
 
 std::string image_cache_file_path();
 std::string get_image_cache_file(const std::string &file_name, bool mkdir = true);
@@ -2565,6 +2565,8 @@ typedef struct NodesModifierData {
 
 typedef enum NodesModifierFlag {
   NODES_MODIFIER_HIDE_DATABLOCK_SELECTOR = (1 << 0),
+  /** Reuse outputs of expensive nodes from previous evaluations when their inputs are the same. */
+  NODES_MODIFIER_USE_EVAL_CACHE = (1 << 1),
 } NodesModifierFlag;
 
 typedef struct MeshToVolumeModifierData {
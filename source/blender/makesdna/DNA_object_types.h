@@ -680,6 +680,8 @@ enum {
 #ifdef DNA_DEPRECATED_ALLOW
   OB_FLAG_UNUSED_12 = 1 << 12, /* cleared */
 #endif
+  /** Keep the frames of the simulation cache compressed in memory. */
+  OB_FLAG_COMPRESS_SIMULATION_CACHE = 1 << 14,
 };
 
 /** #Object.visibility_flag */
@@ -280,6 +280,15 @@ static void rna_Depsgraph_debug_stats_gnuplot(Depsgraph *depsgraph,
   fclose(f);
 }
 
+static void rna_Depsgraph_debug_eval_trace(Depsgraph *depsgraph,
+                                           ReportList *reports,
+                                           const char *filepath)
+{
+  if (!DEG_debug_eval_trace_write(depsgraph, filepath)) {
+    BKE_reportf(reports, RPT_ERROR, "Could not open \"%s\" for writing", filepath);
+  }
+}
+
 static void rna_Depsgraph_debug_tag_update(Depsgraph *depsgraph)
 {
   DEG_graph_tag_relations_update(depsgraph);
@@ -730,6 +739,16 @@ static void rna_def_depsgraph(BlenderRNA *brna)
                                   "File name where gnuplot script will save the result");
   RNA_def_parameter_flags(parm, PropertyFlag(0), PARM_REQUIRED);
 
+  func = RNA_def_function(srna, "debug_eval_trace", "rna_Depsgraph_debug_eval_trace");
+  RNA_def_function_ui_description(
+      func,
+      "Write the evaluations recorded while bpy.app.debug_depsgraph_trace is enabled to a file in "
+      "the Chrome trace event format, and clear them");
+  RNA_def_function_flag(func, FUNC_USE_REPORTS);
+  parm = RNA_def_string_file_path(
+      func, "filepath", nullptr, FILE_MAX, "File Name", "Output path for the trace file");
+  RNA_def_parameter_flags(parm, PropertyFlag(0), PARM_REQUIRED);
+
   func = RNA_def_function(srna, "debug_tag_update", "rna_Depsgraph_debug_tag_update");
 
   func = RNA_def_function(srna, "debug_stats", "rna_Depsgraph_debug_stats");
@@ -932,7 +932,7 @@ static void rna_Modifier_update(Main * /*bmain*/, Scene * /*scene*/, PointerRNA
 static void rna_Modifier_dependency_update(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
   rna_Modifier_update(bmain, scene, ptr);
-  DEG_relations_tag_update(bmain);
+  DEG_id_tag_relations_update(bmain, ptr->owner_id);
 }
 
 static void rna_NodesModifier_bake_update(Main *bmain, Scene *scene, PointerRNA *ptr)
@@ -8124,6 +8124,14 @@ static void rna_def_modifier_nodes(BlenderRNA *brna)
   RNA_def_property_flag(prop, PROP_NO_DEG_UPDATE);
   RNA_def_property_update(prop, NC_OBJECT | ND_MODIFIER, nullptr);
 
+  prop = RNA_def_property(srna, "use_eval_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, nullptr, "flag", NODES_MODIFIER_USE_EVAL_CACHE);
+  RNA_def_property_ui_text(prop,
+                           "Cache Node Results",
+                           "Reuse the results of expensive nodes from previous evaluations when "
+                           "their inputs did not change, at the cost of using more memory");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   prop = RNA_def_property(srna, "node_warnings", PROP_COLLECTION, PROP_NONE);
   RNA_def_property_collection_funcs(prop,
                                     "rna_NodesModifier_node_warnings_iterator_begin",
@@ -3429,6 +3429,16 @@ static void rna_def_object(BlenderRNA *brna)
   RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
   RNA_def_property_update(prop, NC_OBJECT | ND_DRAW, nullptr);
 
+  prop = RNA_def_property(srna, "use_simulation_cache_compression", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, nullptr, "flag", OB_FLAG_COMPRESS_SIMULATION_CACHE);
+  RNA_def_property_ui_text(prop,
+                           "Compress Simulation Cache",
+                           "Store cached simulation frames compressed in memory, relative to the "
+                           "previous frame, to cache longer simulations at the cost of "
+                           "decompressing frames during playback");
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+  RNA_def_property_update(prop, NC_OBJECT | ND_DRAW, nullptr);
+
   rna_def_object_visibility(srna);
 
   /* instancing */
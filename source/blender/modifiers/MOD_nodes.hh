@@ -15,6 +15,9 @@ struct NodesModifierBake;
 namespace blender::bke::bake {
 struct ModifierCache;
 }
+namespace blender::nodes {
+class GeoNodesEvalCache;
+}
 namespace blender::nodes::geo_eval_log {
 class GeoNodesLog;
 }
@@ -42,6 +45,12 @@ struct NodesModifierRuntime {
    * used by the evaluated modifier.
    */
   std::shared_ptr<bke::bake::ModifierCache> cache;
+  /**
+   * Outputs of nodes from previous evaluations, used when #NODES_MODIFIER_USE_EVAL_CACHE is set.
+   * Shared between original and evaluated modifier like the simulation cache, so that it is kept
+   * when the evaluated modifier is copied again.
+   */
+  std::shared_ptr<nodes::GeoNodesEvalCache> eval_cache;
 };
 
 void nodes_modifier_data_block_destruct(NodesModifierDataBlock *data_block, bool do_id_user);
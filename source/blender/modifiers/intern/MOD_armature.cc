@@ -56,6 +56,26 @@ static void copy_data(const ModifierData *md, ModifierData *target, const int fl
   tamd->vert_coords_prev = nullptr;
 }
 
+static void free_runtime_data(void *runtime_data)
+{
+  MEM_delete(static_cast<blender::bke::ArmatureDeformWeightsCache *>(runtime_data));
+}
+
+static void free_data(ModifierData *md)
+{
+  free_runtime_data(md->runtime);
+  md->runtime = nullptr;
+}
+
+/* Compact vertex group weights of the deformed mesh, kept between evaluations. */
+static blender::bke::ArmatureDeformWeightsCache &ensure_weights_cache(ModifierData *md)
+{
+  if (md->runtime == nullptr) {
+    md->runtime = MEM_new<blender::bke::ArmatureDeformWeightsCache>(__func__);
+  }
+  return *static_cast<blender::bke::ArmatureDeformWeightsCache *>(md->runtime);
+}
+
 static void required_data_mask(ModifierData * /*md*/, CustomData_MeshMasks *r_cddata_masks)
 {
   /* Ask for vertex-groups. */
@@ -135,7 +155,8 @@ static void deform_verts(ModifierData *md,
                                        std::nullopt,
                                        amd->deformflag,
                                        amd->defgrp_name,
-                                       mesh);
+                                       mesh,
+                                       &ensure_weights_cache(md));
 
   /* free cache */
   MEM_SAFE_FREE(amd->vert_coords_prev);
@@ -207,7 +228,8 @@ static void deform_matrices(ModifierData *md,
                                        matrices,
                                        amd->deformflag,
                                        amd->defgrp_name,
-                                       mesh);
+                                       mesh,
+                                       &ensure_weights_cache(md));
 }
 
 static void panel_draw(const bContext * /*C*/, Panel *panel)
@@ -268,14 +290,14 @@ ModifierTypeInfo modifierType_Armature = {
 
     /*init_data*/ init_data,
     /*required_data_mask*/ required_data_mask,
-    /*free_data*/ nullptr,
+    /*free_data*/ free_data,
     /*is_disabled*/ is_disabled,
     /*update_depsgraph*/ update_depsgraph,
     /*depends_on_time*/ nullptr,
     /*depends_on_normals*/ nullptr,
     /*foreach_ID_link*/ foreach_ID_link,
     /*foreach_tex_link*/ nullptr,
-    /*free_runtime_data*/ nullptr,
+    /*free_runtime_data*/ free_runtime_data,
     /*panel_register*/ panel_register,
     /*blend_write*/ nullptr,
     /*blend_read*/ blend_read,
@@ -86,6 +86,7 @@
 #include "ED_viewer_path.hh"
 
 #include "NOD_geometry_nodes_dependencies.hh"
+#include "NOD_geometry_nodes_eval_cache.hh"
 #include "NOD_geometry_nodes_execute.hh"
 #include "NOD_geometry_nodes_gizmos.hh"
 #include "NOD_geometry_nodes_lazy_function.hh"
@@ -108,6 +109,7 @@ static void init_data(ModifierData *md)
   MEMCPY_STRUCT_AFTER(nmd, DNA_struct_default_get(NodesModifierData), modifier);
   nmd->runtime = MEM_new<NodesModifierRuntime>(__func__);
   nmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+  nmd->runtime->eval_cache = std::make_shared<nodes::GeoNodesEvalCache>();
 }
 
 static void find_dependencies_from_settings(const NodesModifierSettings &settings,
@@ -1154,6 +1156,7 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
   const Scene *scene_;
   SubFrame current_frame_;
   bool use_frame_cache_;
+  bool use_frame_cache_compression_;
   bool depsgraph_is_active_;
   bake::ModifierCache *modifier_cache_;
   float fps_;
@@ -1176,6 +1179,7 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
     const Scene *scene = DEG_get_input_scene(depsgraph);
     scene_ = scene;
     use_frame_cache_ = ctx_.object->flag & OB_FLAG_USE_SIMULATION_CACHE;
+    use_frame_cache_compression_ = ctx_.object->flag & OB_FLAG_COMPRESS_SIMULATION_CACHE;
     depsgraph_is_active_ = DEG_is_active(depsgraph);
     modifier_cache_ = nmd.runtime->cache.get();
     fps_ = FPS;
@@ -1323,6 +1327,7 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
         {
           /* Read the previous frame's data and store the newly computed simulation state. */
           auto &output_copy_info = zone_behavior.input.emplace<sim_input::OutputCopy>();
+          node_cache.bake.ensure_frame_decompressed(*frame_indices.prev);
           const bake::FrameCache &prev_frame_cache = *node_cache.bake.frames[*frame_indices.prev];
           const float real_delta_frames = float(current_frame_) - float(prev_frame_cache.frame);
           if (real_delta_frames != 1) {
@@ -1330,7 +1335,7 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
           }
           const float delta_frames = std::min(max_delta_frames, real_delta_frames);
           output_copy_info.delta_time = delta_frames / fps_;
-          output_copy_info.state = prev_frame_cache.state;
+          output_copy_info.state = prev_frame_cache.state_ref();
           this->output_store_frame_cache(node_cache, zone_behavior);
           return;
         }
@@ -1396,12 +1401,18 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
     auto &store_new_state_info = zone_behavior.output.emplace<sim_output::StoreNewState>();
     store_new_state_info.store_fn = [simulation_cache = modifier_cache_,
                                      node_cache = &node_cache,
-                                     current_frame = current_frame_](bke::bake::BakeState state) {
+                                     current_frame = current_frame_,
+                                     use_compression = use_frame_cache_compression_](
+                                        bke::bake::BakeState state) {
       std::lock_guard lock{simulation_cache->mutex};
       auto frame_cache = std::make_unique<bake::FrameCache>();
       frame_cache->frame = current_frame;
       frame_cache->state = std::move(state);
       node_cache->bake.frames.append(std::move(frame_cache));
+      if (use_compression && node_cache->bake.frames.size() >= 2) {
+        /* Only the last frame is needed for the next simulation step. */
+        node_cache->bake.compress_frame(node_cache->bake.frames.size() - 2);
+      }
     };
   }
 
@@ -1427,11 +1438,12 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
   {
     if (frame_indices.prev) {
       auto &output_copy_info = zone_behavior.input.emplace<sim_input::OutputCopy>();
+      node_cache.bake.ensure_frame_decompressed(*frame_indices.prev);
       bake::FrameCache &frame_cache = *node_cache.bake.frames[*frame_indices.prev];
       const float delta_frames = std::min(max_delta_frames,
                                           float(current_frame_) - float(frame_cache.frame));
       output_copy_info.delta_time = delta_frames / fps_;
-      output_copy_info.state = frame_cache.state;
+      output_copy_info.state = frame_cache.state_ref();
     }
     else {
       zone_behavior.input.emplace<sim_input::PassThrough>();
@@ -1460,10 +1472,12 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
                    bake::SimulationNodeCache &node_cache,
                    nodes::SimulationZoneBehavior &zone_behavior) const
   {
+    node_cache.bake.ensure_frame_decompressed(frame_index);
+    this->prefetch_compressed_frame(frame_index + 1, node_cache);
     bake::FrameCache &frame_cache = *node_cache.bake.frames[frame_index];
     ensure_bake_loaded(node_cache.bake, frame_cache);
     auto &read_single_info = zone_behavior.output.emplace<sim_output::ReadSingle>();
-    read_single_info.state = frame_cache.state;
+    read_single_info.state = frame_cache.state_ref();
   }
 
   void read_interpolated(const int prev_frame_index,
@@ -1471,6 +1485,9 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
                          bake::SimulationNodeCache &node_cache,
                          nodes::SimulationZoneBehavior &zone_behavior) const
   {
+    node_cache.bake.ensure_frame_decompressed(prev_frame_index);
+    node_cache.bake.ensure_frame_decompressed(next_frame_index);
+    this->prefetch_compressed_frame(next_frame_index + 1, node_cache);
     bake::FrameCache &prev_frame_cache = *node_cache.bake.frames[prev_frame_index];
     bake::FrameCache &next_frame_cache = *node_cache.bake.frames[next_frame_index];
     ensure_bake_loaded(node_cache.bake, prev_frame_cache);
@@ -1479,8 +1496,17 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
     read_interpolated_info.mix_factor = (float(current_frame_) - float(prev_frame_cache.frame)) /
                                         (float(next_frame_cache.frame) -
                                          float(prev_frame_cache.frame));
-    read_interpolated_info.prev_state = prev_frame_cache.state;
-    read_interpolated_info.next_state = next_frame_cache.state;
+    read_interpolated_info.prev_state = prev_frame_cache.state_ref();
+    read_interpolated_info.next_state = next_frame_cache.state_ref();
+  }
+
+  void prefetch_compressed_frame(const int frame_index,
+                                 bake::SimulationNodeCache &node_cache) const
+  {
+    /* During playback, the next frame is likely to be read soon. */
+    if (depsgraph_is_active_) {
+      node_cache.bake.prefetch_frame(frame_index);
+    }
   }
 };
 
@@ -1893,11 +1919,24 @@ static void modifyGeometry(ModifierData *md,
   find_side_effect_nodes(*nmd, *ctx, side_effect_nodes, socket_log_contexts);
   call_data.side_effect_nodes = &side_effect_nodes;
 
+  nodes::GeoNodesEvalCache &eval_cache = *nmd->runtime->eval_cache;
+  if (nmd->flag & NODES_MODIFIER_USE_EVAL_CACHE) {
+    call_data.eval_cache = &eval_cache;
+  }
+  else if (eval_cache.memory() > 0) {
+    eval_cache.clear();
+  }
+
   bke::ModifierComputeContext modifier_compute_context{nullptr, *nmd};
 
   geometry_set = nodes::execute_geometry_nodes_on_geometry(
       tree, properties, modifier_compute_context, call_data, std::move(geometry_set));
 
+  if (call_data.eval_cache) {
+    /* Entries whose input data has been freed or changed are never found again. */
+    eval_cache.remove_unreachable();
+  }
+
   if (logging_enabled(ctx)) {
     nmd_orig->runtime->eval_log = std::move(eval_log);
   }
@@ -2105,6 +2144,7 @@ static void blend_read(BlendDataReader *reader, ModifierData *md)
 
   nmd->runtime = MEM_new<NodesModifierRuntime>(__func__);
   nmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+  nmd->runtime->eval_cache = std::make_shared<nodes::GeoNodesEvalCache>();
 }
 
 static void copy_data(const ModifierData *md, ModifierData *target, const int flag)
@@ -2163,11 +2203,13 @@ static void copy_data(const ModifierData *md, ModifierData *target, const int fl
   if (flag & LIB_ID_COPY_SET_COPIED_ON_WRITE) {
     /* Share the simulation cache between the original and evaluated modifier. */
     tnmd->runtime->cache = nmd->runtime->cache;
+    tnmd->runtime->eval_cache = nmd->runtime->eval_cache;
     /* Keep bake path in the evaluated modifier. */
     tnmd->bake_directory = nmd->bake_directory ? BLI_strdup(nmd->bake_directory) : nullptr;
   }
   else {
     tnmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+    tnmd->runtime->eval_cache = std::make_shared<nodes::GeoNodesEvalCache>();
     /* Clear the bake path when duplicating. */
     tnmd->bake_directory = nullptr;
   }
@@ -0,0 +1,199 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup nodes
+ *
+ * Cache for the outputs of expensive geometry nodes that is kept across evaluations.
+ *
+ * When an input of the geometry nodes modifier or an object it depends on changes, the entire
+ * node tree is evaluated again, even though many nodes get exactly the same inputs as before.
+ * Nodes that opt into caching (see #NodeDeclaration::outputs_cacheable) look up their outputs
+ * here before executing, using a key built from all their input values.
+ *
+ * Building the key has to be cheap compared to executing the node, so geometries are not hashed
+ * by their content. Instead, the key references the implicitly shared arrays of the geometry by
+ * identity, together with their version which changes when the data is modified in place. Only
+ * small values like sizes and names are stored in the key directly.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "BLI_compute_context.hh"
+#include "BLI_generic_pointer.hh"
+#include "BLI_implicit_sharing_ptr.hh"
+#include "BLI_map.hh"
+#include "BLI_mutex.hh"
+#include "BLI_struct_equality_utils.hh"
+#include "BLI_vector.hh"
+
+#include "NOD_geometry_nodes_warning.hh"
+
+namespace blender::nodes {
+
+/**
+ * Identifies one evaluation of a node: the node itself, the compute context it is evaluated in,
+ * and all its input values.
+ */
+class GeoNodesEvalCacheKey {
+ private:
+  struct SharedData {
+    WeakImplicitSharingPtr sharing_info;
+    const void *data;
+    int64_t version;
+
+    BLI_STRUCT_EQUALITY_OPERATORS_3(SharedData, sharing_info, data, version)
+  };
+
+  uint64_t node_id_;
+  ComputeContextHash context_hash_;
+  /** Values that are compared by value, e.g. sizes, names and single socket values. */
+  Vector<uint8_t, 256> bytes_;
+  /** Data that is compared by identity. */
+  Vector<SharedData, 16> shared_data_;
+  uint64_t hash_ = 0;
+
+ public:
+  /**
+   * \param node_id: Unique identifier of the node that is never reused, even when the node tree
+   * is edited. See #GeoNodesEvalCache::new_node_id.
+   */
+  GeoNodesEvalCacheKey(uint64_t node_id, const ComputeContextHash &context_hash);
+
+  /**
+   * Add an input value to the key.
+   * \return False if the value can not be identified by the key, e.g. because it depends on data
+   * that is not passed to the node directly like a field input or an object. The key must not be
+   * used then.
+   */
+  bool add_value(GPointer value);
+
+  /** Add data that is compared by value. */
+  void add_bytes(const void *data, int64_t size);
+  template<typename T> void add_trivial(const T &value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    this->add_bytes(&value, sizeof(T));
+  }
+  void add_string(StringRef str);
+
+  /**
+   * Add implicitly shared data that is compared by identity.
+   * \return False if the data is not shared and can't be identified.
+   */
+  bool add_shared_data(const ImplicitSharingInfo *sharing_info, const void *data);
+
+  /** Has to be called after all values have been added. */
+  void finalize();
+
+  /**
+   * False if the key can't be equal to a key built from new input values anymore, because
+   * referenced shared data has been freed or modified.
+   */
+  bool is_reachable() const;
+
+  uint64_t hash() const
+  {
+    return hash_;
+  }
+
+  uint64_t node_id() const
+  {
+    return node_id_;
+  }
+
+  friend bool operator==(const GeoNodesEvalCacheKey &a, const GeoNodesEvalCacheKey &b);
+
+  friend bool operator!=(const GeoNodesEvalCacheKey &a, const GeoNodesEvalCacheKey &b)
+  {
+    return !(a == b);
+  }
+};
+
+/**
+ * Output values computed by a node for specific inputs, indexed like the outputs of its
+ * lazy-function. Outputs that were not computed are null. Entries are immutable once they are
+ * added to the cache, so they can be used without locking.
+ */
+struct GeoNodesEvalCacheEntry : NonCopyable, NonMovable {
+  Vector<GMutablePointer> outputs;
+  /** Warnings reported by the node when it was executed, so that they can be shown again. */
+  Vector<std::pair<NodeWarningType, std::string>> warnings;
+  /** Approximate memory used by the output values. */
+  int64_t memory = 0;
+
+  GeoNodesEvalCacheEntry(int outputs_num);
+  ~GeoNodesEvalCacheEntry();
+
+  /** Store a copy of the output value. */
+  void add_output(int index, GPointer value);
+};
+
+/**
+ * Cached node outputs of one caller, e.g. a geometry nodes modifier. It is used from multiple
+ * threads and evaluations concurrently.
+ *
+ * All caches share one memory budget. When it is exceeded, the entries that were not used for the
+ * longest time are removed, regardless of which cache they are in.
+ */
+class GeoNodesEvalCache : NonCopyable, NonMovable {
+ private:
+  struct StoredEntry {
+    std::shared_ptr<const GeoNodesEvalCacheEntry> entry;
+    int64_t last_used = 0;
+  };
+
+  mutable Mutex mutex_;
+  Map<GeoNodesEvalCacheKey, StoredEntry> entries_;
+  int64_t memory_ = 0;
+
+ public:
+  static constexpr int64_t default_memory_budget = int64_t(512) * 1024 * 1024;
+
+  GeoNodesEvalCache();
+  ~GeoNodesEvalCache();
+
+  /** Get a new identifier for a node that supports caching, see #GeoNodesEvalCacheKey. */
+  static uint64_t new_node_id();
+
+  /**
+   * The node with this identifier was destroyed, e.g. because the node tree changed. Its entries
+   * can't be found anymore, so they are removed from all caches.
+   */
+  static void remove_node_entries(uint64_t node_id);
+
+  /**
+   * Change the memory budget shared by all caches, entries are removed right away if it is
+   * exceeded.
+   * \return The previous budget.
+   */
+  static int64_t set_memory_budget(int64_t memory_budget);
+
+  std::shared_ptr<const GeoNodesEvalCacheEntry> lookup(const GeoNodesEvalCacheKey &key);
+
+  /**
+   * Add the outputs computed for the key, replacing an existing entry. Entries of all caches that
+   * were not used for the longest time are removed when the memory budget is exceeded.
+   */
+  void add(GeoNodesEvalCacheKey key, std::shared_ptr<const GeoNodesEvalCacheEntry> entry);
+
+  /** Remove entries that can't be found anymore, because some of their inputs were freed. */
+  void remove_unreachable();
+
+  void clear();
+
+  /** Approximate memory used by the cached output values in bytes. */
+  int64_t memory() const;
+
+  /** Approximate memory used by the cached output values of all caches in bytes. */
+  static int64_t memory_all();
+
+ private:
+  static void enforce_budget();
+};
+
+}  // namespace blender::nodes
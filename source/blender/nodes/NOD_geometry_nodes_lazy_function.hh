@@ -46,6 +46,8 @@ using lf::LazyFunction;
 using mf::MultiFunction;
 using ReferenceSetIndex = int;
 
+class GeoNodesEvalCache;
+
 /** The structs in here describe the different possible behaviors of a simulation input node. */
 namespace sim_input {
 
@@ -242,6 +244,11 @@ struct GeoNodesCallData {
    * If this is null, all socket values will be logged.
    */
   const Set<ComputeContextHash> *socket_log_contexts = nullptr;
+  /**
+   * Optional cache that allows nodes to reuse their outputs from previous evaluations when their
+   * inputs did not change.
+   */
+  GeoNodesEvalCache *eval_cache = nullptr;
 
   /**
    * Data from the modifier that is being evaluated.
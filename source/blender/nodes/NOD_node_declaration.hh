@@ -599,6 +599,13 @@ class NodeDeclaration {
    */
   bool is_context_dependent = false;
 
+  /**
+   * The outputs of the node only depend on its input values, so they can be reused when the node
+   * is evaluated with the same inputs again (see #GeoNodesEvalCache). Only used for nodes that are
+   * expensive enough for the cache lookup to be worth it.
+   */
+  bool outputs_cacheable = false;
+
   friend NodeDeclarationBuilder;
 
   /** Asserts that the declaration is considered valid. */
@@ -660,6 +667,7 @@ class NodeDeclarationBuilder : public DeclarationListBuilder {
 
   void use_custom_socket_order(bool enable = true);
   void allow_any_socket_order(bool enable = true);
+  void outputs_cacheable(bool enable = true);
 
   aal::RelationsInNode &get_anonymous_attribute_relations()
   {
@@ -23,6 +23,7 @@ namespace blender::nodes::node_geo_boolean_cc {
 
 static void node_declare(NodeDeclarationBuilder &b)
 {
+  b.outputs_cacheable();
   const bNode *node = b.node_or_null();
 
   auto &first_geometry = b.add_input<decl::Geometry>("Mesh 1").only_realized_data().supported_type(
@@ -2,11 +2,14 @@
  *
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
-#include "BLI_kdtree.h"
+#include "atomic_ops.h"
+
+#include "BLI_bounds.hh"
 #include "BLI_math_geom.h"
 #include "BLI_math_quaternion.hh"
 #include "BLI_math_rotation.h"
 #include "BLI_noise.hh"
+#include "BLI_offset_indices.hh"
 #include "BLI_rand.hh"
 #include "BLI_task.hh"
 
@@ -28,6 +31,7 @@ namespace blender::nodes::node_geo_distribute_points_on_faces_cc {
 
 static void node_declare(NodeDeclarationBuilder &b)
 {
+  b.outputs_cacheable();
   auto enable_random = [](bNode &node) {
     node.custom1 = GEO_NODE_POINT_DISTRIBUTE_POINTS_ON_FACES_RANDOM;
   };
@@ -114,88 +118,173 @@ static void sample_mesh_surface(const Mesh &mesh,
   const Span<int> corner_verts = mesh.corner_verts();
   const Span<int3> corner_tris = mesh.corner_tris();
 
-  for (const int tri_i : corner_tris.index_range()) {
+  /* The random number generator is seeded per triangle, so that the points can be counted and
+   * then generated in parallel, with the same result as generating them in order. */
+  auto sample_point_amount = [&](const int tri_i, RandomNumberGenerator &corner_tri_rng) {
     const int3 &tri = corner_tris[tri_i];
-    const int v0_loop = tri[0];
-    const int v1_loop = tri[1];
-    const int v2_loop = tri[2];
-    const float3 &v0_pos = positions[corner_verts[v0_loop]];
-    const float3 &v1_pos = positions[corner_verts[v1_loop]];
-    const float3 &v2_pos = positions[corner_verts[v2_loop]];
+    const float3 &v0_pos = positions[corner_verts[tri[0]]];
+    const float3 &v1_pos = positions[corner_verts[tri[1]]];
+    const float3 &v2_pos = positions[corner_verts[tri[2]]];
 
     float corner_tri_density_factor = 1.0f;
     if (!density_factors.is_empty()) {
-      const float v0_density_factor = std::max(0.0f, density_factors[v0_loop]);
-      const float v1_density_factor = std::max(0.0f, density_factors[v1_loop]);
-      const float v2_density_factor = std::max(0.0f, density_factors[v2_loop]);
+      const float v0_density_factor = std::max(0.0f, density_factors[tri[0]]);
+      const float v1_density_factor = std::max(0.0f, density_factors[tri[1]]);
+      const float v2_density_factor = std::max(0.0f, density_factors[tri[2]]);
       corner_tri_density_factor = (v0_density_factor + v1_density_factor + v2_density_factor) /
                                   3.0f;
     }
     const float area = area_tri_v3(v0_pos, v1_pos, v2_pos);
+    return corner_tri_rng.round_probabilistic(area * base_density * corner_tri_density_factor);
+  };
+
+  Array<int> offsets_data(corner_tris.size() + 1);
+  threading::parallel_for(corner_tris.index_range(), 1024, [&](const IndexRange range) {
+    for (const int tri_i : range) {
+      RandomNumberGenerator corner_tri_rng(noise::hash(tri_i, seed));
+      offsets_data[tri_i] = sample_point_amount(tri_i, corner_tri_rng);
+    }
+  });
+  const OffsetIndices points_by_tri = offset_indices::accumulate_counts_to_offsets(offsets_data);
+
+  r_positions.resize(points_by_tri.total_size());
+  r_bary_coords.resize(points_by_tri.total_size());
+  r_tri_indices.resize(points_by_tri.total_size());
+
+  threading::parallel_for(corner_tris.index_range(), 1024, [&](const IndexRange range) {
+    for (const int tri_i : range) {
+      const IndexRange tri_points = points_by_tri[tri_i];
+      if (tri_points.is_empty()) {
+        continue;
+      }
+      const int3 &tri = corner_tris[tri_i];
+      const float3 &v0_pos = positions[corner_verts[tri[0]]];
+      const float3 &v1_pos = positions[corner_verts[tri[1]]];
+      const float3 &v2_pos = positions[corner_verts[tri[2]]];
+
+      RandomNumberGenerator corner_tri_rng(noise::hash(tri_i, seed));
+      /* Advance the generator past the values used to count the points. */
+      sample_point_amount(tri_i, corner_tri_rng);
+
+      for (const int point_i : tri_points) {
+        const float3 bary_coord = corner_tri_rng.get_barycentric_coordinates();
+        interp_v3_v3v3v3(r_positions[point_i], v0_pos, v1_pos, v2_pos, bary_coord);
+        r_bary_coords[point_i] = bary_coord;
+        r_tri_indices[point_i] = tri_i;
+      }
+    }
+  });
+}
 
-    const int corner_tri_seed = noise::hash(tri_i, seed);
-    RandomNumberGenerator corner_tri_rng(corner_tri_seed);
+/**
+ * Uniform grid used to find the points that are close to a point. The cells are at least as large
+ * as the search distance, so that all close points are in the same or in a directly adjacent cell.
+ * Cells are hashed into a number of buckets proportional to the number of points, so that memory
+ * usage does not depend on the extent of the points.
+ */
+struct PointGrid {
+  double3 origin;
+  double cell_size_inv;
+  uint32_t buckets_mask;
+  OffsetIndices<int> points_by_bucket;
+  Array<int> bucket_offsets_data;
+  Array<int> bucket_points;
+
+  int3 cell(const float3 &position) const
+  {
+    return int3(math::floor((double3(position) - origin) * cell_size_inv));
+  }
 
-    const int point_amount = corner_tri_rng.round_probabilistic(area * base_density *
-                                                                corner_tri_density_factor);
+  int bucket(const int3 &cell) const
+  {
+    return int(noise::hash(uint32_t(cell.x), uint32_t(cell.y), uint32_t(cell.z)) & buckets_mask);
+  }
 
-    for (int i = 0; i < point_amount; i++) {
-      const float3 bary_coord = corner_tri_rng.get_barycentric_coordinates();
-      float3 point_pos;
-      interp_v3_v3v3v3(point_pos, v0_pos, v1_pos, v2_pos, bary_coord);
-      r_positions.append(point_pos);
-      r_bary_coords.append(bary_coord);
-      r_tri_indices.append(tri_i);
+  /** Call the function for all points in the cells adjacent to the position, and possibly more. */
+  template<typename Fn> void foreach_point_in_adjacent_cells(const float3 &position, Fn &&fn) const
+  {
+    const int3 center = this->cell(position);
+    for (int z = center.z - 1; z <= center.z + 1; z++) {
+      for (int y = center.y - 1; y <= center.y + 1; y++) {
+        for (int x = center.x - 1; x <= center.x + 1; x++) {
+          for (const int point_i : bucket_points.as_span().slice(
+                   points_by_bucket[this->bucket(int3(x, y, z))]))
+          {
+            fn(point_i);
+          }
+        }
+      }
     }
   }
-}
+};
 
-BLI_NOINLINE static KDTree_3d *build_kdtree(Span<float3> positions)
+BLI_NOINLINE static void build_point_grid(const Span<float3> positions,
+                                          const float cell_size,
+                                          PointGrid &grid)
 {
-  KDTree_3d *kdtree = BLI_kdtree_3d_new(positions.size());
+  /* Limit the number of cells along each axis, so that the cell coordinates can't overflow.
+   * Cells are made slightly larger than necessary, so that rounding can't put points that are
+   * closer than the cell size into cells that are not adjacent. */
+  constexpr double max_cells_per_axis = double(1 << 20);
+  const Bounds<float3> bounds = *bounds::min_max(positions);
+  const double max_extent = math::reduce_max(double3(bounds.max) - double3(bounds.min));
+  grid.origin = double3(bounds.min);
+  grid.cell_size_inv = 1.0 / (std::max(double(cell_size), max_extent / max_cells_per_axis) *
+                              (1.0 + 1e-5));
+
+  const int buckets_num = int(power_of_2_max_u(uint(positions.size())));
+  grid.buckets_mask = uint32_t(buckets_num - 1);
+
+  Array<int> point_buckets(positions.size());
+  threading::parallel_for(positions.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      point_buckets[i] = grid.bucket(grid.cell(positions[i]));
+    }
+  });
 
-  int i_point = 0;
-  for (const float3 position : positions) {
-    BLI_kdtree_3d_insert(kdtree, i_point, position);
-    i_point++;
-  }
+  grid.bucket_offsets_data.reinitialize(buckets_num + 1);
+  grid.bucket_offsets_data.fill(0);
+  offset_indices::build_reverse_offsets(point_buckets, grid.bucket_offsets_data);
+  grid.points_by_bucket = OffsetIndices<int>(grid.bucket_offsets_data);
 
-  BLI_kdtree_3d_balance(kdtree);
-  return kdtree;
+  /* The order of the points in a bucket is not important, so they can be added in parallel. */
+  Array<int> counts(buckets_num, 0);
+  grid.bucket_points.reinitialize(positions.size());
+  threading::parallel_for(positions.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      const int bucket = point_buckets[i];
+      const int index_in_bucket = atomic_fetch_and_add_int32(&counts[bucket], 1);
+      grid.bucket_points[grid.points_by_bucket[bucket][index_in_bucket]] = i;
+    }
+  });
 }
 
 BLI_NOINLINE static void update_elimination_mask_for_close_points(
     Span<float3> positions, const float minimum_distance, MutableSpan<bool> elimination_mask)
 {
-  if (minimum_distance <= 0.0f) {
+  if (minimum_distance <= 0.0f || positions.is_empty()) {
     return;
   }
 
-  KDTree_3d *kdtree = build_kdtree(positions);
-  BLI_SCOPED_DEFER([&]() { BLI_kdtree_3d_free(kdtree); });
+  PointGrid grid;
+  build_point_grid(positions, minimum_distance, grid);
 
+  /* Points are kept in order, and every kept point eliminates all later points that are too close
+   * to it. This has to be done serially to give the same result every time, but finding the close
+   * points with the grid only has to look at a few points around every kept point. */
+  const float minimum_distance_sq = minimum_distance * minimum_distance;
   for (const int i : positions.index_range()) {
     if (elimination_mask[i]) {
       continue;
     }
-
-    struct CallbackData {
-      int index;
-      MutableSpan<bool> elimination_mask;
-    } callback_data = {i, elimination_mask};
-
-    BLI_kdtree_3d_range_search_cb(
-        kdtree,
-        positions[i],
-        minimum_distance,
-        [](void *user_data, int index, const float * /*co*/, float /*dist_sq*/) {
-          CallbackData &callback_data = *static_cast<CallbackData *>(user_data);
-          if (index != callback_data.index) {
-            callback_data.elimination_mask[index] = true;
-          }
-          return true;
-        },
-        &callback_data);
+    const float3 position = positions[i];
+    grid.foreach_point_in_adjacent_cells(position, [&](const int other_i) {
+      if (other_i > i && math::distance_squared(position, positions[other_i]) <=
+                             minimum_distance_sq)
+      {
+        elimination_mask[other_i] = true;
+      }
+    });
   }
 }
 
@@ -207,26 +296,29 @@ BLI_NOINLINE static void update_elimination_mask_based_on_density_factors(
     const MutableSpan<bool> elimination_mask)
 {
   const Span<int3> corner_tris = mesh.corner_tris();
-  for (const int i : bary_coords.index_range()) {
-    if (elimination_mask[i]) {
-      continue;
-    }
+  threading::parallel_for(bary_coords.index_range(), 2048, [&](const IndexRange range) {
+    for (const int i : range) {
+      if (elimination_mask[i]) {
+        continue;
+      }
 
-    const int3 &tri = corner_tris[tri_indices[i]];
-    const float3 bary_coord = bary_coords[i];
+      const int3 &tri = corner_tris[tri_indices[i]];
+      const float3 bary_coord = bary_coords[i];
 
-    const float v0_density_factor = std::max(0.0f, density_factors[tri[0]]);
-    const float v1_density_factor = std::max(0.0f, density_factors[tri[1]]);
-    const float v2_density_factor = std::max(0.0f, density_factors[tri[2]]);
+      const float v0_density_factor = std::max(0.0f, density_factors[tri[0]]);
+      const float v1_density_factor = std::max(0.0f, density_factors[tri[1]]);
+      const float v2_density_factor = std::max(0.0f, density_factors[tri[2]]);
 
-    const float probability = v0_density_factor * bary_coord.x + v1_density_factor * bary_coord.y +
-                              v2_density_factor * bary_coord.z;
+      const float probability = v0_density_factor * bary_coord.x +
+                                v1_density_factor * bary_coord.y +
+                                v2_density_factor * bary_coord.z;
 
-    const float hash = noise::hash_float_to_float(bary_coord);
-    if (hash > probability) {
-      elimination_mask[i] = true;
+      const float hash = noise::hash_float_to_float(bary_coord);
+      if (hash > probability) {
+        elimination_mask[i] = true;
+      }
     }
-  }
+  });
 }
 
 BLI_NOINLINE static void eliminate_points_based_on_mask(const Span<bool> elimination_mask,
@@ -116,9 +116,12 @@ void sample_grid(const bke::OpenvdbGridType<T> &grid,
 {
   using GridType = bke::OpenvdbGridType<T>;
   using GridValueT = typename GridType::ValueType;
-  using AccessorT = typename GridType::ConstAccessor;
+  /* The accessor is only used on this thread, so it does not have to be registered with the tree,
+   * which would require a lock. It also caches the last visited nodes, so samples that are close
+   * to each other are faster. */
+  using AccessorT = typename GridType::ConstUnsafeAccessor;
   using TraitsT = typename bke::VolumeGridTraits<T>;
-  AccessorT accessor = grid.getConstAccessor();
+  AccessorT accessor = grid.getConstUnsafeAccessor();
 
   auto sample_data = [&](auto sampler) {
     mask.foreach_index([&](const int64_t i) {
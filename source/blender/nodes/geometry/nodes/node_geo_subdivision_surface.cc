@@ -31,6 +31,7 @@ static void node_declare(NodeDeclarationBuilder &b)
 {
   b.use_custom_socket_order();
   b.allow_any_socket_order();
+  b.outputs_cacheable();
   b.add_default_layout();
   b.add_input<decl::Geometry>("Mesh").supported_type(GeometryComponent::Type::Mesh);
   b.add_output<decl::Geometry>("Mesh").propagate_all().align_with_previous();
@@ -905,6 +905,11 @@ static void draw_manage_panel(const bContext *C,
                               PointerRNA *modifier_ptr,
                               NodesModifierData &nmd)
 {
+  uiLayout *col = &layout->column(false);
+  col->use_property_split_set(true);
+  col->use_property_decorate_set(false);
+  col->prop(modifier_ptr, "use_eval_cache", UI_ITEM_NONE, std::nullopt, ICON_NONE);
+
   if (uiLayout *panel_layout = layout->panel_prop(
           C, modifier_ptr, "open_bake_panel", IFACE_("Bake")))
   {
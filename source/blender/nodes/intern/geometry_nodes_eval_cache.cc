@@ -0,0 +1,565 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include <xxhash.h>
+
+#include "BLI_listbase.h"
+#include "BLI_memory_counter.hh"
+#include "BLI_set.hh"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_curves_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include "BKE_attribute_storage.hh"
+#include "BKE_curves.hh"
+#include "BKE_geometry_nodes_reference_set.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_instances.hh"
+#include "BKE_mesh.hh"
+#include "BKE_node_socket_value.hh"
+
+#include "NOD_geometry_nodes_eval_cache.hh"
+
+namespace blender::nodes {
+
+using bke::GeometryComponent;
+using bke::GeometrySet;
+using bke::SocketValueVariant;
+
+GeoNodesEvalCacheKey::GeoNodesEvalCacheKey(const uint64_t node_id,
+                                           const ComputeContextHash &context_hash)
+    : node_id_(node_id), context_hash_(context_hash)
+{
+}
+
+void GeoNodesEvalCacheKey::add_bytes(const void *data, const int64_t size)
+{
+  bytes_.extend(Span(static_cast<const uint8_t *>(data), size));
+}
+
+void GeoNodesEvalCacheKey::add_string(const StringRef str)
+{
+  /* Add the size first, so that the boundaries between strings are part of the key. */
+  this->add_trivial(str.size());
+  this->add_bytes(str.data(), str.size());
+}
+
+bool GeoNodesEvalCacheKey::add_shared_data(const ImplicitSharingInfo *sharing_info,
+                                           const void *data)
+{
+  if (data == nullptr) {
+    this->add_trivial(false);
+    return true;
+  }
+  if (sharing_info == nullptr) {
+    /* Changes of the data can't be detected. */
+    return false;
+  }
+  this->add_trivial(true);
+  sharing_info->add_weak_user();
+  shared_data_.append({WeakImplicitSharingPtr(sharing_info), data, sharing_info->version()});
+  return true;
+}
+
+void GeoNodesEvalCacheKey::finalize()
+{
+  uint64_t hash = XXH3_64bits(bytes_.data(), bytes_.size());
+  for (const SharedData &shared_data : shared_data_) {
+    hash = get_default_hash(hash, shared_data.sharing_info.get(), shared_data.version);
+  }
+  hash_ = get_default_hash(hash, node_id_, context_hash_);
+}
+
+bool GeoNodesEvalCacheKey::is_reachable() const
+{
+  return std::all_of(
+      shared_data_.begin(), shared_data_.end(), [](const SharedData &shared_data) {
+        return !shared_data.sharing_info->is_expired() &&
+               shared_data.sharing_info->version() == shared_data.version;
+      });
+}
+
+bool operator==(const GeoNodesEvalCacheKey &a, const GeoNodesEvalCacheKey &b)
+{
+  return a.hash_ == b.hash_ && a.node_id_ == b.node_id_ && a.context_hash_ == b.context_hash_ &&
+         a.bytes_.as_span() == b.bytes_.as_span() &&
+         a.shared_data_.as_span() == b.shared_data_.as_span();
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Input Values
+ *
+ * All data that can affect the result of a node has to be added to the key. When in doubt, the
+ * value is not supported, which just disables caching for the node.
+ * \{ */
+
+static bool add_custom_data(GeoNodesEvalCacheKey &key, const CustomData &data)
+{
+  key.add_trivial(data.totlayer);
+  for (const CustomDataLayer &layer : Span(data.layers, data.totlayer)) {
+    key.add_trivial(layer.type);
+    key.add_trivial(layer.flag);
+    key.add_trivial(layer.active);
+    key.add_trivial(layer.active_rnd);
+    key.add_trivial(layer.active_clone);
+    key.add_trivial(layer.active_mask);
+    key.add_string(layer.name);
+    if (!key.add_shared_data(layer.sharing_info, layer.data)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool add_attribute_storage(GeoNodesEvalCacheKey &key, const bke::AttributeStorage &storage)
+{
+  key.add_trivial(storage.count());
+  bool success = true;
+  storage.foreach_with_stop([&](const bke::Attribute &attribute) {
+    key.add_string(attribute.name());
+    key.add_trivial(attribute.domain());
+    key.add_trivial(attribute.data_type());
+    key.add_trivial(attribute.storage_type());
+    if (const auto *data = std::get_if<bke::Attribute::ArrayData>(&attribute.data())) {
+      success = key.add_shared_data(data->sharing_info.get(), data->data);
+    }
+    else if (const auto *data = std::get_if<bke::Attribute::SingleData>(&attribute.data())) {
+      success = key.add_shared_data(data->sharing_info.get(), data->value);
+    }
+    return success;
+  });
+  return success;
+}
+
+static void add_vertex_group_names(GeoNodesEvalCacheKey &key, const ListBase &vertex_group_names)
+{
+  key.add_trivial(BLI_listbase_count(&vertex_group_names));
+  LISTBASE_FOREACH (const bDeformGroup *, group, &vertex_group_names) {
+    key.add_string(group->name);
+  }
+}
+
+static void add_materials(GeoNodesEvalCacheKey &key, const Span<const Material *> materials)
+{
+  /* Materials are only referenced by the geometry, so their identity is enough. */
+  key.add_trivial(materials.size());
+  key.add_bytes(materials.data(), materials.size_in_bytes());
+}
+
+static bool add_mesh(GeoNodesEvalCacheKey &key, const Mesh &mesh)
+{
+  key.add_trivial(mesh.verts_num);
+  key.add_trivial(mesh.edges_num);
+  key.add_trivial(mesh.faces_num);
+  key.add_trivial(mesh.corners_num);
+  add_vertex_group_names(key, mesh.vertex_group_names);
+  add_materials(key, Span(const_cast<const Material **>(mesh.mat), mesh.totcol));
+  key.add_string(StringRef(mesh.active_color_attribute));
+  key.add_string(StringRef(mesh.default_color_attribute));
+  if (!key.add_shared_data(mesh.runtime->face_offsets_sharing_info, mesh.face_offset_indices)) {
+    return false;
+  }
+  return add_custom_data(key, mesh.vert_data) && add_custom_data(key, mesh.edge_data) &&
+         add_custom_data(key, mesh.face_data) && add_custom_data(key, mesh.corner_data) &&
+         add_attribute_storage(key, mesh.attribute_storage.wrap());
+}
+
+static bool add_pointcloud(GeoNodesEvalCacheKey &key, const PointCloud &pointcloud)
+{
+  key.add_trivial(pointcloud.totpoint);
+  add_materials(key, Span(const_cast<const Material **>(pointcloud.mat), pointcloud.totcol));
+  return add_attribute_storage(key, pointcloud.attribute_storage.wrap());
+}
+
+static bool add_curves(GeoNodesEvalCacheKey &key, const Curves &curves_id)
+{
+  const bke::CurvesGeometry &curves = curves_id.geometry.wrap();
+  key.add_trivial(curves.points_num());
+  key.add_trivial(curves.curves_num());
+  add_vertex_group_names(key, curves.vertex_group_names);
+  add_materials(key, Span(const_cast<const Material **>(curves_id.mat), curves_id.totcol));
+  key.add_trivial(curves_id.surface);
+  key.add_string(StringRef(curves_id.surface_uv_map));
+  if (!key.add_shared_data(curves.runtime->curve_offsets_sharing_info, curves.curve_offsets)) {
+    return false;
+  }
+  if (!key.add_shared_data(curves.runtime->custom_knots_sharing_info, curves.custom_knots)) {
+    return false;
+  }
+  return add_custom_data(key, curves.point_data) &&
+         add_attribute_storage(key, curves.attribute_storage.wrap());
+}
+
+static bool add_geometry(GeoNodesEvalCacheKey &key, const GeometrySet &geometry);
+
+static bool add_instances(GeoNodesEvalCacheKey &key, const bke::Instances &instances)
+{
+  key.add_trivial(instances.instances_num());
+  key.add_trivial(instances.references_num());
+  for (const bke::InstanceReference &reference : instances.references()) {
+    key.add_trivial(reference.type());
+    switch (reference.type()) {
+      case bke::InstanceReference::Type::None:
+        break;
+      case bke::InstanceReference::Type::GeometrySet:
+        if (!add_geometry(key, reference.geometry_set())) {
+          return false;
+        }
+        break;
+      case bke::InstanceReference::Type::Object:
+      case bke::InstanceReference::Type::Collection:
+        /* The node may access the evaluated data of the object, which is not part of the key. */
+        return false;
+    }
+  }
+  return add_attribute_storage(key, instances.attribute_storage());
+}
+
+static bool add_geometry(GeoNodesEvalCacheKey &key, const GeometrySet &geometry)
+{
+  key.add_string(geometry.name);
+  const Vector<const GeometryComponent *> components = geometry.get_components();
+  key.add_trivial(components.size());
+  for (const GeometryComponent *component : components) {
+    key.add_trivial(component->type());
+    switch (component->type()) {
+      case GeometryComponent::Type::Mesh:
+        if (!add_mesh(key, *geometry.get_mesh())) {
+          return false;
+        }
+        break;
+      case GeometryComponent::Type::PointCloud:
+        if (!add_pointcloud(key, *geometry.get_pointcloud())) {
+          return false;
+        }
+        break;
+      case GeometryComponent::Type::Curve:
+        if (!add_curves(key, *geometry.get_curves())) {
+          return false;
+        }
+        break;
+      case GeometryComponent::Type::Instance:
+        if (!add_instances(key, *geometry.get_instances())) {
+          return false;
+        }
+        break;
+      case GeometryComponent::Type::Volume:
+      case GeometryComponent::Type::GreasePencil:
+      case GeometryComponent::Type::Edit:
+        return false;
+    }
+  }
+  return true;
+}
+
+static bool add_socket_value(GeoNodesEvalCacheKey &key, const SocketValueVariant &value)
+{
+  if (!value.is_single()) {
+    /* Fields depend on the context they are evaluated in, and grids are not supported yet. */
+    return false;
+  }
+  const GPointer single_value = value.get_single_ptr();
+  const CPPType &type = *single_value.type();
+  key.add_trivial(&type);
+  if (type.is_trivial) {
+    key.add_bytes(single_value.get(), type.size);
+    return true;
+  }
+  if (type.is<std::string>()) {
+    key.add_string(*single_value.get<std::string>());
+    return true;
+  }
+  /* E.g. bundles and closures. */
+  return false;
+}
+
+static void add_reference_set(GeoNodesEvalCacheKey &key,
+                              const bke::GeometryNodesReferenceSet &reference_set)
+{
+  if (!reference_set.names) {
+    key.add_trivial(int64_t(0));
+    return;
+  }
+  /* The order of the set is not deterministic. */
+  Vector<StringRef> names(reference_set.names->begin(), reference_set.names->end());
+  std::sort(names.begin(), names.end());
+  key.add_trivial(names.size());
+  for (const StringRef name : names) {
+    key.add_string(name);
+  }
+}
+
+bool GeoNodesEvalCacheKey::add_value(const GPointer value)
+{
+  const CPPType &type = *value.type();
+  if (type.is<GeometrySet>()) {
+    return add_geometry(*this, *value.get<GeometrySet>());
+  }
+  if (type.is<SocketValueVariant>()) {
+    return add_socket_value(*this, *value.get<SocketValueVariant>());
+  }
+  if (type.is<Vector<GeometrySet>>()) {
+    const Vector<GeometrySet> &geometries = *value.get<Vector<GeometrySet>>();
+    this->add_trivial(geometries.size());
+    return std::all_of(geometries.begin(), geometries.end(), [&](const GeometrySet &geometry) {
+      return add_geometry(*this, geometry);
+    });
+  }
+  if (type.is<Vector<SocketValueVariant>>()) {
+    const Vector<SocketValueVariant> &values = *value.get<Vector<SocketValueVariant>>();
+    this->add_trivial(values.size());
+    return std::all_of(values.begin(), values.end(), [&](const SocketValueVariant &value) {
+      return add_socket_value(*this, value);
+    });
+  }
+  if (type.is<bke::GeometryNodesReferenceSet>()) {
+    add_reference_set(*this, *value.get<bke::GeometryNodesReferenceSet>());
+    return true;
+  }
+  if (type.is<bool>()) {
+    this->add_trivial(*value.get<bool>());
+    return true;
+  }
+  if (type.is<Material *>()) {
+    this->add_trivial(*value.get<Material *>());
+    return true;
+  }
+  /* Other data-blocks like objects and images are accessed by the node, but their data is not part
+   * of the key. */
+  return false;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cache
+ * \{ */
+
+GeoNodesEvalCacheEntry::GeoNodesEvalCacheEntry(const int outputs_num)
+    : outputs(outputs_num, GMutablePointer())
+{
+}
+
+GeoNodesEvalCacheEntry::~GeoNodesEvalCacheEntry()
+{
+  for (GMutablePointer value : outputs) {
+    if (value) {
+      value.destruct();
+      MEM_freeN(value.get());
+    }
+  }
+}
+
+void GeoNodesEvalCacheEntry::add_output(const int index, const GPointer value)
+{
+  BLI_assert(!outputs[index]);
+  const CPPType &type = *value.type();
+  void *buffer = MEM_mallocN_aligned(type.size, type.alignment, __func__);
+  type.copy_construct(value.get(), buffer);
+  outputs[index] = {type, buffer};
+
+  memory += type.size;
+  if (type.is<GeometrySet>()) {
+    /* Most of the memory is shared with the geometry passed on to other nodes, but it is kept
+     * alive by the cache as well. */
+    memory_counter::MemoryCount count;
+    MemoryCounter memory_counter{count};
+    value.get<GeometrySet>()->count_memory(memory_counter);
+    memory += count.total_bytes;
+  }
+}
+
+namespace {
+
+/**
+ * All caches, so that they can share one memory budget and entries of destroyed nodes can be
+ * removed from all of them.
+ */
+struct EvalCacheRegistry {
+  /** Locked before the mutexes of the caches, when both are needed. */
+  Mutex mutex;
+  Set<GeoNodesEvalCache *> caches;
+  std::atomic<int64_t> memory = 0;
+  std::atomic<int64_t> memory_budget = GeoNodesEvalCache::default_memory_budget;
+  /** Time stamps for the last use of entries, comparable between caches. */
+  std::atomic<int64_t> use_counter = 0;
+};
+
+EvalCacheRegistry &eval_cache_registry()
+{
+  static EvalCacheRegistry registry;
+  return registry;
+}
+
+}  // namespace
+
+GeoNodesEvalCache::GeoNodesEvalCache()
+{
+  EvalCacheRegistry &registry = eval_cache_registry();
+  std::lock_guard lock{registry.mutex};
+  registry.caches.add_new(this);
+}
+
+GeoNodesEvalCache::~GeoNodesEvalCache()
+{
+  EvalCacheRegistry &registry = eval_cache_registry();
+  std::lock_guard lock{registry.mutex};
+  registry.caches.remove_contained(this);
+  registry.memory -= memory_;
+}
+
+uint64_t GeoNodesEvalCache::new_node_id()
+{
+  static std::atomic<uint64_t> next_id = 1;
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+void GeoNodesEvalCache::remove_node_entries(const uint64_t node_id)
+{
+  EvalCacheRegistry &registry = eval_cache_registry();
+  std::lock_guard registry_lock{registry.mutex};
+  for (GeoNodesEvalCache *cache : registry.caches) {
+    std::lock_guard lock{cache->mutex_};
+    cache->entries_.remove_if([&](const auto item) {
+      if (item.key.node_id() != node_id) {
+        return false;
+      }
+      cache->memory_ -= item.value.entry->memory;
+      registry.memory -= item.value.entry->memory;
+      return true;
+    });
+  }
+}
+
+int64_t GeoNodesEvalCache::set_memory_budget(const int64_t memory_budget)
+{
+  const int64_t old_budget = eval_cache_registry().memory_budget.exchange(memory_budget);
+  enforce_budget();
+  return old_budget;
+}
+
+std::shared_ptr<const GeoNodesEvalCacheEntry> GeoNodesEvalCache::lookup(
+    const GeoNodesEvalCacheKey &key)
+{
+  std::lock_guard lock{mutex_};
+  StoredEntry *stored_entry = entries_.lookup_ptr(key);
+  if (stored_entry == nullptr) {
+    return {};
+  }
+  stored_entry->last_used = eval_cache_registry().use_counter.fetch_add(1);
+  return stored_entry->entry;
+}
+
+void GeoNodesEvalCache::add(GeoNodesEvalCacheKey key,
+                            std::shared_ptr<const GeoNodesEvalCacheEntry> entry)
+{
+  EvalCacheRegistry &registry = eval_cache_registry();
+  if (entry->memory > registry.memory_budget.load()) {
+    return;
+  }
+  {
+    std::lock_guard lock{mutex_};
+    const int64_t last_used = registry.use_counter.fetch_add(1);
+    int64_t memory_change = entry->memory;
+    entries_.add_or_modify(
+        std::move(key),
+        [&](StoredEntry *stored_entry) {
+          new (stored_entry) StoredEntry{std::move(entry), last_used};
+        },
+        [&](StoredEntry *stored_entry) {
+          memory_change -= stored_entry->entry->memory;
+          *stored_entry = {std::move(entry), last_used};
+        });
+    memory_ += memory_change;
+    registry.memory += memory_change;
+  }
+  enforce_budget();
+}
+
+void GeoNodesEvalCache::enforce_budget()
+{
+  EvalCacheRegistry &registry = eval_cache_registry();
+  if (registry.memory.load() <= registry.memory_budget.load()) {
+    return;
+  }
+  std::lock_guard registry_lock{registry.mutex};
+  /* Lock all caches, to find the entries that were not used for the longest time in any of them.
+   * This is not particularly fast, but it is only done when the budget is exceeded. */
+  struct Candidate {
+    int64_t last_used;
+    GeoNodesEvalCache *cache;
+    const GeoNodesEvalCacheKey *key;
+    int64_t memory;
+  };
+  Vector<std::unique_lock<Mutex>> locks;
+  Vector<Candidate> candidates;
+  for (GeoNodesEvalCache *cache : registry.caches) {
+    locks.append(std::unique_lock(cache->mutex_));
+    for (const auto item : cache->entries_.items()) {
+      candidates.append({item.value.last_used, cache, &item.key, item.value.entry->memory});
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+    return a.last_used < b.last_used;
+  });
+  const int64_t memory_budget = registry.memory_budget.load();
+  int64_t memory = registry.memory.load();
+  Vector<std::pair<GeoNodesEvalCache *, GeoNodesEvalCacheKey>> keys_to_remove;
+  for (const Candidate &candidate : candidates) {
+    if (memory <= memory_budget) {
+      break;
+    }
+    memory -= candidate.memory;
+    candidate.cache->memory_ -= candidate.memory;
+    registry.memory -= candidate.memory;
+    keys_to_remove.append({candidate.cache, *candidate.key});
+  }
+  for (const auto &[cache, key] : keys_to_remove) {
+    cache->entries_.remove(key);
+  }
+}
+
+void GeoNodesEvalCache::remove_unreachable()
+{
+  std::lock_guard lock{mutex_};
+  entries_.remove_if([&](const auto item) {
+    if (item.key.is_reachable()) {
+      return false;
+    }
+    memory_ -= item.value.entry->memory;
+    eval_cache_registry().memory -= item.value.entry->memory;
+    return true;
+  });
+}
+
+void GeoNodesEvalCache::clear()
+{
+  std::lock_guard lock{mutex_};
+  entries_.clear();
+  eval_cache_registry().memory -= memory_;
+  memory_ = 0;
+}
+
+int64_t GeoNodesEvalCache::memory() const
+{
+  std::lock_guard lock{mutex_};
+  return memory_;
+}
+
+int64_t GeoNodesEvalCache::memory_all()
+{
+  return eval_cache_registry().memory.load();
+}
+
+/** \} */
+
+}  // namespace blender::nodes
@@ -0,0 +1,216 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+#include "testing/testing.h"
+
+#include "CLG_log.h"
+
+#include "BKE_attribute.hh"
+#include "BKE_geometry_nodes_reference_set.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_mesh.hh"
+#include "BKE_node_socket_value.hh"
+
+#include "DNA_mesh_types.h"
+
+#include "NOD_geometry_nodes_eval_cache.hh"
+
+namespace blender::nodes::tests {
+
+using bke::GeometryNodesReferenceSet;
+using bke::GeometrySet;
+using bke::SocketValueVariant;
+
+class GeoNodesEvalCacheTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    CLG_init();
+    BKE_idtype_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    CLG_exit();
+  }
+
+  static Mesh *create_mesh()
+  {
+    Mesh *mesh = BKE_mesh_new_nomain(4, 0, 0, 0);
+    mesh->vert_positions_for_write().copy_from(
+        {float3(0, 0, 0), float3(1, 0, 0), float3(1, 1, 0), float3(0, 1, 0)});
+    return mesh;
+  }
+
+  static GeoNodesEvalCacheKey build_key(const Span<GPointer> values,
+                                        const uint64_t node_id = 1,
+                                        const ComputeContextHash context_hash = {})
+  {
+    GeoNodesEvalCacheKey key{node_id, context_hash};
+    for (const GPointer value : values) {
+      EXPECT_TRUE(key.add_value(value));
+    }
+    key.finalize();
+    return key;
+  }
+
+  static GeoNodesEvalCacheKey build_key(const GeometrySet &geometry, const uint64_t node_id = 1)
+  {
+    return build_key({GPointer(&geometry)}, node_id);
+  }
+
+  static std::shared_ptr<const GeoNodesEvalCacheEntry> create_entry(const int value)
+  {
+    auto entry = std::make_shared<GeoNodesEvalCacheEntry>(1);
+    entry->add_output(0, GPointer(&value));
+    return entry;
+  }
+};
+
+TEST_F(GeoNodesEvalCacheTest, identical_inputs)
+{
+  const GeometrySet geometry = GeometrySet::from_mesh(create_mesh());
+  EXPECT_EQ(build_key(geometry), build_key(geometry));
+
+  /* A copy of the geometry shares its arrays, so it is identified as the same input. */
+  const GeometrySet copy = GeometrySet::from_mesh(BKE_mesh_copy_for_eval(*geometry.get_mesh()));
+  const GeoNodesEvalCacheKey key = build_key(geometry);
+  const GeoNodesEvalCacheKey copy_key = build_key(copy);
+  EXPECT_EQ(key.hash(), copy_key.hash());
+  EXPECT_EQ(key, copy_key);
+
+  GeoNodesEvalCache cache;
+  cache.add(build_key(geometry), create_entry(3));
+  const std::shared_ptr<const GeoNodesEvalCacheEntry> entry = cache.lookup(copy_key);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(*entry->outputs[0].get<int>(), 3);
+}
+
+TEST_F(GeoNodesEvalCacheTest, modified_data)
+{
+  GeometrySet geometry = GeometrySet::from_mesh(create_mesh());
+  const GeoNodesEvalCacheKey key = build_key(geometry);
+  EXPECT_TRUE(key.is_reachable());
+
+  /* Changing positions in place changes the version of the shared array. */
+  Mesh *mesh = geometry.get_mesh_for_write();
+  mesh->vert_positions_for_write()[0] = float3(0, 0, 1);
+  EXPECT_NE(key, build_key(geometry));
+  EXPECT_FALSE(key.is_reachable());
+}
+
+TEST_F(GeoNodesEvalCacheTest, attribute_names)
+{
+  GeometrySet geometry = GeometrySet::from_mesh(create_mesh());
+  const GeoNodesEvalCacheKey key = build_key(geometry);
+
+  bke::MutableAttributeAccessor attributes = geometry.get_mesh_for_write()->attributes_for_write();
+  attributes.add<float>("a", bke::AttrDomain::Point, bke::AttributeInitDefaultValue());
+  const GeoNodesEvalCacheKey added_key = build_key(geometry);
+  EXPECT_NE(key, added_key);
+
+  attributes.rename("a", "b");
+  const GeoNodesEvalCacheKey renamed_key = build_key(geometry);
+  EXPECT_NE(added_key, renamed_key);
+  EXPECT_NE(key, renamed_key);
+}
+
+TEST_F(GeoNodesEvalCacheTest, reference_sets)
+{
+  GeometryNodesReferenceSet a;
+  a.names = std::make_shared<Set<std::string>>(Set<std::string>{"x", "y"});
+  GeometryNodesReferenceSet b;
+  b.names = std::make_shared<Set<std::string>>(Set<std::string>{"y", "x"});
+  GeometryNodesReferenceSet c;
+  c.names = std::make_shared<Set<std::string>>(Set<std::string>{"x", "z"});
+  const GeometryNodesReferenceSet empty;
+
+  EXPECT_EQ(build_key({GPointer(&a)}), build_key({GPointer(&b)}));
+  EXPECT_NE(build_key({GPointer(&a)}), build_key({GPointer(&c)}));
+  EXPECT_NE(build_key({GPointer(&a)}), build_key({GPointer(&empty)}));
+}
+
+TEST_F(GeoNodesEvalCacheTest, single_values)
+{
+  const SocketValueVariant a(2);
+  const SocketValueVariant b(2);
+  const SocketValueVariant c(3);
+  const SocketValueVariant d(2.0f);
+  EXPECT_EQ(build_key({GPointer(&a)}), build_key({GPointer(&b)}));
+  EXPECT_NE(build_key({GPointer(&a)}), build_key({GPointer(&c)}));
+  /* The same bytes with a different type. */
+  EXPECT_NE(build_key({GPointer(&a)}), build_key({GPointer(&d)}));
+}
+
+TEST_F(GeoNodesEvalCacheTest, node_and_context)
+{
+  const SocketValueVariant value(2);
+  ComputeContextHash context_hash;
+  context_hash.v1 = 1;
+  EXPECT_NE(build_key({GPointer(&value)}, 1), build_key({GPointer(&value)}, 2));
+  EXPECT_NE(build_key({GPointer(&value)}, 1), build_key({GPointer(&value)}, 1, context_hash));
+}
+
+TEST_F(GeoNodesEvalCacheTest, remove_unreachable)
+{
+  GeometrySet geometry = GeometrySet::from_mesh(create_mesh());
+  GeoNodesEvalCache cache;
+  cache.add(build_key(geometry), create_entry(1));
+  cache.remove_unreachable();
+  EXPECT_GT(cache.memory(), 0);
+
+  geometry.clear();
+  cache.remove_unreachable();
+  EXPECT_EQ(cache.memory(), 0);
+}
+
+TEST_F(GeoNodesEvalCacheTest, remove_node_entries)
+{
+  const GeometrySet geometry = GeometrySet::from_mesh(create_mesh());
+  const uint64_t node_id_a = GeoNodesEvalCache::new_node_id();
+  const uint64_t node_id_b = GeoNodesEvalCache::new_node_id();
+  GeoNodesEvalCache cache_a;
+  GeoNodesEvalCache cache_b;
+  cache_a.add(build_key(geometry, node_id_a), create_entry(1));
+  cache_a.add(build_key(geometry, node_id_b), create_entry(2));
+  cache_b.add(build_key(geometry, node_id_a), create_entry(3));
+
+  GeoNodesEvalCache::remove_node_entries(node_id_a);
+  EXPECT_EQ(cache_a.lookup(build_key(geometry, node_id_a)), nullptr);
+  EXPECT_NE(cache_a.lookup(build_key(geometry, node_id_b)), nullptr);
+  EXPECT_EQ(cache_b.lookup(build_key(geometry, node_id_a)), nullptr);
+  EXPECT_EQ(cache_b.memory(), 0);
+}
+
+TEST_F(GeoNodesEvalCacheTest, shared_memory_budget)
+{
+  const int64_t entry_memory = create_entry(0)->memory;
+  const int64_t old_budget = GeoNodesEvalCache::set_memory_budget(entry_memory * 2);
+  {
+    GeoNodesEvalCache cache_a;
+    GeoNodesEvalCache cache_b;
+    const SocketValueVariant value(0);
+    cache_a.add(build_key({GPointer(&value)}, 1), create_entry(1));
+    cache_b.add(build_key({GPointer(&value)}, 2), create_entry(2));
+    EXPECT_EQ(GeoNodesEvalCache::memory_all(), entry_memory * 2);
+
+    /* Use the first entry, so that the entry of the other cache is the oldest one. */
+    EXPECT_NE(cache_a.lookup(build_key({GPointer(&value)}, 1)), nullptr);
+    cache_a.add(build_key({GPointer(&value)}, 3), create_entry(3));
+    EXPECT_EQ(GeoNodesEvalCache::memory_all(), entry_memory * 2);
+    EXPECT_NE(cache_a.lookup(build_key({GPointer(&value)}, 1)), nullptr);
+    EXPECT_NE(cache_a.lookup(build_key({GPointer(&value)}, 3)), nullptr);
+    EXPECT_EQ(cache_b.lookup(build_key({GPointer(&value)}, 2)), nullptr);
+    EXPECT_EQ(cache_b.memory(), 0);
+
+    /* Lowering the budget removes entries right away. */
+    GeoNodesEvalCache::set_memory_budget(entry_memory);
+    EXPECT_EQ(cache_a.memory(), entry_memory);
+    EXPECT_NE(cache_a.lookup(build_key({GPointer(&value)}, 3)), nullptr);
+  }
+  EXPECT_EQ(GeoNodesEvalCache::memory_all(), 0);
+  GeoNodesEvalCache::set_memory_budget(old_budget);
+}
+
+}  // namespace blender::nodes::tests
@@ -21,6 +21,7 @@
  */
 
 #include "NOD_geometry_exec.hh"
+#include "NOD_geometry_nodes_eval_cache.hh"
 #include "NOD_geometry_nodes_lazy_function.hh"
 #include "NOD_multi_function.hh"
 #include "NOD_node_declaration.hh"
@@ -49,6 +50,7 @@
 
 #include "ED_node.hh"
 
+#include "FN_lazy_function_execute.hh"
 #include "FN_lazy_function_graph_executor.hh"
 
 #include "DEG_depsgraph_query.hh"
@@ -143,6 +145,8 @@ class LazyFunctionForGeometryNode : public LazyFunction {
    * does not have to execute.
    */
   Vector<bool> is_attribute_output_bsocket_;
+  /** Identifier of the node in the #GeoNodesEvalCache, zero if the outputs are not cached. */
+  uint64_t cache_node_id_ = 0;
 
  public:
   LazyFunctionForGeometryNode(const bNode &node,
@@ -157,6 +161,9 @@ class LazyFunctionForGeometryNode : public LazyFunction {
         node, inputs_, outputs_, own_lf_graph_info.mapping.lf_index_by_bsocket);
 
     const NodeDeclaration &node_decl = *node.declaration();
+    if (node_decl.outputs_cacheable) {
+      cache_node_id_ = GeoNodesEvalCache::new_node_id();
+    }
     const aal::RelationsInNode *relations = node_decl.anonymous_attribute_relations();
     if (relations == nullptr) {
       return;
@@ -197,6 +204,15 @@ class LazyFunctionForGeometryNode : public LazyFunction {
     }
   }
 
+  ~LazyFunctionForGeometryNode() override
+  {
+    if (cache_node_id_ != 0) {
+      /* The entries can't be found anymore, because a new identifier is used when the lazy
+       * function graph is built again. */
+      GeoNodesEvalCache::remove_node_entries(cache_node_id_);
+    }
+  }
+
   void execute_impl(lf::Params &params, const lf::Context &context) const override
   {
     const ScopedNodeTimer node_timer{context, node_};
@@ -246,8 +262,19 @@ class LazyFunctionForGeometryNode : public LazyFunction {
       return;
     }
 
+    if (cache_node_id_ != 0 && user_data->call_data->eval_cache != nullptr) {
+      this->execute_node_cached(params, context, *user_data, *user_data->call_data->eval_cache);
+      return;
+    }
+    this->execute_node(params, context, *user_data);
+  }
+
+  void execute_node(lf::Params &params,
+                    const lf::Context &context,
+                    const GeoNodesUserData &user_data) const
+  {
     auto get_anonymous_attribute_name = [&](const int i) {
-      return this->anonymous_attribute_name_for_output(*user_data, i);
+      return this->anonymous_attribute_name_for_output(user_data, i);
     };
 
     GeoNodeExecParams geo_params{
@@ -261,6 +288,106 @@ class LazyFunctionForGeometryNode : public LazyFunction {
     node_.typeinfo->geometry_node_execute(geo_params);
   }
 
+  /**
+   * Reuse the outputs from a previous evaluation with the same inputs if possible. Otherwise the
+   * node is executed, and its outputs are added to the cache before they are passed on.
+   */
+  void execute_node_cached(lf::Params &params,
+                           const lf::Context &context,
+                           const GeoNodesUserData &user_data,
+                           GeoNodesEvalCache &eval_cache) const
+  {
+    GeoNodesEvalCacheKey key{cache_node_id_, user_data.compute_context->hash()};
+    /* The object name is part of the names of anonymous attributes created by the node. */
+    key.add_string(user_data.call_data->self_object()->id.name);
+    for (const int i : inputs_.index_range()) {
+      if (!key.add_value({*inputs_[i].type, params.try_get_input_data_ptr(i)})) {
+        this->execute_node(params, context, user_data);
+        return;
+      }
+    }
+    key.finalize();
+
+    geo_eval_log::GeoTreeLogger *tree_logger = nullptr;
+    if (const auto *local_user_data = dynamic_cast<GeoNodesLocalUserData *>(
+            context.local_user_data))
+    {
+      tree_logger = local_user_data->try_get_tree_logger(user_data);
+    }
+
+    auto output_is_required = [&](const int i) {
+      return !params.output_was_set(i) &&
+             params.get_output_usage(i) != lf::ValueUsage::Unused;
+    };
+
+    if (const std::shared_ptr<const GeoNodesEvalCacheEntry> entry = eval_cache.lookup(key)) {
+      const bool has_required_outputs = std::all_of(
+          outputs_.index_range().begin(), outputs_.index_range().end(), [&](const int i) {
+            return !output_is_required(i) || entry->outputs[i];
+          });
+      if (has_required_outputs) {
+        for (const int i : outputs_.index_range()) {
+          if (output_is_required(i)) {
+            const GPointer value = entry->outputs[i];
+            value.type()->copy_construct(value.get(), params.get_output_data_ptr(i));
+            params.output_set(i);
+          }
+        }
+        if (tree_logger) {
+          for (const auto &[type, message] : entry->warnings) {
+            tree_logger->node_warnings.append(*tree_logger->allocator,
+                                              {node_.identifier, {type, message}});
+          }
+        }
+        return;
+      }
+    }
+
+    /* Execute the node with separate output buffers, so that the output values can be copied to
+     * the cache before they are passed to other nodes. */
+    LinearAllocator<> allocator;
+    Array<GMutablePointer> input_values(inputs_.size());
+    Array<std::optional<lf::ValueUsage>> input_usages(inputs_.size());
+    for (const int i : inputs_.index_range()) {
+      input_values[i] = {*inputs_[i].type, params.try_get_input_data_ptr(i)};
+    }
+    Array<GMutablePointer> output_values(outputs_.size());
+    Array<lf::ValueUsage> output_usages(outputs_.size());
+    Array<bool> set_outputs(outputs_.size());
+    for (const int i : outputs_.index_range()) {
+      const CPPType &type = *outputs_[i].type;
+      output_values[i] = {type, allocator.allocate(type)};
+      output_usages[i] = params.get_output_usage(i);
+      set_outputs[i] = params.output_was_set(i);
+    }
+    lf::BasicParams node_params{
+        *this, input_values, output_values, input_usages, output_usages, set_outputs};
+    this->execute_node(node_params, context, user_data);
+
+    auto entry = std::make_shared<GeoNodesEvalCacheEntry>(outputs_.size());
+    for (const int i : outputs_.index_range()) {
+      if (!set_outputs[i] || params.output_was_set(i)) {
+        continue;
+      }
+      GMutablePointer value = output_values[i];
+      entry->add_output(i, value);
+      value.type()->move_construct(value.get(), params.get_output_data_ptr(i));
+      value.destruct();
+      params.output_set(i);
+    }
+    /* Warnings are only known when logging is enabled. */
+    if (tree_logger) {
+      for (const geo_eval_log::GeoTreeLogger::WarningWithNode &warning :
+           tree_logger->node_warnings)
+      {
+        if (warning.node_id == node_.identifier) {
+          entry->warnings.append({warning.warning.type, warning.warning.message});
+        }
+      }
+    }
+    eval_cache.add(std::move(key), std::move(entry));
+  }
+
   std::string input_name(const int index) const override
   {
     for (const bNodeSocket *bsocket : node_.output_sockets()) {
@@ -132,6 +132,11 @@ void NodeDeclarationBuilder::allow_any_socket_order(bool enable)
   declaration_.allow_any_socket_order = enable;
 }
 
+void NodeDeclarationBuilder::outputs_cacheable(bool enable)
+{
+  declaration_.outputs_cacheable = enable;
+}
+
 Span<SocketDeclaration *> NodeDeclaration::sockets(eNodeSocketInOut in_out) const
 {
   if (in_out == SOCK_IN) {
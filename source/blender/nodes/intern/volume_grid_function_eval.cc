@@ -225,12 +225,20 @@ BLI_NOINLINE static void process_leaf_node(const mf::MultiFunction &fn,
                                            const openvdb::CoordBBox &leaf_bbox,
                                            const GetVoxelsFn get_voxels_fn)
 {
-  /* Create an index mask for all the active voxels in the leaf. */
+  /* Create an index mask for all the active voxels in the leaf. The bits of the leaf mask are
+   * ordered like the voxels in the leaf buffers, so the mask words can be used directly. */
   IndexMaskMemory memory;
-  const IndexMask index_mask = IndexMask::from_predicate(
-      IndexRange(LeafNodeMask::SIZE), GrainSize(LeafNodeMask::SIZE), memory, [&](const int64_t i) {
-        return leaf_node_mask.isOn(i);
-      });
+  IndexMask index_mask;
+  if (leaf_node_mask.isOn()) {
+    index_mask = IndexMask(LeafNodeMask::SIZE);
+  }
+  else {
+    std::array<bits::BitInt, LeafNodeMask::WORD_COUNT> mask_words;
+    for (const int i : IndexRange(LeafNodeMask::WORD_COUNT)) {
+      mask_words[i] = leaf_node_mask.getWord<LeafNodeMask::Word>(i);
+    }
+    index_mask = IndexMask::from_bits(BitSpan(mask_words.data(), LeafNodeMask::SIZE), memory);
+  }
 
   AlignedBuffer<8192, 8> allocation_buffer;
   ResourceScope scope;
@@ -269,12 +277,10 @@ BLI_NOINLINE static void process_leaf_node(const mf::MultiFunction &fn,
           /* Boolean grids are special because they encode the values as bitmask. So create a
            * temporary buffer for the inputs. */
           if constexpr (std::is_same_v<ValueT, bool>) {
-            const Span<openvdb::Coord> voxels = ensure_voxel_coords();
             MutableSpan<bool> values = scope.allocator().allocate_array<bool>(
                 index_mask.min_array_size());
-            index_mask.foreach_index([&](const int64_t i) {
-              const openvdb::Coord &coord = voxels[i];
-              values[i] = tree.getValue(coord);
+            index_mask.foreach_index_optimized<int>([&](const int i) {
+              values[i] = leaf_node->getValue(openvdb::Index(i));
             });
             params.add_readonly_single_input(values);
           }
@@ -371,12 +377,11 @@ BLI_NOINLINE static void process_leaf_node(const mf::MultiFunction &fn,
     }
     openvdb::BoolGrid &grid = static_cast<openvdb::BoolGrid &>(*output_grids[output_i]);
     const Span<bool> values = params.computed_array(param_index).typed<bool>();
-    auto accessor = grid.getUnsafeAccessor();
-    const Span<openvdb::Coord> voxels = ensure_voxel_coords();
-    index_mask.foreach_index([&](const int64_t i) {
-      const openvdb::Coord &coord = voxels[i];
-      accessor.setValue(coord, values[i]);
-    });
+    /* The voxels are active already, only the values have to be set. */
+    openvdb::BoolTree::LeafNodeType *leaf_node = grid.tree().probeLeaf(any_voxel_in_leaf);
+    BLI_assert(leaf_node);
+    index_mask.foreach_index_optimized<int>(
+        [&](const int i) { leaf_node->setValueOnly(openvdb::Index(i), values[i]); });
   }
 }
 
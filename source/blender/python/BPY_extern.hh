@@ -73,6 +73,11 @@ void BPY_modules_update();
 void BPY_modules_load_user(bContext *C);
 
 void BPY_app_handlers_reset(bool do_all);
+/**
+ * True when scripts registered handlers that run when the frame changes,
+ * these expect the scene to be at the frame that is being evaluated.
+ */
+[[nodiscard]] bool BPY_app_handlers_frame_change_used();
 
 /**
  * Run on exit to free any cached data.
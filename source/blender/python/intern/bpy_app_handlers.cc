@@ -342,6 +342,17 @@ void BPY_app_handlers_reset(const bool do_all)
   PyGILState_Release(gilstate);
 }
 
+bool BPY_app_handlers_frame_change_used()
+{
+  for (const eCbEvent event : {BKE_CB_EVT_FRAME_CHANGE_PRE, BKE_CB_EVT_FRAME_CHANGE_POST}) {
+    PyObject *cb_list = py_cb_array[event];
+    if (cb_list && PyList_GET_SIZE(cb_list) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 static PyObject *choose_arguments(PyObject *func, PyObject *args_all, PyObject *args_single)
 {
   if (!PyFunction_Check(func)) {
@@ -721,6 +721,8 @@ static void engine_depsgraph_init(RenderEngine *engine, ViewLayer *view_layer)
     }
   }
   else {
+    /* Reuse the meshes the viewport already evaluated for the rendered frame. */
+    DEG_reuse_viewport_meshes(engine->depsgraph);
     /* Go through update with full Python callbacks for regular render. */
     BKE_scene_graph_update_for_newframe_ex(engine->depsgraph, false);
   }
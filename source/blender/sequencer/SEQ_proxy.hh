@@ -35,6 +35,11 @@ bool proxy_rebuild_context(Main *bmain,
                            bool build_only_on_bad_performance);
 void proxy_rebuild(IndexBuildContext *context, wmJobWorkerStatus *worker_status);
 void proxy_rebuild_finish(IndexBuildContext *context, bool stop);
+/**
+ * Movie proxies are built from a separate reader of the movie file, and can be built at the same
+ * time as other proxies. Image strip proxies are rendered by the sequencer.
+ */
+bool proxy_rebuild_is_movie(const IndexBuildContext *context);
 void proxy_set(Strip *strip, bool value);
 bool can_use_proxy(const RenderData *context, const Strip *strip, int psize);
 int rendersize_to_proxysize(int render_size);
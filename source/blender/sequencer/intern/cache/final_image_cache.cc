@@ -6,6 +6,13 @@
  * \ingroup sequencer
  */
 
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+#include "atomic_ops.h"
+
 #include "BLI_hash.hh"
 #include "BLI_map.hh"
 #include "BLI_mutex.hh"
@@ -24,7 +31,13 @@
 
 namespace blender::seq {
 
-static Mutex final_image_cache_mutex;
+/**
+ * Protects the lifetime of the cache: every access holds it shared for as long as it uses the
+ * cache, creation and destruction hold it exclusively. Access to the cached images themselves is
+ * synchronized per shard, so that playback, prefetch workers and thumbnail jobs do not serialize
+ * on a single lock.
+ */
+static std::shared_mutex final_image_cache_mutex;
 
 struct FinalImageCache {
   struct Key {
@@ -43,57 +56,101 @@ struct FinalImageCache {
              display_channel == other.display_channel;
     }
   };
-  Map<Key, ImBuf *> map_;
+
+  struct Entry {
+    ImBuf *image = nullptr;
+    /** Size of the image at the time it was added, so that the totals stay consistent. */
+    size_t memory_size = 0;
+  };
+
+  /* Aligned to avoid false sharing of the mutexes between threads. */
+  struct alignas(64) Shard {
+    Mutex mutex;
+    Map<Key, Entry> map;
+  };
+
+  static constexpr int shards_num = 16;
+  std::array<Shard, shards_num> shards_;
+
+  /* Totals over all shards, updated whenever an entry is added or removed. */
+  std::atomic<size_t> memory_size_ = 0;
+  std::atomic<size_t> image_count_ = 0;
 
   ~FinalImageCache()
   {
     clear();
   }
 
+  Shard &shard_for_key(const Key &key)
+  {
+    return shards_[key.hash() % shards_num];
+  }
+
+  void remove_entry_in_shard(Shard &shard, const Key &key)
+  {
+    const Entry entry = shard.map.pop(key);
+    memory_size_ -= entry.memory_size;
+    image_count_--;
+    IMB_freeImBuf(entry.image);
+  }
+
   void clear()
   {
-    for (ImBuf *item : map_.values()) {
-      IMB_freeImBuf(item);
+    for (Shard &shard : shards_) {
+      std::lock_guard lock(shard.mutex);
+      for (const Entry &entry : shard.map.values()) {
+        memory_size_ -= entry.memory_size;
+        image_count_--;
+        IMB_freeImBuf(entry.image);
+      }
+      shard.map.clear();
     }
-    map_.clear();
   }
 };
 
-static FinalImageCache *ensure_final_image_cache(Scene *scene)
+static void ensure_final_image_cache(Scene *scene)
 {
-  FinalImageCache **cache = &scene->ed->runtime.final_image_cache;
-  if (*cache == nullptr) {
-    *cache = MEM_new<FinalImageCache>(__func__);
+  /* The pointer is read without holding the lock exclusively, so access it atomically. */
+  void **cache = reinterpret_cast<void **>(&scene->ed->runtime.final_image_cache);
+  if (atomic_load_ptr(cache) != nullptr) {
+    return;
+  }
+  std::unique_lock lock(final_image_cache_mutex);
+  if (atomic_load_ptr(cache) == nullptr) {
+    atomic_store_ptr(cache, MEM_new<FinalImageCache>(__func__));
   }
-  return *cache;
 }
 
+/** The caller has to hold #final_image_cache_mutex. */
 static FinalImageCache *query_final_image_cache(const Scene *scene)
 {
   if (scene == nullptr || scene->ed == nullptr) {
     return nullptr;
   }
-  return scene->ed->runtime.final_image_cache;
+  return static_cast<FinalImageCache *>(
+      atomic_load_ptr(reinterpret_cast<void *const *>(&scene->ed->runtime.final_image_cache)));
 }
 
 ImBuf *final_image_cache_get(Scene *scene, float timeline_frame, int view_id, int display_channel)
 {
   const FinalImageCache::Key key = {int(math::round(timeline_frame)), view_id, display_channel};
 
-  ImBuf *res = nullptr;
-  {
-    std::lock_guard lock(final_image_cache_mutex);
-    FinalImageCache *cache = query_final_image_cache(scene);
-    if (cache == nullptr) {
-      return nullptr;
-    }
-    res = cache->map_.lookup_default(key, nullptr);
+  std::shared_lock cache_lock(final_image_cache_mutex);
+  FinalImageCache *cache = query_final_image_cache(scene);
+  if (cache == nullptr) {
+    return nullptr;
   }
 
-  if (res) {
-    IMB_refImBuf(res);
+  FinalImageCache::Shard &shard = cache->shard_for_key(key);
+  std::lock_guard lock(shard.mutex);
+  const FinalImageCache::Entry *entry = shard.map.lookup_ptr(key);
+  if (entry == nullptr) {
+    return nullptr;
   }
-  return res;
+  /* Add the reference while the shard is locked, so that the image can't be freed by a
+   * concurrent eviction in between. */
+  IMB_refImBuf(entry->image);
+  return entry->image;
 }
 
 void final_image_cache_put(
@@ -101,27 +158,39 @@ void final_image_cache_put(
 {
   const FinalImageCache::Key key = {int(math::round(timeline_frame)), view_id, display_channel};
 
+  ensure_final_image_cache(scene);
+  std::shared_lock cache_lock(final_image_cache_mutex);
+  FinalImageCache *cache = query_final_image_cache(scene);
+  if (cache == nullptr) {
+    /* Destroyed concurrently. */
+    return;
+  }
+
   IMB_refImBuf(image);
+  const size_t memory_size = IMB_get_size_in_memory(image);
 
-  std::lock_guard lock(final_image_cache_mutex);
-  FinalImageCache *cache = ensure_final_image_cache(scene);
+  FinalImageCache::Shard &shard = cache->shard_for_key(key);
+  std::lock_guard lock(shard.mutex);
 
-  cache->map_.add_or_modify(
+  shard.map.add_or_modify(
       key,
-      [&](ImBuf **value) { *value = image; },
-      [&](ImBuf **existing) {
-        if (*existing) {
-          IMB_freeImBuf(*existing);
-        }
-        *existing = image;
+      [&](FinalImageCache::Entry *value) {
+        *value = {image, memory_size};
+        cache->image_count_++;
+      },
+      [&](FinalImageCache::Entry *existing) {
+        cache->memory_size_ -= existing->memory_size;
+        IMB_freeImBuf(existing->image);
+        *existing = {image, memory_size};
       });
+  cache->memory_size_ += memory_size;
 }
 
 void final_image_cache_invalidate_frame_range(Scene *scene,
                                               const float timeline_frame_start,
                                               const float timeline_frame_end)
 {
-  std::lock_guard lock(final_image_cache_mutex);
+  std::shared_lock cache_lock(final_image_cache_mutex);
   FinalImageCache *cache = query_final_image_cache(scene);
   if (cache == nullptr) {
     return;
@@ -130,32 +199,38 @@ void final_image_cache_invalidate_frame_range(Scene *scene,
   const int key_start = int(math::floor(timeline_frame_start));
   const int key_end = int(math::ceil(timeline_frame_end));
 
-  for (auto it = cache->map_.items().begin(); it != cache->map_.items().end(); it++) {
-    const int key = (*it).key.timeline_frame;
-    if (key >= key_start && key <= key_end) {
-      IMB_freeImBuf((*it).value);
-      cache->map_.remove(it);
+  for (FinalImageCache::Shard &shard : cache->shards_) {
+    std::lock_guard lock(shard.mutex);
+    for (auto it = shard.map.items().begin(); it != shard.map.items().end(); it++) {
+      const int key = (*it).key.timeline_frame;
+      if (key >= key_start && key <= key_end) {
+        cache->memory_size_ -= (*it).value.memory_size;
+        cache->image_count_--;
+        IMB_freeImBuf((*it).value.image);
+        shard.map.remove(it);
+      }
     }
   }
 }
 
 void final_image_cache_clear(Scene *scene)
 {
-  std::lock_guard lock(final_image_cache_mutex);
+  std::shared_lock cache_lock(final_image_cache_mutex);
   FinalImageCache *cache = query_final_image_cache(scene);
   if (cache != nullptr) {
-    scene->ed->runtime.final_image_cache->clear();
+    cache->clear();
   }
 }
 
 void final_image_cache_destroy(Scene *scene)
 {
-  std::lock_guard lock(final_image_cache_mutex);
+  /* Waits for all threads that are still accessing the cache, and the shards are locked once
+   * more when the destructor clears them. */
+  std::unique_lock lock(final_image_cache_mutex);
   FinalImageCache *cache = query_final_image_cache(scene);
   if (cache != nullptr) {
-    BLI_assert(cache == scene->ed->runtime.final_image_cache);
-    MEM_delete(scene->ed->runtime.final_image_cache);
-    scene->ed->runtime.final_image_cache = nullptr;
+    atomic_store_ptr(reinterpret_cast<void **>(&scene->ed->runtime.final_image_cache), nullptr);
+    MEM_delete(cache);
   }
 }
 
@@ -163,43 +238,42 @@ void final_image_cache_iterate(Scene *scene,
                                void *userdata,
                                void callback_iter(void *userdata, int timeline_frame))
 {
-  std::lock_guard lock(final_image_cache_mutex);
+  std::shared_lock cache_lock(final_image_cache_mutex);
   FinalImageCache *cache = query_final_image_cache(scene);
   if (cache == nullptr) {
     return;
   }
-  for (const FinalImageCache::Key &frame_view : cache->map_.keys()) {
-    callback_iter(userdata, frame_view.timeline_frame);
+  for (FinalImageCache::Shard &shard : cache->shards_) {
+    std::lock_guard lock(shard.mutex);
+    for (const FinalImageCache::Key &frame_view : shard.map.keys()) {
+      callback_iter(userdata, frame_view.timeline_frame);
+    }
   }
 }
 
 size_t final_image_cache_calc_memory_size(const Scene *scene)
 {
-  std::lock_guard lock(final_image_cache_mutex);
+  std::shared_lock cache_lock(final_image_cache_mutex);
   FinalImageCache *cache = query_final_image_cache(scene);
   if (cache == nullptr) {
     return 0;
   }
-  size_t size = 0;
-  for (ImBuf *frame : cache->map_.values()) {
-    size += IMB_get_size_in_memory(frame);
-  }
-  return size;
+  return cache->memory_size_;
 }
 
 size_t final_image_cache_get_image_count(const Scene *scene)
 {
-  std::lock_guard lock(final_image_cache_mutex);
+  std::shared_lock cache_lock(final_image_cache_mutex);
   FinalImageCache *cache = query_final_image_cache(scene);
   if (cache == nullptr) {
     return 0;
   }
-  return cache->map_.size();
+  return cache->image_count_;
 }
 
 bool final_image_cache_evict(Scene *scene)
 {
-  std::lock_guard lock(final_image_cache_mutex);
+  std::shared_lock cache_lock(final_image_cache_mutex);
   FinalImageCache *cache = query_final_image_cache(scene);
   if (cache == nullptr) {
     return false;
@@ -225,47 +299,59 @@ bool final_image_cache_evict(Scene *scene)
    * This is to try to mitigate un-needed cache evictions. */
   const int cur_frame = prefetch_loops_around ? timeline_start : scene->r.cfra;
 
-  FinalImageCache::Key best_key = {};
-  ImBuf *best_item = nullptr;
-  int best_score = 0;
-  for (const auto &item : cache->map_.items()) {
-    const int item_frame = item.key.timeline_frame;
-    if (prefetch_loops_around) {
-      if (item_frame >= timeline_start && item_frame <= cur_prefetch_end) {
-        continue; /* Within active prefetch range, do not try to remove it. */
-      }
-      if (item_frame >= cur_prefetch_start && item_frame <= timeline_end) {
-        continue; /* Within active prefetch range, do not try to remove it. */
+  /* Shards are scanned one at a time, so the best candidate can be removed or replaced by another
+   * thread before we get to remove it. In that case, just scan again. */
+  while (true) {
+    FinalImageCache::Shard *best_shard = nullptr;
+    FinalImageCache::Key best_key = {};
+    ImBuf *best_item = nullptr;
+    int best_score = 0;
+    for (FinalImageCache::Shard &shard : cache->shards_) {
+      std::lock_guard lock(shard.mutex);
+      for (const auto &item : shard.map.items()) {
+        const int item_frame = item.key.timeline_frame;
+        if (prefetch_loops_around) {
+          if (item_frame >= timeline_start && item_frame <= cur_prefetch_end) {
+            continue; /* Within active prefetch range, do not try to remove it. */
+          }
+          if (item_frame >= cur_prefetch_start && item_frame <= timeline_end) {
+            continue; /* Within active prefetch range, do not try to remove it. */
+          }
+        }
+        else if (item_frame >= cur_prefetch_start && item_frame <= cur_prefetch_end) {
+          continue; /* Within active prefetch range, do not try to remove it. */
+        }
+
+        /* Score for removal is distance to current frame; 2x that if behind current frame. */
+        int score = 0;
+        if (item_frame < cur_frame) {
+          score = (cur_frame - item_frame) * 2;
+        }
+        else if (item_frame > cur_frame) {
+          score = item_frame - cur_frame;
+        }
+        if (score > best_score) {
+          best_shard = &shard;
+          best_key = item.key;
+          best_item = item.value.image;
+          best_score = score;
+        }
       }
     }
-    else if (item_frame >= cur_prefetch_start && item_frame <= cur_prefetch_end) {
-      continue; /* Within active prefetch range, do not try to remove it. */
-    }
 
-    /* Score for removal is distance to current frame; 2x that if behind current frame. */
-    int score = 0;
-    if (item_frame < cur_frame) {
-      score = (cur_frame - item_frame) * 2;
+    if (best_item == nullptr) {
+      /* Did not find anything to remove. */
+      return false;
     }
-    else if (item_frame > cur_frame) {
-      score = item_frame - cur_frame;
-    }
-    if (score > best_score) {
-      best_key = item.key;
-      best_item = item.value;
-      best_score = score;
-    }
-  }
 
-  /* Remove if we found one. */
-  if (best_item != nullptr) {
-    IMB_freeImBuf(best_item);
-    cache->map_.remove(best_key);
-    return true;
+    /* Remove if it is still the same image. */
+    std::lock_guard lock(best_shard->mutex);
+    const FinalImageCache::Entry *entry = best_shard->map.lookup_ptr(best_key);
+    if (entry != nullptr && entry->image == best_item) {
+      cache->remove_entry_in_shard(*best_shard, best_key);
+      return true;
+    }
   }
-
-  /* Did not find anything to remove. */
-  return false;
 }
 
 }  // namespace blender::seq
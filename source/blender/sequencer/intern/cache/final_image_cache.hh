@@ -12,6 +12,9 @@
  *   frames behind the current-frame.
  * - Invalidated fairly often while editing, basically whenever any
  *   strip overlapping that frame changes.
+ * - Safe to access from multiple threads. Entries are split into shards
+ *   that are locked separately, memory usage totals are kept up to date
+ *   incrementally.
  */
 
 #pragma once
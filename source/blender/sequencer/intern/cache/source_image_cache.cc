@@ -6,6 +6,14 @@
  * \ingroup sequencer
  */
 
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+#include "atomic_ops.h"
+
+#include "BLI_hash.hh"
 #include "BLI_map.hh"
 #include "BLI_mutex.hh"
 #include "BLI_vector.hh"
@@ -24,7 +32,13 @@
 
 namespace blender::seq {
 
-static Mutex source_image_cache_mutex;
+/**
+ * Protects the lifetime of the cache: every access holds it shared for as long as it uses the
+ * cache, creation and destruction hold it exclusively. Access to the cached images themselves is
+ * synchronized per shard, so that playback, prefetch workers and thumbnail jobs do not serialize
+ * on a single lock.
+ */
+static std::shared_mutex source_image_cache_mutex;
 
 struct SourceImageCache {
   struct FrameEntry {
@@ -36,6 +50,8 @@ struct SourceImageCache {
      * index and timeline frame is not a simple one.
      */
     float strip_frame = 0;
+    /** Size of the image at the time it was added, so that the totals stay consistent. */
+    size_t memory_size = 0;
   };
 
   struct StripEntry {
@@ -43,51 +59,84 @@ struct SourceImageCache {
     Map<std::pair<int, int>, FrameEntry> frames;
   };
 
-  Map<const Strip *, StripEntry> map_;
+  /* Aligned to avoid false sharing of the mutexes between threads. */
+  struct alignas(64) Shard {
+    Mutex mutex;
+    Map<const Strip *, StripEntry> map;
+  };
+
+  static constexpr int shards_num = 16;
+  std::array<Shard, shards_num> shards_;
+
+  /* Totals over all shards, updated whenever an entry is added or removed. */
+  std::atomic<size_t> memory_size_ = 0;
+  std::atomic<size_t> image_count_ = 0;
 
   ~SourceImageCache()
   {
     clear();
   }
 
+  Shard &shard_for_strip(const Strip *strip)
+  {
+    return shards_[get_default_hash(strip) % shards_num];
+  }
+
+  void free_frame(const FrameEntry &frame)
+  {
+    memory_size_ -= frame.memory_size;
+    image_count_--;
+    IMB_freeImBuf(frame.image);
+  }
+
   void clear()
   {
-    for (const auto &item : map_.items()) {
-      for (const auto &frame : item.value.frames.values()) {
-        IMB_freeImBuf(frame.image);
+    for (Shard &shard : shards_) {
+      std::lock_guard lock(shard.mutex);
+      for (const auto &item : shard.map.items()) {
+        for (const auto &frame : item.value.frames.values()) {
+          free_frame(frame);
+        }
       }
+      shard.map.clear();
     }
-    map_.clear();
   }
 
-  void remove_entry(const Strip *strip)
+  /** The shard of the strip has to be locked by the caller. */
+  void remove_entry_in_shard(Shard &shard, const Strip *strip)
   {
-    StripEntry *entry = map_.lookup_ptr(strip);
+    StripEntry *entry = shard.map.lookup_ptr(strip);
     if (entry == nullptr) {
       return;
     }
     for (const auto &frame : entry->frames.values()) {
-      IMB_freeImBuf(frame.image);
+      free_frame(frame);
     }
-    map_.remove_contained(strip);
+    shard.map.remove_contained(strip);
   }
 };
 
-static SourceImageCache *ensure_source_image_cache(Scene *scene)
+static void ensure_source_image_cache(Scene *scene)
 {
-  SourceImageCache **cache = &scene->ed->runtime.source_image_cache;
-  if (*cache == nullptr) {
-    *cache = MEM_new<SourceImageCache>(__func__);
+  /* The pointer is read without holding the lock exclusively, so access it atomically. */
+  void **cache = reinterpret_cast<void **>(&scene->ed->runtime.source_image_cache);
+  if (atomic_load_ptr(cache) != nullptr) {
+    return;
+  }
+  std::unique_lock lock(source_image_cache_mutex);
+  if (atomic_load_ptr(cache) == nullptr) {
+    atomic_store_ptr(cache, MEM_new<SourceImageCache>(__func__));
   }
-  return *cache;
 }
 
+/** The caller has to hold #source_image_cache_mutex. */
 static SourceImageCache *query_source_image_cache(const Scene *scene)
 {
   if (scene == nullptr || scene->ed == nullptr) {
     return nullptr;
   }
-  return scene->ed->runtime.source_image_cache;
+  return static_cast<SourceImageCache *>(
+      atomic_load_ptr(reinterpret_cast<void *const *>(&scene->ed->runtime.source_image_cache)));
 }
 
 ImBuf *source_image_cache_get(const RenderData *context, const Strip *strip, float timeline_frame)
@@ -104,40 +153,39 @@ ImBuf *source_image_cache_get(const RenderData *context, const Strip *strip, flo
   }
   const int view_id = context->view_id;
 
-  ImBuf *res = nullptr;
-  {
-    std::lock_guard lock(source_image_cache_mutex);
-    SourceImageCache *cache = query_source_image_cache(scene);
-    if (cache == nullptr) {
-      return nullptr;
-    }
+  std::shared_lock cache_lock(source_image_cache_mutex);
+  SourceImageCache *cache = query_source_image_cache(scene);
+  if (cache == nullptr) {
+    return nullptr;
+  }
 
-    SourceImageCache::StripEntry *val = cache->map_.lookup_ptr(strip);
-    if (val == nullptr) {
-      /* Nothing in cache for this strip yet. */
-      return nullptr;
-    }
-    /* Search entries for the frame we want. */
-    SourceImageCache::FrameEntry *frame = val->frames.lookup_ptr({frame_index, view_id});
-    if (frame != nullptr) {
-      res = frame->image;
-    }
+  SourceImageCache::Shard &shard = cache->shard_for_strip(strip);
+  std::lock_guard lock(shard.mutex);
 
-    /* For effect and scene strips, check if the cached result matches our current
-     * render resolution. If it does not, remove stale source entries for this strip. */
-    if (res != nullptr &&
-        ((strip->type & STRIP_TYPE_EFFECT) != 0 || strip->type == STRIP_TYPE_SCENE))
-    {
-      if (res->x != context->rectx || res->y != context->recty) {
-        cache->remove_entry(strip);
-        return nullptr;
-      }
-    }
+  SourceImageCache::StripEntry *val = shard.map.lookup_ptr(strip);
+  if (val == nullptr) {
+    /* Nothing in cache for this strip yet. */
+    return nullptr;
   }
+  /* Search entries for the frame we want. */
+  SourceImageCache::FrameEntry *frame = val->frames.lookup_ptr({frame_index, view_id});
+  if (frame == nullptr) {
+    return nullptr;
+  }
+  ImBuf *res = frame->image;
 
-  if (res) {
-    IMB_refImBuf(res);
+  /* For effect and scene strips, check if the cached result matches our current
+   * render resolution. If it does not, remove stale source entries for this strip. */
+  if ((strip->type & STRIP_TYPE_EFFECT) != 0 || strip->type == STRIP_TYPE_SCENE) {
+    if (res->x != context->rectx || res->y != context->recty) {
+      cache->remove_entry_in_shard(shard, strip);
+      return nullptr;
+    }
   }
+
+  /* Add the reference while the shard is locked, so that the image can't be freed by a
+   * concurrent eviction in between. */
+  IMB_refImBuf(res);
   return res;
 }
 
@@ -159,54 +207,61 @@ void source_image_cache_put(const RenderData *context,
   }
   const int view_id = context->view_id;
 
-  IMB_refImBuf(image);
-
-  std::lock_guard lock(source_image_cache_mutex);
-  SourceImageCache *cache = ensure_source_image_cache(scene);
+  ensure_source_image_cache(scene);
+  std::shared_lock cache_lock(source_image_cache_mutex);
+  SourceImageCache *cache = query_source_image_cache(scene);
+  if (cache == nullptr) {
+    /* Destroyed concurrently. */
+    return;
+  }
 
-  SourceImageCache::StripEntry *val = cache->map_.lookup_ptr(strip);
+  IMB_refImBuf(image);
+  const size_t memory_size = IMB_get_size_in_memory(image);
 
-  if (val == nullptr) {
-    /* Nothing in cache for this strip yet. */
-    cache->map_.add_new(strip, {});
-    val = cache->map_.lookup_ptr(strip);
-  }
-  BLI_assert_msg(val != nullptr, "Source image cache value should never be null here");
+  SourceImageCache::Shard &shard = cache->shard_for_strip(strip);
+  std::lock_guard lock(shard.mutex);
 
-  SourceImageCache::FrameEntry &frame = val->frames.lookup_or_add_default({frame_index, view_id});
+  SourceImageCache::StripEntry &val = shard.map.lookup_or_add_default(strip);
+  SourceImageCache::FrameEntry &frame = val.frames.lookup_or_add_default({frame_index, view_id});
   if (frame.image != nullptr) {
-    IMB_freeImBuf(frame.image);
+    cache->free_frame(frame);
   }
   frame.strip_frame = timeline_frame - strip->start;
   frame.image = image;
+  frame.memory_size = memory_size;
+  cache->memory_size_ += memory_size;
+  cache->image_count_++;
 }
 
 void source_image_cache_invalidate_strip(Scene *scene, const Strip *strip)
 {
-  std::lock_guard lock(source_image_cache_mutex);
+  std::shared_lock cache_lock(source_image_cache_mutex);
   SourceImageCache *cache = query_source_image_cache(scene);
   if (cache != nullptr) {
-    cache->remove_entry(strip);
+    SourceImageCache::Shard &shard = cache->shard_for_strip(strip);
+    std::lock_guard lock(shard.mutex);
+    cache->remove_entry_in_shard(shard, strip);
   }
 }
 
 void source_image_cache_clear(Scene *scene)
 {
-  std::lock_guard lock(source_image_cache_mutex);
+  std::shared_lock cache_lock(source_image_cache_mutex);
   SourceImageCache *cache = query_source_image_cache(scene);
   if (cache != nullptr) {
-    scene->ed->runtime.source_image_cache->clear();
+    cache->clear();
   }
 }
 
 void source_image_cache_destroy(Scene *scene)
 {
-  std::lock_guard lock(source_image_cache_mutex);
+  /* Waits for all threads that are still accessing the cache, and the shards are locked once
+   * more when the destructor clears them. */
+  std::unique_lock lock(source_image_cache_mutex);
   SourceImageCache *cache = query_source_image_cache(scene);
   if (cache != nullptr) {
-    BLI_assert(cache == scene->ed->runtime.source_image_cache);
-    MEM_delete(scene->ed->runtime.source_image_cache);
-    scene->ed->runtime.source_image_cache = nullptr;
+    atomic_store_ptr(reinterpret_cast<void **>(&scene->ed->runtime.source_image_cache), nullptr);
+    MEM_delete(cache);
   }
 }
 
@@ -216,53 +271,46 @@ void source_image_cache_iterate(Scene *scene,
                                                    const Strip *strip,
                                                    int timeline_frame))
 {
-  std::lock_guard lock(source_image_cache_mutex);
+  std::shared_lock cache_lock(source_image_cache_mutex);
   SourceImageCache *cache = query_source_image_cache(scene);
   if (cache == nullptr) {
     return;
   }
 
-  for (const auto &[strip, frames] : cache->map_.items()) {
-    for (const auto &[frame_key, frame] : frames.frames.items()) {
-      const float timeline_frame = strip->start + frame.strip_frame;
-      callback_iter(userdata, strip, int(timeline_frame));
+  for (SourceImageCache::Shard &shard : cache->shards_) {
+    std::lock_guard lock(shard.mutex);
+    for (const auto &[strip, frames] : shard.map.items()) {
+      for (const auto &[frame_key, frame] : frames.frames.items()) {
+        const float timeline_frame = strip->start + frame.strip_frame;
+        callback_iter(userdata, strip, int(timeline_frame));
+      }
     }
   }
 }
 
 size_t source_image_cache_calc_memory_size(const Scene *scene)
 {
-  std::lock_guard lock(source_image_cache_mutex);
+  std::shared_lock cache_lock(source_image_cache_mutex);
   SourceImageCache *cache = query_source_image_cache(scene);
   if (cache == nullptr) {
     return 0;
   }
-  size_t size = 0;
-  for (const SourceImageCache::StripEntry &entry : cache->map_.values()) {
-    for (const SourceImageCache::FrameEntry &frame : entry.frames.values()) {
-      size += IMB_get_size_in_memory(frame.image);
-    }
-  }
-  return size;
+  return cache->memory_size_;
 }
 
 size_t source_image_cache_get_image_count(const Scene *scene)
 {
-  std::lock_guard lock(source_image_cache_mutex);
+  std::shared_lock cache_lock(source_image_cache_mutex);
   SourceImageCache *cache = query_source_image_cache(scene);
   if (cache == nullptr) {
     return 0;
   }
-  size_t count = 0;
-  for (const SourceImageCache::StripEntry &entry : cache->map_.values()) {
-    count += entry.frames.size();
-  }
-  return count;
+  return cache->image_count_;
 }
 
 bool source_image_cache_evict(Scene *scene)
 {
-  std::lock_guard lock(source_image_cache_mutex);
+  std::shared_lock cache_lock(source_image_cache_mutex);
   SourceImageCache *cache = query_source_image_cache(scene);
   if (cache == nullptr) {
     return false;
@@ -287,48 +335,67 @@ bool source_image_cache_evict(Scene *scene)
    * This is to try to mitigate un-needed cache evictions. */
   const int cur_frame = prefetch_loops_around ? timeline_start : scene->r.cfra;
 
-  SourceImageCache::StripEntry *best_strip = nullptr;
-  std::pair<int, int> best_key = {};
-  int best_score = 0;
-  for (const auto &strip : cache->map_.items()) {
-    for (const auto &entry : strip.value.frames.items()) {
-      const int item_frame = int(strip.key->start + entry.value.strip_frame);
-      if (prefetch_loops_around) {
-        if (item_frame >= timeline_start && item_frame <= cur_prefetch_end) {
-          continue; /* Within active prefetch range, do not try to remove it. */
-        }
-        if (item_frame >= cur_prefetch_start && item_frame <= timeline_end) {
-          continue; /* Within active prefetch range, do not try to remove it. */
+  /* Shards are scanned one at a time, so the best candidate can be removed or replaced by another
+   * thread before we get to remove it. In that case, just scan again. */
+  while (true) {
+    SourceImageCache::Shard *best_shard = nullptr;
+    const Strip *best_strip = nullptr;
+    std::pair<int, int> best_key = {};
+    ImBuf *best_item = nullptr;
+    int best_score = 0;
+    for (SourceImageCache::Shard &shard : cache->shards_) {
+      std::lock_guard lock(shard.mutex);
+      for (const auto &strip : shard.map.items()) {
+        for (const auto &entry : strip.value.frames.items()) {
+          const int item_frame = int(strip.key->start + entry.value.strip_frame);
+          if (prefetch_loops_around) {
+            if (item_frame >= timeline_start && item_frame <= cur_prefetch_end) {
+              continue; /* Within active prefetch range, do not try to remove it. */
+            }
+            if (item_frame >= cur_prefetch_start && item_frame <= timeline_end) {
+              continue; /* Within active prefetch range, do not try to remove it. */
+            }
+          }
+          else if (item_frame >= cur_prefetch_start && item_frame <= cur_prefetch_end) {
+            continue; /* Within active prefetch range, do not try to remove it. */
+          }
+
+          /* Score for removal is distance to current frame; 2x that if behind current frame. */
+          int score = 0;
+          if (item_frame < cur_frame) {
+            score = (cur_frame - item_frame) * 2;
+          }
+          else if (item_frame > cur_frame) {
+            score = item_frame - cur_frame;
+          }
+          if (score > best_score) {
+            best_shard = &shard;
+            best_strip = strip.key;
+            best_key = entry.key;
+            best_item = entry.value.image;
+            best_score = score;
+          }
         }
       }
-      else if (item_frame >= cur_prefetch_start && item_frame <= cur_prefetch_end) {
-        continue; /* Within active prefetch range, do not try to remove it. */
-      }
+    }
 
-      /* Score for removal is distance to current frame; 2x that if behind current frame. */
-      int score = 0;
-      if (item_frame < cur_frame) {
-        score = (cur_frame - item_frame) * 2;
-      }
-      else if (item_frame > cur_frame) {
-        score = item_frame - cur_frame;
-      }
-      if (score > best_score) {
-        best_strip = &strip.value;
-        best_key = entry.key;
-        best_score = score;
-      }
+    if (best_item == nullptr) {
+      return false;
     }
-  }
 
-  /* Remove if we found one. */
-  if (best_strip != nullptr) {
-    IMB_freeImBuf(best_strip->frames.lookup(best_key).image);
-    best_strip->frames.remove(best_key);
-    return true;
+    /* Remove if it is still the same image. */
+    std::lock_guard lock(best_shard->mutex);
+    SourceImageCache::StripEntry *strip_entry = best_shard->map.lookup_ptr(best_strip);
+    if (strip_entry == nullptr) {
+      continue;
+    }
+    const SourceImageCache::FrameEntry *frame = strip_entry->frames.lookup_ptr(best_key);
+    if (frame != nullptr && frame->image == best_item) {
+      cache->free_frame(*frame);
+      strip_entry->frames.remove(best_key);
+      return true;
+    }
   }
-
-  return false;
 }
 
 }  // namespace blender::seq
@@ -15,6 +15,9 @@
  *   frames behind the current-frame.
  * - Invalidated fairly rarely, since the cached items only change
  *   when the source content changes.
+ * - Safe to access from multiple threads. Entries are split into shards
+ *   that are locked separately, memory usage totals are kept up to date
+ *   incrementally.
  */
 
 #pragma once
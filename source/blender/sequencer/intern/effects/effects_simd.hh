@@ -0,0 +1,453 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup sequencer
+ *
+ * SIMD versions of the per-pixel loops of the simple blending effects.
+ *
+ * Every function processes a prefix of the given RGBA pixels and returns the number of pixels it
+ * handled. The caller is expected to process the remaining pixels with the scalar code, which is
+ * also what happens on platforms without SIMD support (the functions return zero there). The
+ * results match the scalar code, except for the sign of zero in a few cases.
+ */
+
+#include <cstdint>
+
+#include "BLI_simd.hh"
+#include "BLI_sys_types.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_sequence_types.h"
+
+namespace blender::seq {
+
+#if BLI_HAVE_SSE2
+
+/* -------------------------------------------------------------------- */
+/** \name Helpers
+ * \{ */
+
+/** Broadcast the alpha of each pixel to all of its channels. */
+inline __m128 simd_splat_alpha(const __m128 pixel)
+{
+  return _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/** Same as above, for two pixels stored as 16-bit integers. */
+inline __m128i simd_splat_alpha_epi16(const __m128i pixels)
+{
+  const __m128i lo = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+  return _mm_shufflehi_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/** Take the RGB channels from `rgb` and the alpha channel from `alpha`. */
+inline __m128 simd_select_alpha(const __m128 rgb, const __m128 alpha)
+{
+  const __m128 alpha_mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+  return _mm_or_ps(_mm_andnot_ps(alpha_mask, rgb), _mm_and_ps(alpha_mask, alpha));
+}
+
+inline __m128i simd_select_alpha_epi16(const __m128i rgb, const __m128i alpha)
+{
+  const __m128i alpha_mask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+  return _mm_or_si128(_mm_andnot_si128(alpha_mask, rgb), _mm_and_si128(alpha_mask, alpha));
+}
+
+/** Select `a` where `mask` is set, `b` otherwise. */
+inline __m128 simd_select(const __m128 mask, const __m128 a, const __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/** Same as #straight_uchar_to_premul_float. */
+inline __m128 simd_load_premul_pixel(const uchar *ptr)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i pixel8 = _mm_cvtsi32_si128(*reinterpret_cast<const int *>(ptr));
+  const __m128i pixel32 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(pixel8, zero), zero);
+  const __m128 color = _mm_cvtepi32_ps(pixel32);
+  const __m128 alpha = _mm_mul_ps(simd_splat_alpha(color), _mm_set1_ps(1.0f / 255.0f));
+  const __m128 fac = _mm_mul_ps(alpha, _mm_set1_ps(1.0f / 255.0f));
+  return simd_select_alpha(_mm_mul_ps(color, fac), alpha);
+}
+
+/** Same as #premul_float_to_straight_uchar. */
+inline void simd_store_premul_pixel(const __m128 pixel, uchar *dst)
+{
+  const __m128 alpha = simd_splat_alpha(pixel);
+  const __m128 one = _mm_set1_ps(1.0f);
+  /* Only un-premultiply when alpha is neither zero nor one. */
+  const __m128 keep = _mm_or_ps(_mm_cmpeq_ps(alpha, _mm_setzero_ps()), _mm_cmpeq_ps(alpha, one));
+  const __m128 alpha_inv = simd_select(keep, one, _mm_div_ps(one, alpha));
+  __m128 straight = simd_select_alpha(_mm_mul_ps(pixel, alpha_inv), pixel);
+  /* Same as #unit_float_to_uchar_clamp. */
+  straight = _mm_min_ps(_mm_max_ps(straight, _mm_setzero_ps()), one);
+  straight = _mm_add_ps(_mm_mul_ps(straight, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+  const __m128i pixel32 = _mm_cvttps_epi32(straight);
+  const __m128i pixel16 = _mm_packs_epi32(pixel32, pixel32);
+  const __m128i pixel8 = _mm_packus_epi16(pixel16, pixel16);
+  *reinterpret_cast<int *>(dst) = _mm_cvtsi128_si32(pixel8);
+}
+
+/** Same as #sqrtf_signed. */
+inline __m128 simd_sqrt_signed(const __m128 value)
+{
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+  const __m128 root = _mm_sqrt_ps(_mm_andnot_ps(sign_mask, value));
+  return _mm_or_ps(root, _mm_and_ps(sign_mask, value));
+}
+
+/** Square while keeping the sign of the value. */
+inline __m128 simd_square_signed(const __m128 value)
+{
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+  return _mm_or_ps(_mm_mul_ps(value, value), _mm_and_ps(sign_mask, value));
+}
+
+/** Expand two RGBA byte pixels to 16-bit integers. */
+inline __m128i simd_load_two_pixels_epi16(const uchar *ptr)
+{
+  return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(ptr)),
+                           _mm_setzero_si128());
+}
+
+inline void simd_store_two_pixels_epi16(const __m128i pixels, uchar *dst)
+{
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), _mm_packus_epi16(pixels, pixels));
+}
+
+/** The integer code paths only stay in 16-bit range for factors between zero and one. */
+inline bool simd_integer_factor_supported(const int ifac)
+{
+  return ifac >= 0 && ifac <= 256;
+}
+
+/** \} */
+
+#endif
+
+/* -------------------------------------------------------------------- */
+/** \name Cross
+ * \{ */
+
+inline int64_t cross_effect_simd(
+    const float *src1, const float *src2, float *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  const __m128 fac_v = _mm_set1_ps(fac);
+  const __m128 mfac_v = _mm_set1_ps(1.0f - fac);
+  for (int64_t i = 0; i < size; i++) {
+    const __m128 col1 = _mm_loadu_ps(src1 + i * 4);
+    const __m128 col2 = _mm_loadu_ps(src2 + i * 4);
+    _mm_storeu_ps(dst + i * 4, _mm_add_ps(_mm_mul_ps(mfac_v, col1), _mm_mul_ps(fac_v, col2)));
+  }
+  return size;
+#else
+  UNUSED_VARS(src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+inline int64_t cross_effect_simd(
+    const uchar *src1, const uchar *src2, uchar *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  const int ifac = int(256.0f * fac);
+  if (!simd_integer_factor_supported(ifac)) {
+    return 0;
+  }
+  const __m128i ifac_v = _mm_set1_epi16(short(ifac));
+  const __m128i imfac_v = _mm_set1_epi16(short(256 - ifac));
+  int64_t i = 0;
+  for (; i + 2 <= size; i += 2) {
+    const __m128i col1 = simd_load_two_pixels_epi16(src1 + i * 4);
+    const __m128i col2 = simd_load_two_pixels_epi16(src2 + i * 4);
+    /* The sum is at most `256 * 255`, so it fits into unsigned 16-bit. */
+    const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(imfac_v, col1),
+                                      _mm_mullo_epi16(ifac_v, col2));
+    simd_store_two_pixels_epi16(_mm_srli_epi16(sum, 8), dst + i * 4);
+  }
+  return i;
+#else
+  UNUSED_VARS(src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Gamma Cross
+ * \{ */
+
+#if BLI_HAVE_SSE2
+inline __m128 simd_gamma_cross(const __m128 col1, const __m128 col2, float fac)
+{
+  const __m128 mix = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.0f - fac), simd_sqrt_signed(col1)),
+                                _mm_mul_ps(_mm_set1_ps(fac), simd_sqrt_signed(col2)));
+  return simd_square_signed(mix);
+}
+#endif
+
+inline int64_t gamma_cross_effect_simd(
+    const float *src1, const float *src2, float *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  for (int64_t i = 0; i < size; i++) {
+    const __m128 col1 = _mm_loadu_ps(src1 + i * 4);
+    const __m128 col2 = _mm_loadu_ps(src2 + i * 4);
+    _mm_storeu_ps(dst + i * 4, simd_gamma_cross(col1, col2, fac));
+  }
+  return size;
+#else
+  UNUSED_VARS(src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+inline int64_t gamma_cross_effect_simd(
+    const uchar *src1, const uchar *src2, uchar *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  for (int64_t i = 0; i < size; i++) {
+    const __m128 col1 = simd_load_premul_pixel(src1 + i * 4);
+    const __m128 col2 = simd_load_premul_pixel(src2 + i * 4);
+    simd_store_premul_pixel(simd_gamma_cross(col1, col2, fac), dst + i * 4);
+  }
+  return size;
+#else
+  UNUSED_VARS(src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Add, Subtract and Multiply
+ * \{ */
+
+inline int64_t add_effect_simd(
+    const float *src1, const float *src2, float *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 mfac_v = _mm_set1_ps(1.0f - fac);
+  for (int64_t i = 0; i < size; i++) {
+    const __m128 col1 = _mm_loadu_ps(src1 + i * 4);
+    const __m128 col2 = _mm_loadu_ps(src2 + i * 4);
+    const __m128 f = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(simd_splat_alpha(col1), mfac_v)),
+                                simd_splat_alpha(col2));
+    const __m128 col = _mm_add_ps(col1, _mm_mul_ps(f, col2));
+    _mm_storeu_ps(dst + i * 4, simd_select_alpha(col, col1));
+  }
+  return size;
+#else
+  UNUSED_VARS(src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+inline int64_t add_effect_simd(
+    const uchar *src1, const uchar *src2, uchar *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  const int ifac = int(256.0f * fac);
+  if (!simd_integer_factor_supported(ifac)) {
+    return 0;
+  }
+  const __m128i ifac_v = _mm_set1_epi16(short(ifac));
+  const __m128i max_v = _mm_set1_epi16(255);
+  int64_t i = 0;
+  for (; i + 2 <= size; i += 2) {
+    const __m128i col1 = simd_load_two_pixels_epi16(src1 + i * 4);
+    const __m128i col2 = simd_load_two_pixels_epi16(src2 + i * 4);
+    /* `ifac * alpha` is at most `256 * 255`, the high half of the product is the `>> 16`. */
+    const __m128i f = _mm_mullo_epi16(ifac_v, simd_splat_alpha_epi16(col2));
+    const __m128i col = _mm_min_epi16(_mm_add_epi16(col1, _mm_mulhi_epu16(f, col2)), max_v);
+    simd_store_two_pixels_epi16(simd_select_alpha_epi16(col, col1), dst + i * 4);
+  }
+  return i;
+#else
+  UNUSED_VARS(src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+inline int64_t sub_effect_simd(
+    const float *src1, const float *src2, float *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 mfac_v = _mm_set1_ps(1.0f - fac);
+  for (int64_t i = 0; i < size; i++) {
+    const __m128 col1 = _mm_loadu_ps(src1 + i * 4);
+    const __m128 col2 = _mm_loadu_ps(src2 + i * 4);
+    const __m128 f = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(simd_splat_alpha(col1), mfac_v)),
+                                simd_splat_alpha(col2));
+    const __m128 col = _mm_max_ps(_mm_sub_ps(col1, _mm_mul_ps(f, col2)), _mm_setzero_ps());
+    _mm_storeu_ps(dst + i * 4, simd_select_alpha(col, col1));
+  }
+  return size;
+#else
+  UNUSED_VARS(src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+inline int64_t sub_effect_simd(
+    const uchar *src1, const uchar *src2, uchar *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  const int ifac = int(256.0f * fac);
+  if (!simd_integer_factor_supported(ifac)) {
+    return 0;
+  }
+  const __m128i ifac_v = _mm_set1_epi16(short(ifac));
+  int64_t i = 0;
+  for (; i + 2 <= size; i += 2) {
+    const __m128i col1 = simd_load_two_pixels_epi16(src1 + i * 4);
+    const __m128i col2 = simd_load_two_pixels_epi16(src2 + i * 4);
+    const __m128i f = _mm_mullo_epi16(ifac_v, simd_splat_alpha_epi16(col2));
+    const __m128i col = _mm_subs_epu16(col1, _mm_mulhi_epu16(f, col2));
+    simd_store_two_pixels_epi16(simd_select_alpha_epi16(col, col1), dst + i * 4);
+  }
+  return i;
+#else
+  UNUSED_VARS(src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+inline int64_t mul_effect_simd(
+    const float *src1, const float *src2, float *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 fac_v = _mm_set1_ps(fac);
+  for (int64_t i = 0; i < size; i++) {
+    const __m128 col1 = _mm_loadu_ps(src1 + i * 4);
+    const __m128 col2 = _mm_loadu_ps(src2 + i * 4);
+    const __m128 col = _mm_add_ps(col1,
+                                  _mm_mul_ps(_mm_mul_ps(fac_v, col1), _mm_sub_ps(col2, one)));
+    _mm_storeu_ps(dst + i * 4, col);
+  }
+  return size;
+#else
+  UNUSED_VARS(src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+inline int64_t mul_effect_simd(
+    const uchar *src1, const uchar *src2, uchar *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  const int ifac = int(256.0f * fac);
+  if (!simd_integer_factor_supported(ifac)) {
+    return 0;
+  }
+  const __m128i ifac_v = _mm_set1_epi16(short(ifac));
+  const __m128i max_v = _mm_set1_epi16(255);
+  const __m128i one_v = _mm_set1_epi16(1);
+  int64_t i = 0;
+  for (; i + 2 <= size; i += 2) {
+    const __m128i col1 = simd_load_two_pixels_epi16(src1 + i * 4);
+    const __m128i col2 = simd_load_two_pixels_epi16(src2 + i * 4);
+    /* The scalar code computes `(ifac * a * (b - 255)) >> 16` on a non-positive number, which is
+     * `-ceil(ifac * a * (255 - b) / 65536)`. Both factors fit into unsigned 16-bit. */
+    const __m128i p = _mm_mullo_epi16(ifac_v, col1);
+    const __m128i q = _mm_sub_epi16(max_v, col2);
+    const __m128i hi = _mm_mulhi_epu16(p, q);
+    const __m128i lo_is_zero = _mm_cmpeq_epi16(_mm_mullo_epi16(p, q), _mm_setzero_si128());
+    const __m128i ceil = _mm_add_epi16(_mm_add_epi16(hi, one_v), lo_is_zero);
+    simd_store_two_pixels_epi16(_mm_sub_epi16(col1, ceil), dst + i * 4);
+  }
+  return i;
+#else
+  UNUSED_VARS(src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Blend Modes
+ *
+ * Float versions of the simple blend modes of `BLI_math_color_blend.h`, as used by the blend
+ * mode and color mix effects. The alpha of the second input is scaled by the effect factor.
+ * Byte images and the other blend modes always use the scalar code.
+ * \{ */
+
+inline int64_t blend_mode_effect_simd(
+    int blend_mode, const float *src1, const float *src2, float *dst, int64_t size, float fac)
+{
+#if BLI_HAVE_SSE2
+  if (!ELEM(blend_mode,
+            STRIP_TYPE_ADD,
+            STRIP_TYPE_SUB,
+            STRIP_TYPE_MUL,
+            STRIP_TYPE_LIGHTEN,
+            STRIP_TYPE_DARKEN,
+            STRIP_TYPE_SCREEN))
+  {
+    return 0;
+  }
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 fac_v = _mm_set1_ps(fac);
+  for (int64_t i = 0; i < size; i++) {
+    const __m128 col1 = _mm_loadu_ps(src1 + i * 4);
+    const __m128 col2 = _mm_loadu_ps(src2 + i * 4);
+    const __m128 alpha1 = simd_splat_alpha(col1);
+    const __m128 t = _mm_mul_ps(simd_splat_alpha(col2), fac_v);
+    const __m128 mt = _mm_sub_ps(one, t);
+    __m128 col;
+    switch (blend_mode) {
+      case STRIP_TYPE_ADD:
+        col = _mm_add_ps(col1, _mm_mul_ps(col2, alpha1));
+        break;
+      case STRIP_TYPE_SUB:
+        col = _mm_max_ps(_mm_sub_ps(col1, _mm_mul_ps(col2, alpha1)), zero);
+        break;
+      case STRIP_TYPE_MUL:
+        col = _mm_add_ps(_mm_mul_ps(mt, col1), _mm_mul_ps(_mm_mul_ps(col1, col2), alpha1));
+        break;
+      case STRIP_TYPE_LIGHTEN: {
+        const __m128 map_alpha = _mm_div_ps(alpha1, t);
+        col = _mm_add_ps(_mm_mul_ps(mt, col1),
+                         _mm_mul_ps(t, _mm_max_ps(col1, _mm_mul_ps(col2, map_alpha))));
+        break;
+      }
+      case STRIP_TYPE_DARKEN: {
+        const __m128 map_alpha = _mm_div_ps(alpha1, t);
+        col = _mm_add_ps(_mm_mul_ps(mt, col1),
+                         _mm_mul_ps(t, _mm_min_ps(col1, _mm_mul_ps(col2, map_alpha))));
+        break;
+      }
+      default: { /* #STRIP_TYPE_SCREEN */
+        const __m128 screen = _mm_max_ps(
+            _mm_sub_ps(one, _mm_mul_ps(_mm_sub_ps(one, col1), _mm_sub_ps(one, col2))), zero);
+        col = _mm_add_ps(_mm_mul_ps(screen, t), _mm_mul_ps(col1, mt));
+        break;
+      }
+    }
+    /* Zero alpha of the second input leaves the first input unchanged. */
+    col = simd_select(_mm_cmpneq_ps(t, zero), col, col1);
+    _mm_storeu_ps(dst + i * 4, simd_select_alpha(col, col1));
+  }
+  return size;
+#else
+  UNUSED_VARS(blend_mode, src1, src2, dst, size, fac);
+  return 0;
+#endif
+}
+
+/** \} */
+
+}  // namespace blender::seq
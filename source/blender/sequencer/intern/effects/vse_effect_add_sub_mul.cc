@@ -13,6 +13,7 @@
 #include "SEQ_render.hh"
 
 #include "effects.hh"
+#include "effects_simd.hh"
 
 namespace blender::seq {
 
@@ -24,7 +25,11 @@ struct AddEffectOp {
   {
     const float fac = this->factor;
     int ifac = int(256.0f * fac);
-    for (int64_t idx = 0; idx < size; idx++) {
+    const int64_t simd_size = add_effect_simd(src1, src2, dst, size, fac);
+    src1 += simd_size * 4;
+    src2 += simd_size * 4;
+    dst += simd_size * 4;
+    for (int64_t idx = simd_size; idx < size; idx++) {
       if constexpr (std::is_same_v<T, uchar>) {
         const int f = ifac * int(src2[3]);
         dst[0] = min_ii(src1[0] + ((f * src2[0]) >> 16), 255);
@@ -68,7 +73,11 @@ struct SubEffectOp {
   {
     const float fac = this->factor;
     int ifac = int(256.0f * fac);
-    for (int64_t idx = 0; idx < size; idx++) {
+    const int64_t simd_size = sub_effect_simd(src1, src2, dst, size, fac);
+    src1 += simd_size * 4;
+    src2 += simd_size * 4;
+    dst += simd_size * 4;
+    for (int64_t idx = simd_size; idx < size; idx++) {
       if constexpr (std::is_same_v<T, uchar>) {
         const int f = ifac * int(src2[3]);
         dst[0] = max_ii(src1[0] - ((f * src2[0]) >> 16), 0);
@@ -112,7 +121,11 @@ struct MulEffectOp {
   {
     const float fac = this->factor;
     int ifac = int(256.0f * fac);
-    for (int64_t idx = 0; idx < size; idx++) {
+    const int64_t simd_size = mul_effect_simd(src1, src2, dst, size, fac);
+    src1 += simd_size * 4;
+    src2 += simd_size * 4;
+    dst += simd_size * 4;
+    for (int64_t idx = simd_size; idx < size; idx++) {
       /* Formula: `fac * (a * b) + (1-fac) * a => fac * a * (b - 1) + a` */
       if constexpr (std::is_same_v<T, uchar>) {
         dst[0] = src1[0] + ((ifac * src1[0] * (src2[0] - 255)) >> 16);
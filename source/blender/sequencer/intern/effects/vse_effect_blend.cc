@@ -15,6 +15,7 @@
 #include "SEQ_render.hh"
 
 #include "effects.hh"
+#include "effects_simd.hh"
 
 namespace blender::seq {
 
@@ -147,10 +148,9 @@ static void apply_blend_function(
     float fac, int64_t size, const T *src1, const T *src2, T *dst, Func blend_function)
 {
   for (int64_t i = 0; i < size; i++) {
-    T achannel = src2[3];
-    ((T *)src2)[3] = T(achannel * fac);
-    blend_function(dst, src1, src2);
-    ((T *)src2)[3] = achannel;
+    /* Scale alpha on a copy, the input image may be read by other threads at the same time. */
+    const T src2_scaled[4] = {src2[0], src2[1], src2[2], T(src2[3] * fac)};
+    blend_function(dst, src1, src2_scaled);
     dst[3] = src1[3];
     src1 += 4;
     src2 += 4;
@@ -161,6 +161,12 @@ static void apply_blend_function(
 static void do_blend_effect_float(
     float fac, int64_t size, const float *rect1, const float *rect2, int btype, float *out)
 {
+  const int64_t simd_size = blend_mode_effect_simd(btype, rect1, rect2, out, size, fac);
+  rect1 += simd_size * 4;
+  rect2 += simd_size * 4;
+  out += simd_size * 4;
+  size -= simd_size;
+
   switch (btype) {
     case STRIP_TYPE_ADD:
       apply_blend_function(fac, size, rect1, rect2, out, blend_color_add_float);
@@ -13,6 +13,7 @@
 #include "SEQ_render.hh"
 
 #include "effects.hh"
+#include "effects_simd.hh"
 
 namespace blender::seq {
 
@@ -23,7 +24,11 @@ struct CrossEffectOp {
     const float mfac = 1.0f - fac;
     const int ifac = int(256.0f * fac);
     const int imfac = 256 - ifac;
-    for (int64_t idx = 0; idx < size; idx++) {
+    const int64_t simd_size = cross_effect_simd(src1, src2, dst, size, fac);
+    src1 += simd_size * 4;
+    src2 += simd_size * 4;
+    dst += simd_size * 4;
+    for (int64_t idx = simd_size; idx < size; idx++) {
       if constexpr (std::is_same_v<T, uchar>) {
         dst[0] = (imfac * src1[0] + ifac * src2[0]) >> 8;
         dst[1] = (imfac * src1[1] + ifac * src2[1]) >> 8;
@@ -81,7 +86,11 @@ struct GammaCrossEffectOp {
   {
     const float fac = this->factor;
     const float mfac = 1.0f - fac;
-    for (int64_t idx = 0; idx < size; idx++) {
+    const int64_t simd_size = gamma_cross_effect_simd(src1, src2, dst, size, fac);
+    src1 += simd_size * 4;
+    src2 += simd_size * 4;
+    dst += simd_size * 4;
+    for (int64_t idx = simd_size; idx < size; idx++) {
       float4 col1 = load_premul_pixel(src1);
       float4 col2 = load_premul_pixel(src2);
       float4 col;
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 
 #include "MEM_guardedalloc.h"
 
@@ -19,6 +20,7 @@
 
 #include "BLI_listbase.h"
 #include "BLI_threads.h"
+#include "BLI_vector.hh"
 #include "BLI_vector_set.hh"
 
 #include "IMB_imbuf.hh"
@@ -49,6 +51,26 @@
 
 namespace blender::seq {
 
+struct PrefetchJob;
+
+/**
+ * A prefetch worker renders frames on its own thread, with its own depsgraph and evaluated scene.
+ * Workers of the same job share nothing but the caches of the original scene, which allows them
+ * to render different frames concurrently.
+ */
+struct PrefetchWorker {
+  PrefetchJob *pfjob = nullptr;
+
+  Depsgraph *depsgraph = nullptr;
+  Scene *scene_eval = nullptr;
+
+  /* context */
+  RenderData context_cpy = {};
+
+  /* Frame which is currently being rendered by this worker. */
+  int timeline_frame = 0;
+};
+
 struct PrefetchJob {
   PrefetchJob *next = nullptr;
   PrefetchJob *prev = nullptr;
@@ -56,17 +78,15 @@ struct PrefetchJob {
   Main *bmain = nullptr;
   Main *bmain_eval = nullptr;
   Scene *scene = nullptr;
-  Scene *scene_eval = nullptr;
-  Depsgraph *depsgraph = nullptr;
 
   ThreadMutex prefetch_suspend_mutex = {};
   ThreadCondition prefetch_suspend_cond = {};
 
   ListBase threads = {};
+  blender::Vector<std::unique_ptr<PrefetchWorker>> workers;
 
   /* context */
   RenderData context = {};
-  RenderData context_cpy = {};
   ListBase *seqbasep = nullptr;
   ListBase *seqbasep_cpy = nullptr;
 
@@ -83,10 +103,23 @@ struct PrefetchJob {
   bool running = false;
   bool waiting = false;
   bool stop = false;
+  /* Number of workers which did not finish yet and number of workers which are suspended,
+   * protected by `prefetch_suspend_mutex`. The job is only `waiting` when all of them are. */
+  int num_running_workers = 0;
+  int num_waiting_workers = 0;
   /* Set from outside. */
   bool is_scrubbing = false;
 };
 
+/**
+ * Each worker holds a full copy of the evaluated scene and renders with multi-threaded effects,
+ * so only use a fraction of the available cores and cap the amount of depsgraphs to keep.
+ */
+static int seq_prefetch_workers_num()
+{
+  return std::clamp(BLI_system_thread_count() / 4, 1, 8);
+}
+
 static PrefetchJob *seq_prefetch_job_get(Scene *scene)
 {
   if (scene && scene->ed) {
@@ -200,9 +233,9 @@ static int seq_prefetch_cfra(PrefetchJob *pfjob)
   }
   return new_frame;
 }
-static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchJob *pfjob)
+static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchWorker *worker)
 {
-  return BKE_animsys_eval_context_construct(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  return BKE_animsys_eval_context_construct(worker->depsgraph, worker->timeline_frame);
 }
 
 void seq_prefetch_get_time_range(Scene *scene, int *r_start, int *r_end)
@@ -223,37 +256,39 @@ void seq_prefetch_get_time_range(Scene *scene, int *r_start, int *r_end)
   *r_end = seq_prefetch_cfra(pfjob);
 }
 
-static void seq_prefetch_free_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_free_depsgraph(PrefetchWorker *worker)
 {
-  if (pfjob->depsgraph != nullptr) {
-    DEG_graph_free(pfjob->depsgraph);
+  if (worker->depsgraph != nullptr) {
+    DEG_graph_free(worker->depsgraph);
   }
-  pfjob->depsgraph = nullptr;
-  pfjob->scene_eval = nullptr;
+  worker->depsgraph = nullptr;
+  worker->scene_eval = nullptr;
 }
 
-static void seq_prefetch_update_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_update_depsgraph(PrefetchWorker *worker)
 {
-  DEG_evaluate_on_framechange(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  DEG_evaluate_on_framechange(worker->depsgraph, worker->timeline_frame);
 }
 
-static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_init_depsgraph(PrefetchWorker *worker)
 {
+  PrefetchJob *pfjob = worker->pfjob;
   Main *bmain = pfjob->bmain_eval;
   Scene *scene = pfjob->scene;
   ViewLayer *view_layer = BKE_view_layer_default_render(scene);
 
-  pfjob->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
-  DEG_debug_name_set(pfjob->depsgraph, "SEQUENCER PREFETCH");
+  worker->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
+  DEG_debug_name_set(worker->depsgraph, "SEQUENCER PREFETCH");
 
   /* Make sure there is a correct evaluated scene pointer. */
-  DEG_graph_build_for_render_pipeline(pfjob->depsgraph);
+  DEG_graph_build_for_render_pipeline(worker->depsgraph);
 
   /* Update immediately so we have proper evaluated scene. */
-  seq_prefetch_update_depsgraph(pfjob);
+  worker->timeline_frame = seq_prefetch_cfra(pfjob);
+  seq_prefetch_update_depsgraph(worker);
 
-  pfjob->scene_eval = DEG_get_evaluated_scene(pfjob->depsgraph);
-  pfjob->scene_eval->ed->cache_flag = 0;
+  worker->scene_eval = DEG_get_evaluated_scene(worker->depsgraph);
+  worker->scene_eval->ed->cache_flag = 0;
 }
 
 static void seq_prefetch_update_area(PrefetchJob *pfjob)
@@ -316,7 +351,7 @@ void prefetch_stop(Scene *scene)
   pfjob->stop = true;
 
   while (pfjob->running) {
-    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
   }
 }
 
@@ -325,19 +360,21 @@ static void seq_prefetch_update_context(const RenderData *context)
   PrefetchJob *pfjob;
   pfjob = seq_prefetch_job_get(context->scene);
 
-  render_new_render_data(pfjob->bmain_eval,
-                         pfjob->depsgraph,
-                         pfjob->scene_eval,
-                         context->rectx,
-                         context->recty,
-                         context->preview_render_size,
-                         false,
-                         &pfjob->context_cpy);
-  pfjob->context_cpy.is_prefetch_render = true;
-  pfjob->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
+  for (std::unique_ptr<PrefetchWorker> &worker : pfjob->workers) {
+    render_new_render_data(pfjob->bmain_eval,
+                           worker->depsgraph,
+                           worker->scene_eval,
+                           context->rectx,
+                           context->recty,
+                           context->preview_render_size,
+                           false,
+                           &worker->context_cpy);
+    worker->context_cpy.is_prefetch_render = true;
+    worker->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
+  }
 
   render_new_render_data(pfjob->bmain,
-                         pfjob->depsgraph,
+                         pfjob->workers.first()->depsgraph,
                          pfjob->scene,
                          context->rectx,
                          context->recty,
@@ -362,17 +399,19 @@ static void seq_prefetch_update_scene(Scene *scene)
   }
 
   pfjob->scene = scene;
-  seq_prefetch_free_depsgraph(pfjob);
-  seq_prefetch_init_depsgraph(pfjob);
+  for (std::unique_ptr<PrefetchWorker> &worker : pfjob->workers) {
+    seq_prefetch_free_depsgraph(worker.get());
+    seq_prefetch_init_depsgraph(worker.get());
+  }
 }
 
-static void seq_prefetch_update_active_seqbase(PrefetchJob *pfjob)
+static void seq_prefetch_update_active_seqbase(PrefetchWorker *worker)
 {
-  MetaStack *ms_orig = meta_stack_active_get(editing_get(pfjob->scene));
-  Editing *ed_eval = editing_get(pfjob->scene_eval);
+  MetaStack *ms_orig = meta_stack_active_get(editing_get(worker->pfjob->scene));
+  Editing *ed_eval = editing_get(worker->scene_eval);
 
   if (ms_orig != nullptr) {
-    Strip *meta_eval = original_strip_get(ms_orig->parent_strip, pfjob->scene_eval);
+    Strip *meta_eval = original_strip_get(ms_orig->parent_strip, worker->scene_eval);
     active_seqbase_set(ed_eval, &meta_eval->seqbase);
   }
   else {
@@ -384,8 +423,8 @@ static void seq_prefetch_resume(Scene *scene)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
 
-  if (pfjob && pfjob->waiting) {
-    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+  if (pfjob && pfjob->num_waiting_workers > 0) {
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
   }
 }
 
@@ -398,20 +437,25 @@ void seq_prefetch_free(Scene *scene)
 
   prefetch_stop(scene);
 
-  BLI_threadpool_remove(&pfjob->threads, pfjob);
+  for (std::unique_ptr<PrefetchWorker> &worker : pfjob->workers) {
+    BLI_threadpool_remove(&pfjob->threads, worker.get());
+  }
   BLI_threadpool_end(&pfjob->threads);
   BLI_mutex_end(&pfjob->prefetch_suspend_mutex);
   BLI_condition_end(&pfjob->prefetch_suspend_cond);
-  seq_prefetch_free_depsgraph(pfjob);
+  for (std::unique_ptr<PrefetchWorker> &worker : pfjob->workers) {
+    seq_prefetch_free_depsgraph(worker.get());
+  }
   BKE_main_free(pfjob->bmain_eval);
   scene->ed->prefetch_job = nullptr;
   MEM_delete(pfjob);
 }
 
-static bool strip_is_cached(PrefetchJob *pfjob, Strip *strip, bool can_have_final_image)
+static bool strip_is_cached(PrefetchWorker *worker, Strip *strip, bool can_have_final_image)
 {
-  RenderData *ctx = &pfjob->context_cpy;
-  float cfra = seq_prefetch_cfra(pfjob);
+  PrefetchJob *pfjob = worker->pfjob;
+  RenderData *ctx = &worker->context_cpy;
+  float cfra = worker->timeline_frame;
 
   ImBuf *ibuf = source_image_cache_get(ctx, strip, cfra);
   if (ibuf != nullptr) {
@@ -430,28 +474,28 @@ static bool strip_is_cached(PrefetchJob *pfjob, Strip *strip, bool can_have_fina
   return false;
 }
 
-static bool seq_prefetch_scene_strip_is_rendered(PrefetchJob *pfjob,
+static bool seq_prefetch_scene_strip_is_rendered(PrefetchWorker *worker,
                                                  ListBase *channels,
                                                  ListBase *seqbase,
                                                  blender::Span<Strip *> scene_strips,
                                                  bool is_recursive_check)
 {
-  int cfra = seq_prefetch_cfra(pfjob);
+  int cfra = worker->timeline_frame;
   blender::Vector<Strip *> strips = seq_shown_strips_get(
-      pfjob->scene_eval, channels, seqbase, cfra, 0);
+      worker->scene_eval, channels, seqbase, cfra, 0);
 
   /* Iterate over rendered strips. */
   for (Strip *strip : strips) {
     if (strip->type == STRIP_TYPE_META &&
         seq_prefetch_scene_strip_is_rendered(
-            pfjob, &strip->channels, &strip->seqbase, scene_strips, true))
+            worker, &strip->channels, &strip->seqbase, scene_strips, true))
     {
       return true;
     }
 
     /* A scene strip would be rendered, if it has no cached image for it. */
     if (strip->type == STRIP_TYPE_SCENE && (strip->flag & SEQ_SCENE_STRIPS) == 0 &&
-        !strip_is_cached(pfjob, strip, !is_recursive_check))
+        !strip_is_cached(worker, strip, !is_recursive_check))
     {
       return true;
     }
@@ -479,10 +523,12 @@ static blender::VectorSet<Strip *> query_scene_strips(ListBase *seqbase)
 
 /* Prefetch must avoid rendering scene strips, because rendering in background locks UI and can
  * make it unresponsive for long time periods. */
-static bool seq_prefetch_must_skip_frame(PrefetchJob *pfjob, ListBase *channels, ListBase *seqbase)
+static bool seq_prefetch_must_skip_frame(PrefetchWorker *worker,
+                                         ListBase *channels,
+                                         ListBase *seqbase)
 {
   blender::VectorSet<Strip *> scene_strips = query_scene_strips(seqbase);
-  if (seq_prefetch_scene_strip_is_rendered(pfjob, channels, seqbase, scene_strips, false)) {
+  if (seq_prefetch_scene_strip_is_rendered(worker, channels, seqbase, scene_strips, false)) {
     return true;
   }
   return false;
@@ -494,76 +540,99 @@ static bool seq_prefetch_need_suspend(PrefetchJob *pfjob)
          (pfjob->num_frames_prefetched >= pfjob->timeline_length);
 }
 
-static void seq_prefetch_do_suspend(PrefetchJob *pfjob)
+static bool seq_prefetch_must_stop(PrefetchJob *pfjob)
+{
+  return !(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) ||
+         !(pfjob->scene->ed->cache_flag & SEQ_CACHE_ALL_TYPES) || pfjob->stop;
+}
+
+/**
+ * Suspend the worker while there is nothing to be prefetched, then claim the next frame to render.
+ * Frames are handed out in timeline order, so concurrent workers fill the cache ahead of the
+ * playhead without gaps.
+ *
+ * \return False when the worker should terminate.
+ */
+static bool seq_prefetch_claim_frame(PrefetchWorker *worker)
 {
+  PrefetchJob *pfjob = worker->pfjob;
+
   BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  seq_prefetch_update_area(pfjob);
   while (seq_prefetch_need_suspend(pfjob) &&
          (pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) && !pfjob->stop)
   {
-    pfjob->waiting = true;
+    pfjob->num_waiting_workers++;
+    pfjob->waiting = pfjob->num_waiting_workers == pfjob->num_running_workers;
     BLI_condition_wait(&pfjob->prefetch_suspend_cond, &pfjob->prefetch_suspend_mutex);
+    pfjob->num_waiting_workers--;
     seq_prefetch_update_area(pfjob);
   }
   pfjob->waiting = false;
+
+  const bool is_claimed = !seq_prefetch_must_stop(pfjob) &&
+                          pfjob->cfra >= pfjob->timeline_start &&
+                          pfjob->cfra <= pfjob->timeline_end;
+  if (is_claimed) {
+    worker->timeline_frame = seq_prefetch_cfra(pfjob);
+    pfjob->num_frames_prefetched++;
+  }
   BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+
+  return is_claimed;
 }
 
-static void *seq_prefetch_frames(void *job)
+static void seq_prefetch_render_frame(PrefetchWorker *worker)
 {
-  PrefetchJob *pfjob = (PrefetchJob *)job;
+  PrefetchJob *pfjob = worker->pfjob;
 
-  while (true) {
-    if (pfjob->cfra < pfjob->timeline_start || pfjob->cfra > pfjob->timeline_end) {
-      /* Don't try to prefetch anything when we are outside of the timeline range. */
-      break;
-    }
-    pfjob->scene_eval->ed->prefetch_job = nullptr;
-
-    seq_prefetch_update_depsgraph(pfjob);
-    AnimData *adt = BKE_animdata_from_id(&pfjob->context_cpy.scene->id);
-    AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(pfjob);
-    BKE_animsys_evaluate_animdata(
-        &pfjob->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
-
-    /* This is quite hacky solution:
-     * We need cross-reference original scene with copy for cache.
-     * However depsgraph must not have this data, because it will try to kill this job.
-     * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
-     * Set to nullptr before return!
-     */
-    pfjob->scene_eval->ed->prefetch_job = pfjob;
-
-    ListBase *seqbase = active_seqbase_get(editing_get(pfjob->scene_eval));
-    ListBase *channels = channels_displayed_get(editing_get(pfjob->scene_eval));
-    if (seq_prefetch_must_skip_frame(pfjob, channels, seqbase)) {
-      pfjob->num_frames_prefetched++;
-      /* Break instead of keep looping if the job should be terminated. */
-      if (!(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) ||
-          !(pfjob->scene->ed->cache_flag & SEQ_CACHE_ALL_TYPES) || pfjob->stop)
-      {
-        break;
-      }
-      continue;
-    }
+  worker->scene_eval->ed->prefetch_job = nullptr;
 
-    ImBuf *ibuf = render_give_ibuf(&pfjob->context_cpy, seq_prefetch_cfra(pfjob), 0);
-    pfjob->num_frames_prefetched++;
-    IMB_freeImBuf(ibuf);
+  seq_prefetch_update_depsgraph(worker);
+  AnimData *adt = BKE_animdata_from_id(&worker->context_cpy.scene->id);
+  AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(worker);
+  BKE_animsys_evaluate_animdata(
+      &worker->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
 
-    /* Suspend thread if there is nothing to be prefetched. */
-    seq_prefetch_do_suspend(pfjob);
+  /* This is quite hacky solution:
+   * We need cross-reference original scene with copy for cache.
+   * However depsgraph must not have this data, because it will try to kill this job.
+   * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
+   * Set to nullptr before return!
+   */
+  worker->scene_eval->ed->prefetch_job = pfjob;
 
-    if (!(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) ||
-        !(pfjob->scene->ed->cache_flag & SEQ_CACHE_ALL_TYPES) || pfjob->stop)
-    {
-      break;
-    }
+  ListBase *seqbase = active_seqbase_get(editing_get(worker->scene_eval));
+  ListBase *channels = channels_displayed_get(editing_get(worker->scene_eval));
+  if (seq_prefetch_must_skip_frame(worker, channels, seqbase)) {
+    return;
+  }
 
-    seq_prefetch_update_area(pfjob);
+  ImBuf *ibuf = render_give_ibuf(&worker->context_cpy, worker->timeline_frame, 0);
+  IMB_freeImBuf(ibuf);
+}
+
+static void *seq_prefetch_frames(void *job)
+{
+  PrefetchWorker *worker = (PrefetchWorker *)job;
+  PrefetchJob *pfjob = worker->pfjob;
+
+  while (seq_prefetch_claim_frame(worker)) {
+    seq_prefetch_render_frame(worker);
   }
 
-  pfjob->running = false;
-  pfjob->scene_eval->ed->prefetch_job = nullptr;
+  worker->scene_eval->ed->prefetch_job = nullptr;
+
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  pfjob->num_running_workers--;
+  if (pfjob->num_running_workers == 0) {
+    pfjob->running = false;
+  }
+  else {
+    /* Let the other workers re-check the stop conditions. */
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
+  }
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
 
   return nullptr;
 }
@@ -579,16 +648,27 @@ static PrefetchJob *seq_prefetch_start_ex(const RenderData *context, float cfra)
     pfjob = MEM_new<PrefetchJob>("PrefetchJob");
     context->scene->ed->prefetch_job = pfjob;
 
-    BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, 1);
+    const int workers_num = seq_prefetch_workers_num();
+    BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, workers_num);
     BLI_mutex_init(&pfjob->prefetch_suspend_mutex);
     BLI_condition_init(&pfjob->prefetch_suspend_cond);
 
     pfjob->bmain_eval = BKE_main_new();
     pfjob->scene = context->scene;
-    seq_prefetch_init_depsgraph(pfjob);
+    for (int i = 0; i < workers_num; i++) {
+      std::unique_ptr<PrefetchWorker> worker = std::make_unique<PrefetchWorker>();
+      worker->pfjob = pfjob;
+      /* The depsgraph is built by #seq_prefetch_update_scene below. */
+      pfjob->workers.append(std::move(worker));
+    }
   }
   pfjob->bmain = context->bmain;
 
+  /* Make sure no worker of a previous run is still accessing the job. */
+  for (std::unique_ptr<PrefetchWorker> &worker : pfjob->workers) {
+    BLI_threadpool_remove(&pfjob->threads, worker.get());
+  }
+
   Scene *scene = pfjob->scene; /* For the start/end frame macros. */
   pfjob->cfra = cfra;
   pfjob->timeline_start = PSFRA;
@@ -600,13 +680,18 @@ static PrefetchJob *seq_prefetch_start_ex(const RenderData *context, float cfra)
   pfjob->waiting = false;
   pfjob->stop = false;
   pfjob->running = true;
+  pfjob->num_running_workers = pfjob->workers.size();
+  pfjob->num_waiting_workers = 0;
 
   seq_prefetch_update_scene(context->scene);
   seq_prefetch_update_context(context);
-  seq_prefetch_update_active_seqbase(pfjob);
+  for (std::unique_ptr<PrefetchWorker> &worker : pfjob->workers) {
+    seq_prefetch_update_active_seqbase(worker.get());
+  }
 
-  BLI_threadpool_remove(&pfjob->threads, pfjob);
-  BLI_threadpool_insert(&pfjob->threads, pfjob);
+  for (std::unique_ptr<PrefetchWorker> &worker : pfjob->workers) {
+    BLI_threadpool_insert(&pfjob->threads, worker.get());
+  }
 
   return pfjob;
 }
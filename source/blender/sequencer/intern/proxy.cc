@@ -10,6 +10,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_scene_types.h"
 #include "DNA_sequence_types.h"
 #include "DNA_space_types.h"
@@ -565,17 +567,27 @@ void proxy_rebuild(IndexBuildContext *context, wmJobWorkerStatus *worker_status)
       seq_proxy_build_frame(&render_context, &state, strip, timeline_frame, 100, overwrite);
     }
 
-    worker_status->progress = float(timeline_frame - time_left_handle_frame_get(scene, strip)) /
-                              (time_right_handle_frame_get(scene, strip) -
-                               time_left_handle_frame_get(scene, strip));
+    /* The proxy job may build several strips at once, and read the progress and set the stop
+     * flag from another thread. */
+    const float progress = float(timeline_frame - time_left_handle_frame_get(scene, strip)) /
+                           (time_right_handle_frame_get(scene, strip) -
+                            time_left_handle_frame_get(scene, strip));
+    atomic_store_fl(&worker_status->progress, progress);
     worker_status->do_update = true;
 
-    if (worker_status->stop || G.is_break) {
+    if (atomic_load_uint8(reinterpret_cast<const uint8_t *>(&worker_status->stop)) ||
+        G.is_break)
+    {
       break;
     }
   }
 }
 
+bool proxy_rebuild_is_movie(const IndexBuildContext *context)
+{
+  return context->strip->type == STRIP_TYPE_MOVIE;
+}
+
 void proxy_rebuild_finish(IndexBuildContext *context, bool stop)
 {
   if (context->proxy_builder) {
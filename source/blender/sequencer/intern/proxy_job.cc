@@ -8,12 +8,23 @@
  * \ingroup bke
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_scene_types.h"
 #include "DNA_sequence_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_listbase.h"
+#include "BLI_mutex.hh"
+#include "BLI_threads.h"
+#include "BLI_time.h"
 
 #include "BKE_context.hh"
 
@@ -35,11 +46,156 @@ static void proxy_freejob(void *pjv)
   MEM_freeN(pj);
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Concurrent Proxy Building
+ *
+ * Building a movie proxy is mostly decoding and encoding, which FFmpeg already spreads over a few
+ * threads. To keep all cores busy when building proxies of many clips, several of them are built
+ * at the same time. Each build thread takes the next context from the job queue, which may still
+ * grow while the job runs.
+ * \{ */
+
+static int proxy_job_threads_num()
+{
+  return std::clamp(BLI_system_thread_count() / 8, 1, 4);
+}
+
+struct ProxyJobQueue {
+  ProxyJob *pj;
+  /** Guards the members below. */
+  Mutex mutex;
+  LinkData *last_link = nullptr;
+  /**
+   * Number of contexts to build. Contexts may be appended to the job queue from the main thread
+   * while building, so the queue is not counted again but grows when such contexts are taken.
+   */
+  int contexts_num = 0;
+  int contexts_started = 0;
+  int contexts_done = 0;
+  /** Image strip proxies are rendered by the sequencer, only build one of them at a time. */
+  Mutex render_mutex;
+};
+
+struct ProxyJobThread {
+  ProxyJobQueue *queue = nullptr;
+  /**
+   * Passed to the proxy builder on the build thread. Its stop flag is set and its progress is read
+   * by the job thread, so those are only accessed atomically.
+   */
+  wmJobWorkerStatus worker_status = {};
+  std::atomic<bool> finished = false;
+
+  bool is_stopped()
+  {
+    return atomic_load_uint8(reinterpret_cast<const uint8_t *>(&worker_status.stop)) != 0;
+  }
+};
+
+static IndexBuildContext *proxy_job_queue_next(ProxyJobQueue &queue)
+{
+  std::lock_guard lock(queue.mutex);
+  LinkData *link = static_cast<LinkData *>(queue.last_link ? queue.last_link->next :
+                                                             queue.pj->queue.first);
+  if (link == nullptr) {
+    return nullptr;
+  }
+  queue.last_link = link;
+  queue.contexts_started++;
+  queue.contexts_num = std::max(queue.contexts_num, queue.contexts_started);
+  return static_cast<IndexBuildContext *>(link->data);
+}
+
+static void *proxy_job_thread_run(void *thread_v)
+{
+  ProxyJobThread *thread = static_cast<ProxyJobThread *>(thread_v);
+  ProxyJobQueue &queue = *thread->queue;
+
+  while (!thread->is_stopped()) {
+    IndexBuildContext *context = proxy_job_queue_next(queue);
+    if (context == nullptr) {
+      break;
+    }
+
+    atomic_store_fl(&thread->worker_status.progress, 0.0f);
+    if (proxy_rebuild_is_movie(context)) {
+      proxy_rebuild(context, &thread->worker_status);
+    }
+    else {
+      std::lock_guard lock(queue.render_mutex);
+      proxy_rebuild(context, &thread->worker_status);
+    }
+
+    std::lock_guard lock(queue.mutex);
+    queue.contexts_done++;
+    atomic_store_fl(&thread->worker_status.progress, 0.0f);
+  }
+
+  thread->finished = true;
+  return nullptr;
+}
+
+/* Run the build threads, passing the stop request of the job to them and combining their
+ * progress until all of them are done. */
+static void proxy_job_build_concurrently(ProxyJob *pj,
+                                         wmJobWorkerStatus *worker_status,
+                                         const int threads_num)
+{
+  ProxyJobQueue queue;
+  queue.pj = pj;
+  queue.contexts_num = BLI_listbase_count(&pj->queue);
+
+  Array<ProxyJobThread> threads(threads_num);
+  ListBase threadbase;
+  BLI_threadpool_init(&threadbase, proxy_job_thread_run, threads_num);
+  for (ProxyJobThread &thread : threads) {
+    thread.queue = &queue;
+    BLI_threadpool_insert(&threadbase, &thread);
+  }
+
+  while (true) {
+    bool all_finished = true;
+    float progress = 0.0f;
+    for (ProxyJobThread &thread : threads) {
+      all_finished &= thread.finished;
+      progress += atomic_load_fl(&thread.worker_status.progress);
+      atomic_store_uint8(reinterpret_cast<uint8_t *>(&thread.worker_status.stop),
+                         worker_status->stop);
+    }
+    if (all_finished) {
+      break;
+    }
+
+    {
+      std::lock_guard lock(queue.mutex);
+      progress += queue.contexts_done;
+      progress /= std::max(queue.contexts_num, 1);
+    }
+    worker_status->progress = std::min(progress, 1.0f);
+    worker_status->do_update = true;
+
+    BLI_time_sleep_ms(50);
+  }
+
+  BLI_threadpool_end(&threadbase);
+}
+
+/** \} */
+
 /* Only this runs inside thread. */
 static void proxy_startjob(void *pjv, wmJobWorkerStatus *worker_status)
 {
   ProxyJob *pj = static_cast<ProxyJob *>(pjv);
 
+  const int threads_num = proxy_job_threads_num();
+  if (threads_num > 1) {
+    proxy_job_build_concurrently(pj, worker_status, threads_num);
+    if (worker_status->stop) {
+      pj->stop = true;
+      fprintf(stderr, "Canceling proxy rebuild on users request...\n");
+    }
+    return;
+  }
+
   LISTBASE_FOREACH (LinkData *, link, &pj->queue) {
     IndexBuildContext *context = static_cast<IndexBuildContext *>(link->data);
 
@@ -22,6 +22,7 @@
 #include "BLI_listbase.h"
 #include "BLI_math_geom.h"
 #include "BLI_math_matrix.hh"
+#include "BLI_memory_utils.hh"
 #include "BLI_path_utils.hh"
 #include "BLI_rect.h"
 #include "BLI_task.hh"
@@ -78,6 +79,9 @@
 #include "utils.hh"
 
 #include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
 
 namespace blender::seq {
 
@@ -88,7 +92,57 @@ static ImBuf *seq_render_strip_stack(const RenderData *context,
                                      float timeline_frame,
                                      int chanshown);
 
-static blender::Mutex seq_render_mutex;
+/**
+ * Prefetch workers render into their own evaluated scene copies, so they only need to be mutually
+ * exclusive with other renders, but not with each other. They lock the mutex in shared mode.
+ *
+ * Foreground renders have priority: while one of them waits for the lock, prefetch workers don't
+ * start new renders. Otherwise continuous prefetching could keep the lock in shared mode and
+ * starve the interactive render.
+ */
+class RenderLock {
+ private:
+  std::shared_mutex mutex_;
+  std::mutex wait_mutex_;
+  std::condition_variable foreground_done_cond_;
+  int foreground_waiting_num_ = 0;
+
+ public:
+  void lock_foreground()
+  {
+    {
+      std::lock_guard lock(wait_mutex_);
+      foreground_waiting_num_++;
+    }
+    mutex_.lock();
+    {
+      std::lock_guard lock(wait_mutex_);
+      foreground_waiting_num_--;
+    }
+    foreground_done_cond_.notify_all();
+  }
+
+  void unlock_foreground()
+  {
+    mutex_.unlock();
+  }
+
+  void lock_prefetch()
+  {
+    {
+      std::unique_lock lock(wait_mutex_);
+      foreground_done_cond_.wait(lock, [&]() { return foreground_waiting_num_ == 0; });
+    }
+    mutex_.lock_shared();
+  }
+
+  void unlock_prefetch()
+  {
+    mutex_.unlock_shared();
+  }
+};
+
+static RenderLock seq_render_lock;
 DrawViewFn view3d_fn = nullptr; /* nullptr in background mode */
 
 /* -------------------------------------------------------------------- */
@@ -2013,7 +2067,21 @@ ImBuf *render_give_ibuf(const RenderData *context, float timeline_frame, int cha
   SeqRenderState state;
 
   if (!strips.is_empty() && !out) {
-    std::scoped_lock lock(seq_render_mutex);
+    const bool is_prefetch_render = context->is_prefetch_render;
+    if (is_prefetch_render) {
+      seq_render_lock.lock_prefetch();
+    }
+    else {
+      seq_render_lock.lock_foreground();
+    }
+    BLI_SCOPED_DEFER([&]() {
+      if (is_prefetch_render) {
+        seq_render_lock.unlock_prefetch();
+      }
+      else {
+        seq_render_lock.unlock_foreground();
+      }
+    });
     /* Try to make space before we add any new frames to the cache if it is full.
      * If we do this after we have added the new cache, we risk removing what we just added.*/
     evict_caches_if_full(orig_scene);
@@ -0,0 +1,327 @@
+/* SPDX-FileCopyrightText: 2025 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_math_base.h"
+#include "BLI_math_color.h"
+#include "BLI_math_color_blend.h"
+#include "BLI_timeit.hh"
+
+#include "DNA_sequence_types.h"
+
+#include "effects_simd.hh"
+
+using namespace blender;
+using namespace blender::seq;
+
+/* 4K UHD frame, processed on a single thread to compare the per-pixel loops only. */
+static constexpr int64_t PIXELS_NUM = 3840 * 2160;
+static constexpr float FACTOR = 0.37f;
+
+template<typename T> static Array<T> create_image(int seed)
+{
+  Array<T> pixels(PIXELS_NUM * 4);
+  for (int64_t i = 0; i < PIXELS_NUM; i++) {
+    const int64_t v = i * 7 + seed * 13;
+    if constexpr (std::is_same_v<T, uchar>) {
+      pixels[i * 4 + 0] = v & 0xFF;
+      pixels[i * 4 + 1] = (v * 3) & 0xFF;
+      pixels[i * 4 + 2] = (v + 12345) & 0xFF;
+      pixels[i * 4 + 3] = (v / 4) & 0xFF;
+    }
+    else {
+      pixels[i * 4 + 0] = (v % 1000) * 0.001f;
+      pixels[i * 4 + 1] = ((v * 3) % 1000) * 0.0013f;
+      pixels[i * 4 + 2] = ((v + 12345) % 1000) * 0.0007f;
+      pixels[i * 4 + 3] = ((v / 4) % 1000) * 0.001f;
+    }
+  }
+  return pixels;
+}
+
+/* Scalar reference loops, matching the effect implementations. */
+
+static void cross_scalar(const uchar *src1, const uchar *src2, uchar *dst, int64_t size)
+{
+  const int ifac = int(256.0f * FACTOR);
+  const int imfac = 256 - ifac;
+  for (int64_t i = 0; i < size * 4; i++) {
+    dst[i] = (imfac * src1[i] + ifac * src2[i]) >> 8;
+  }
+}
+
+static void cross_scalar(const float *src1, const float *src2, float *dst, int64_t size)
+{
+  for (int64_t i = 0; i < size * 4; i++) {
+    dst[i] = (1.0f - FACTOR) * src1[i] + FACTOR * src2[i];
+  }
+}
+
+static float gamma_cross_scalar_channel(float a, float b)
+{
+  const float c = (1.0f - FACTOR) * sqrtf_signed(a) + FACTOR * sqrtf_signed(b);
+  return c < 0.0f ? -(c * c) : c * c;
+}
+
+static void gamma_cross_scalar(const uchar *src1, const uchar *src2, uchar *dst, int64_t size)
+{
+  for (int64_t i = 0; i < size; i++) {
+    float col1[4], col2[4], col[4];
+    straight_uchar_to_premul_float(col1, src1 + i * 4);
+    straight_uchar_to_premul_float(col2, src2 + i * 4);
+    for (int c = 0; c < 4; c++) {
+      col[c] = gamma_cross_scalar_channel(col1[c], col2[c]);
+    }
+    premul_float_to_straight_uchar(dst + i * 4, col);
+  }
+}
+
+static void gamma_cross_scalar(const float *src1, const float *src2, float *dst, int64_t size)
+{
+  for (int64_t i = 0; i < size * 4; i++) {
+    dst[i] = gamma_cross_scalar_channel(src1[i], src2[i]);
+  }
+}
+
+static void mul_scalar(const uchar *src1, const uchar *src2, uchar *dst, int64_t size)
+{
+  const int ifac = int(256.0f * FACTOR);
+  for (int64_t i = 0; i < size * 4; i++) {
+    dst[i] = src1[i] + ((ifac * src1[i] * (src2[i] - 255)) >> 16);
+  }
+}
+
+static void mul_scalar(const float *src1, const float *src2, float *dst, int64_t size)
+{
+  for (int64_t i = 0; i < size * 4; i++) {
+    dst[i] = src1[i] + FACTOR * src1[i] * (src2[i] - 1.0f);
+  }
+}
+
+static void add_scalar(const uchar *src1, const uchar *src2, uchar *dst, int64_t size)
+{
+  const int ifac = int(256.0f * FACTOR);
+  for (int64_t i = 0; i < size; i++, src1 += 4, src2 += 4, dst += 4) {
+    const int f = ifac * int(src2[3]);
+    for (int c = 0; c < 3; c++) {
+      dst[c] = min_ii(src1[c] + ((f * src2[c]) >> 16), 255);
+    }
+    dst[3] = src1[3];
+  }
+}
+
+static void add_scalar(const float *src1, const float *src2, float *dst, int64_t size)
+{
+  for (int64_t i = 0; i < size; i++, src1 += 4, src2 += 4, dst += 4) {
+    const float f = (1.0f - (src1[3] * (1.0f - FACTOR))) * src2[3];
+    for (int c = 0; c < 3; c++) {
+      dst[c] = src1[c] + f * src2[c];
+    }
+    dst[3] = src1[3];
+  }
+}
+
+static void sub_scalar(const uchar *src1, const uchar *src2, uchar *dst, int64_t size)
+{
+  const int ifac = int(256.0f * FACTOR);
+  for (int64_t i = 0; i < size; i++, src1 += 4, src2 += 4, dst += 4) {
+    const int f = ifac * int(src2[3]);
+    for (int c = 0; c < 3; c++) {
+      dst[c] = max_ii(src1[c] - ((f * src2[c]) >> 16), 0);
+    }
+    dst[3] = src1[3];
+  }
+}
+
+static void sub_scalar(const float *src1, const float *src2, float *dst, int64_t size)
+{
+  for (int64_t i = 0; i < size; i++, src1 += 4, src2 += 4, dst += 4) {
+    const float f = (1.0f - (src1[3] * (1.0f - FACTOR))) * src2[3];
+    for (int c = 0; c < 3; c++) {
+      dst[c] = max_ff(src1[c] - f * src2[c], 0.0f);
+    }
+    dst[3] = src1[3];
+  }
+}
+
+/* Same as the blend mode effect, which uses the `BLI_math_color_blend.h` functions. */
+static void blend_mode_scalar(
+    int blend_mode, const float *src1, const float *src2, float *dst, int64_t size)
+{
+  for (int64_t i = 0; i < size; i++, src1 += 4, src2 += 4, dst += 4) {
+    const float src2_scaled[4] = {src2[0], src2[1], src2[2], src2[3] * FACTOR};
+    switch (blend_mode) {
+      case STRIP_TYPE_ADD:
+        blend_color_add_float(dst, src1, src2_scaled);
+        break;
+      case STRIP_TYPE_SUB:
+        blend_color_sub_float(dst, src1, src2_scaled);
+        break;
+      case STRIP_TYPE_MUL:
+        blend_color_mul_float(dst, src1, src2_scaled);
+        break;
+      case STRIP_TYPE_LIGHTEN:
+        blend_color_lighten_float(dst, src1, src2_scaled);
+        break;
+      case STRIP_TYPE_DARKEN:
+        blend_color_darken_float(dst, src1, src2_scaled);
+        break;
+      case STRIP_TYPE_SCREEN:
+        blend_color_screen_float(dst, src1, src2_scaled);
+        break;
+    }
+    dst[3] = src1[3];
+  }
+}
+
+template<typename T, typename ScalarFn, typename SimdFn>
+static void compare_perf(const char *name, ScalarFn scalar_fn, SimdFn simd_fn)
+{
+  const Array<T> src1 = create_image<T>(1);
+  const Array<T> src2 = create_image<T>(2);
+  Array<T> dst_scalar(PIXELS_NUM * 4);
+  Array<T> dst_simd(PIXELS_NUM * 4);
+
+  {
+    SCOPED_TIMER(std::string(name) + " scalar");
+    scalar_fn(src1.data(), src2.data(), dst_scalar.data(), PIXELS_NUM);
+  }
+  int64_t simd_size;
+  {
+    SCOPED_TIMER(std::string(name) + " simd");
+    simd_size = simd_fn(src1.data(), src2.data(), dst_simd.data(), PIXELS_NUM, FACTOR);
+  }
+  /* Pixels not handled by SIMD are not compared. */
+  for (int64_t i = 0; i < simd_size * 4; i++) {
+    if constexpr (std::is_same_v<T, uchar>) {
+      EXPECT_EQ(dst_scalar[i], dst_simd[i]);
+    }
+    else {
+      EXPECT_NEAR(dst_scalar[i], dst_simd[i], 1e-6f);
+    }
+  }
+}
+
+TEST(seq_effects, cross_perf_byte)
+{
+  compare_perf<uchar>(
+      "cross_byte",
+      [](const uchar *a, const uchar *b, uchar *d, int64_t n) { cross_scalar(a, b, d, n); },
+      [](const uchar *a, const uchar *b, uchar *d, int64_t n, float f) {
+        return cross_effect_simd(a, b, d, n, f);
+      });
+}
+
+TEST(seq_effects, cross_perf_float)
+{
+  compare_perf<float>(
+      "cross_float",
+      [](const float *a, const float *b, float *d, int64_t n) { cross_scalar(a, b, d, n); },
+      [](const float *a, const float *b, float *d, int64_t n, float f) {
+        return cross_effect_simd(a, b, d, n, f);
+      });
+}
+
+TEST(seq_effects, gamma_cross_perf_byte)
+{
+  compare_perf<uchar>(
+      "gamma_cross_byte",
+      [](const uchar *a, const uchar *b, uchar *d, int64_t n) { gamma_cross_scalar(a, b, d, n); },
+      [](const uchar *a, const uchar *b, uchar *d, int64_t n, float f) {
+        return gamma_cross_effect_simd(a, b, d, n, f);
+      });
+}
+
+TEST(seq_effects, gamma_cross_perf_float)
+{
+  compare_perf<float>(
+      "gamma_cross_float",
+      [](const float *a, const float *b, float *d, int64_t n) { gamma_cross_scalar(a, b, d, n); },
+      [](const float *a, const float *b, float *d, int64_t n, float f) {
+        return gamma_cross_effect_simd(a, b, d, n, f);
+      });
+}
+
+TEST(seq_effects, mul_perf_byte)
+{
+  compare_perf<uchar>(
+      "mul_byte",
+      [](const uchar *a, const uchar *b, uchar *d, int64_t n) { mul_scalar(a, b, d, n); },
+      [](const uchar *a, const uchar *b, uchar *d, int64_t n, float f) {
+        return mul_effect_simd(a, b, d, n, f);
+      });
+}
+
+TEST(seq_effects, mul_perf_float)
+{
+  compare_perf<float>(
+      "mul_float",
+      [](const float *a, const float *b, float *d, int64_t n) { mul_scalar(a, b, d, n); },
+      [](const float *a, const float *b, float *d, int64_t n, float f) {
+        return mul_effect_simd(a, b, d, n, f);
+      });
+}
+
+TEST(seq_effects, add_perf_byte)
+{
+  compare_perf<uchar>(
+      "add_byte",
+      [](const uchar *a, const uchar *b, uchar *d, int64_t n) { add_scalar(a, b, d, n); },
+      [](const uchar *a, const uchar *b, uchar *d, int64_t n, float f) {
+        return add_effect_simd(a, b, d, n, f);
+      });
+}
+
+TEST(seq_effects, add_perf_float)
+{
+  compare_perf<float>(
+      "add_float",
+      [](const float *a, const float *b, float *d, int64_t n) { add_scalar(a, b, d, n); },
+      [](const float *a, const float *b, float *d, int64_t n, float f) {
+        return add_effect_simd(a, b, d, n, f);
+      });
+}
+
+TEST(seq_effects, sub_perf_byte)
+{
+  compare_perf<uchar>(
+      "sub_byte",
+      [](const uchar *a, const uchar *b, uchar *d, int64_t n) { sub_scalar(a, b, d, n); },
+      [](const uchar *a, const uchar *b, uchar *d, int64_t n, float f) {
+        return sub_effect_simd(a, b, d, n, f);
+      });
+}
+
+TEST(seq_effects, sub_perf_float)
+{
+  compare_perf<float>(
+      "sub_float",
+      [](const float *a, const float *b, float *d, int64_t n) { sub_scalar(a, b, d, n); },
+      [](const float *a, const float *b, float *d, int64_t n, float f) {
+        return sub_effect_simd(a, b, d, n, f);
+      });
+}
+
+TEST(seq_effects, blend_mode_perf_float)
+{
+  const std::pair<int, const char *> blend_modes[] = {{STRIP_TYPE_ADD, "blend_add_float"},
+                                                      {STRIP_TYPE_SUB, "blend_sub_float"},
+                                                      {STRIP_TYPE_MUL, "blend_mul_float"},
+                                                      {STRIP_TYPE_LIGHTEN, "blend_lighten_float"},
+                                                      {STRIP_TYPE_DARKEN, "blend_darken_float"},
+                                                      {STRIP_TYPE_SCREEN, "blend_screen_float"}};
+  for (const std::pair<int, const char *> &item : blend_modes) {
+    const int blend_mode = item.first;
+    compare_perf<float>(
+        item.second,
+        [&](const float *a, const float *b, float *d, int64_t n) {
+          blend_mode_scalar(blend_mode, a, b, d, n);
+        },
+        [&](const float *a, const float *b, float *d, int64_t n, float f) {
+          return blend_mode_effect_simd(blend_mode, a, b, d, n, f);
+        });
+  }
+}
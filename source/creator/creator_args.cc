@@ -70,6 +70,7 @@
 #  endif
 
 #  include "DEG_depsgraph.hh"
+#  include "DEG_depsgraph_debug.hh"
 
 #  include "WM_types.hh"
 
@@ -741,7 +742,9 @@ static void print_help(bArgs *ba, bool all)
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-build");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-tag");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-no-threads");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-no-incremental");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-time");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-trace");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-pretty");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-uid");
   BLI_args_print_arg_doc(ba, "--debug-ghost");
@@ -1374,6 +1377,9 @@ static const char arg_handle_debug_mode_generic_set_doc_depsgraph_eval[] =
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_no_threads[] =
     "\n\t"
     "Switch dependency graph to a single threaded evaluation.";
+static const char arg_handle_debug_mode_generic_set_doc_depsgraph_no_incremental[] =
+    "\n\t"
+    "Always rebuild all dependency graph relations, instead of only those of the edited objects.";
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_pretty[] =
     "\n\t"
     "Enable colors for dependency graph debug messages.";
@@ -1395,6 +1401,24 @@ static int arg_handle_debug_mode_generic_set(int /*argc*/, const char ** /*argv*
   return 0;
 }
 
+static const char arg_handle_debug_depsgraph_trace_set_doc[] =
+    "<filepath>\n"
+    "\tWrite the timeline of dependency graph evaluations to a file in the Chrome trace event\n"
+    "\tformat, which can be viewed in Perfetto or 'chrome://tracing'.";
+static int arg_handle_debug_depsgraph_trace_set(int argc, const char **argv, void * /*data*/)
+{
+  if (argc > 1) {
+    if (!DEG_debug_eval_trace_file_set(argv[1])) {
+      fprintf(stderr, "\nError: could not open '%s' for writing the trace.\n", argv[1]);
+      return 1;
+    }
+    G.debug |= G_DEBUG_DEPSGRAPH_TRACE;
+    return 1;
+  }
+  fprintf(stderr, "\nError: you must specify a file path to write the trace to.\n");
+  return 0;
+}
+
 static const char arg_handle_debug_mode_io_doc[] =
     "\n\t"
     "Enable debug messages for I/O.";
@@ -2894,12 +2918,19 @@ void main_args_setup(bContext *C, bArgs *ba, bool all)
                "--debug-depsgraph-time",
                CB_EX(arg_handle_debug_mode_generic_set, depsgraph_time),
                (void *)G_DEBUG_DEPSGRAPH_TIME);
+  BLI_args_add(
+      ba, nullptr, "--debug-depsgraph-trace", CB(arg_handle_debug_depsgraph_trace_set), nullptr);
   BLI_args_add(ba,
 
                nullptr,
                "--debug-depsgraph-no-threads",
                CB_EX(arg_handle_debug_mode_generic_set, depsgraph_no_threads),
                (void *)G_DEBUG_DEPSGRAPH_NO_THREADS);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-depsgraph-no-incremental",
+               CB_EX(arg_handle_debug_mode_generic_set, depsgraph_no_incremental),
+               (void *)G_DEBUG_DEPSGRAPH_NO_INCREMENTAL);
   BLI_args_add(ba,
                nullptr,
                "--debug-depsgraph-pretty",